@@ -53,6 +53,7 @@
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "parser/scansup.h"
+#include "postmaster/sessionpool.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/fmgroids.h"
@@ -64,6 +65,8 @@
 
 PG_MODULE_MAGIC;
 
+void		_PG_init(void);
+
 typedef struct remoteConn
 {
 	PGconn	   *conn;			/* Hold the remote connection */
@@ -124,11 +127,14 @@ static bool is_valid_dblink_option(const PQconninfoOption *options,
 					   const char *option, Oid context);
 static int	applyRemoteGucs(PGconn *conn);
 static void restoreLocalGucs(int nestlevel);
+static bool dblink_session_pool_release(void);
 
 /* Global */
 static remoteConn *pconn = NULL;
 static HTAB *remoteConnHash = NULL;
 
+static session_pool_release_hook_type prev_session_pool_release_hook = NULL;
+
 /*
  *	Following is list that holds multiple remote connections.
  *	Calling convention of each dblink function changes to accept
@@ -3071,3 +3077,31 @@ restoreLocalGucs(int nestlevel)
 	if (nestlevel > 0)
 		AtEOXact_GUC(true, nestlevel);
 }
+
+/*
+ * Module load callback
+ */
+void
+_PG_init(void)
+{
+	/* Keep sessions with open connections out of the connection pool */
+	prev_session_pool_release_hook = session_pool_release_hook;
+	session_pool_release_hook = dblink_session_pool_release;
+}
+
+/*
+ * A session with open connections can't be handed to another backend, which
+ * wouldn't have them, nor can this backend serve other sessions with them.
+ */
+static bool
+dblink_session_pool_release(void)
+{
+	if (pconn && pconn->conn)
+		return false;
+	if (remoteConnHash && hash_get_num_entries(remoteConnHash) > 0)
+		return false;
+
+	if (prev_session_pool_release_hook)
+		return (*prev_session_pool_release_hook) ();
+	return true;
+}
@@ -0,0 +1,18 @@
+/* contrib/pg_buffercache/pg_buffercache--1.3--1.4.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION pg_buffercache UPDATE TO '1.4'" to load this file. \quit
+
+CREATE FUNCTION pg_buffercache_strategy_stats(
+    OUT replacement_policy text,
+    OUT buffer_allocs int8,
+    OUT freelist_allocs int8,
+    OUT ring_reuses int8,
+    OUT clock_sweep_ticks int8,
+    OUT clock_sweep_passes int8)
+AS 'MODULE_PATHNAME', 'pg_buffercache_strategy_stats'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+-- Don't want this to be available to public.
+REVOKE ALL ON FUNCTION pg_buffercache_strategy_stats() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_buffercache_strategy_stats() TO pg_monitor;
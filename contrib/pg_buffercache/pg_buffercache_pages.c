@@ -13,10 +13,13 @@
 #include "funcapi.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
 
 
 #define NUM_BUFFERCACHE_PAGES_MIN_ELEM	8
 #define NUM_BUFFERCACHE_PAGES_ELEM	9
+#define NUM_BUFFERCACHE_STRATEGY_STATS_ELEM	6
 
 PG_MODULE_MAGIC;
 
@@ -237,3 +240,34 @@ pg_buffercache_pages(PG_FUNCTION_ARGS)
 	else
 		SRF_RETURN_DONE(funcctx);
 }
+
+/*
+ * Function returning cumulative statistics about buffer replacement, and
+ * the replacement policy currently in use.
+ */
+PG_FUNCTION_INFO_V1(pg_buffercache_strategy_stats);
+
+Datum
+pg_buffercache_strategy_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	BufferStrategyStats stats;
+	Datum		values[NUM_BUFFERCACHE_STRATEGY_STATS_ELEM];
+	bool		nulls[NUM_BUFFERCACHE_STRATEGY_STATS_ELEM];
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	StrategyGetStats(&stats);
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = CStringGetTextDatum(GetConfigOption("buffer_replacement_policy",
+													false, false));
+	values[1] = Int64GetDatum((int64) stats.buffer_allocs);
+	values[2] = Int64GetDatum((int64) stats.freelist_allocs);
+	values[3] = Int64GetDatum((int64) stats.ring_reuses);
+	values[4] = Int64GetDatum((int64) stats.clock_sweep_ticks);
+	values[5] = Int64GetDatum((int64) stats.clock_sweep_passes);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
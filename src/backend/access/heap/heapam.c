@@ -59,6 +59,7 @@
 #include "storage/lmgr.h"
 #include "storage/predicate.h"
 #include "storage/procarray.h"
+#include "storage/read_stream.h"
 #include "storage/smgr.h"
 #include "storage/spin.h"
 #include "storage/standby.h"
@@ -102,6 +103,9 @@ static void MultiXactIdWait(MultiXactId multi, MultiXactStatus status, uint16 in
 static bool ConditionalMultiXactIdWait(MultiXactId multi, MultiXactStatus status,
 						   uint16 infomask, Relation rel, int *remaining);
 static XLogRecPtr log_heap_new_cid(Relation relation, HeapTuple tup);
+static void heap_scan_stream_begin(HeapScanDesc scan);
+static BlockNumber heap_scan_stream_read_next(ReadStream *stream,
+							void *callback_private_data);
 static HeapTuple ExtractReplicaIdentity(Relation rel, HeapTuple tup, bool key_modified,
 					   bool *copy);
 
@@ -334,6 +338,77 @@ heap_setscanlimits(TableScanDesc sscan, BlockNumber startBlk, BlockNumber numBlk
 	scan->rs_numblocks = numBlks;
 }
 
+/*
+ * heap_scan_stream_begin - start combining reads for a forward scan
+ *
+ * Called when a serial forward scan is about to read its first page.  The
+ * read stream is fed the same sequence of blocks that heapgettup() will ask
+ * for, so that runs of blocks that are not in shared buffers yet can be read
+ * with a single I/O.
+ */
+static void
+heap_scan_stream_begin(HeapScanDesc scan)
+{
+	if (scan->rs_read_stream != NULL)
+	{
+		read_stream_end(scan->rs_read_stream);
+		scan->rs_read_stream = NULL;
+	}
+
+	/*
+	 * Parallel scans get their blocks one at a time from the shared state,
+	 * and reads of local buffers can't be combined anyway.
+	 */
+	if (scan->rs_base.rs_parallel != NULL ||
+		scan->rs_base.rs_bitmapscan ||
+		scan->rs_base.rs_samplescan ||
+		RelationUsesLocalBuffers(scan->rs_base.rs_rd) ||
+		io_combine_limit <= 1)
+		return;
+
+	scan->rs_stream_nextblock = scan->rs_startblock;
+	scan->rs_stream_numblocks = scan->rs_numblocks;
+	scan->rs_read_stream = read_stream_begin_relation(scan->rs_base.rs_rd,
+													  MAIN_FORKNUM,
+													  scan->rs_strategy,
+													  heap_scan_stream_read_next,
+													  scan);
+}
+
+/*
+ * heap_scan_stream_read_next - read stream callback for heap scans
+ *
+ * Returns the blocks in the order heapgettup() visits them going forward:
+ * from rs_startblock to the end of the relation, then wrapping around to
+ * block 0, until we're back at the start or rs_numblocks pages have been
+ * scanned.
+ */
+static BlockNumber
+heap_scan_stream_read_next(ReadStream *stream, void *callback_private_data)
+{
+	HeapScanDesc scan = (HeapScanDesc) callback_private_data;
+	BlockNumber blkno = scan->rs_stream_nextblock;
+	BlockNumber next;
+
+	if (blkno == InvalidBlockNumber)
+		return InvalidBlockNumber;
+
+	if (scan->rs_stream_numblocks != InvalidBlockNumber &&
+		--scan->rs_stream_numblocks == 0)
+		next = InvalidBlockNumber;
+	else
+	{
+		next = blkno + 1;
+		if (next >= scan->rs_nblocks)
+			next = 0;
+		if (next == scan->rs_startblock)
+			next = InvalidBlockNumber;
+	}
+	scan->rs_stream_nextblock = next;
+
+	return blkno;
+}
+
 /*
  * heapgetpage - subroutine for heapgettup()
  *
@@ -370,9 +445,30 @@ heapgetpage(TableScanDesc sscan, BlockNumber page)
 	 */
 	CHECK_FOR_INTERRUPTS();
 
-	/* read page using selected strategy */
-	scan->rs_cbuf = ReadBufferExtended(scan->rs_base.rs_rd, MAIN_FORKNUM, page,
-									   RBM_NORMAL, scan->rs_strategy);
+	/*
+	 * Get the page from the read stream if we have one.  If the scan didn't
+	 * ask for the block the stream predicted, e.g. because a cursor changed
+	 * direction, give up on combining reads for the rest of the scan.
+	 */
+	if (scan->rs_read_stream != NULL)
+	{
+		buffer = read_stream_next_buffer(scan->rs_read_stream);
+		if (BufferIsValid(buffer) && BufferGetBlockNumber(buffer) == page)
+			scan->rs_cbuf = buffer;
+		else
+		{
+			if (BufferIsValid(buffer))
+				ReleaseBuffer(buffer);
+			read_stream_end(scan->rs_read_stream);
+			scan->rs_read_stream = NULL;
+		}
+	}
+
+	/* otherwise read page using selected strategy */
+	if (!BufferIsValid(scan->rs_cbuf))
+		scan->rs_cbuf = ReadBufferExtended(scan->rs_base.rs_rd, MAIN_FORKNUM,
+										   page, RBM_NORMAL,
+										   scan->rs_strategy);
 	scan->rs_cblock = page;
 
 	if (!scan->rs_base.rs_pageatatime)
@@ -529,7 +625,10 @@ heapgettup(HeapScanDesc scan,
 				}
 			}
 			else
+			{
 				page = scan->rs_startblock; /* first page */
+				heap_scan_stream_begin(scan);
+			}
 			heapgetpage((TableScanDesc) scan, page);
 			lineoff = FirstOffsetNumber;	/* first offnum */
 			scan->rs_inited = true;
@@ -575,8 +674,14 @@ heapgettup(HeapScanDesc scan,
 			 * forward scanners.
 			 */
 			scan->rs_base.rs_syncscan = false;
-			/* start from last page of the scan */
-			if (scan->rs_startblock > 0)
+
+			/*
+			 * Start from last page of the scan.  Ensure we take into account
+			 * rs_numblocks if it's been adjusted by heap_setscanlimits().
+			 */
+			if (scan->rs_numblocks != InvalidBlockNumber)
+				page = (scan->rs_startblock + scan->rs_numblocks - 1) % scan->rs_nblocks;
+			else if (scan->rs_startblock > 0)
 				page = scan->rs_startblock - 1;
 			else
 				page = scan->rs_nblocks - 1;
@@ -843,7 +948,10 @@ heapgettup_pagemode(HeapScanDesc scan,
 				}
 			}
 			else
+			{
 				page = scan->rs_startblock; /* first page */
+				heap_scan_stream_begin(scan);
+			}
 			heapgetpage((TableScanDesc) scan, page);
 			lineindex = 0;
 			scan->rs_inited = true;
@@ -886,8 +994,14 @@ heapgettup_pagemode(HeapScanDesc scan,
 			 * forward scanners.
 			 */
 			scan->rs_base.rs_syncscan = false;
-			/* start from last page of the scan */
-			if (scan->rs_startblock > 0)
+
+			/*
+			 * Start from last page of the scan.  Ensure we take into account
+			 * rs_numblocks if it's been adjusted by heap_setscanlimits().
+			 */
+			if (scan->rs_numblocks != InvalidBlockNumber)
+				page = (scan->rs_startblock + scan->rs_numblocks - 1) % scan->rs_nblocks;
+			else if (scan->rs_startblock > 0)
 				page = scan->rs_startblock - 1;
 			else
 				page = scan->rs_nblocks - 1;
@@ -1154,6 +1268,7 @@ heap_beginscan(Relation relation, Snapshot snapshot,
 	scan->rs_base.rs_bitmapscan = is_bitmapscan;
 	scan->rs_base.rs_samplescan = is_samplescan;
 	scan->rs_strategy = NULL;	/* set in initscan */
+	scan->rs_read_stream = NULL;
 	scan->rs_base.rs_allow_strat = allow_strat;
 	scan->rs_base.rs_allow_sync = allow_sync;
 	scan->rs_base.rs_temp_snap = temp_snap;
@@ -1216,6 +1331,12 @@ heap_rescan(TableScanDesc sscan, ScanKey key, bool set_params,
 	if (BufferIsValid(scan->rs_cbuf))
 		ReleaseBuffer(scan->rs_cbuf);
 
+	if (scan->rs_read_stream != NULL)
+	{
+		read_stream_end(scan->rs_read_stream);
+		scan->rs_read_stream = NULL;
+	}
+
 	/*
 	 * reinitialize scan descriptor
 	 */
@@ -1235,6 +1356,9 @@ heap_endscan(TableScanDesc sscan)
 	if (BufferIsValid(scan->rs_cbuf))
 		ReleaseBuffer(scan->rs_cbuf);
 
+	if (scan->rs_read_stream != NULL)
+		read_stream_end(scan->rs_read_stream);
+
 	/*
 	 * decrement relation reference count and free scan descriptor storage
 	 */
@@ -1361,6 +1485,153 @@ heap_getnextslot(TableScanDesc sscan, ScanDirection direction, TupleTableSlot *s
 	return true;
 }
 
+void
+heap_set_tidrange(TableScanDesc sscan, ItemPointer mintid,
+				  ItemPointer maxtid)
+{
+	HeapScanDesc scan = (HeapScanDesc) sscan;
+	BlockNumber startBlk;
+	BlockNumber numBlks;
+	ItemPointerData highestItem;
+	ItemPointerData lowestItem;
+
+	/*
+	 * For relations without any pages, we can simply leave the TID range
+	 * unset.  There will be no tuples to scan, therefore no tuples outside
+	 * the given TID range.
+	 */
+	if (scan->rs_nblocks == 0)
+		return;
+
+	/*
+	 * Set up some ItemPointers which point to the first and last possible
+	 * tuples in the heap.
+	 */
+	ItemPointerSet(&highestItem, scan->rs_nblocks - 1, MaxOffsetNumber);
+	ItemPointerSet(&lowestItem, 0, FirstOffsetNumber);
+
+	/*
+	 * If the given maximum TID is below the highest possible TID in the
+	 * relation, then restrict the range to that, otherwise we scan to the end
+	 * of the relation.
+	 */
+	if (ItemPointerCompare(maxtid, &highestItem) < 0)
+		ItemPointerCopy(maxtid, &highestItem);
+
+	/*
+	 * If the given minimum TID is above the lowest possible TID in the
+	 * relation, then restrict the range to only scan for TIDs above that.
+	 */
+	if (ItemPointerCompare(mintid, &lowestItem) > 0)
+		ItemPointerCopy(mintid, &lowestItem);
+
+	/*
+	 * Check for an empty range and protect from would be negative results
+	 * from the numBlks calculation below.
+	 */
+	if (ItemPointerCompare(&highestItem, &lowestItem) < 0)
+	{
+		/* Set an empty range of blocks to scan */
+		heap_setscanlimits(sscan, 0, 0);
+		return;
+	}
+
+	/*
+	 * Calculate the first block and the number of blocks we must scan.  We
+	 * could be more aggressive here and perform some more validation to try
+	 * and further narrow the scope of blocks to scan by checking if the
+	 * lowerItem has an offset above MaxOffsetNumber.  In this case, we could
+	 * advance startBlk by one.  Likewise, if highestItem has an offset of 0
+	 * we could scan one less block.  However, such an optimization does not
+	 * seem worth troubling over, currently.
+	 */
+	startBlk = ItemPointerGetBlockNumberNoCheck(&lowestItem);
+
+	numBlks = ItemPointerGetBlockNumberNoCheck(&highestItem) -
+		ItemPointerGetBlockNumberNoCheck(&lowestItem) + 1;
+
+	/* Set the start block and number of blocks to scan */
+	heap_setscanlimits(sscan, startBlk, numBlks);
+
+	/* Finally, set the TID range in sscan */
+	ItemPointerCopy(&lowestItem, &sscan->rs_mintid);
+	ItemPointerCopy(&highestItem, &sscan->rs_maxtid);
+}
+
+bool
+heap_getnextslot_tidrange(TableScanDesc sscan, ScanDirection direction,
+						  TupleTableSlot *slot)
+{
+	HeapScanDesc scan = (HeapScanDesc) sscan;
+	ItemPointer mintid = &sscan->rs_mintid;
+	ItemPointer maxtid = &sscan->rs_maxtid;
+
+	/* Note: no locking manipulations needed */
+	for (;;)
+	{
+		if (sscan->rs_pageatatime)
+			heapgettup_pagemode(scan, direction, sscan->rs_nkeys, sscan->rs_key);
+		else
+			heapgettup(scan, direction, sscan->rs_nkeys, sscan->rs_key);
+
+		if (scan->rs_ctup.t_data == NULL)
+		{
+			ExecClearTuple(slot);
+			return false;
+		}
+
+		/*
+		 * heap_set_tidrange will have used heap_setscanlimits to limit the
+		 * range of pages we scan to only ones that can contain the TID range
+		 * we're scanning for.  Here we must filter out any tuples from these
+		 * pages that are outside of that range.
+		 */
+		if (ItemPointerCompare(&scan->rs_ctup.t_self, mintid) < 0)
+		{
+			ExecClearTuple(slot);
+
+			/*
+			 * When scanning backwards, the TIDs will be in descending order.
+			 * Future tuples in this direction will be lower still, so we can
+			 * just return false to indicate there will be no more tuples.
+			 */
+			if (ScanDirectionIsBackward(direction))
+				return false;
+
+			continue;
+		}
+
+		/*
+		 * Likewise for the final page, we must filter out TIDs greater than
+		 * maxtid.
+		 */
+		if (ItemPointerCompare(&scan->rs_ctup.t_self, maxtid) > 0)
+		{
+			ExecClearTuple(slot);
+
+			/*
+			 * When scanning forward, the TIDs will be in ascending order.
+			 * Future tuples in this direction will be higher still, so we can
+			 * just return false to indicate there will be no more tuples.
+			 */
+			if (ScanDirectionIsForward(direction))
+				return false;
+			continue;
+		}
+
+		break;
+	}
+
+	/*
+	 * if we get here it means we have a new current scan tuple, so point to
+	 * the proper return buffer and return the tuple.
+	 */
+	pgstat_count_heap_getnext(scan->rs_base.rs_rd);
+
+	ExecStoreBufferHeapTuple(&scan->rs_ctup, slot, scan->rs_cbuf);
+	return true;
+}
+
 /*
  *	heap_fetch		- retrieve tuple with given tid
  *
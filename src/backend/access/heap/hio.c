@@ -186,9 +186,10 @@ static void
 RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 {
 	BlockNumber blockNum,
-				firstBlock = InvalidBlockNumber;
+				firstBlock;
 	int			extraBlocks;
 	int			lockWaiters;
+	Size		freespace;
 
 	/* Use the length of the lock wait queue to judge how much to extend. */
 	lockWaiters = RelationExtensionLockWaiterCount(relation);
@@ -203,59 +204,35 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 	 */
 	extraBlocks = Min(512, lockWaiters * 20);
 
-	do
-	{
-		Buffer		buffer;
-		Page		page;
-		Size		freespace;
-
-		/*
-		 * Extend by one page.  This should generally match the main-line
-		 * extension code in RelationGetBufferForTuple, except that we hold
-		 * the relation extension lock throughout, and we don't immediately
-		 * initialize the page (see below).
-		 */
-		buffer = ReadBufferBI(relation, P_NEW, RBM_ZERO_AND_LOCK, bistate);
-		page = BufferGetPage(buffer);
-
-		if (!PageIsNew(page))
-			elog(ERROR, "page %u of relation \"%s\" should be empty but is not",
-				 BufferGetBlockNumber(buffer),
-				 RelationGetRelationName(relation));
-
-		/*
-		 * Add the page to the FSM without initializing. If we were to
-		 * initialize here, the page would potentially get flushed out to disk
-		 * before we add any useful content. There's no guarantee that that'd
-		 * happen before a potential crash, so we need to deal with
-		 * uninitialized pages anyway, thus avoid the potential for
-		 * unnecessary writes.
-		 */
-
-		/* we'll need this info below */
-		blockNum = BufferGetBlockNumber(buffer);
-		freespace = BufferGetPageSize(buffer) - SizeOfPageHeaderData;
-
-		UnlockReleaseBuffer(buffer);
-
-		/* Remember first block number thus added. */
-		if (firstBlock == InvalidBlockNumber)
-			firstBlock = blockNum;
+	/*
+	 * Extend by all the blocks at once.  This costs a single call into the
+	 * storage manager, which can allocate the space without writing it, and
+	 * we hold the relation extension lock throughout.
+	 *
+	 * The pages are added to the FSM without initializing them.  If we were
+	 * to initialize here, the pages would potentially get flushed out to
+	 * disk before we add any useful content. There's no guarantee that that'd
+	 * happen before a potential crash, so we need to deal with uninitialized
+	 * pages anyway, thus avoid the potential for unnecessary writes.
+	 */
+	firstBlock = ExtendBufferedRelBy(relation, MAIN_FORKNUM, extraBlocks,
+									 NULL,
+									 bistate ? bistate->strategy : NULL);
+	freespace = BLCKSZ - SizeOfPageHeaderData;
 
-		/*
-		 * Immediately update the bottom level of the FSM.  This has a good
-		 * chance of making this page visible to other concurrently inserting
-		 * backends, and we want that to happen without delay.
-		 *
-		 * Since we know the table will end up with extraBlocks additional
-		 * pages, we pass the final number to avoid possible unnecessary
-		 * system calls and to make sure the FSM is created when we add the
-		 * first new page.
-		 */
+	/*
+	 * Immediately update the bottom level of the FSM.  This has a good chance
+	 * of making the pages visible to other concurrently inserting backends,
+	 * in particular those waiting for the extension lock, and we want that to
+	 * happen without delay.
+	 *
+	 * Since we know the table ends up with extraBlocks additional pages, we
+	 * pass the final number to avoid possible unnecessary system calls and to
+	 * make sure the FSM is created when we add the first new page.
+	 */
+	for (blockNum = firstBlock; blockNum < firstBlock + extraBlocks; blockNum++)
 		RecordPageWithFreeSpace(relation, blockNum, freespace,
 								firstBlock + extraBlocks);
-	}
-	while (--extraBlocks > 0);
 
 	/*
 	 * Updating the upper levels of the free space map is too expensive to do
@@ -263,7 +240,7 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 	 * subsequent insertion activity sees all of those nifty free pages we
 	 * just inserted.
 	 */
-	FreeSpaceMapVacuumRange(relation, firstBlock, blockNum + 1);
+	FreeSpaceMapVacuumRange(relation, firstBlock, firstBlock + extraBlocks);
 }
 
 /*
@@ -590,11 +567,6 @@ loop:
 	/*
 	 * In addition to whatever extension we performed above, we always add at
 	 * least one block to satisfy our own request.
-	 *
-	 * XXX This does an lseek - rather expensive - but at the moment it is the
-	 * only way to accurately determine how many blocks are in a relation.  Is
-	 * it worth keeping an accurate file length in shared memory someplace,
-	 * rather than relying on the kernel to do it for us?
 	 */
 	buffer = ReadBufferBI(relation, P_NEW, RBM_ZERO_AND_LOCK, bistate);
 
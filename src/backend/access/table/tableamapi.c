@@ -52,6 +52,9 @@ GetTableAmRoutine(Oid amhandler)
 	Assert(routine->scan_begin != NULL);
 	Assert(routine->scan_end != NULL);
 	Assert(routine->scan_rescan != NULL);
+	/* optional, but either both or neither need to be provided */
+	Assert((routine->scan_set_tidrange == NULL) ==
+		   (routine->scan_getnextslot_tidrange == NULL));
 
 	Assert(routine->parallelscan_estimate != NULL);
 	Assert(routine->parallelscan_initialize != NULL);
@@ -232,10 +232,11 @@ SetXidCommitTsInPage(TransactionId xid, int nsubxids,
 					 TransactionId *subxids, TimestampTz ts,
 					 RepOriginId nodeid, int pageno)
 {
+	LWLock	   *lock = SimpleLruGetBankLock(CommitTsCtl, pageno);
 	int			slotno;
 	int			i;
 
-	LWLockAcquire(CommitTsControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	slotno = SimpleLruReadPage(CommitTsCtl, pageno, true, xid);
 
@@ -245,13 +246,13 @@ SetXidCommitTsInPage(TransactionId xid, int nsubxids,
 
 	CommitTsCtl->shared->page_dirty[slotno] = true;
 
-	LWLockRelease(CommitTsControlLock);
+	LWLockRelease(lock);
 }
 
 /*
  * Sets the commit timestamp of a single transaction.
  *
- * Must be called with CommitTsControlLock held
+ * Must be called with the page's bank lock held
  */
 static void
 TransactionIdSetCommitTs(TransactionId xid, TimestampTz ts,
@@ -352,7 +353,7 @@ TransactionIdGetCommitTsData(TransactionId xid, TimestampTz *ts,
 	if (nodeid)
 		*nodeid = entry.nodeid;
 
-	LWLockRelease(CommitTsControlLock);
+	LWLockRelease(SimpleLruGetBankLock(CommitTsCtl, pageno));
 	return *ts != 0;
 }
 
@@ -464,12 +465,16 @@ pg_last_committed_xact(PG_FUNCTION_ARGS)
  * Number of shared CommitTS buffers.
  *
  * We use a very similar logic as for the number of CLOG buffers; see comments
- * in CLOGShmemBuffers.
+ * in CLOGShmemBuffers.  commit_timestamp_buffers overrides it.
  */
 Size
 CommitTsShmemBuffers(void)
 {
-	return Min(16, Max(4, NBuffers / 1024));
+	if (commit_timestamp_buffers == 0)
+		return SimpleLruAutotuneBuffers(512, 1024);
+
+	return Min(Max(SLRU_BANK_SIZE, commit_timestamp_buffers),
+			   SLRU_MAX_ALLOWED_BUFFERS);
 }
 
 /*
@@ -493,8 +498,8 @@ CommitTsShmemInit(void)
 
 	CommitTsCtl->PagePrecedes = CommitTsPagePrecedes;
 	SimpleLruInit(CommitTsCtl, "commit_timestamp", CommitTsShmemBuffers(), 0,
-				  CommitTsControlLock, "pg_commit_ts",
-				  LWTRANCHE_COMMITTS_BUFFERS);
+				  "pg_commit_ts", LWTRANCHE_COMMITTS_BUFFERS,
+				  LWTRANCHE_COMMITTS_SLRU);
 
 	commitTsShared = ShmemInitStruct("CommitTs shared",
 									 sizeof(CommitTimestampShared),
@@ -536,7 +541,7 @@ BootStrapCommitTs(void)
  * The page is not actually written, just set up in shared memory.
  * The slot number of the new page is returned.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Bank lock of the page must be held at entry, and will be held at exit.
  */
 static int
 ZeroCommitTsPage(int pageno, bool writeXlog)
@@ -649,9 +654,7 @@ ActivateCommitTs(void)
 	/*
 	 * Re-Initialize our idea of the latest page number.
 	 */
-	LWLockAcquire(CommitTsControlLock, LW_EXCLUSIVE);
-	CommitTsCtl->shared->latest_page_number = pageno;
-	LWLockRelease(CommitTsControlLock);
+	SimpleLruSetLatestPage(CommitTsCtl, pageno);
 
 	/*
 	 * If CommitTs is enabled, but it wasn't in the previous server run, we
@@ -677,13 +680,14 @@ ActivateCommitTs(void)
 	/* Create the current segment file, if necessary */
 	if (!SimpleLruDoesPhysicalPageExist(CommitTsCtl, pageno))
 	{
+		LWLock	   *lock = SimpleLruGetBankLock(CommitTsCtl, pageno);
 		int			slotno;
 
-		LWLockAcquire(CommitTsControlLock, LW_EXCLUSIVE);
+		LWLockAcquire(lock, LW_EXCLUSIVE);
 		slotno = ZeroCommitTsPage(pageno, false);
 		SimpleLruWritePage(CommitTsCtl, slotno);
 		Assert(!CommitTsCtl->shared->page_dirty[slotno]);
-		LWLockRelease(CommitTsControlLock);
+		LWLockRelease(lock);
 	}
 
 	/* Change the activation status in shared memory. */
@@ -705,6 +709,8 @@ ActivateCommitTs(void)
 static void
 DeactivateCommitTs(void)
 {
+	int			i;
+
 	/*
 	 * Cleanup the status in the shared memory.
 	 *
@@ -730,11 +736,14 @@ DeactivateCommitTs(void)
 	 * with it disabled for some time there may be a gap in the file sequence.
 	 * (We can probably tolerate out-of-sequence files, as they are going to
 	 * be overwritten anyway when we wrap around, but it seems better to be
-	 * tidy.)
+	 * tidy.)  Hold all the bank locks meanwhile, so that no page is being
+	 * written out while its file goes away.
 	 */
-	LWLockAcquire(CommitTsControlLock, LW_EXCLUSIVE);
+	for (i = 0; i < CommitTsCtl->num_banks; i++)
+		LWLockAcquire(&CommitTsCtl->shared->bank_locks[i].lock, LW_EXCLUSIVE);
 	(void) SlruScanDirectory(CommitTsCtl, SlruScanDirCbDeleteAll, NULL);
-	LWLockRelease(CommitTsControlLock);
+	for (i = 0; i < CommitTsCtl->num_banks; i++)
+		LWLockRelease(&CommitTsCtl->shared->bank_locks[i].lock);
 }
 
 /*
@@ -804,12 +813,12 @@ ExtendCommitTs(TransactionId newestXact)
 
 	pageno = TransactionIdToCTsPage(newestXact);
 
-	LWLockAcquire(CommitTsControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(SimpleLruGetBankLock(CommitTsCtl, pageno), LW_EXCLUSIVE);
 
 	/* Zero the page and make an XLOG entry about it */
 	ZeroCommitTsPage(pageno, !InRecovery);
 
-	LWLockRelease(CommitTsControlLock);
+	LWLockRelease(SimpleLruGetBankLock(CommitTsCtl, pageno));
 }
 
 /*
@@ -974,13 +983,13 @@ commit_ts_redo(XLogReaderState *record)
 
 		memcpy(&pageno, XLogRecGetData(record), sizeof(int));
 
-		LWLockAcquire(CommitTsControlLock, LW_EXCLUSIVE);
+		LWLockAcquire(SimpleLruGetBankLock(CommitTsCtl, pageno), LW_EXCLUSIVE);
 
 		slotno = ZeroCommitTsPage(pageno, false);
 		SimpleLruWritePage(CommitTsCtl, slotno);
 		Assert(!CommitTsCtl->shared->page_dirty[slotno]);
 
-		LWLockRelease(CommitTsControlLock);
+		LWLockRelease(SimpleLruGetBankLock(CommitTsCtl, pageno));
 	}
 	else if (info == COMMIT_TS_TRUNCATE)
 	{
@@ -992,7 +1001,7 @@ commit_ts_redo(XLogReaderState *record)
 		 * During XLOG replay, latest_page_number isn't set up yet; insert a
 		 * suitable value to bypass the sanity test in SimpleLruTruncate.
 		 */
-		CommitTsCtl->shared->latest_page_number = trunc->pageno;
+		SimpleLruSetLatestPage(CommitTsCtl, trunc->pageno);
 
 		SimpleLruTruncate(CommitTsCtl, trunc->pageno);
 	}
@@ -7,32 +7,40 @@
  * buffers.  Under ordinary circumstances we expect that write
  * traffic will occur mostly to the latest page (and to the just-prior
  * page, soon after a page transition).  Read traffic will probably touch
- * a larger span of pages, but in any case a fairly small number of page
- * buffers should be sufficient.  So, we just search the buffers using plain
- * linear search; there's no need for a hashtable or anything fancy.
- * The management algorithm is straight LRU except that we will never swap
+ * a larger span of pages, though, and some workloads (many subtransactions
+ * or multixacts, for example) want a good many buffers.  To keep lookups
+ * cheap no matter how many buffers are configured, the buffers are divided
+ * into banks of SLRU_BANK_SIZE slots, and a page can only be held in the
+ * bank selected by its page number.  Looking up a page, or choosing a
+ * victim to replace, is a linear search of that one bank.  The management
+ * algorithm is straight LRU within the bank, except that we will never swap
  * out the latest page (since we know it's going to be hit again eventually).
  *
- * We use a control LWLock to protect the shared data structures, plus
- * per-buffer LWLocks that synchronize I/O for each buffer.  The control lock
- * must be held to examine or modify any shared state.  A process that is
- * reading in or writing out a page buffer does not hold the control lock,
- * only the per-buffer lock for the buffer it is working on.
+ * Each bank has its own LWLock protecting the shared state of its slots,
+ * plus there are per-buffer LWLocks that synchronize I/O for each buffer.
+ * The bank lock must be held to examine or modify the state of any slot in
+ * the bank, and callers must hold the bank lock of a page (see
+ * SimpleLruGetBankLock()) while they access the page's contents.  A process
+ * that is reading in or writing out a page buffer does not hold the bank
+ * lock, only the per-buffer lock for the buffer it is working on.
  *
- * "Holding the control lock" means exclusive lock in all cases except for
+ * "Holding the bank lock" means exclusive lock in all cases except for
  * SimpleLruReadPage_ReadOnly(); see comments for SlruRecentlyUsed() for
  * the implications of that.
  *
  * When initiating I/O on a buffer, we acquire the per-buffer lock exclusively
- * before releasing the control lock.  The per-buffer lock is released after
- * completing the I/O, re-acquiring the control lock, and updating the shared
+ * before releasing the bank lock.  The per-buffer lock is released after
+ * completing the I/O, re-acquiring the bank lock, and updating the shared
  * state.  (Deadlock is not possible here, because we never try to initiate
  * I/O when someone else is already doing I/O on the same buffer.)
- * To wait for I/O to complete, release the control lock, acquire the
+ * To wait for I/O to complete, release the bank lock, acquire the
  * per-buffer lock in shared mode, immediately release the per-buffer lock,
- * reacquire the control lock, and then recheck state (since arbitrary things
+ * reacquire the bank lock, and then recheck state (since arbitrary things
  * could have happened while we didn't have the lock).
  *
+ * A process never holds more than one bank lock of the same SLRU at a time,
+ * except in code that takes them all in bank order.
+ *
  * As with the regular buffer manager, it is possible for another process
  * to re-dirty a page that is currently being written out.  This is handled
  * by re-setting the page's page_dirty flag.
@@ -58,6 +66,7 @@
 #include "storage/fd.h"
 #include "storage/shmem.h"
 #include "miscadmin.h"
+#include "utils/guc.h"
 
 
 #define SlruFileName(ctl, path, seg) \
@@ -87,13 +96,13 @@ typedef struct SlruFlushData *SlruFlush;
  *
  * The reason for the if-test is that there are often many consecutive
  * accesses to the same page (particularly the latest page).  By suppressing
- * useless increments of cur_lru_count, we reduce the probability that old
+ * useless increments of bank_cur_lru_count, we reduce the probability that old
  * pages' counts will "wrap around" and make them appear recently used.
  *
  * We allow this code to be executed concurrently by multiple processes within
  * SimpleLruReadPage_ReadOnly().  As long as int reads and writes are atomic,
  * this should not cause any completely-bogus values to enter the computation.
- * However, it is possible for either cur_lru_count or individual
+ * However, it is possible for either bank_cur_lru_count or individual
  * page_lru_count entries to be "reset" to lower values than they should have,
  * in case a process is delayed while it executes this macro.  With care in
  * SlruSelectLRUPage(), this does little harm, and in any case the absolute
@@ -102,9 +111,10 @@ typedef struct SlruFlushData *SlruFlush;
  */
 #define SlruRecentlyUsed(shared, slotno)	\
 	do { \
-		int		new_lru_count = (shared)->cur_lru_count; \
+		int		bankno = (slotno) / SLRU_BANK_SIZE; \
+		int		new_lru_count = (shared)->bank_cur_lru_count[bankno]; \
 		if (new_lru_count != (shared)->page_lru_count[slotno]) { \
-			(shared)->cur_lru_count = ++new_lru_count; \
+			(shared)->bank_cur_lru_count[bankno] = ++new_lru_count; \
 			(shared)->page_lru_count[slotno] = new_lru_count; \
 		} \
 	} while (0)
@@ -144,8 +154,12 @@ static void SlruInternalDeleteSegment(SlruCtl ctl, char *filename);
 Size
 SimpleLruShmemSize(int nslots, int nlsns)
 {
+	int			nbanks = nslots / SLRU_BANK_SIZE;
 	Size		sz;
 
+	Assert(nslots > 0 && nslots % SLRU_BANK_SIZE == 0);
+	Assert(nslots <= SLRU_MAX_ALLOWED_BUFFERS);
+
 	/* we assume nslots isn't so large as to risk overflow */
 	sz = MAXALIGN(sizeof(SlruSharedData));
 	sz += MAXALIGN(nslots * sizeof(char *));	/* page_buffer[] */
@@ -153,7 +167,9 @@ SimpleLruShmemSize(int nslots, int nlsns)
 	sz += MAXALIGN(nslots * sizeof(bool));	/* page_dirty[] */
 	sz += MAXALIGN(nslots * sizeof(int));	/* page_number[] */
 	sz += MAXALIGN(nslots * sizeof(int));	/* page_lru_count[] */
+	sz += MAXALIGN(nbanks * sizeof(int));	/* bank_cur_lru_count[] */
 	sz += MAXALIGN(nslots * sizeof(LWLockPadded));	/* buffer_locks[] */
+	sz += MAXALIGN(nbanks * sizeof(LWLockPadded));	/* bank_locks[] */
 
 	if (nlsns > 0)
 		sz += MAXALIGN(nslots * nlsns * sizeof(XLogRecPtr));	/* group_lsn[] */
@@ -161,12 +177,55 @@ SimpleLruShmemSize(int nslots, int nlsns)
 	return BUFFERALIGN(sz) + BLCKSZ * nslots;
 }
 
+/*
+ * Determine a number of SLRU buffers to use, for SLRUs whose size GUC is set
+ * to 0 ("auto").
+ *
+ * We scale the number with shared_buffers, dividing it by 'divisor', but keep
+ * it between one bank and 'max', and round it down to a whole number of
+ * banks.
+ */
+int
+SimpleLruAutotuneBuffers(int divisor, int max)
+{
+	int			nslots;
+
+	nslots = Min(max, NBuffers / divisor);
+	nslots -= nslots % SLRU_BANK_SIZE;
+
+	return Max(SLRU_BANK_SIZE, nslots);
+}
+
+/*
+ * GUC check hook for the SLRU size parameters.  The number of buffers must be
+ * a whole number of banks; 0 is accepted, meaning the caller will autotune.
+ */
+bool
+check_slru_buffers(const char *name, int *newval)
+{
+	if (*newval % SLRU_BANK_SIZE != 0)
+	{
+		GUC_check_errdetail("\"%s\" must be a multiple of %d.", name,
+							SLRU_BANK_SIZE);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Initialize, or attach to, the shared memory of an SLRU.
+ *
+ * 'tranche_id' is used for the per-buffer I/O locks, which are registered
+ * under the SLRU's name, and 'bank_tranche_id' for the bank locks, whose
+ * tranche the caller registers.
+ */
 void
 SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
-			  LWLock *ctllock, const char *subdir, int tranche_id)
+			  const char *subdir, int tranche_id, int bank_tranche_id)
 {
 	SlruShared	shared;
 	bool		found;
+	int			nbanks = nslots / SLRU_BANK_SIZE;
 
 	shared = (SlruShared) ShmemInitStruct(name,
 										  SimpleLruShmemSize(nslots, nlsns),
@@ -178,19 +237,18 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		char	   *ptr;
 		Size		offset;
 		int			slotno;
+		int			bankno;
 
 		Assert(!found);
 
 		memset(shared, 0, sizeof(SlruSharedData));
 
-		shared->ControlLock = ctllock;
-
 		shared->num_slots = nslots;
+		shared->num_banks = nbanks;
 		shared->lsn_groups_per_page = nlsns;
 
-		shared->cur_lru_count = 0;
-
 		/* shared->latest_page_number will be set later */
+		pg_atomic_init_u32(&shared->latest_page_number, 0);
 
 		ptr = (char *) shared;
 		offset = MAXALIGN(sizeof(SlruSharedData));
@@ -204,10 +262,14 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		offset += MAXALIGN(nslots * sizeof(int));
 		shared->page_lru_count = (int *) (ptr + offset);
 		offset += MAXALIGN(nslots * sizeof(int));
+		shared->bank_cur_lru_count = (int *) (ptr + offset);
+		offset += MAXALIGN(nbanks * sizeof(int));
 
 		/* Initialize LWLocks */
 		shared->buffer_locks = (LWLockPadded *) (ptr + offset);
 		offset += MAXALIGN(nslots * sizeof(LWLockPadded));
+		shared->bank_locks = (LWLockPadded *) (ptr + offset);
+		offset += MAXALIGN(nbanks * sizeof(LWLockPadded));
 
 		if (nlsns > 0)
 		{
@@ -232,6 +294,13 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 			ptr += BLCKSZ;
 		}
 
+		for (bankno = 0; bankno < nbanks; bankno++)
+		{
+			LWLockInitialize(&shared->bank_locks[bankno].lock,
+							 bank_tranche_id);
+			shared->bank_cur_lru_count[bankno] = 0;
+		}
+
 		/* Should fit to estimated shmem size */
 		Assert(ptr - (char *) shared <= SimpleLruShmemSize(nslots, nlsns));
 	}
@@ -247,6 +316,7 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 	 * assume caller set PagePrecedes.
 	 */
 	ctl->shared = shared;
+	ctl->num_banks = shared->num_banks;
 	ctl->do_fsync = true;		/* default behavior */
 	StrNCpy(ctl->Dir, subdir, sizeof(ctl->Dir));
 }
@@ -257,7 +327,7 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
  * The page is not actually written, just set up in shared memory.
  * The slot number of the new page is returned.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Bank lock of the page must be held at entry, and will be held at exit.
  */
 int
 SimpleLruZeroPage(SlruCtl ctl, int pageno)
@@ -285,11 +355,23 @@ SimpleLruZeroPage(SlruCtl ctl, int pageno)
 	SimpleLruZeroLSNs(ctl, slotno);
 
 	/* Assume this page is now the latest active page */
-	shared->latest_page_number = pageno;
+	SimpleLruSetLatestPage(ctl, pageno);
 
 	return slotno;
 }
 
+/*
+ * Set the page number of the current end of the log.
+ *
+ * This is done by SimpleLruZeroPage(), but callers also use it to establish
+ * the latest page at startup, and during recovery.  No lock is required.
+ */
+void
+SimpleLruSetLatestPage(SlruCtl ctl, int pageno)
+{
+	pg_atomic_write_u32(&ctl->shared->latest_page_number, (uint32) pageno);
+}
+
 /*
  * Zero all the LSNs we store for this slru page.
  *
@@ -315,18 +397,19 @@ SimpleLruZeroLSNs(SlruCtl ctl, int slotno)
  * guarantee that new I/O hasn't been started before we return, though.
  * In fact the slot might not even contain the same page anymore.)
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Bank lock of the slot must be held at entry, and will be held at exit.
  */
 static void
 SimpleLruWaitIO(SlruCtl ctl, int slotno)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *banklock = SimpleLruGetSlotBankLock(ctl, slotno);
 
 	/* See notes at top of file */
-	LWLockRelease(shared->ControlLock);
+	LWLockRelease(banklock);
 	LWLockAcquire(&shared->buffer_locks[slotno].lock, LW_SHARED);
 	LWLockRelease(&shared->buffer_locks[slotno].lock);
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 	/*
 	 * If the slot is still in an io-in-progress state, then either someone
@@ -369,13 +452,16 @@ SimpleLruWaitIO(SlruCtl ctl, int slotno)
  * Return value is the shared-buffer slot number now holding the page.
  * The buffer's LRU access info is updated.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Bank lock of the page must be held at entry, and will be held at exit.
  */
 int
 SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 				  TransactionId xid)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *banklock = SimpleLruGetBankLock(ctl, pageno);
+
+	Assert(LWLockHeldByMeInMode(banklock, LW_EXCLUSIVE));
 
 	/* Outer loop handles restart if we must wait for someone else's I/O */
 	for (;;)
@@ -420,8 +506,8 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 		/* Acquire per-buffer lock (cannot deadlock, see notes at top) */
 		LWLockAcquire(&shared->buffer_locks[slotno].lock, LW_EXCLUSIVE);
 
-		/* Release control lock while doing I/O */
-		LWLockRelease(shared->ControlLock);
+		/* Release bank lock while doing I/O */
+		LWLockRelease(banklock);
 
 		/* Do the read */
 		ok = SlruPhysicalReadPage(ctl, pageno, slotno);
@@ -429,8 +515,8 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 		/* Set the LSNs for this newly read-in page to zero */
 		SimpleLruZeroLSNs(ctl, slotno);
 
-		/* Re-acquire control lock and update page state */
-		LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+		/* Re-acquire bank lock and update page state */
+		LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 		Assert(shared->page_number[slotno] == pageno &&
 			   shared->page_status[slotno] == SLRU_PAGE_READ_IN_PROGRESS &&
@@ -460,20 +546,23 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
  * Return value is the shared-buffer slot number now holding the page.
  * The buffer's LRU access info is updated.
  *
- * Control lock must NOT be held at entry, but will be held at exit.
+ * Bank lock of the page must NOT be held at entry, but will be held at exit.
  * It is unspecified whether the lock will be shared or exclusive.
  */
 int
 SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *banklock = SimpleLruGetBankLock(ctl, pageno);
+	int			bankstart = SimpleLruGetBankNo(ctl, pageno) * SLRU_BANK_SIZE;
+	int			bankend = bankstart + SLRU_BANK_SIZE;
 	int			slotno;
 
 	/* Try to find the page while holding only shared lock */
-	LWLockAcquire(shared->ControlLock, LW_SHARED);
+	LWLockAcquire(banklock, LW_SHARED);
 
 	/* See if page is already in a buffer */
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	for (slotno = bankstart; slotno < bankend; slotno++)
 	{
 		if (shared->page_number[slotno] == pageno &&
 			shared->page_status[slotno] != SLRU_PAGE_EMPTY &&
@@ -486,8 +575,8 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 	}
 
 	/* No luck, so switch to normal exclusive lock and do regular read */
-	LWLockRelease(shared->ControlLock);
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockRelease(banklock);
+	LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 	return SimpleLruReadPage(ctl, pageno, true, xid);
 }
@@ -501,12 +590,13 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
  * the write).  However, we *do* attempt a fresh write even if the page
  * is already being written; this is for checkpoints.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Bank lock of the slot must be held at entry, and will be held at exit.
  */
 static void
 SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *banklock = SimpleLruGetSlotBankLock(ctl, slotno);
 	int			pageno = shared->page_number[slotno];
 	bool		ok;
 
@@ -536,8 +626,8 @@ SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 	/* Acquire per-buffer lock (cannot deadlock, see notes at top) */
 	LWLockAcquire(&shared->buffer_locks[slotno].lock, LW_EXCLUSIVE);
 
-	/* Release control lock while doing I/O */
-	LWLockRelease(shared->ControlLock);
+	/* Release bank lock while doing I/O */
+	LWLockRelease(banklock);
 
 	/* Do the write */
 	ok = SlruPhysicalWritePage(ctl, pageno, slotno, fdata);
@@ -551,8 +641,8 @@ SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 			CloseTransientFile(fdata->fd[i]);
 	}
 
-	/* Re-acquire control lock and update page state */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	/* Re-acquire bank lock and update page state */
+	LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 	Assert(shared->page_number[slotno] == pageno &&
 		   shared->page_status[slotno] == SLRU_PAGE_WRITE_IN_PROGRESS);
@@ -964,20 +1054,24 @@ SlruReportIOError(SlruCtl ctl, int pageno, TransactionId xid)
  * any slot already holds the target page, and return that slot if so.
  * Thus, the returned slot is *either* a slot already holding the pageno
  * (could be any state except EMPTY), *or* a freeable slot (state EMPTY
- * or CLEAN).
+ * or CLEAN).  Either way, it is in the page's bank.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Bank lock of the page must be held at entry, and will be held at exit.
  */
 static int
 SlruSelectLRUPage(SlruCtl ctl, int pageno)
 {
 	SlruShared	shared = ctl->shared;
+	int			bankno = SimpleLruGetBankNo(ctl, pageno);
+	int			bankstart = bankno * SLRU_BANK_SIZE;
+	int			bankend = bankstart + SLRU_BANK_SIZE;
 
 	/* Outer loop handles restart after I/O */
 	for (;;)
 	{
 		int			slotno;
 		int			cur_count;
+		int			latest_page_number;
 		int			bestvalidslot = 0;	/* keep compiler quiet */
 		int			best_valid_delta = -1;
 		int			best_valid_page_number = 0; /* keep compiler quiet */
@@ -986,7 +1080,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		int			best_invalid_page_number = 0;	/* keep compiler quiet */
 
 		/* See if page already has a buffer assigned */
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			if (shared->page_number[slotno] == pageno &&
 				shared->page_status[slotno] != SLRU_PAGE_EMPTY)
@@ -1012,16 +1106,17 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		 * acquire the same lru_count values.  In that case we break ties by
 		 * choosing the furthest-back page.
 		 *
-		 * Notice that this next line forcibly advances cur_lru_count to a
-		 * value that is certainly beyond any value that will be in the
-		 * page_lru_count array after the loop finishes.  This ensures that
-		 * the next execution of SlruRecentlyUsed will mark the page newly
-		 * used, even if it's for a page that has the current counter value.
-		 * That gets us back on the path to having good data when there are
-		 * multiple pages with the same lru_count.
+		 * Notice that this next line forcibly advances the bank's lru count
+		 * to a value that is certainly beyond any value that will be in the
+		 * bank's page_lru_count entries after the loop finishes.  This
+		 * ensures that the next execution of SlruRecentlyUsed will mark the
+		 * page newly used, even if it's for a page that has the current
+		 * counter value.  That gets us back on the path to having good data
+		 * when there are multiple pages with the same lru_count.
 		 */
-		cur_count = (shared->cur_lru_count)++;
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		cur_count = (shared->bank_cur_lru_count[bankno])++;
+		latest_page_number = (int) pg_atomic_read_u32(&shared->latest_page_number);
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			int			this_delta;
 			int			this_page_number;
@@ -1042,7 +1137,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 				this_delta = 0;
 			}
 			this_page_number = shared->page_number[slotno];
-			if (this_page_number == shared->latest_page_number)
+			if (this_page_number == latest_page_number)
 				continue;
 			if (shared->page_status[slotno] == SLRU_PAGE_VALID)
 			{
@@ -1120,10 +1215,16 @@ SimpleLruFlush(SlruCtl ctl, bool allow_redirtied)
 	 */
 	fdata.num_files = 0;
 
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-
 	for (slotno = 0; slotno < shared->num_slots; slotno++)
 	{
+		/* Switch to the next bank's lock at each bank boundary */
+		if (slotno % SLRU_BANK_SIZE == 0)
+		{
+			if (slotno > 0)
+				LWLockRelease(SimpleLruGetSlotBankLock(ctl, slotno - 1));
+			LWLockAcquire(SimpleLruGetSlotBankLock(ctl, slotno), LW_EXCLUSIVE);
+		}
+
 		SlruInternalWritePage(ctl, slotno, &fdata);
 
 		/*
@@ -1137,7 +1238,7 @@ SimpleLruFlush(SlruCtl ctl, bool allow_redirtied)
 				!shared->page_dirty[slotno]));
 	}
 
-	LWLockRelease(shared->ControlLock);
+	LWLockRelease(SimpleLruGetSlotBankLock(ctl, shared->num_slots - 1));
 
 	/*
 	 * Now fsync and close any files that were open
@@ -1174,7 +1275,7 @@ void
 SimpleLruTruncate(SlruCtl ctl, int cutoffPage)
 {
 	SlruShared	shared = ctl->shared;
-	int			slotno;
+	int			bankno;
 
 	/*
 	 * The cutoff point is the start of the segment containing cutoffPage.
@@ -1182,63 +1283,70 @@ SimpleLruTruncate(SlruCtl ctl, int cutoffPage)
 	cutoffPage -= cutoffPage % SLRU_PAGES_PER_SEGMENT;
 
 	/*
-	 * Scan shared memory and remove any pages preceding the cutoff page, to
-	 * ensure we won't rewrite them later.  (Since this is normally called in
-	 * or just after a checkpoint, any dirty pages should have been flushed
-	 * already ... we're just being extra careful here.)
+	 * Make an important safety check: the planned cutoff point must be <= the
+	 * current endpoint page. Otherwise we have already wrapped around, and
+	 * proceeding with the truncation would risk removing the current segment.
 	 */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-
-restart:;
-
-	/*
-	 * While we are holding the lock, make an important safety check: the
-	 * planned cutoff point must be <= the current endpoint page. Otherwise we
-	 * have already wrapped around, and proceeding with the truncation would
-	 * risk removing the current segment.
-	 */
-	if (ctl->PagePrecedes(shared->latest_page_number, cutoffPage))
+	if (ctl->PagePrecedes((int) pg_atomic_read_u32(&shared->latest_page_number),
+						  cutoffPage))
 	{
-		LWLockRelease(shared->ControlLock);
 		ereport(LOG,
 				(errmsg("could not truncate directory \"%s\": apparent wraparound",
 						ctl->Dir)));
 		return;
 	}
 
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	/*
+	 * Scan shared memory and remove any pages preceding the cutoff page, to
+	 * ensure we won't rewrite them later.  (Since this is normally called in
+	 * or just after a checkpoint, any dirty pages should have been flushed
+	 * already ... we're just being extra careful here.)  We do this one bank
+	 * at a time.
+	 */
+	for (bankno = 0; bankno < shared->num_banks; bankno++)
 	{
-		if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
-			continue;
-		if (!ctl->PagePrecedes(shared->page_number[slotno], cutoffPage))
-			continue;
+		LWLock	   *banklock = &shared->bank_locks[bankno].lock;
+		int			bankstart = bankno * SLRU_BANK_SIZE;
+		int			bankend = bankstart + SLRU_BANK_SIZE;
+		int			slotno;
 
-		/*
-		 * If page is clean, just change state to EMPTY (expected case).
-		 */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
-			!shared->page_dirty[slotno])
+		LWLockAcquire(banklock, LW_EXCLUSIVE);
+
+restart:
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
-			shared->page_status[slotno] = SLRU_PAGE_EMPTY;
-			continue;
+			if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
+				continue;
+			if (!ctl->PagePrecedes(shared->page_number[slotno], cutoffPage))
+				continue;
+
+			/*
+			 * If page is clean, just change state to EMPTY (expected case).
+			 */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
+				!shared->page_dirty[slotno])
+			{
+				shared->page_status[slotno] = SLRU_PAGE_EMPTY;
+				continue;
+			}
+
+			/*
+			 * Hmm, we have (or may have) I/O operations acting on the page,
+			 * so we've got to wait for them to finish and then start again.
+			 * This is the same logic as in SlruSelectLRUPage.  (XXX if page
+			 * is dirty, wouldn't it be OK to just discard it without writing
+			 * it?  For now, keep the logic the same as it was.)
+			 */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID)
+				SlruInternalWritePage(ctl, slotno, NULL);
+			else
+				SimpleLruWaitIO(ctl, slotno);
+			goto restart;
 		}
 
-		/*
-		 * Hmm, we have (or may have) I/O operations acting on the page, so
-		 * we've got to wait for them to finish and then start again. This is
-		 * the same logic as in SlruSelectLRUPage.  (XXX if page is dirty,
-		 * wouldn't it be OK to just discard it without writing it?  For now,
-		 * keep the logic the same as it was.)
-		 */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID)
-			SlruInternalWritePage(ctl, slotno, NULL);
-		else
-			SimpleLruWaitIO(ctl, slotno);
-		goto restart;
+		LWLockRelease(banklock);
 	}
 
-	LWLockRelease(shared->ControlLock);
-
 	/* Now we can remove the old segment(s) */
 	(void) SlruScanDirectory(ctl, SlruScanDirCbDeleteCutoff, &cutoffPage);
 }
@@ -1267,55 +1375,67 @@ void
 SlruDeleteSegment(SlruCtl ctl, int segno)
 {
 	SlruShared	shared = ctl->shared;
-	int			slotno;
+	int			bankno;
 	char		path[MAXPGPATH];
-	bool		did_write;
 
-	/* Clean out any possibly existing references to the segment. */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-restart:
-	did_write = false;
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	/*
+	 * Clean out any possibly existing references to the segment, one bank at
+	 * a time.  We hold each bank's lock until the file has been unlinked, so
+	 * that no one can read a page of it back in before it's gone.
+	 */
+	for (bankno = 0; bankno < shared->num_banks; bankno++)
 	{
-		int			pagesegno = shared->page_number[slotno] / SLRU_PAGES_PER_SEGMENT;
+		int			bankstart = bankno * SLRU_BANK_SIZE;
+		int			bankend = bankstart + SLRU_BANK_SIZE;
+		int			slotno;
+		bool		did_write;
 
-		if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
-			continue;
+		LWLockAcquire(&shared->bank_locks[bankno].lock, LW_EXCLUSIVE);
+restart:
+		did_write = false;
+		for (slotno = bankstart; slotno < bankend; slotno++)
+		{
+			int			pagesegno = shared->page_number[slotno] / SLRU_PAGES_PER_SEGMENT;
 
-		/* not the segment we're looking for */
-		if (pagesegno != segno)
-			continue;
+			if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
+				continue;
 
-		/* If page is clean, just change state to EMPTY (expected case). */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
-			!shared->page_dirty[slotno])
-		{
-			shared->page_status[slotno] = SLRU_PAGE_EMPTY;
-			continue;
-		}
+			/* not the segment we're looking for */
+			if (pagesegno != segno)
+				continue;
 
-		/* Same logic as SimpleLruTruncate() */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID)
-			SlruInternalWritePage(ctl, slotno, NULL);
-		else
-			SimpleLruWaitIO(ctl, slotno);
+			/* If page is clean, just change state to EMPTY (expected case). */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
+				!shared->page_dirty[slotno])
+			{
+				shared->page_status[slotno] = SLRU_PAGE_EMPTY;
+				continue;
+			}
 
-		did_write = true;
-	}
+			/* Same logic as SimpleLruTruncate() */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID)
+				SlruInternalWritePage(ctl, slotno, NULL);
+			else
+				SimpleLruWaitIO(ctl, slotno);
 
-	/*
-	 * Be extra careful and re-check. The IO functions release the control
-	 * lock, so new pages could have been read in.
-	 */
-	if (did_write)
-		goto restart;
+			did_write = true;
+		}
+
+		/*
+		 * Be extra careful and re-check. The IO functions release the bank
+		 * lock, so new pages could have been read in.
+		 */
+		if (did_write)
+			goto restart;
+	}
 
 	snprintf(path, MAXPGPATH, "%s/%04X", ctl->Dir, segno);
 	ereport(DEBUG2,
 			(errmsg("removing file \"%s\"", path)));
 	unlink(path);
 
-	LWLockRelease(shared->ControlLock);
+	for (bankno = 0; bankno < shared->num_banks; bankno++)
+		LWLockRelease(&shared->bank_locks[bankno].lock);
 }
 
 /*
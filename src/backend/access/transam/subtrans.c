@@ -31,6 +31,8 @@
 #include "access/slru.h"
 #include "access/subtrans.h"
 #include "access/transam.h"
+#include "access/xlog.h"
+#include "miscadmin.h"
 #include "pg_trace.h"
 #include "utils/snapmgr.h"
 
@@ -62,6 +64,31 @@ static SlruCtlData SubTransCtlData;
 
 #define SubTransCtl  (&SubTransCtlData)
 
+/*
+ * Backend-local cache of SubTransGetTopmostTransaction() results.
+ *
+ * When some backend's subxid cache overflows, every snapshot that sees it has
+ * to resolve the XIDs of that transaction through pg_subtrans, and the same
+ * handful of XIDs tend to be looked up over and over while scanning the rows
+ * they wrote.  The answer only depends on the XID and on TransactionXmin,
+ * because a subtransaction's parent never changes once it has been recorded,
+ * so we remember recent answers in a small direct-mapped cache that is reset
+ * whenever TransactionXmin moves.
+ *
+ * During recovery, a parent link may be recorded only after the standby has
+ * already seen the child XID, so nothing is cached then.
+ */
+#define SUBTRANS_TOPMOST_CACHE_SIZE 256
+
+typedef struct SubTransTopmostCacheEntry
+{
+	TransactionId xid;
+	TransactionId topmostXid;
+} SubTransTopmostCacheEntry;
+
+static SubTransTopmostCacheEntry topmostCache[SUBTRANS_TOPMOST_CACHE_SIZE];
+static TransactionId topmostCacheXmin = InvalidTransactionId;
+
 
 static int	ZeroSUBTRANSPage(int pageno);
 static bool SubTransPagePrecedes(int page1, int page2);
@@ -78,10 +105,13 @@ SubTransSetParent(TransactionId xid, TransactionId parent)
 	int			slotno;
 	TransactionId *ptr;
 
+	LWLock	   *lock;
+
 	Assert(TransactionIdIsValid(parent));
 	Assert(TransactionIdFollows(xid, parent));
 
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
+	lock = SimpleLruGetBankLock(SubTransCtl, pageno);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	slotno = SimpleLruReadPage(SubTransCtl, pageno, true, xid);
 	ptr = (TransactionId *) SubTransCtl->shared->page_buffer[slotno];
@@ -99,7 +129,7 @@ SubTransSetParent(TransactionId xid, TransactionId parent)
 		SubTransCtl->shared->page_dirty[slotno] = true;
 	}
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(lock);
 }
 
 /*
@@ -129,7 +159,7 @@ SubTransGetParent(TransactionId xid)
 
 	parent = *ptr;
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(SimpleLruGetBankLock(SubTransCtl, pageno));
 
 	return parent;
 }
@@ -151,10 +181,22 @@ SubTransGetTopmostTransaction(TransactionId xid)
 {
 	TransactionId parentXid = xid,
 				previousXid = xid;
+	SubTransTopmostCacheEntry *entry;
 
 	/* Can't ask about stuff that might not be around anymore */
 	Assert(TransactionIdFollowsOrEquals(xid, TransactionXmin));
 
+	/* Answers computed against a different TransactionXmin may differ */
+	if (!TransactionIdEquals(topmostCacheXmin, TransactionXmin))
+	{
+		MemSet(topmostCache, 0, sizeof(topmostCache));
+		topmostCacheXmin = TransactionXmin;
+	}
+
+	entry = &topmostCache[xid % SUBTRANS_TOPMOST_CACHE_SIZE];
+	if (TransactionIdEquals(entry->xid, xid))
+		return entry->topmostXid;
+
 	while (TransactionIdIsValid(parentXid))
 	{
 		previousXid = parentXid;
@@ -174,26 +216,48 @@ SubTransGetTopmostTransaction(TransactionId xid)
 
 	Assert(TransactionIdIsValid(previousXid));
 
+	if (!RecoveryInProgress())
+	{
+		entry->xid = xid;
+		entry->topmostXid = previousXid;
+	}
+
 	return previousXid;
 }
 
 
+/*
+ * Number of shared SUBTRANS buffers.
+ *
+ * If subtransaction_buffers is 0, this scales with shared_buffers the same
+ * way as the CLOG does; see CLOGShmemBuffers().
+ */
+static int
+SUBTRANSShmemBuffers(void)
+{
+	if (subtransaction_buffers == 0)
+		return SimpleLruAutotuneBuffers(512, 1024);
+
+	return Min(Max(SLRU_BANK_SIZE, subtransaction_buffers),
+			   SLRU_MAX_ALLOWED_BUFFERS);
+}
+
 /*
  * Initialization of shared memory for SUBTRANS
  */
 Size
 SUBTRANSShmemSize(void)
 {
-	return SimpleLruShmemSize(NUM_SUBTRANS_BUFFERS, 0);
+	return SimpleLruShmemSize(SUBTRANSShmemBuffers(), 0);
 }
 
 void
 SUBTRANSShmemInit(void)
 {
 	SubTransCtl->PagePrecedes = SubTransPagePrecedes;
-	SimpleLruInit(SubTransCtl, "subtrans", NUM_SUBTRANS_BUFFERS, 0,
-				  SubtransControlLock, "pg_subtrans",
-				  LWTRANCHE_SUBTRANS_BUFFERS);
+	SimpleLruInit(SubTransCtl, "subtrans", SUBTRANSShmemBuffers(), 0,
+				  "pg_subtrans", LWTRANCHE_SUBTRANS_BUFFERS,
+				  LWTRANCHE_SUBTRANS_SLRU);
 	/* Override default assumption that writes should be fsync'd */
 	SubTransCtl->do_fsync = false;
 }
@@ -212,8 +276,9 @@ void
 BootStrapSUBTRANS(void)
 {
 	int			slotno;
+	LWLock	   *lock = SimpleLruGetBankLock(SubTransCtl, 0);
 
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	/* Create and zero the first page of the subtrans log */
 	slotno = ZeroSUBTRANSPage(0);
@@ -222,7 +287,7 @@ BootStrapSUBTRANS(void)
 	SimpleLruWritePage(SubTransCtl, slotno);
 	Assert(!SubTransCtl->shared->page_dirty[slotno]);
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(lock);
 }
 
 /*
@@ -231,7 +296,7 @@ BootStrapSUBTRANS(void)
  * The page is not actually written, just set up in shared memory.
  * The slot number of the new page is returned.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Bank lock of the page must be held at entry, and will be held at exit.
  */
 static int
 ZeroSUBTRANSPage(int pageno)
@@ -251,6 +316,8 @@ StartupSUBTRANS(TransactionId oldestActiveXID)
 {
 	int			startPage;
 	int			endPage;
+	LWLock	   *prevlock = NULL;
+	LWLock	   *lock;
 
 	/*
 	 * Since we don't expect pg_subtrans to be valid across crashes, we
@@ -258,22 +325,32 @@ StartupSUBTRANS(TransactionId oldestActiveXID)
 	 * Whenever we advance into a new page, ExtendSUBTRANS will likewise zero
 	 * the new page without regard to whatever was previously on disk.
 	 */
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
-
 	startPage = TransactionIdToPage(oldestActiveXID);
 	endPage = TransactionIdToPage(ShmemVariableCache->nextXid);
 
-	while (startPage != endPage)
+	for (;;)
 	{
+		/* Consecutive pages are in different banks; switch locks as needed */
+		lock = SimpleLruGetBankLock(SubTransCtl, startPage);
+		if (prevlock != lock)
+		{
+			if (prevlock)
+				LWLockRelease(prevlock);
+			LWLockAcquire(lock, LW_EXCLUSIVE);
+			prevlock = lock;
+		}
+
 		(void) ZeroSUBTRANSPage(startPage);
+		if (startPage == endPage)
+			break;
+
 		startPage++;
 		/* must account for wraparound */
 		if (startPage > TransactionIdToPage(MaxTransactionId))
 			startPage = 0;
 	}
-	(void) ZeroSUBTRANSPage(startPage);
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(lock);
 }
 
 /*
@@ -335,12 +412,12 @@ ExtendSUBTRANS(TransactionId newestXact)
 
 	pageno = TransactionIdToPage(newestXact);
 
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(SimpleLruGetBankLock(SubTransCtl, pageno), LW_EXCLUSIVE);
 
 	/* Zero the page */
 	ZeroSUBTRANSPage(pageno);
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(SimpleLruGetBankLock(SubTransCtl, pageno));
 }
 
 
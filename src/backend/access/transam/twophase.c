@@ -448,6 +448,8 @@ MarkAsPreparingGuts(GlobalTransaction gxact, TransactionId xid, const char *gid,
 {
 	PGPROC	   *proc;
 	PGXACT	   *pgxact;
+	uint64	   *fpLockBits;
+	Oid		   *fpRelId;
 	int			i;
 
 	Assert(LWLockHeldByMeInMode(TwoPhaseStateLock, LW_EXCLUSIVE));
@@ -456,9 +458,16 @@ MarkAsPreparingGuts(GlobalTransaction gxact, TransactionId xid, const char *gid,
 	proc = &ProcGlobal->allProcs[gxact->pgprocno];
 	pgxact = &ProcGlobal->allPgXact[gxact->pgprocno];
 
-	/* Initialize the PGPROC entry */
+	/*
+	 * Initialize the PGPROC entry, keeping its fast-path lock arrays, which
+	 * are allocated separately by InitProcGlobal.
+	 */
+	fpLockBits = proc->fpLockBits;
+	fpRelId = proc->fpRelId;
 	MemSet(proc, 0, sizeof(PGPROC));
 	proc->pgprocno = gxact->pgprocno;
+	proc->fpLockBits = fpLockBits;
+	proc->fpRelId = fpRelId;
 	SHMQueueElemInit(&(proc->links));
 	proc->waitStatus = STATUS_OK;
 	/* We set up the gxact's VXID as InvalidBackendId/XID */
@@ -51,6 +51,7 @@
 #include "storage/lmgr.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
+#include "storage/read_stream.h"
 #include "utils/acl.h"
 #include "utils/attoptcache.h"
 #include "utils/builtins.h"
@@ -97,6 +98,8 @@ static VacAttrStats *examine_attribute(Relation onerel, int attnum,
 static int acquire_sample_rows(Relation onerel, int elevel,
 					HeapTuple *rows, int targrows,
 					double *totalrows, double *totaldeadrows);
+static BlockNumber acquire_sample_rows_next_block(ReadStream *stream,
+							   void *callback_private_data);
 static int	compare_rows(const void *a, const void *b);
 static int acquire_inherited_sample_rows(Relation onerel, int elevel,
 							  HeapTuple *rows, int targrows,
@@ -1014,6 +1017,8 @@ acquire_sample_rows(Relation onerel, int elevel,
 	TransactionId OldestXmin;
 	BlockSamplerData bs;
 	ReservoirStateData rstate;
+	ReadStream *stream;
+	Buffer		targbuffer;
 
 	Assert(targrows > 0);
 
@@ -1027,11 +1032,18 @@ acquire_sample_rows(Relation onerel, int elevel,
 	/* Prepare for sampling rows */
 	reservoir_init_selection_state(&rstate, targrows);
 
+	/*
+	 * Read the sampled blocks through a read stream, so that reads of
+	 * neighboring blocks get combined.  That matters mostly for small tables,
+	 * where we sample most or all of the blocks.
+	 */
+	stream = read_stream_begin_relation(onerel, MAIN_FORKNUM, vac_strategy,
+										acquire_sample_rows_next_block, &bs);
+
 	/* Outer loop over blocks to sample */
-	while (BlockSampler_HasMore(&bs))
+	while ((targbuffer = read_stream_next_buffer(stream)) != InvalidBuffer)
 	{
-		BlockNumber targblock = BlockSampler_Next(&bs);
-		Buffer		targbuffer;
+		BlockNumber targblock = BufferGetBlockNumber(targbuffer);
 		Page		targpage;
 		OffsetNumber targoffset,
 					maxoffset;
@@ -1041,14 +1053,12 @@ acquire_sample_rows(Relation onerel, int elevel,
 		/*
 		 * We must maintain a pin on the target page's buffer to ensure that
 		 * the maxoffset value stays good (else concurrent VACUUM might delete
-		 * tuples out from under us).  Hence, pin the page until we are done
-		 * looking at it.  We also choose to hold sharelock on the buffer
-		 * throughout --- we could release and re-acquire sharelock for each
-		 * tuple, but since we aren't doing much work per tuple, the extra
-		 * lock traffic is probably better avoided.
+		 * tuples out from under us).  Hence, keep the page pinned until we
+		 * are done looking at it.  We also choose to hold sharelock on the
+		 * buffer throughout --- we could release and re-acquire sharelock for
+		 * each tuple, but since we aren't doing much work per tuple, the
+		 * extra lock traffic is probably better avoided.
 		 */
-		targbuffer = ReadBufferExtended(onerel, MAIN_FORKNUM, targblock,
-										RBM_NORMAL, vac_strategy);
 		LockBuffer(targbuffer, BUFFER_LOCK_SHARE);
 		targpage = BufferGetPage(targbuffer);
 		maxoffset = PageGetMaxOffsetNumber(targpage);
@@ -1214,6 +1224,8 @@ acquire_sample_rows(Relation onerel, int elevel,
 		UnlockReleaseBuffer(targbuffer);
 	}
 
+	read_stream_end(stream);
+
 	/*
 	 * If we didn't find as many tuples as we wanted then we're done. No sort
 	 * is needed, since they're already in order.
@@ -1258,6 +1270,21 @@ acquire_sample_rows(Relation onerel, int elevel,
 	return numrows;
 }
 
+/*
+ * Read stream callback for acquire_sample_rows: returns the blocks chosen by
+ * the block sampler, which come in ascending order.
+ */
+static BlockNumber
+acquire_sample_rows_next_block(ReadStream *stream, void *callback_private_data)
+{
+	BlockSampler bs = (BlockSampler) callback_private_data;
+
+	if (!BlockSampler_HasMore(bs))
+		return InvalidBlockNumber;
+
+	return BlockSampler_Next(bs);
+}
+
 /*
  * qsort comparator for sorting rows[] array
  */
@@ -24,8 +24,12 @@
  *	  All notification messages are placed in the queue and later read out
  *	  by listening backends.
  *
- *	  There is no central knowledge of which backend listens on which channel;
- *	  every backend has its own list of interesting channels.
+ *	  Every backend has its own list of interesting channels.  In addition,
+ *	  each listening backend advertises hash codes of the channels it listens
+ *	  on in its AsyncQueueControl entry (up to ASYNC_MAX_TRACKED_CHANNELS of
+ *	  them; a backend listening on more channels than that is treated as
+ *	  interested in everything).  The hash codes only serve to decide whom to
+ *	  wake up; a hash collision merely causes a useless wakeup.
  *
  *	  Although there is only one queue, notifications are treated as being
  *	  database-local; this is done by including the sender's database OID
@@ -73,10 +77,13 @@
  *	  Finally, after we are out of the transaction altogether, we check if
  *	  we need to signal listening backends.  In SignalBackends() we scan the
  *	  list of listening backends and send a PROCSIG_NOTIFY_INTERRUPT signal
- *	  to every listening backend (we don't know which backend is listening on
- *	  which channel so we must signal them all). We can exclude backends that
- *	  are already up to date, though.  We don't bother with a self-signal
- *	  either, but just process the queue directly.
+ *	  only to backends of our database that advertise interest in one of the
+ *	  channels we notified.  Other listeners that were idle at the position
+ *	  where our notifications start are simply moved past them, since they
+ *	  would have skipped them anyway; uninterested listeners are signaled
+ *	  only when they fall far enough behind to hold back queue truncation.
+ *	  We can exclude backends that are already up to date, too.  We don't
+ *	  bother with a self-signal either, but just process the queue directly.
  *
  * 5. Upon receipt of a PROCSIG_NOTIFY_INTERRUPT signal, the signal handler
  *	  sets the process's latch, which triggers the event to be processed
@@ -104,7 +111,7 @@
  * frontend during startup.)  The above design guarantees that notifies from
  * other backends will never be missed by ignoring self-notifies.
  *
- * The amount of shared memory used for notify management (NUM_ASYNC_BUFFERS)
+ * The amount of shared memory used for notify management (notify_buffers)
  * can be varied without affecting anything but performance.  The maximum
  * amount of notification data that can be queued at one time is determined
  * by slru.c's wraparound limit; see QUEUE_MAX_PAGE below.
@@ -135,6 +142,7 @@
 #include "storage/sinval.h"
 #include "tcop/tcopprot.h"
 #include "utils/builtins.h"
+#include "utils/hashutils.h"
 #include "utils/memutils.h"
 #include "utils/ps_status.h"
 #include "utils/snapmgr.h"
@@ -210,14 +218,30 @@ typedef struct QueuePosition
 	 (x).page != (y).page ? (x) : \
 	 (x).offset > (y).offset ? (x) : (y))
 
+/*
+ * Number of channel hash codes a listening backend advertises in shared
+ * memory.  A backend listening on more channels sets nchannels to -1 and is
+ * woken for every notification in its database.
+ */
+#define ASYNC_MAX_TRACKED_CHANNELS	16
+
 /*
  * Struct describing a listening backend's status
+ *
+ * "advancing" is set while the backend is reading the queue on its own.  A
+ * notifying backend may move the pos of an uninterested listener past its
+ * own notifications, but only if the listener is not advancing; otherwise
+ * the listener would overwrite the new position with an older one when it
+ * finishes.
  */
 typedef struct QueueBackendStatus
 {
 	int32		pid;			/* either a PID or InvalidPid */
 	Oid			dboid;			/* backend's database OID, or InvalidOid */
 	QueuePosition pos;			/* backend has read queue up to here */
+	bool		advancing;		/* backend is reading the queue */
+	int			nchannels;		/* # of valid channelHashes, or -1 */
+	uint32		channelHashes[ASYNC_MAX_TRACKED_CHANNELS];
 } QueueBackendStatus;
 
 /*
@@ -233,9 +257,9 @@ typedef struct QueueBackendStatus
  * When holding the lock in EXCLUSIVE mode, backends can inspect the entries
  * of other backends and also change the head and tail pointers.
  *
- * AsyncCtlLock is used as the control lock for the pg_notify SLRU buffers.
- * In order to avoid deadlocks, whenever we need both locks, we always first
- * get AsyncQueueLock and then AsyncCtlLock.
+ * The SLRU bank locks of AsyncCtl protect the pg_notify SLRU buffers; see
+ * slru.c.  In order to avoid deadlocks, whenever we need both locks, we
+ * always first get AsyncQueueLock and then a bank lock.
  *
  * Each backend uses the backend[] array entry with index equal to its
  * BackendId (which can range from 1 to MaxBackends).  We rely on this to make
@@ -258,6 +282,9 @@ static AsyncQueueControl *asyncQueueControl;
 #define QUEUE_BACKEND_PID(i)		(asyncQueueControl->backend[i].pid)
 #define QUEUE_BACKEND_DBOID(i)		(asyncQueueControl->backend[i].dboid)
 #define QUEUE_BACKEND_POS(i)		(asyncQueueControl->backend[i].pos)
+#define QUEUE_BACKEND_ADVANCING(i)	(asyncQueueControl->backend[i].advancing)
+#define QUEUE_BACKEND_NCHANNELS(i)	(asyncQueueControl->backend[i].nchannels)
+#define QUEUE_BACKEND_CHANNELS(i)	(asyncQueueControl->backend[i].channelHashes)
 
 /*
  * The SLRU buffer area through which we access the notification queue
@@ -268,6 +295,13 @@ static SlruCtlData AsyncCtlData;
 #define QUEUE_PAGESIZE				BLCKSZ
 #define QUEUE_FULL_WARN_INTERVAL	5000	/* warn at most once every 5s */
 
+/*
+ * A listener that is not interested in our notifications is signaled anyway
+ * once it lags this many pages behind the queue head, so that it advances
+ * its pointer and lets the queue tail move forward.
+ */
+#define QUEUE_CLEANUP_DELAY			4
+
 /*
  * slru.c currently assumes that all filenames are four characters of hex
  * digits. That means that we can use segments 0000 through FFFF.
@@ -365,6 +399,21 @@ static bool amRegisteredListener = false;
 /* has this backend sent notifications in the current transaction? */
 static bool backendHasSentNotifications = false;
 
+/*
+ * What SignalBackends() needs to know about the notifications we have queued
+ * since ProcessCompletedNotifies() last ran: hash codes of the notified
+ * channels (numNotifiedChannels is -1 if there were too many to track), and
+ * the queue range they occupy.  notifyRangeContiguous is false if other
+ * backends' entries may be interleaved with ours in that range, which can
+ * happen if several of our transactions commit before we go idle.
+ */
+static uint32 notifiedChannels[ASYNC_MAX_TRACKED_CHANNELS];
+static int	numNotifiedChannels = 0;
+static bool notifyRangeValid = false;
+static bool notifyRangeContiguous = false;
+static QueuePosition notifyRangeStart;
+static QueuePosition notifyRangeEnd;
+
 /* GUC parameter */
 bool		Trace_notify = false;
 
@@ -377,8 +426,12 @@ static void Exec_ListenCommit(const char *channel);
 static void Exec_UnlistenCommit(const char *channel);
 static void Exec_UnlistenAllCommit(void);
 static bool IsListeningOn(const char *channel);
+static int	AddChannelHash(uint32 *hashes, int nhashes, const char *channel);
+static void asyncQueuePublishChannels(bool includePending);
+static bool asyncQueueIsInterested(int backend);
 static void asyncQueueUnregister(void);
 static bool asyncQueueIsFull(void);
+static int	asyncQueuePageDiff(int p, int q);
 static bool asyncQueueAdvance(volatile QueuePosition *position, int entryLength);
 static void asyncQueueNotificationToEntry(Notification *n, AsyncQueueEntry *qe);
 static ListCell *asyncQueueAddEntries(ListCell *nextNotify);
@@ -430,7 +483,7 @@ AsyncShmemSize(void)
 	size = mul_size(MaxBackends + 1, sizeof(QueueBackendStatus));
 	size = add_size(size, offsetof(AsyncQueueControl, backend));
 
-	size = add_size(size, SimpleLruShmemSize(NUM_ASYNC_BUFFERS, 0));
+	size = add_size(size, SimpleLruShmemSize(notify_buffers, 0));
 
 	return size;
 }
@@ -444,6 +497,7 @@ AsyncShmemInit(void)
 	bool		found;
 	int			slotno;
 	Size		size;
+	LWLock	   *lock;
 
 	/*
 	 * Create or attach to the AsyncQueueControl structure.
@@ -471,6 +525,8 @@ AsyncShmemInit(void)
 			QUEUE_BACKEND_PID(i) = InvalidPid;
 			QUEUE_BACKEND_DBOID(i) = InvalidOid;
 			SET_QUEUE_POS(QUEUE_BACKEND_POS(i), 0, 0);
+			QUEUE_BACKEND_ADVANCING(i) = false;
+			QUEUE_BACKEND_NCHANNELS(i) = 0;
 		}
 	}
 
@@ -478,8 +534,8 @@ AsyncShmemInit(void)
 	 * Set up SLRU management of the pg_notify data.
 	 */
 	AsyncCtl->PagePrecedes = asyncQueuePagePrecedes;
-	SimpleLruInit(AsyncCtl, "async", NUM_ASYNC_BUFFERS, 0,
-				  AsyncCtlLock, "pg_notify", LWTRANCHE_ASYNC_BUFFERS);
+	SimpleLruInit(AsyncCtl, "async", notify_buffers, 0,
+				  "pg_notify", LWTRANCHE_ASYNC_BUFFERS, LWTRANCHE_ASYNC_SLRU);
 	/* Override default assumption that writes should be fsync'd */
 	AsyncCtl->do_fsync = false;
 
@@ -491,11 +547,12 @@ AsyncShmemInit(void)
 		(void) SlruScanDirectory(AsyncCtl, SlruScanDirCbDeleteAll, NULL);
 
 		/* Now initialize page zero to empty */
-		LWLockAcquire(AsyncCtlLock, LW_EXCLUSIVE);
+		lock = SimpleLruGetBankLock(AsyncCtl, QUEUE_POS_PAGE(QUEUE_HEAD));
+		LWLockAcquire(lock, LW_EXCLUSIVE);
 		slotno = SimpleLruZeroPage(AsyncCtl, QUEUE_POS_PAGE(QUEUE_HEAD));
 		/* This write is just to verify that pg_notify/ is writable */
 		SimpleLruWritePage(AsyncCtl, slotno);
-		LWLockRelease(AsyncCtlLock);
+		LWLockRelease(lock);
 	}
 }
 
@@ -678,6 +735,18 @@ Async_UnlistenAll(void)
 	queue_listen(LISTEN_UNLISTEN_ALL, "");
 }
 
+/*
+ * Async_IsListening
+ *
+ *		Is this backend listening on any channel?  Only meaningful outside
+ *		a transaction.
+ */
+bool
+Async_IsListening(void)
+{
+	return listenChannels != NIL || amRegisteredListener;
+}
+
 /*
  * SQL function: return a set of the channel names this backend is actively
  * listening to.
@@ -800,6 +869,15 @@ PreCommit_Notify(void)
 		}
 	}
 
+	/*
+	 * Advertise the channels we are about to listen on before our commit
+	 * becomes visible, so that notifying backends that commit after us will
+	 * know to wake us.  Channels of a LISTEN that ends up rolled back are
+	 * withdrawn again in AtAbort_Notify.
+	 */
+	if (pendingActions != NIL && amRegisteredListener)
+		asyncQueuePublishChannels(true);
+
 	/* Queue any pending notifies (must happen after the above) */
 	if (pendingNotifies)
 	{
@@ -832,6 +910,19 @@ PreCommit_Notify(void)
 		LockSharedObject(DatabaseRelationId, InvalidOid, 0,
 						 AccessExclusiveLock);
 
+		/*
+		 * Remember which channels we notify, for SignalBackends.  A backend
+		 * with many distinct channels is treated as notifying all of them.
+		 */
+		foreach(p, pendingNotifies)
+		{
+			Notification *n = (Notification *) lfirst(p);
+
+			numNotifiedChannels = AddChannelHash(notifiedChannels,
+												 numNotifiedChannels,
+												 n->channel);
+		}
+
 		/* Now push the notifications into the queue */
 		backendHasSentNotifications = true;
 
@@ -856,7 +947,25 @@ PreCommit_Notify(void)
 				ereport(ERROR,
 						(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
 						 errmsg("too many notifications in the NOTIFY queue")));
+
+			/*
+			 * Track the queue range our entries occupy.  While we hold the
+			 * heavyweight lock taken above nobody else can insert entries,
+			 * so within one transaction the range is always contiguous.
+			 */
+			if (nextNotify == list_head(pendingNotifies))
+			{
+				if (!notifyRangeValid)
+				{
+					notifyRangeStart = QUEUE_HEAD;
+					notifyRangeValid = true;
+					notifyRangeContiguous = true;
+				}
+				else if (!QUEUE_POS_EQUAL(QUEUE_HEAD, notifyRangeEnd))
+					notifyRangeContiguous = false;
+			}
 			nextNotify = asyncQueueAddEntries(nextNotify);
+			notifyRangeEnd = QUEUE_HEAD;
 			LWLockRelease(AsyncQueueLock);
 		}
 	}
@@ -906,6 +1015,8 @@ AtCommit_Notify(void)
 	/* If no longer listening to anything, get out of listener array */
 	if (amRegisteredListener && listenChannels == NIL)
 		asyncQueueUnregister();
+	else if (amRegisteredListener && pendingActions != NIL)
+		asyncQueuePublishChannels(false);
 
 	/* And clean up */
 	ClearPendingActionsAndNotifies();
@@ -978,6 +1089,8 @@ Exec_ListenPreCommit(void)
 	QUEUE_BACKEND_POS(MyBackendId) = max;
 	QUEUE_BACKEND_PID(MyBackendId) = MyProcPid;
 	QUEUE_BACKEND_DBOID(MyBackendId) = MyDatabaseId;
+	QUEUE_BACKEND_ADVANCING(MyBackendId) = false;
+	QUEUE_BACKEND_NCHANNELS(MyBackendId) = 0;
 	LWLockRelease(AsyncQueueLock);
 
 	/* Now we are listed in the global array, so remember we're listening */
@@ -1131,6 +1244,11 @@ ProcessCompletedNotifies(void)
 	/* Send signals to other backends */
 	signalled = SignalBackends();
 
+	/* SignalBackends is done with the description of what we queued */
+	numNotifiedChannels = 0;
+	notifyRangeValid = false;
+	notifyRangeContiguous = false;
+
 	if (listenChannels != NIL)
 	{
 		/* Read the queue ourselves, and send relevant stuff to the frontend */
@@ -1179,6 +1297,101 @@ IsListeningOn(const char *channel)
 	return false;
 }
 
+/*
+ * Add the hash code of a channel name to an array of distinct hash codes
+ * holding nhashes entries, and return the new number of entries.  If the
+ * array would exceed ASYNC_MAX_TRACKED_CHANNELS entries, return -1 instead,
+ * meaning "any channel"; once reached, that state sticks.
+ */
+static int
+AddChannelHash(uint32 *hashes, int nhashes, const char *channel)
+{
+	uint32		hash;
+	int			i;
+
+	if (nhashes < 0)
+		return -1;
+
+	hash = DatumGetUInt32(hash_any((const unsigned char *) channel,
+								   strlen(channel)));
+	for (i = 0; i < nhashes; i++)
+	{
+		if (hashes[i] == hash)
+			return nhashes;
+	}
+	if (nhashes >= ASYNC_MAX_TRACKED_CHANNELS)
+		return -1;
+	hashes[nhashes++] = hash;
+	return nhashes;
+}
+
+/*
+ * Advertise the channels we are listening on in our AsyncQueueControl entry,
+ * so that notifying backends can tell whether they need to wake us.
+ *
+ * If includePending is true, the channels of LISTEN actions pending in the
+ * current transaction are included too.  This must not fail, since it is
+ * also called after commit.
+ */
+static void
+asyncQueuePublishChannels(bool includePending)
+{
+	uint32		hashes[ASYNC_MAX_TRACKED_CHANNELS];
+	int			nhashes = 0;
+	ListCell   *p;
+
+	foreach(p, listenChannels)
+		nhashes = AddChannelHash(hashes, nhashes, (char *) lfirst(p));
+
+	if (includePending)
+	{
+		foreach(p, pendingActions)
+		{
+			ListenAction *actrec = (ListenAction *) lfirst(p);
+
+			if (actrec->action == LISTEN_LISTEN)
+				nhashes = AddChannelHash(hashes, nhashes, actrec->channel);
+		}
+	}
+
+	/* We may update our own entry while holding only shared lock */
+	LWLockAcquire(AsyncQueueLock, LW_SHARED);
+	QUEUE_BACKEND_NCHANNELS(MyBackendId) = nhashes;
+	if (nhashes > 0)
+		memcpy(QUEUE_BACKEND_CHANNELS(MyBackendId), hashes,
+			   nhashes * sizeof(uint32));
+	LWLockRelease(AsyncQueueLock);
+}
+
+/*
+ * Test whether the given listening backend may be interested in any of the
+ * channels we have notified since ProcessCompletedNotifies last ran.  This
+ * only looks at channels, not at the backend's database.
+ *
+ * Caller must hold exclusive AsyncQueueLock.
+ */
+static bool
+asyncQueueIsInterested(int backend)
+{
+	int			nchannels = QUEUE_BACKEND_NCHANNELS(backend);
+	uint32	   *channels = QUEUE_BACKEND_CHANNELS(backend);
+	int			i;
+	int			j;
+
+	if (nchannels < 0 || numNotifiedChannels < 0)
+		return true;
+
+	for (i = 0; i < numNotifiedChannels; i++)
+	{
+		for (j = 0; j < nchannels; j++)
+		{
+			if (channels[j] == notifiedChannels[i])
+				return true;
+		}
+	}
+	return false;
+}
+
 /*
  * Remove our entry from the listeners array when we are no longer listening
  * on any channel.  NB: must not fail if we're already not listening.
@@ -1200,6 +1413,7 @@ asyncQueueUnregister(void)
 	/* ... then mark it invalid */
 	QUEUE_BACKEND_PID(MyBackendId) = InvalidPid;
 	QUEUE_BACKEND_DBOID(MyBackendId) = InvalidOid;
+	QUEUE_BACKEND_NCHANNELS(MyBackendId) = 0;
 	LWLockRelease(AsyncQueueLock);
 
 	/* mark ourselves as no longer listed in the global array */
@@ -1241,6 +1455,20 @@ asyncQueueIsFull(void)
 	return asyncQueuePagePrecedes(nexthead, boundary);
 }
 
+/*
+ * Return the number of pages from page q forward to page p, taking
+ * wraparound into account.  p must not logically precede q.
+ */
+static int
+asyncQueuePageDiff(int p, int q)
+{
+	int			diff = p - q;
+
+	if (diff < 0)
+		diff += QUEUE_MAX_PAGE + 1;
+	return diff;
+}
+
 /*
  * Advance the QueuePosition to the next entry, assuming that the current
  * entry is of length entryLength.  If we jump to a new page the function
@@ -1315,8 +1543,8 @@ asyncQueueNotificationToEntry(Notification *n, AsyncQueueEntry *qe)
  * and return the first still-unwritten cell back.  Eventually we will return
  * NULL indicating all is done.
  *
- * We are holding AsyncQueueLock already from the caller and grab AsyncCtlLock
- * locally in this function.
+ * We are holding AsyncQueueLock already from the caller and grab the bank
+ * lock of the head page locally in this function.
  */
 static ListCell *
 asyncQueueAddEntries(ListCell *nextNotify)
@@ -1326,9 +1554,7 @@ asyncQueueAddEntries(ListCell *nextNotify)
 	int			pageno;
 	int			offset;
 	int			slotno;
-
-	/* We hold both AsyncQueueLock and AsyncCtlLock during this operation */
-	LWLockAcquire(AsyncCtlLock, LW_EXCLUSIVE);
+	LWLock	   *prevlock;
 
 	/*
 	 * We work with a local copy of QUEUE_HEAD, which we write back to shared
@@ -1343,8 +1569,13 @@ asyncQueueAddEntries(ListCell *nextNotify)
 	 */
 	queue_head = QUEUE_HEAD;
 
-	/* Fetch the current page */
+	/*
+	 * Fetch the current page.  We hold both AsyncQueueLock and the page's
+	 * bank lock during this operation.
+	 */
 	pageno = QUEUE_POS_PAGE(queue_head);
+	prevlock = SimpleLruGetBankLock(AsyncCtl, pageno);
+	LWLockAcquire(prevlock, LW_EXCLUSIVE);
 	slotno = SimpleLruReadPage(AsyncCtl, pageno, true, InvalidTransactionId);
 	/* Note we mark the page dirty before writing in it */
 	AsyncCtl->shared->page_dirty[slotno] = true;
@@ -1391,9 +1622,20 @@ asyncQueueAddEntries(ListCell *nextNotify)
 			 * idea of the head page is always the same as ours, which avoids
 			 * boundary problems in SimpleLruTruncate.  The test in
 			 * asyncQueueIsFull() ensured that there is room to create this
-			 * page without overrunning the queue.
+			 * page without overrunning the queue.  The next page may belong
+			 * to a different bank, in which case we switch bank locks.
 			 */
-			slotno = SimpleLruZeroPage(AsyncCtl, QUEUE_POS_PAGE(queue_head));
+			LWLock	   *lock;
+
+			pageno = QUEUE_POS_PAGE(queue_head);
+			lock = SimpleLruGetBankLock(AsyncCtl, pageno);
+			if (lock != prevlock)
+			{
+				LWLockRelease(prevlock);
+				LWLockAcquire(lock, LW_EXCLUSIVE);
+				prevlock = lock;
+			}
+			slotno = SimpleLruZeroPage(AsyncCtl, pageno);
 			/* And exit the loop */
 			break;
 		}
@@ -1402,7 +1644,7 @@ asyncQueueAddEntries(ListCell *nextNotify)
 	/* Success, so update the global QUEUE_HEAD */
 	QUEUE_HEAD = queue_head;
 
-	LWLockRelease(AsyncCtlLock);
+	LWLockRelease(prevlock);
 
 	return nextNotify;
 }
@@ -1510,6 +1752,13 @@ asyncQueueFillWarning(void)
  * the signaled backend has read the other notifications and ours in the same
  * step.
  *
+ * We only signal backends of our own database that advertise interest in one
+ * of the channels we notified.  A backend that would skip all of our
+ * notifications anyway is not woken: if it was idle exactly at the start of
+ * our entries, we move its pointer past them on its behalf, and otherwise we
+ * leave it alone unless it lags more than QUEUE_CLEANUP_DELAY pages behind
+ * the head, in which case it is signaled so that the tail can advance.
+ *
  * Since we know the BackendId and the Pid the signalling is quite cheap.
  */
 static bool
@@ -1521,6 +1770,8 @@ SignalBackends(void)
 	int			count;
 	int			i;
 	int32		pid;
+	int			advanced = 0;
+	bool		advanceTail = false;
 
 	/*
 	 * Identify all backends that are listening and not already up-to-date. We
@@ -1538,21 +1789,57 @@ SignalBackends(void)
 	LWLockAcquire(AsyncQueueLock, LW_EXCLUSIVE);
 	for (i = 1; i <= MaxBackends; i++)
 	{
+		QueuePosition pos;
+
 		pid = QUEUE_BACKEND_PID(i);
-		if (pid != InvalidPid && pid != MyProcPid)
-		{
-			QueuePosition pos = QUEUE_BACKEND_POS(i);
+		if (pid == InvalidPid || pid == MyProcPid)
+			continue;
 
-			if (!QUEUE_POS_EQUAL(pos, QUEUE_HEAD))
+		pos = QUEUE_BACKEND_POS(i);
+		if (QUEUE_POS_EQUAL(pos, QUEUE_HEAD))
+			continue;			/* already up-to-date */
+
+		if (QUEUE_BACKEND_DBOID(i) != MyDatabaseId ||
+			!asyncQueueIsInterested(i))
+		{
+			/*
+			 * The backend would skip our notifications.  If it is idle right
+			 * at their start, and nobody else's entries are mixed in with
+			 * ours, we can move it past them without waking it.
+			 */
+			if (notifyRangeContiguous &&
+				!QUEUE_BACKEND_ADVANCING(i) &&
+				QUEUE_POS_EQUAL(pos, notifyRangeStart))
 			{
-				pids[count] = pid;
-				ids[count] = i;
-				count++;
+				if (QUEUE_POS_EQUAL(pos, QUEUE_TAIL))
+					advanceTail = true;
+				pos = notifyRangeEnd;
+				QUEUE_BACKEND_POS(i) = pos;
+				advanced++;
+				if (QUEUE_POS_EQUAL(pos, QUEUE_HEAD))
+					continue;
 			}
+
+			/* Otherwise, wake it only if it is holding back the tail */
+			if (asyncQueuePageDiff(QUEUE_POS_PAGE(QUEUE_HEAD),
+								   QUEUE_POS_PAGE(pos)) < QUEUE_CLEANUP_DELAY)
+				continue;
 		}
+
+		pids[count] = pid;
+		ids[count] = i;
+		count++;
 	}
 	LWLockRelease(AsyncQueueLock);
 
+	if (Trace_notify)
+		elog(DEBUG1, "SignalBackends: %d to signal, %d advanced",
+			 count, advanced);
+
+	/* If we moved the laziest backend, try to advance the tail pointer */
+	if (advanceTail)
+		asyncQueueAdvanceTail();
+
 	/* Now send signals */
 	for (i = 0; i < count; i++)
 	{
@@ -1594,6 +1881,8 @@ AtAbort_Notify(void)
 	 */
 	if (amRegisteredListener && listenChannels == NIL)
 		asyncQueueUnregister();
+	else if (amRegisteredListener && pendingActions != NIL)
+		asyncQueuePublishChannels(false);
 
 	/* And clean up */
 	ClearPendingActionsAndNotifies();
@@ -1764,6 +2053,9 @@ asyncQueueReadAllNotifications(void)
 	Assert(MyProcPid == QUEUE_BACKEND_PID(MyBackendId));
 	pos = oldpos = QUEUE_BACKEND_POS(MyBackendId);
 	head = QUEUE_HEAD;
+	/* Keep notifying backends from moving our pointer while we read */
+	if (!QUEUE_POS_EQUAL(pos, head))
+		QUEUE_BACKEND_ADVANCING(MyBackendId) = true;
 	LWLockRelease(AsyncQueueLock);
 
 	if (QUEUE_POS_EQUAL(pos, head))
@@ -1822,7 +2114,7 @@ asyncQueueReadAllNotifications(void)
 
 			/*
 			 * We copy the data from SLRU into a local buffer, so as to avoid
-			 * holding the AsyncCtlLock while we are examining the entries and
+			 * holding the SLRU bank lock while we are examining the entries and
 			 * possibly transmitting them to our frontend.  Copy only the part
 			 * of the page we will actually inspect.
 			 */
@@ -1844,7 +2136,7 @@ asyncQueueReadAllNotifications(void)
 				   AsyncCtl->shared->page_buffer[slotno] + curoffset,
 				   copysize);
 			/* Release lock that we got from SimpleLruReadPage_ReadOnly() */
-			LWLockRelease(AsyncCtlLock);
+			LWLockRelease(SimpleLruGetBankLock(AsyncCtl, curpage));
 
 			/*
 			 * Process messages up to the stop position, end of page, or an
@@ -1871,6 +2163,7 @@ asyncQueueReadAllNotifications(void)
 		/* Update shared state */
 		LWLockAcquire(AsyncQueueLock, LW_SHARED);
 		QUEUE_BACKEND_POS(MyBackendId) = pos;
+		QUEUE_BACKEND_ADVANCING(MyBackendId) = false;
 		advanceTail = QUEUE_POS_EQUAL(oldpos, QUEUE_TAIL);
 		LWLockRelease(AsyncQueueLock);
 
@@ -1885,6 +2178,7 @@ asyncQueueReadAllNotifications(void)
 	/* Update shared state */
 	LWLockAcquire(AsyncQueueLock, LW_SHARED);
 	QUEUE_BACKEND_POS(MyBackendId) = pos;
+	QUEUE_BACKEND_ADVANCING(MyBackendId) = false;
 	advanceTail = QUEUE_POS_EQUAL(oldpos, QUEUE_TAIL);
 	LWLockRelease(AsyncQueueLock);
 
@@ -1902,7 +2196,7 @@ asyncQueueReadAllNotifications(void)
  *
  * The current page must have been fetched into page_buffer from shared
  * memory.  (We could access the page right in shared memory, but that
- * would imply holding the AsyncCtlLock throughout this routine.)
+ * would imply holding the SLRU bank lock throughout this routine.)
  *
  * We stop if we reach the "stop" position, or reach a notification from an
  * uncommitted transaction, or reach the end of the page.
@@ -2033,8 +2327,8 @@ asyncQueueAdvanceTail(void)
 	if (asyncQueuePagePrecedes(oldtailpage, boundary))
 	{
 		/*
-		 * SimpleLruTruncate() will ask for AsyncCtlLock but will also release
-		 * the lock again.
+		 * SimpleLruTruncate() will ask for the SLRU bank locks but will also
+		 * release them again.
 		 */
 		SimpleLruTruncate(AsyncCtl, newtailpage);
 	}
@@ -323,6 +323,11 @@ static void CopyFromInsertBatch(CopyState cstate, EState *estate,
 					BulkInsertState bistate,
 					int nBufferedTuples, HeapTuple *bufferedTuples,
 					uint64 firstBufferedLineNo);
+static void CopyFromForeignBufferTuple(EState *estate,
+						   ResultRelInfo *resultRelInfo,
+						   TupleTableSlot *slot);
+static uint64 CopyFromForeignInsertBatch(CopyState cstate, EState *estate,
+						   ResultRelInfo *resultRelInfo);
 static bool CopyReadLine(CopyState cstate);
 static bool CopyReadLineText(CopyState cstate);
 static int	CopyReadAttributesText(CopyState cstate);
@@ -2536,6 +2541,19 @@ CopyFrom(CopyState cstate)
 		resultRelInfo->ri_FdwRoutine->BeginForeignInsert(mtstate,
 														 resultRelInfo);
 
+	/*
+	 * If the FDW supports batch insert, find out how many rows it'd like to
+	 * receive at once.  Foreign partitions are set up the same way by
+	 * ExecInitRoutingInfo().
+	 */
+	if (resultRelInfo->ri_FdwRoutine != NULL &&
+		resultRelInfo->ri_FdwRoutine->GetForeignModifyBatchSize != NULL &&
+		resultRelInfo->ri_FdwRoutine->ExecForeignBatchInsert != NULL)
+		resultRelInfo->ri_BatchSize =
+			resultRelInfo->ri_FdwRoutine->GetForeignModifyBatchSize(resultRelInfo);
+	else
+		resultRelInfo->ri_BatchSize = 1;
+
 	/* Prepare to catch AFTER triggers. */
 	AfterTriggerBeginQuery();
 
@@ -2973,6 +2991,21 @@ CopyFrom(CopyState cstate)
 						MemoryContextReset(batchcontext);
 					}
 				}
+				else if (resultRelInfo->ri_FdwRoutine != NULL &&
+						 resultRelInfo->ri_BatchSize > 1)
+				{
+					/*
+					 * The FDW accepts rows in batches.  Send the batch once
+					 * it's full; rows are counted as processed only once the
+					 * FDW reports them inserted.
+					 */
+					if (resultRelInfo->ri_NumSlots == resultRelInfo->ri_BatchSize)
+						processed += CopyFromForeignInsertBatch(cstate, estate,
+																resultRelInfo);
+
+					CopyFromForeignBufferTuple(estate, resultRelInfo, slot);
+					continue;	/* next tuple please */
+				}
 				else
 				{
 					List	   *recheckIndexes = NIL;
@@ -3046,6 +3079,27 @@ CopyFrom(CopyState cstate)
 								firstBufferedLineNo);
 	}
 
+	/* Flush any rows still waiting to be sent to foreign tables */
+	if (proute)
+	{
+		ListCell   *lc;
+
+		foreach(lc, estate->es_tuple_routing_result_relations)
+		{
+			ResultRelInfo *partRelInfo = (ResultRelInfo *) lfirst(lc);
+
+			if (partRelInfo->ri_NumSlots > 0)
+			{
+				estate->es_result_relation_info = partRelInfo;
+				processed += CopyFromForeignInsertBatch(cstate, estate,
+														partRelInfo);
+			}
+		}
+	}
+	else if (target_resultRelInfo->ri_NumSlots > 0)
+		processed += CopyFromForeignInsertBatch(cstate, estate,
+												target_resultRelInfo);
+
 	/* Done, clean up */
 	error_context_stack = errcallback.previous;
 
@@ -3182,6 +3236,93 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
 	cstate->cur_lineno = save_cur_lineno;
 }
 
+/*
+ * A subroutine of CopyFrom, to remember a tuple destined for a foreign table
+ * whose FDW supports batch insert.  The tuple is copied into a slot owned by
+ * the result relation, so the caller may reuse the input slot right away.
+ */
+static void
+CopyFromForeignBufferTuple(EState *estate, ResultRelInfo *resultRelInfo,
+						   TupleTableSlot *slot)
+{
+	MemoryContext oldcontext;
+
+	Assert(resultRelInfo->ri_NumSlots < resultRelInfo->ri_BatchSize);
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	if (resultRelInfo->ri_Slots == NULL)
+		resultRelInfo->ri_Slots = palloc(sizeof(TupleTableSlot *) *
+										 resultRelInfo->ri_BatchSize);
+
+	/*
+	 * Slots are created as the batch grows and kept across batches.  Give
+	 * each its own copy of the tuple descriptor, so that we don't pile up
+	 * resource-owner references to one refcounted descriptor.
+	 */
+	if (resultRelInfo->ri_NumSlots >= resultRelInfo->ri_NumSlotsInitialized)
+	{
+		TupleDesc	tdesc = CreateTupleDescCopy(slot->tts_tupleDescriptor);
+
+		resultRelInfo->ri_Slots[resultRelInfo->ri_NumSlots] =
+			ExecInitExtraTupleSlot(estate, tdesc, slot->tts_ops);
+		resultRelInfo->ri_NumSlotsInitialized++;
+	}
+
+	ExecCopySlot(resultRelInfo->ri_Slots[resultRelInfo->ri_NumSlots], slot);
+	resultRelInfo->ri_NumSlots++;
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * A subroutine of CopyFrom, to send the tuples buffered for a foreign table
+ * to its FDW in one ExecForeignBatchInsert call, and run AFTER ROW INSERT
+ * triggers for the rows that were inserted.  Returns the number of rows the
+ * FDW reports as inserted.
+ */
+static uint64
+CopyFromForeignInsertBatch(CopyState cstate, EState *estate,
+						   ResultRelInfo *resultRelInfo)
+{
+	TupleTableSlot **rslots;
+	int			numInserted = resultRelInfo->ri_NumSlots;
+	bool		line_buf_valid = cstate->line_buf_valid;
+	int			i;
+
+	/*
+	 * The rows in the batch come from several input lines, so don't claim
+	 * any particular one in error context.
+	 */
+	cstate->line_buf_valid = false;
+
+	rslots = resultRelInfo->ri_FdwRoutine->ExecForeignBatchInsert(estate,
+																  resultRelInfo,
+																  resultRelInfo->ri_Slots,
+																  NULL,
+																  &numInserted);
+
+	for (i = 0; i < numInserted; i++)
+	{
+		TupleTableSlot *slot = rslots[i];
+
+		/*
+		 * AFTER ROW Triggers might reference the tableoid column, so
+		 * (re-)initialize tts_tableOid before evaluating them.
+		 */
+		slot->tts_tableOid = RelationGetRelid(resultRelInfo->ri_RelationDesc);
+
+		/* AFTER ROW INSERT Triggers */
+		ExecARInsertTriggers(estate, resultRelInfo, slot, NIL,
+							 cstate->transition_capture);
+	}
+
+	resultRelInfo->ri_NumSlots = 0;
+	cstate->line_buf_valid = line_buf_valid;
+
+	return numInserted;
+}
+
 /*
  * Setup to read tuples from a file for COPY FROM.
  *
@@ -58,8 +58,10 @@
 #include "storage/smgr.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/catcache.h"
 #include "utils/fmgroids.h"
 #include "utils/pg_locale.h"
+#include "utils/plancache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
@@ -929,6 +931,9 @@ dropdb(const char *dbname, bool missing_ok)
 	 * dirty buffer to the dead database later...
 	 */
 	DropDatabaseBuffers(db_id);
+	DropDatabaseRelationSizes(db_id);
+	SharedCatCacheFlushDatabase(db_id);
+	SharedPlanCacheFlushDatabase(db_id);
 
 	/*
 	 * Tell the stats collector to forget it immediately, too.
@@ -1206,6 +1211,7 @@ movedb(const char *dbname, const char *tblspcname)
 	 * src_tblspcoid, but bufmgr.c presently provides no API for that.
 	 */
 	DropDatabaseBuffers(db_id);
+	DropDatabaseRelationSizes(db_id);
 
 	/*
 	 * Check for existence of files in the target directory, i.e., objects of
@@ -2148,6 +2154,9 @@ dbase_redo(XLogReaderState *record)
 
 		/* Drop pages for this database that are in the shared buffer cache */
 		DropDatabaseBuffers(xlrec->db_id);
+		DropDatabaseRelationSizes(xlrec->db_id);
+		SharedCatCacheFlushDatabase(xlrec->db_id);
+		SharedPlanCacheFlushDatabase(xlrec->db_id);
 
 		/* Also, clean out any fsync requests that might be pending in md.c */
 		ForgetDatabaseFsyncRequests(xlrec->db_id);
@@ -584,6 +584,16 @@ DropPreparedStatement(const char *stmt_name, bool showError)
 	}
 }
 
+/*
+ * Are there any prepared statements?
+ */
+bool
+PreparedStatementsExist(void)
+{
+	return prepared_queries != NULL &&
+		hash_get_num_entries(prepared_queries) > 0;
+}
+
 /*
  * Drop all cached statements.
  */
@@ -1919,6 +1919,16 @@ seq_redo(XLogReaderState *record)
 	pfree(localpage);
 }
 
+/*
+ * Does this session hold any sequence state (as reported by currval() and
+ * lastval())?
+ */
+bool
+SequenceCachesExist(void)
+{
+	return seqhashtab != NULL && hash_get_num_entries(seqhashtab) > 0;
+}
+
 /*
  * Flush cached sequence information.
  */
@@ -59,6 +59,7 @@ static void *dense_alloc(HashJoinTable hashtable, Size size);
 static HashJoinTuple ExecParallelHashTupleAlloc(HashJoinTable hashtable,
 						   size_t size,
 						   dsa_pointer *shared);
+static int64 ExecHashBloomFilterElems(HashState *node);
 static void MultiExecPrivateHash(HashState *node);
 static void MultiExecParallelHash(HashState *node);
 static inline HashJoinTuple ExecParallelHashFirstTuple(HashJoinTable table,
@@ -143,6 +144,7 @@ MultiExecPrivateHash(HashState *node)
 	TupleTableSlot *slot;
 	ExprContext *econtext;
 	uint32		hashvalue;
+	bloom_filter *filter = NULL;
 
 	/*
 	 * get state info from node
@@ -156,6 +158,19 @@ MultiExecPrivateHash(HashState *node)
 	hashkeys = node->hashkeys;
 	econtext = node->ps.ps_ExprContext;
 
+	/*
+	 * If our parent wants a bloom filter, build it alongside the hash table.
+	 * It's not made visible until it's complete.
+	 */
+	if (node->build_bloom)
+	{
+		MemoryContext oldcxt = MemoryContextSwitchTo(hashtable->hashCxt);
+
+		filter = bloom_create(ExecHashBloomFilterElems(node),
+							  ExecHashBloomWorkMem(), 0);
+		MemoryContextSwitchTo(oldcxt);
+	}
+
 	/*
 	 * get all inner tuples and insert into the hash table (or temp files)
 	 */
@@ -172,6 +187,10 @@ MultiExecPrivateHash(HashState *node)
 		{
 			int			bucketNumber;
 
+			if (filter)
+				bloom_add_element(filter, (unsigned char *) &hashvalue,
+								  sizeof(hashvalue));
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -199,6 +218,7 @@ MultiExecPrivateHash(HashState *node)
 		hashtable->spacePeak = hashtable->spaceUsed;
 
 	hashtable->partialTuples = hashtable->totalTuples;
+	hashtable->bloomfilter = filter;
 }
 
 /* ----------------------------------------------------------------
@@ -220,6 +240,7 @@ MultiExecParallelHash(HashState *node)
 	ExprContext *econtext;
 	uint32		hashvalue;
 	Barrier    *build_barrier;
+	bloom_filter *filter = NULL;
 	int			i;
 
 	/*
@@ -276,6 +297,22 @@ MultiExecParallelHash(HashState *node)
 				ExecParallelHashIncreaseNumBuckets(hashtable);
 			ExecParallelHashEnsureBatchAccessors(hashtable);
 			ExecParallelHashTableSetCurrentBatch(hashtable, 0);
+
+			/*
+			 * If a bloom filter is wanted, each participant fills a private
+			 * one with the tuples it hashes, and merges it into the shared
+			 * one below.
+			 */
+			if (node->build_bloom)
+			{
+				MemoryContext oldcxt;
+
+				oldcxt = MemoryContextSwitchTo(hashtable->hashCxt);
+				filter = bloom_create(ExecHashBloomFilterElems(node),
+									  ExecHashBloomWorkMem(), 0);
+				MemoryContextSwitchTo(oldcxt);
+			}
+
 			for (;;)
 			{
 				slot = ExecProcNode(outerNode);
@@ -285,10 +322,26 @@ MultiExecParallelHash(HashState *node)
 				if (ExecHashGetHashValue(hashtable, econtext, hashkeys,
 										 false, hashtable->keepNulls,
 										 &hashvalue))
+				{
+					if (filter)
+						bloom_add_element(filter, (unsigned char *) &hashvalue,
+										  sizeof(hashvalue));
 					ExecParallelHashTableInsert(hashtable, slot, hashvalue);
+				}
 				hashtable->partialTuples++;
 			}
 
+			if (filter)
+			{
+				Assert(DsaPointerIsValid(pstate->bloomfilter));
+				LWLockAcquire(&pstate->lock, LW_EXCLUSIVE);
+				bloom_union(dsa_get_address(hashtable->area,
+											pstate->bloomfilter),
+							filter);
+				LWLockRelease(&pstate->lock);
+				bloom_free(filter);
+			}
+
 			/*
 			 * Make sure that any tuples we wrote to disk are visible to
 			 * others before anyone tries to load them.
@@ -333,6 +386,14 @@ MultiExecParallelHash(HashState *node)
 	hashtable->totalTuples = pstate->total_tuples;
 	ExecParallelHashEnsureBatchAccessors(hashtable);
 
+	/*
+	 * Everyone has merged their part of the bloom filter by now, so it's
+	 * safe to start probing it.
+	 */
+	if (DsaPointerIsValid(pstate->bloomfilter))
+		hashtable->bloomfilter = dsa_get_address(hashtable->area,
+												 pstate->bloomfilter);
+
 	/*
 	 * The next synchronization point is in ExecHashJoin's HJ_BUILD_HASHTABLE
 	 * case, which will bring the build phase to PHJ_BUILD_DONE (if it isn't
@@ -342,6 +403,72 @@ MultiExecParallelHash(HashState *node)
 		   BarrierPhase(build_barrier) == PHJ_BUILD_DONE);
 }
 
+/*
+ * Number of elements to size the bloom filter for.  We use the same row
+ * estimate as ExecHashTableCreate() uses to size the hash table; the filter
+ * is always created with ExecHashBloomWorkMem() and seed 0, so that all
+ * participants of a Parallel Hash agree on its shape.
+ */
+static int64
+ExecHashBloomFilterElems(HashState *node)
+{
+	Hash	   *plan = (Hash *) node->ps.plan;
+	double		rows;
+
+	rows = plan->plan.parallel_aware ? plan->rows_total :
+		outerPlan(plan)->plan_rows;
+
+	return (int64) Max(rows, 1.0);
+}
+
+/*
+ * Memory for a bloom filter of the hash values, in kilobytes, or 0 if
+ * work_mem is too small to spare the minimum size of one.
+ */
+int
+ExecHashBloomWorkMem(void)
+{
+	int			bloom_work_mem;
+
+	bloom_work_mem = (int) ((int64) work_mem * BLOOM_WORK_MEM_PERCENT / 100);
+
+	/* bloomfilter.c never makes a bitset smaller than 1MB */
+	if (bloom_work_mem < 1024)
+		return 0;
+
+	return bloom_work_mem;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecHashBloomLacksTuple
+ *
+ *		Test whether an outer tuple certainly has no match in the hash
+ *		table, according to the hash table's bloom filter.
+ *
+ * The hash keys are evaluated in econtext, which must be set up to supply
+ * the tuple being tested.  Returns false if there is no bloom filter (yet).
+ * This is only valid for join types that discard unmatched outer tuples.
+ * ----------------------------------------------------------------
+ */
+bool
+ExecHashBloomLacksTuple(HashJoinTable hashtable, ExprContext *econtext,
+						List *hashkeys)
+{
+	uint32		hashvalue;
+
+	if (hashtable == NULL || hashtable->bloomfilter == NULL)
+		return false;
+
+	/* a null join key means the tuple cannot match */
+	if (!ExecHashGetHashValue(hashtable, econtext, hashkeys,
+							  true, false, &hashvalue))
+		return true;
+
+	return bloom_lacks_element(hashtable->bloomfilter,
+							   (unsigned char *) &hashvalue,
+							   sizeof(hashvalue));
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitHash
  *
@@ -365,6 +492,7 @@ ExecInitHash(Hash *node, EState *estate, int eflags)
 	hashstate->ps.ExecProcNode = ExecHash;
 	hashstate->hashtable = NULL;
 	hashstate->hashkeys = NIL;	/* will be set by parent HashJoin */
+	hashstate->build_bloom = false; /* ditto */
 
 	/*
 	 * Miscellaneous initialization
@@ -440,6 +568,7 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	int			i;
 	ListCell   *ho;
 	ListCell   *hc;
+	Size		bloom_space;
 	MemoryContext oldcxt;
 
 	/*
@@ -465,6 +594,23 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 							&space_allowed,
 							&nbuckets, &nbatch, &num_skew_mcvs);
 
+	/*
+	 * If we're going to build a bloom filter, its space comes out of the
+	 * hash table's budget.  With Parallel Hash, every participant also fills
+	 * a private filter while hashing, on top of the shared one.
+	 */
+	bloom_space = 0;
+	if (state->build_bloom)
+	{
+		int			nfilters = 1;
+
+		if (state->parallel_state != NULL)
+			nfilters += state->parallel_state->nparticipants;
+		bloom_space = bloom_estimate(ExecHashBloomFilterElems(state),
+									 ExecHashBloomWorkMem());
+		space_allowed -= Min(bloom_space * nfilters, space_allowed / 2);
+	}
+
 	/* nbuckets must be a power of 2 */
 	log2_nbuckets = my_log2(nbuckets);
 	Assert(nbuckets == (1 << log2_nbuckets));
@@ -510,6 +656,8 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->parallel_state = state->parallel_state;
 	hashtable->area = state->ps.state->es_query_dsa;
 	hashtable->batches = NULL;
+	hashtable->bloomfilter = NULL;
+	hashtable->bloomSpace = bloom_space;
 
 #ifdef HJDEBUG
 	printf("Hashjoin %p: initial nbatch = %d, nbuckets = %d\n",
@@ -616,6 +764,23 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 			 */
 			pstate->nbuckets = nbuckets;
 			ExecParallelHashTableAlloc(hashtable, 0);
+
+			/*
+			 * Allocate an empty shared bloom filter, if wanted.  Participants
+			 * will merge their private filters into it while hashing.
+			 */
+			if (state->build_bloom)
+			{
+				int64		nelems = ExecHashBloomFilterElems(state);
+
+				pstate->bloomfilter =
+					dsa_allocate(hashtable->area,
+								 bloom_estimate(nelems,
+												ExecHashBloomWorkMem()));
+				bloom_init(dsa_get_address(hashtable->area,
+										   pstate->bloomfilter),
+						   nelems, ExecHashBloomWorkMem(), 0);
+			}
 		}
 
 		/*
@@ -1098,9 +1263,12 @@ ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable)
 					/*
 					 * We are going from single-batch to multi-batch.  We need
 					 * to switch from one large combined memory budget to the
-					 * regular work_mem budget.
+					 * regular work_mem budget, less the shared bloom filter
+					 * and our private one, if any.
 					 */
 					pstate->space_allowed = work_mem * 1024L;
+					pstate->space_allowed -= Min(hashtable->bloomSpace * 2,
+												 pstate->space_allowed / 2);
 
 					/*
 					 * The combined work_mem of all participants wasn't
@@ -3160,9 +3328,15 @@ ExecHashTableDetach(HashJoinTable hashtable)
 				dsa_free(hashtable->area, pstate->batches);
 				pstate->batches = InvalidDsaPointer;
 			}
+			if (DsaPointerIsValid(pstate->bloomfilter))
+			{
+				dsa_free(hashtable->area, pstate->bloomfilter);
+				pstate->bloomfilter = InvalidDsaPointer;
+			}
 		}
 
 		hashtable->parallel_state = NULL;
+		hashtable->bloomfilter = NULL;
 	}
 }
 
@@ -113,6 +113,7 @@
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
 #include "miscadmin.h"
+#include "parser/parsetree.h"
 #include "pgstat.h"
 #include "utils/memutils.h"
 #include "utils/sharedtuplestore.h"
@@ -146,6 +147,7 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
 static bool ExecParallelHashJoinNewBatch(HashJoinState *hjstate);
 static void ExecParallelHashJoinPartitionOuter(HashJoinState *node);
+static void ExecHashJoinInitBloomFilter(HashJoinState *hjstate);
 
 
 /* ----------------------------------------------------------------
@@ -761,6 +763,10 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	/* child Hash node needs to evaluate inner hash keys, too */
 	((HashState *) innerPlanState(hjstate))->hashkeys = rhclauses;
 
+	/* set up the bloom filter, if the planner asked for one */
+	if (node->bloom_filter)
+		ExecHashJoinInitBloomFilter(hjstate);
+
 	hjstate->hj_JoinState = HJ_BUILD_HASHTABLE;
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
@@ -768,6 +774,70 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	return hjstate;
 }
 
+/*
+ * ExecHashJoinInitBloomFilter
+ *
+ *		Arrange for the Hash node to build a bloom filter of the inner hash
+ *		values, and for the outer sequential scan to probe it.
+ *
+ * The scan probes the filter before evaluating its quals, so it needs the
+ * outer hash keys expressed in terms of its scan tuple rather than its
+ * output tuple.  The planner only requests a filter if every outer key is a
+ * plain column of the scanned relation, possibly relabeled, which we can
+ * translate through the scan's targetlist.  If that fails for some reason,
+ * just do without the filter.
+ */
+static void
+ExecHashJoinInitBloomFilter(HashJoinState *hjstate)
+{
+	HashJoin   *node = (HashJoin *) hjstate->js.ps.plan;
+	PlanState  *outerState = outerPlanState(hjstate);
+	SeqScanState *scanstate;
+	List	   *scankeys = NIL;
+	ListCell   *l;
+
+	if (!IsA(outerState, SeqScanState))
+		return;
+
+	/* A filter must not take up too much of work_mem */
+	if (ExecHashBloomWorkMem() == 0)
+		return;
+
+	scanstate = (SeqScanState *) outerState;
+
+	foreach(l, node->hashclauses)
+	{
+		OpExpr	   *hclause = lfirst_node(OpExpr, l);
+		Expr	   *key = (Expr *) linitial(hclause->args);
+		RelabelType *relabel = NULL;
+		TargetEntry *tle;
+
+		if (IsA(key, RelabelType))
+		{
+			relabel = (RelabelType *) key;
+			key = relabel->arg;
+		}
+		if (!IsA(key, Var) || ((Var *) key)->varno != OUTER_VAR)
+			return;
+		tle = get_tle_by_resno(outerState->plan->targetlist,
+							   ((Var *) key)->varattno);
+		if (tle == NULL || !IsA(tle->expr, Var))
+			return;
+		key = tle->expr;
+		if (relabel != NULL)
+		{
+			relabel = copyObject(relabel);
+			relabel->arg = key;
+			key = (Expr *) relabel;
+		}
+		scankeys = lappend(scankeys, ExecInitExpr(key, outerState));
+	}
+
+	scanstate->bloomsource = hjstate;
+	scanstate->bloomkeys = scankeys;
+	((HashState *) innerPlanState(hjstate))->build_bloom = true;
+}
+
 /* ----------------------------------------------------------------
  *		ExecEndHashJoin
  *
@@ -1482,6 +1552,7 @@ ExecHashJoinInitializeDSM(HashJoinState *state, ParallelContext *pcxt)
 	pstate->nbuckets = 0;
 	pstate->growth = PHJ_GROWTH_OK;
 	pstate->chunk_work_queue = InvalidDsaPointer;
+	pstate->bloomfilter = InvalidDsaPointer;
 	pg_atomic_init_u32(&pstate->distributor, 0);
 	pstate->nparticipants = pcxt->nworkers + 1;
 	pstate->total_tuples = 0;
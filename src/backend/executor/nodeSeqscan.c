@@ -30,10 +30,13 @@
 #include "access/relscan.h"
 #include "access/tableam.h"
 #include "executor/execdebug.h"
+#include "executor/nodeHash.h"
 #include "executor/nodeSeqscan.h"
+#include "miscadmin.h"
 #include "utils/rel.h"
 
 static TupleTableSlot *SeqNext(SeqScanState *node);
+static bool SeqBloomLacksTuple(SeqScanState *node, TupleTableSlot *slot);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -75,13 +78,44 @@ SeqNext(SeqScanState *node)
 	}
 
 	/*
-	 * get the next tuple from the table
+	 * get the next tuple from the table, skipping any that a parent hash
+	 * join's bloom filter tells us cannot have a join partner
 	 */
-	if (table_scan_getnextslot(scandesc, direction, slot))
+	while (table_scan_getnextslot(scandesc, direction, slot))
+	{
+		if (node->bloomsource != NULL && SeqBloomLacksTuple(node, slot))
+		{
+			InstrCountFiltered2(node, 1);
+			CHECK_FOR_INTERRUPTS();
+			continue;
+		}
 		return slot;
+	}
 	return NULL;
 }
 
+/*
+ * SeqBloomLacksTuple -- probe the parent hash join's bloom filter
+ *
+ * Returns true if the scanned tuple certainly has no join partner.
+ */
+static bool
+SeqBloomLacksTuple(SeqScanState *node, TupleTableSlot *slot)
+{
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+
+	/*
+	 * ExecScan only resets the per-tuple context once per tuple returned, and
+	 * we might reject any number of tuples in between.  Don't let what the
+	 * hash keys and functions allocate for each of them pile up.
+	 */
+	ResetExprContext(econtext);
+
+	econtext->ecxt_scantuple = slot;
+	return ExecHashBloomLacksTuple(node->bloomsource->hj_HashTable,
+								   econtext, node->bloomkeys);
+}
+
 /*
  * SeqRecheck -- access method routine to recheck a tuple in EvalPlanQual
  */
@@ -51,6 +51,7 @@ struct bloom_filter
 	unsigned char bitset[FLEXIBLE_ARRAY_MEMBER];
 };
 
+static uint64 bloom_bitset_bits(int64 total_elems, int bloom_work_mem);
 static int	my_bloom_power(uint64 target_bitset_bits);
 static int	optimal_k(uint64 bitset_bits, int64 total_elems);
 static void k_hashes(bloom_filter *filter, uint32 *hashes, unsigned char *elem,
@@ -87,32 +88,44 @@ static inline uint32 mod_m(uint32 a, uint64 m);
 bloom_filter *
 bloom_create(int64 total_elems, int bloom_work_mem, uint64 seed)
 {
-	bloom_filter *filter;
-	int			bloom_power;
-	uint64		bitset_bytes;
-	uint64		bitset_bits;
+	void	   *space;
 
-	/*
-	 * Aim for two bytes per element; this is sufficient to get a false
-	 * positive rate below 1%, independent of the size of the bitset or total
-	 * number of elements.  Also, if rounding down the size of the bitset to
-	 * the next lowest power of two turns out to be a significant drop, the
-	 * false positive rate still won't exceed 2% in almost all cases.
-	 */
-	bitset_bytes = Min(bloom_work_mem * UINT64CONST(1024), total_elems * 2);
-	bitset_bytes = Max(1024 * 1024, bitset_bytes);
+	space = palloc(bloom_estimate(total_elems, bloom_work_mem));
 
-	/*
-	 * Size in bits should be the highest power of two <= target.  bitset_bits
-	 * is uint64 because PG_UINT32_MAX is 2^32 - 1, not 2^32
-	 */
-	bloom_power = my_bloom_power(bitset_bytes * BITS_PER_BYTE);
-	bitset_bits = UINT64CONST(1) << bloom_power;
-	bitset_bytes = bitset_bits / BITS_PER_BYTE;
+	return bloom_init(space, total_elems, bloom_work_mem, seed);
+}
+
+/*
+ * Compute the amount of space needed for a Bloom filter created with the
+ * given arguments, for callers that want to allocate the space themselves
+ * (in shared memory, for example) and use bloom_init().
+ */
+Size
+bloom_estimate(int64 total_elems, int bloom_work_mem)
+{
+	uint64		bitset_bits = bloom_bitset_bits(total_elems, bloom_work_mem);
+
+	return offsetof(bloom_filter, bitset) +
+		sizeof(unsigned char) * (bitset_bits / BITS_PER_BYTE);
+}
 
-	/* Allocate bloom filter with unset bitset */
-	filter = palloc0(offsetof(bloom_filter, bitset) +
-					 sizeof(unsigned char) * bitset_bytes);
+/*
+ * Initialize Bloom filter with unset bitset in caller-provided space, which
+ * must be at least bloom_estimate() bytes.  See bloom_create() for the
+ * meaning of the arguments.
+ *
+ * The result depends on nothing but the arguments, so filters initialized
+ * with the same arguments (perhaps in different processes) can later be
+ * combined with bloom_union().
+ */
+bloom_filter *
+bloom_init(void *space, int64 total_elems, int bloom_work_mem, uint64 seed)
+{
+	bloom_filter *filter = (bloom_filter *) space;
+	uint64		bitset_bits = bloom_bitset_bits(total_elems, bloom_work_mem);
+
+	memset(filter->bitset, 0, sizeof(unsigned char) *
+		   (bitset_bits / BITS_PER_BYTE));
 	filter->k_hash_funcs = optimal_k(bitset_bits, total_elems);
 	filter->seed = seed;
 	filter->m = bitset_bits;
@@ -147,6 +160,25 @@ bloom_add_element(bloom_filter *filter, unsigned char *elem, size_t len)
 	}
 }
 
+/*
+ * Add all elements of one Bloom filter to another
+ *
+ * Both filters must have been created with the same arguments.
+ */
+void
+bloom_union(bloom_filter *dst, bloom_filter *src)
+{
+	uint64		bitset_bytes = dst->m / BITS_PER_BYTE;
+	uint64		i;
+
+	if (dst->m != src->m || dst->k_hash_funcs != src->k_hash_funcs ||
+		dst->seed != src->seed)
+		elog(ERROR, "cannot combine Bloom filters of different shape");
+
+	for (i = 0; i < bitset_bytes; i++)
+		dst->bitset[i] |= src->bitset[i];
+}
+
 /*
  * Test if Bloom filter definitely lacks element.
  *
@@ -193,6 +225,34 @@ bloom_prop_bits_set(bloom_filter *filter)
 	return bits_set / (double) filter->m;
 }
 
+/*
+ * Size of the bitset, in bits, for given arguments to bloom_create().
+ */
+static uint64
+bloom_bitset_bits(int64 total_elems, int bloom_work_mem)
+{
+	uint64		bitset_bytes;
+	int			bloom_power;
+
+	/*
+	 * Aim for two bytes per element; this is sufficient to get a false
+	 * positive rate below 1%, independent of the size of the bitset or total
+	 * number of elements.  Also, if rounding down the size of the bitset to
+	 * the next lowest power of two turns out to be a significant drop, the
+	 * false positive rate still won't exceed 2% in almost all cases.
+	 */
+	bitset_bytes = Min(bloom_work_mem * UINT64CONST(1024), total_elems * 2);
+	bitset_bytes = Max(1024 * 1024, bitset_bytes);
+
+	/*
+	 * Size in bits should be the highest power of two <= target.  bitset_bits
+	 * is uint64 because PG_UINT32_MAX is 2^32 - 1, not 2^32
+	 */
+	bloom_power = my_bloom_power(bitset_bytes * BITS_PER_BYTE);
+
+	return UINT64CONST(1) << bloom_power;
+}
+
 /*
  * Which element in the sequence of powers of two is less than or equal to
  * target_bitset_bits?
@@ -46,6 +46,8 @@
  *		pq_init			- initialize libpq at backend startup
  *		pq_comm_reset	- reset libpq during error recovery
  *		pq_close		- shutdown libpq at backend exit
+ *		pq_release_socket - hand the connection back to the connection pool
+ *		pq_adopt_socket - take over a connection from the connection pool
  *
  * low-level I/O:
  *		pq_getbytes		- get a known number of bytes from connection
@@ -53,6 +55,7 @@
  *		pq_getmessage	- get a message with length word from connection
  *		pq_getbyte		- get next byte from connection
  *		pq_peekbyte		- peek at next byte from connection
+ *		pq_buffer_has_data - is any received data still unread?
  *		pq_putbytes		- send bytes to connection (not flushed until pq_flush)
  *		pq_flush		- flush pending output
  *		pq_flush_if_writable - flush pending output if writable without blocking
@@ -154,6 +157,7 @@ static bool DoingCopyOut;		/* in old-protocol COPY OUT processing */
 /* Internal functions */
 static void socket_comm_reset(void);
 static void socket_close(int code, Datum arg);
+static void socket_setup(void);
 static void socket_set_nonblocking(bool nonblocking);
 static int	socket_flush(void);
 static int	socket_flush_if_writable(void);
@@ -204,6 +208,16 @@ pq_init(void)
 	/* set up process-exit hook to close the socket */
 	on_proc_exit(socket_close, 0);
 
+	socket_setup();
+}
+
+/* --------------------------------
+ *		socket_setup - prepare MyProcPort->sock for use by this backend
+ * --------------------------------
+ */
+static void
+socket_setup(void)
+{
 	/*
 	 * In backends (as soon as forked) we operate the underlying socket in
 	 * nonblocking mode and use latches to implement blocking semantics if
@@ -227,6 +241,45 @@ pq_init(void)
 	AddWaitEventToSet(FeBeWaitSet, WL_POSTMASTER_DEATH, -1, NULL, NULL);
 }
 
+/* --------------------------------
+ *		pq_release_socket - give up the connection to the client
+ *
+ * Used by the connection pool once the session has been handed back to the
+ * postmaster, which holds its own descriptor for the socket.  The caller must
+ * have made sure that nothing is left to send or to read.
+ * --------------------------------
+ */
+void
+pq_release_socket(void)
+{
+	Assert(!PqCommBusy && !PqCommReadingMsg && !DoingCopyOut);
+	Assert(PqSendStart == PqSendPointer && PqRecvPointer == PqRecvLength);
+
+	FreeWaitEventSet(FeBeWaitSet);
+	FeBeWaitSet = NULL;
+
+	closesocket(MyProcPort->sock);
+	MyProcPort->sock = PGINVALID_SOCKET;
+
+	PqSendPointer = PqSendStart = PqRecvPointer = PqRecvLength = 0;
+}
+
+/* --------------------------------
+ *		pq_adopt_socket - take over a client connection from the postmaster
+ *
+ * Counterpart of pq_release_socket(), for a session handed to this backend
+ * by the connection pool.
+ * --------------------------------
+ */
+void
+pq_adopt_socket(pgsocket sock)
+{
+	Assert(MyProcPort->sock == PGINVALID_SOCKET);
+
+	MyProcPort->sock = sock;
+	socket_setup();
+}
+
 /* --------------------------------
  *		socket_comm_reset - reset libpq during error recovery
  *
@@ -1009,6 +1062,16 @@ pq_getbyte(void)
 	return (unsigned char) PqRecvBuffer[PqRecvPointer++];
 }
 
+/* --------------------------------
+ *		pq_buffer_has_data		- is any received data still unread?
+ * --------------------------------
+ */
+bool
+pq_buffer_has_data(void)
+{
+	return (PqRecvPointer < PqRecvLength);
+}
+
 /* --------------------------------
  *		pq_peekbyte		- peek at next byte from connection
  *
@@ -75,6 +75,7 @@ typedef int IpcMemoryId;		/* shared memory ID returned by shmget(2) */
 
 unsigned long UsedShmemSegID = 0;
 void	   *UsedShmemSegAddr = NULL;
+Size		UsedShmemPageSize = 0;
 
 static Size AnonymousShmemSize;
 static void *AnonymousShmem = NULL;
@@ -480,6 +481,8 @@ CreateAnonymousSegment(Size *size)
 		if (huge_pages == HUGE_PAGES_TRY && ptr == MAP_FAILED)
 			elog(DEBUG1, "mmap(%zu) with MAP_HUGETLB failed, huge pages disabled: %m",
 				 allocsize);
+		else if (ptr != MAP_FAILED)
+			UsedShmemPageSize = hugepagesize;
 	}
 #endif
 
@@ -19,6 +19,7 @@
 
 HANDLE		UsedShmemSegID = INVALID_HANDLE_VALUE;
 void	   *UsedShmemSegAddr = NULL;
+Size		UsedShmemPageSize = 0;
 static Size UsedShmemSegSize = 0;
 
 static bool EnableLockPagesPrivilege(int elevel);
@@ -220,6 +221,7 @@ PGSharedMemoryCreate(Size size, bool makePrivate, int port,
 		{
 			/* Huge pages available and privilege enabled, so turn on */
 			flProtect = PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES;
+			UsedShmemPageSize = largePageSize;
 
 			/* Round size up as appropriate. */
 			if (size % largePageSize != 0)
@@ -272,6 +274,7 @@ retry:
 				 */
 				size = orig_size;
 				flProtect = PAGE_READWRITE;
+				UsedShmemPageSize = 0;
 				goto retry;
 			}
 			else
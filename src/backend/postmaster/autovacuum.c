@@ -652,6 +652,10 @@ AutoVacLauncherMain(int argc, char *argv[])
 		/* Process sinval catchup interrupts that happened while sleeping */
 		ProcessCatchupInterrupt();
 
+		/* Likewise for global barriers */
+		if (ProcSignalBarrierPending)
+			ProcessProcSignalBarrier();
+
 		/* the normal shutdown case */
 		if (got_SIGTERM)
 			break;
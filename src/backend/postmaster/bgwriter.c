@@ -51,6 +51,7 @@
 #include "storage/ipc.h"
 #include "storage/lwlock.h"
 #include "storage/proc.h"
+#include "storage/procsignal.h"
 #include "storage/shmem.h"
 #include "storage/smgr.h"
 #include "storage/spin.h"
@@ -250,6 +251,7 @@ BackgroundWriterMain(void)
 			got_SIGHUP = false;
 			ProcessConfigFile(PGC_SIGHUP);
 		}
+		ProcessProcSignalBarrier();
 		if (shutdown_requested)
 		{
 			/*
@@ -266,6 +268,18 @@ BackgroundWriterMain(void)
 		 */
 		can_hibernate = BgBufferSync(&wb_context);
 
+		/*
+		 * If shared_buffers has been changed, carry the resize of the buffer
+		 * pool as far as we can without waiting long.  Don't hibernate while
+		 * it isn't done.
+		 */
+		if (BufferPoolResizePending())
+		{
+			ResizeBufferPool();
+			if (BufferPoolResizePending())
+				can_hibernate = false;
+		}
+
 		/*
 		 * Send off activity statistics to the stats collector
 		 */
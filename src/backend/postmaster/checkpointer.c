@@ -54,12 +54,14 @@
 #include "storage/ipc.h"
 #include "storage/lwlock.h"
 #include "storage/proc.h"
+#include "storage/procsignal.h"
 #include "storage/shmem.h"
 #include "storage/smgr.h"
 #include "storage/spin.h"
 #include "utils/guc.h"
 #include "utils/memutils.h"
 #include "utils/resowner.h"
+#include "utils/timestamp.h"
 
 
 /*----------
@@ -148,6 +150,7 @@ static CheckpointerShmemStruct *CheckpointerShmem;
 int			CheckPointTimeout = 300;
 int			CheckPointWarning = 30;
 double		CheckPointCompletionTarget = 0.5;
+int			CheckPointIOLatencyTarget = 0;
 
 /*
  * Flags set by interrupt handlers for later service in the main loop.
@@ -164,6 +167,11 @@ static bool ckpt_active = false;
 static pg_time_t ckpt_start_time;
 static XLogRecPtr ckpt_start_recptr;
 static double ckpt_cached_elapsed;
+static double ckpt_write_target;
+static double ckpt_io_latency;
+
+/* duration of the sync phase of the last completed checkpoint, in seconds */
+static double ckpt_last_sync_secs = 0;
 
 static pg_time_t last_checkpoint_time;
 static pg_time_t last_xlog_switch_time;
@@ -171,7 +179,9 @@ static pg_time_t last_xlog_switch_time;
 /* Prototypes for private functions */
 
 static void CheckArchiveTimeout(void);
-static bool IsCheckpointOnSchedule(double progress);
+static bool IsCheckpointOnSchedule(double progress, double target);
+static double CheckpointWriteTarget(void);
+static double CheckpointSyncReserve(void);
 static bool ImmediateCheckpointRequested(void);
 static bool CompactCheckpointerRequestQueue(void);
 static void UpdateSharedMemoryConfig(void);
@@ -369,6 +379,14 @@ CheckpointerMain(void)
 			 */
 			UpdateSharedMemoryConfig();
 		}
+
+		/*
+		 * Barriers are absorbed only here, not in CheckpointWriteDelay(), so
+		 * that the buffer pool never changes size in the middle of a
+		 * checkpoint.
+		 */
+		ProcessProcSignalBarrier();
+
 		if (shutdown_requested)
 		{
 			/*
@@ -472,6 +490,8 @@ CheckpointerMain(void)
 				ckpt_start_recptr = GetInsertRecPtr();
 			ckpt_start_time = now;
 			ckpt_cached_elapsed = 0;
+			ckpt_write_target = CheckpointWriteTarget();
+			ckpt_io_latency = 0;
 
 			/*
 			 * Do the checkpoint.
@@ -484,6 +504,21 @@ CheckpointerMain(void)
 			else
 				ckpt_performed = CreateRestartPoint(flags);
 
+			/*
+			 * Remember how long the sync phase took, so that the next
+			 * checkpoint can leave room for it when I/O pacing is enabled.
+			 */
+			if (ckpt_performed)
+			{
+				long		sync_secs;
+				int			sync_usecs;
+
+				TimestampDifference(CheckpointStats.ckpt_sync_t,
+									CheckpointStats.ckpt_sync_end_t,
+									&sync_secs, &sync_usecs);
+				ckpt_last_sync_secs = sync_secs + sync_usecs / 1000000.0;
+			}
+
 			/*
 			 * After any checkpoint, close all smgr files.  This is so we
 			 * won't hang onto smgr references to deleted files indefinitely.
@@ -657,16 +692,25 @@ ImmediateCheckpointRequested(void)
  *
  * 'progress' is an estimate of how much of the work has been done, as a
  * fraction between 0.0 meaning none, and 1.0 meaning all done.
+ *
+ * When checkpoint_io_latency_target is set and recent writes have been slower
+ * than that, the storage is taken to be congested: we then nap for longer,
+ * and keep napping even when somewhat behind the nominal schedule, as long as
+ * the writes can still finish early enough to leave room for the sync phase.
  */
 void
 CheckpointWriteDelay(int flags, double progress)
 {
 	static int	absorb_counter = WRITES_PER_ABSORB;
+	bool		congested;
 
 	/* Do nothing if checkpoint is being executed by non-checkpointer process */
 	if (!AmCheckpointerProcess())
 		return;
 
+	congested = (CheckPointIOLatencyTarget > 0 &&
+				 ckpt_io_latency > CheckPointIOLatencyTarget);
+
 	/*
 	 * Perform the usual duties and take a nap, unless we're behind schedule,
 	 * in which case we just try to catch up as quickly as possible.
@@ -674,8 +718,12 @@ CheckpointWriteDelay(int flags, double progress)
 	if (!(flags & CHECKPOINT_IMMEDIATE) &&
 		!shutdown_requested &&
 		!ImmediateCheckpointRequested() &&
-		IsCheckpointOnSchedule(progress))
+		(IsCheckpointOnSchedule(progress, ckpt_write_target) ||
+		 (congested &&
+		  IsCheckpointOnSchedule(progress, 1.0 - CheckpointSyncReserve()))))
 	{
+		long		naptime = 100000L;
+
 		if (got_SIGHUP)
 		{
 			got_SIGHUP = false;
@@ -694,13 +742,22 @@ CheckpointWriteDelay(int flags, double progress)
 		 */
 		pgstat_send_bgwriter();
 
+		/*
+		 * Back off in proportion to how far the device is over the latency
+		 * target, but never sleep more than a second at a time so that we
+		 * keep absorbing fsync requests.
+		 */
+		if (congested)
+			naptime = (long) Min(naptime * ckpt_io_latency /
+								 CheckPointIOLatencyTarget, 1000000.0);
+
 		/*
 		 * This sleep used to be connected to bgwriter_delay, typically 200ms.
 		 * That resulted in more frequent wakeups if not much work to do.
 		 * Checkpointer and bgwriter are no longer related so take the Big
 		 * Sleep.
 		 */
-		pg_usleep(100000L);
+		pg_usleep(naptime);
 	}
 	else if (--absorb_counter <= 0)
 	{
@@ -714,16 +771,109 @@ CheckpointWriteDelay(int flags, double progress)
 	}
 }
 
+/*
+ * CheckpointNoteIOLatency -- report the latency of a checkpoint write
+ *
+ * BufferSync() calls this with the time, in milliseconds, that each combined
+ * write took.  We keep an exponentially decaying average, which
+ * CheckpointWriteDelay() compares against checkpoint_io_latency_target.
+ */
+void
+CheckpointNoteIOLatency(double msecs)
+{
+	if (!AmCheckpointerProcess() || !ckpt_active)
+		return;
+
+	if (ckpt_io_latency == 0)
+		ckpt_io_latency = msecs;
+	else
+		ckpt_io_latency += (msecs - ckpt_io_latency) * 0.2;
+}
+
+/*
+ * CheckpointSyncDelay -- control rate of checkpoint fsyncs
+ *
+ * This function is called by mdsync() after each file it has fsync'd.
+ * 'sync_msecs' is how long that fsync took and 'progress' is the fraction of
+ * the files to be synced that have been processed so far.
+ *
+ * Unless checkpoint_io_latency_target is set, the fsyncs are issued back to
+ * back as before.  Otherwise, an fsync slower than the target makes us pause
+ * before the next one, giving the device time to drain the writeback it just
+ * absorbed, provided the sync phase is still on schedule to end by the next
+ * checkpoint.
+ */
+void
+CheckpointSyncDelay(double sync_msecs, double progress)
+{
+	if (!AmCheckpointerProcess() || !ckpt_active)
+		return;
+
+	if (CheckPointIOLatencyTarget <= 0 ||
+		sync_msecs <= CheckPointIOLatencyTarget)
+		return;
+
+	/* The sync phase runs from the end of the writes to the next checkpoint */
+	progress = ckpt_write_target + (1.0 - ckpt_write_target) * progress;
+
+	if (!shutdown_requested &&
+		!ImmediateCheckpointRequested() &&
+		IsCheckpointOnSchedule(progress, 1.0))
+		pg_usleep((long) Min(sync_msecs, 1000.0) * 1000L);
+}
+
+/*
+ * CheckpointSyncReserve -- fraction of the checkpoint interval to set aside
+ *		for the sync phase
+ *
+ * This is based on how long the sync phase of the previous checkpoint took,
+ * with some slack.  It's zero unless checkpoint_io_latency_target is set.
+ */
+static double
+CheckpointSyncReserve(void)
+{
+	if (CheckPointIOLatencyTarget <= 0)
+		return 0.0;
+
+	return Min(1.5 * ckpt_last_sync_secs / CheckPointTimeout, 0.5);
+}
+
+/*
+ * CheckpointWriteTarget -- fraction of the checkpoint interval to spread the
+ *		writes of a new checkpoint over
+ *
+ * This is normally just checkpoint_completion_target.  With I/O pacing
+ * enabled, if the previous sync phase wouldn't fit in the time left after
+ * the writes, the writes are made to finish earlier instead; but never in
+ * less than half of checkpoint_completion_target.
+ */
+static double
+CheckpointWriteTarget(void)
+{
+	double		target = CheckPointCompletionTarget;
+
+	if (CheckPointIOLatencyTarget > 0)
+	{
+		target = Min(target, 1.0 - CheckpointSyncReserve());
+		target = Max(target, CheckPointCompletionTarget / 2);
+		elog(DEBUG1, "checkpoint write phase target %.2f, last sync phase took %.3f s",
+			 target, ckpt_last_sync_secs);
+	}
+
+	return target;
+}
+
 /*
  * IsCheckpointOnSchedule -- are we on schedule to finish this checkpoint
  *		 (or restartpoint) in time?
  *
  * Compares the current progress against the time/segments elapsed since last
  * checkpoint, and returns true if the progress we've made this far is greater
- * than the elapsed time/segments.
+ * than the elapsed time/segments.  'target' is the fraction of the checkpoint
+ * interval by which 'progress' should reach 1.0.
  */
 static bool
-IsCheckpointOnSchedule(double progress)
+IsCheckpointOnSchedule(double progress, double target)
 {
 	XLogRecPtr	recptr;
 	struct timeval now;
@@ -732,8 +882,8 @@ IsCheckpointOnSchedule(double progress)
 
 	Assert(ckpt_active);
 
-	/* Scale progress according to checkpoint_completion_target. */
-	progress *= CheckPointCompletionTarget;
+	/* Scale progress according to the target. */
+	progress *= target;
 
 	/*
 	 * Check against the cached value first. Only do the more expensive
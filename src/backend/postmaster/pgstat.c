@@ -3583,6 +3583,9 @@ pgstat_get_wait_client(WaitEventClient w)
 		case WAIT_EVENT_LIBPQWALRECEIVER_RECEIVE:
 			event_name = "LibPQWalReceiverReceive";
 			break;
+		case WAIT_EVENT_POOLED_SESSION:
+			event_name = "PooledSession";
+			break;
 		case WAIT_EVENT_SSL_OPEN_SERVER:
 			event_name = "SSLOpenServer";
 			break;
@@ -3710,6 +3713,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_PROCARRAY_GROUP_UPDATE:
 			event_name = "ProcArrayGroupUpdate";
 			break;
+		case WAIT_EVENT_PROC_SIGNAL_BARRIER:
+			event_name = "ProcSignalBarrier";
+			break;
 		case WAIT_EVENT_PROMOTE:
 			event_name = "Promote";
 			break;
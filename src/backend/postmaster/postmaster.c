@@ -114,17 +114,22 @@
 #include "postmaster/fork_process.h"
 #include "postmaster/pgarch.h"
 #include "postmaster/postmaster.h"
+#include "postmaster/sessionpool.h"
 #include "postmaster/syslogger.h"
 #include "replication/logicallauncher.h"
 #include "replication/walsender.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
+#include "storage/latch.h"
 #include "storage/pg_shmem.h"
 #include "storage/pmsignal.h"
 #include "storage/proc.h"
+#include "storage/procsignal.h"
+#include "storage/sinval.h"
 #include "tcop/tcopprot.h"
 #include "utils/builtins.h"
 #include "utils/datetime.h"
+#include "utils/inval.h"
 #include "utils/memutils.h"
 #include "utils/pidfile.h"
 #include "utils/ps_status.h"
@@ -166,6 +171,17 @@
  *
  * Background workers are in this list, too.
  */
+
+/*
+ * Something the postmaster waits on in PoolWaitSet, see below: a backend's
+ * pool channel or a pooled session's socket.
+ */
+typedef struct PoolEventOwner
+{
+	bool		is_session;		/* PooledSession, else Backend */
+	int			pos;			/* position in PoolWaitSet, or -1 */
+} PoolEventOwner;
+
 typedef struct bkend
 {
 	pid_t		pid;			/* process id of backend */
@@ -180,11 +196,67 @@ typedef struct bkend
 	int			bkend_type;
 	bool		dead_end;		/* is it going to send an error and quit? */
 	bool		bgworker_notify;	/* gets bgworker start/stop notifications */
+
+	/*
+	 * Connection pooling state of a regular backend, when pooling is enabled.
+	 * pool_key is NULL until the backend first hands back a session.  A
+	 * pooled backend is known to clients by the BackendKeyData of the session
+	 * it's serving, which is what cancel requests are matched against.
+	 * Pre-forked backends get a pool channel too, to receive their first
+	 * connection through; they keep it only if pooling is enabled.
+	 */
+	pgsocket	pool_channel;	/* postmaster's end, or PGINVALID_SOCKET */
+	PoolEventOwner pool_event;	/* pool_channel's entry in PoolWaitSet */
+	SessionPoolKey *pool_key;	/* sessions it can serve (malloc'd) */
+	bool		pool_idle;		/* waiting to be assigned a session? */
+	bool		prefork_idle;	/* pre-forked, waiting for a connection? */
+	int			session_pid;	/* BackendKeyData of the session served */
+	int32		session_key;
+
 	dlist_node	elem;			/* list link in BackendList */
 } Backend;
 
 static dlist_head BackendList = DLIST_STATIC_INIT(BackendList);
 
+/*
+ * Entries of exited backends whose pool channel is still registered in
+ * PoolWaitSet.  Backends are reaped in signal handlers, which must not touch
+ * PoolWaitSet, so ServerLoop finishes the cleanup.
+ */
+static dlist_head DeadPoolBackends = DLIST_STATIC_INIT(DeadPoolBackends);
+
+/*
+ * A client session handed back by a backend, while it waits for its client
+ * to send something (in IdleSessions, watched in PoolWaitSet) and then for a
+ * backend to serve it (in ReadySessions).
+ */
+typedef struct PooledSession
+{
+	pgsocket	sock;			/* the client connection */
+	PoolEventOwner event;		/* sock's entry in PoolWaitSet */
+	int			session_pid;	/* BackendKeyData given to the client */
+	int32		session_key;
+	SessionPoolKey key;			/* which backends can serve it */
+	dlist_node	elem;			/* list link in IdleSessions/ReadySessions */
+} PooledSession;
+
+static dlist_head IdleSessions = DLIST_STATIC_INIT(IdleSessions);
+static dlist_head ReadySessions = DLIST_STATIC_INIT(ReadySessions);
+static int	NumPooledSessions = 0;
+
+/*
+ * With connection pooling, ServerLoop waits on this set instead of calling
+ * select(): it holds PoolLatch, which signal handlers set to wake it up, the
+ * listen sockets, the pool channels of backends and the idle sessions.
+ */
+static WaitEventSet *PoolWaitSet = NULL;
+static WaitEvent *PoolOccurredEvents = NULL;
+static int	PoolWaitSetSize = 0;
+static Latch PoolLatch;
+
+/* Number of BackendList entries with prefork_idle set */
+static int	NumIdlePreforked = 0;
+
 #ifdef EXEC_BACKEND
 static Backend *ShmemBackendArray;
 #endif
@@ -213,6 +285,12 @@ char	   *ListenAddresses;
  */
 int			ReservedBackends;
 
+/*
+ * PreforkedBackends is the number of backends forked ahead of time to take
+ * new connections without waiting for a fork.
+ */
+int			PreforkedBackends;
+
 /* The socket(s) we're listening to. */
 #define MAXLISTEN	64
 static pgsocket ListenSocket[MAXLISTEN];
@@ -384,6 +462,7 @@ static void unlink_external_pid_file(int status, Datum arg);
 static void getInstallationPaths(const char *argv0);
 static void checkControlFile(void);
 static Port *ConnCreate(int serverFd);
+static Port *ConnAdopt(pgsocket sock);
 static void ConnFree(Port *port);
 static void reset_shared(int port);
 static void SIGHUP_handler(SIGNAL_ARGS);
@@ -408,6 +487,33 @@ static int	ProcessStartupPacket(Port *port, bool SSLdone);
 static void SendNegotiateProtocolVersion(List *unrecognized_protocol_options);
 static void processCancelRequest(Port *port, void *pkt);
 static int	initMasks(fd_set *rmask);
+static void FreeBackendEntry(Backend *bp);
+static void SessionPoolInit(void);
+static int	SessionPoolWait(struct timeval *timeout);
+static int	SessionPoolHandleEvents(int nevents, fd_set *rmask);
+static void SessionPoolMaintenance(void);
+static void SessionPoolWatch(PoolEventOwner *owner, pgsocket sock);
+static void SessionPoolUnwatch(PoolEventOwner *owner);
+static int	SessionPoolCountBackends(const SessionPoolKey *key);
+static void SessionPoolDismiss(Backend *bp);
+static void SessionPoolHandleMessage(Backend *bp);
+static void SessionPoolBackendIdle(Backend *bp);
+static void SessionPoolSessionReadable(PooledSession *session);
+static bool SessionPoolDispatch(PooledSession *session);
+static bool SessionPoolAssign(Backend *bp, PooledSession *session);
+static bool SessionPoolStartBackend(PooledSession *session);
+static void SessionPoolDropSession(PooledSession *session);
+static bool PreforkBackend(void);
+static bool PreforkedBackendStartup(Port *port);
+static bool PreforkedBackendsUsable(void);
+static bool PreforkedBackendFits(void);
+static void PreforkedBackendsMaintenance(void);
+static bool WorkerChildSlotAvailable(void);
+static void DismissPreforkedBackends(int keep);
+#ifndef EXEC_BACKEND
+static void PreforkedBackendMain(pgsocket channel) pg_attribute_noreturn();
+#endif
+static void WakeServerLoop(void);
 static void report_fork_failure_to_client(Port *port, int errnum);
 static CAC_state canAcceptConnections(void);
 static bool RandomCancelKey(int32 *cancel_key);
@@ -510,6 +616,7 @@ typedef struct
 	bool		IsBinaryUpgrade;
 	int			max_safe_fds;
 	int			MaxBackends;
+	int			NBuffers;
 #ifdef WIN32
 	HANDLE		PostmasterHandle;
 	HANDLE		initial_signal_pipe;
@@ -1373,6 +1480,10 @@ PostmasterMain(int argc, char *argv[])
 	/* Some workers may be scheduled to start now */
 	maybe_start_bgworkers();
 
+	/* Set up connection pooling, if enabled */
+	if (connection_pool_size > 0)
+		SessionPoolInit();
+
 	status = ServerLoop();
 
 	/*
@@ -1664,9 +1775,16 @@ ServerLoop(void)
 
 			PG_SETMASK(&UnBlockSig);
 
-			selres = select(nSockets, &rmask, NULL, NULL, &timeout);
+			if (PoolWaitSet != NULL)
+				selres = SessionPoolWait(&timeout);
+			else
+				selres = select(nSockets, &rmask, NULL, NULL, &timeout);
 
 			PG_SETMASK(&BlockSig);
+
+			/* Deal with pool events, and report ready listen sockets */
+			if (PoolWaitSet != NULL)
+				selres = SessionPoolHandleEvents(selres, &rmask);
 		}
 
 		/* Now check the select() result */
@@ -1713,6 +1831,12 @@ ServerLoop(void)
 			}
 		}
 
+		/* Hand pooled sessions to backends, and clean up after exits */
+		SessionPoolMaintenance();
+
+		/* Keep pre-forked backends waiting for new connections */
+		PreforkedBackendsMaintenance();
+
 		/* If we have lost the log collector, try to start a new one */
 		if (SysLoggerPID == 0 && Logging_collector)
 			SysLoggerPID = SysLogger_Start();
@@ -1754,129 +1878,1105 @@ ServerLoop(void)
 				start_autovac_launcher = false; /* signal processed */
 		}
 
-		/* If we have lost the stats collector, try to start a new one */
-		if (PgStatPID == 0 &&
-			(pmState == PM_RUN || pmState == PM_HOT_STANDBY))
-			PgStatPID = pgstat_start();
+		/* If we have lost the stats collector, try to start a new one */
+		if (PgStatPID == 0 &&
+			(pmState == PM_RUN || pmState == PM_HOT_STANDBY))
+			PgStatPID = pgstat_start();
+
+		/* If we have lost the archiver, try to start a new one. */
+		if (PgArchPID == 0 && PgArchStartupAllowed())
+			PgArchPID = pgarch_start();
+
+		/* If we need to signal the autovacuum launcher, do so now */
+		if (avlauncher_needs_signal)
+		{
+			avlauncher_needs_signal = false;
+			if (AutoVacPID != 0)
+				kill(AutoVacPID, SIGUSR2);
+		}
+
+		/* If we need to start a WAL receiver, try to do that now */
+		if (WalReceiverRequested)
+			MaybeStartWalReceiver();
+
+		/* Get other worker processes running, if needed */
+		if (StartWorkerNeeded || HaveCrashedWorker)
+			maybe_start_bgworkers();
+
+#ifdef HAVE_PTHREAD_IS_THREADED_NP
+
+		/*
+		 * With assertions enabled, check regularly for appearance of
+		 * additional threads.  All builds check at start and exit.
+		 */
+		Assert(pthread_is_threaded_np() == 0);
+#endif
+
+		/*
+		 * Lastly, check to see if it's time to do some things that we don't
+		 * want to do every single time through the loop, because they're a
+		 * bit expensive.  Note that there's up to a minute of slop in when
+		 * these tasks will be performed, since DetermineSleepTime() will let
+		 * us sleep at most that long; except for SIGKILL timeout which has
+		 * special-case logic there.
+		 */
+		now = time(NULL);
+
+		/*
+		 * If we already sent SIGQUIT to children and they are slow to shut
+		 * down, it's time to send them SIGKILL.  This doesn't happen
+		 * normally, but under certain conditions backends can get stuck while
+		 * shutting down.  This is a last measure to get them unwedged.
+		 *
+		 * Note we also do this during recovery from a process crash.
+		 */
+		if ((Shutdown >= ImmediateShutdown || (FatalError && !SendStop)) &&
+			AbortStartTime != 0 &&
+			(now - AbortStartTime) >= SIGKILL_CHILDREN_AFTER_SECS)
+		{
+			/* We were gentle with them before. Not anymore */
+			TerminateChildren(SIGKILL);
+			/* reset flag so we don't SIGKILL again */
+			AbortStartTime = 0;
+		}
+
+		/*
+		 * Once a minute, verify that postmaster.pid hasn't been removed or
+		 * overwritten.  If it has, we force a shutdown.  This avoids having
+		 * postmasters and child processes hanging around after their database
+		 * is gone, and maybe causing problems if a new database cluster is
+		 * created in the same place.  It also provides some protection
+		 * against a DBA foolishly removing postmaster.pid and manually
+		 * starting a new postmaster.  Data corruption is likely to ensue from
+		 * that anyway, but we can minimize the damage by aborting ASAP.
+		 */
+		if (now - last_lockfile_recheck_time >= 1 * SECS_PER_MINUTE)
+		{
+			if (!RecheckDataDirLockFile())
+			{
+				ereport(LOG,
+						(errmsg("performing immediate shutdown because data directory lock file is invalid")));
+				kill(MyProcPid, SIGQUIT);
+			}
+			last_lockfile_recheck_time = now;
+		}
+
+		/*
+		 * Touch Unix socket and lock files every 58 minutes, to ensure that
+		 * they are not removed by overzealous /tmp-cleaning tasks.  We assume
+		 * no one runs cleaners with cutoff times of less than an hour ...
+		 */
+		if (now - last_touch_time >= 58 * SECS_PER_MINUTE)
+		{
+			TouchSocketFiles();
+			TouchSocketLockFiles();
+			last_touch_time = now;
+		}
+	}
+}
+
+/*
+ * Initialise the masks for select() for the ports we are listening on.
+ * Return the number of sockets to listen on.
+ */
+static int
+initMasks(fd_set *rmask)
+{
+	int			maxsock = -1;
+	int			i;
+
+	FD_ZERO(rmask);
+
+	for (i = 0; i < MAXLISTEN; i++)
+	{
+		int			fd = ListenSocket[i];
+
+		if (fd == PGINVALID_SOCKET)
+			break;
+		FD_SET(fd, rmask);
+
+		if (fd > maxsock)
+			maxsock = fd;
+	}
+
+	return maxsock + 1;
+}
+
+/*
+ * Free a BackendList entry, after it has been removed from the list.  An
+ * entry with a pool channel has to wait for ServerLoop to unregister the
+ * channel, see DeadPoolBackends.
+ */
+static void
+FreeBackendEntry(Backend *bp)
+{
+	if (bp->prefork_idle)
+	{
+		bp->prefork_idle = false;
+		NumIdlePreforked--;
+	}
+
+	if (bp->pool_channel != PGINVALID_SOCKET)
+	{
+		bp->pid = 0;
+		bp->pool_idle = false;
+		dlist_push_tail(&DeadPoolBackends, &bp->elem);
+	}
+	else
+		free(bp);
+}
+
+/*
+ * Wake up ServerLoop from a signal handler.  This is only needed while it
+ * waits on PoolWaitSet; select() returns when interrupted by a signal anyway.
+ */
+static void
+WakeServerLoop(void)
+{
+	if (PoolWaitSet != NULL)
+		SetLatch(&PoolLatch);
+}
+
+
+/*
+ * Connection pooling
+ *
+ * When a backend's session is idle and holds no state of its own, the
+ * backend hands the client socket back to us over its pool channel (see
+ * postmaster/sessionpool.c) and waits to be assigned another session.  We
+ * keep the session in IdleSessions until its client sends something, then
+ * pass it to an idle backend that can serve it, or start a new backend for it
+ * if there are fewer than connection_pool_size of those.  Failing both, the
+ * session waits in ReadySessions for a backend to become free.
+ *
+ * New connections are still accepted and authenticated by a backend of their
+ * own; a backend that hands back a session when there are more than enough
+ * backends for its kind of session is told to exit.
+ */
+
+/*
+ * Set up PoolWaitSet.  Called once, before ServerLoop starts.
+ */
+static void
+SessionPoolInit(void)
+{
+	int			i;
+
+	/* leave room for exited backends' channels not yet cleaned up */
+	PoolWaitSetSize = 1 + MAXLISTEN + 2 * MaxLivePostmasterChildren() +
+		max_pooled_sessions;
+
+	InitializeLatchSupport();
+	InitLatch(&PoolLatch);
+
+	PoolWaitSet = CreateWaitEventSet(PostmasterContext, PoolWaitSetSize);
+	PoolOccurredEvents = (WaitEvent *)
+		MemoryContextAlloc(PostmasterContext,
+						   sizeof(WaitEvent) * PoolWaitSetSize);
+
+	/* These must come first, they can't be removed from the set */
+	AddWaitEventToSet(PoolWaitSet, WL_LATCH_SET, PGINVALID_SOCKET,
+					  &PoolLatch, NULL);
+	for (i = 0; i < MAXLISTEN; i++)
+	{
+		if (ListenSocket[i] == PGINVALID_SOCKET)
+			break;
+		AddWaitEventToSet(PoolWaitSet, WL_SOCKET_READABLE, ListenSocket[i],
+						  NULL, NULL);
+	}
+}
+
+/*
+ * Wait on PoolWaitSet, for ServerLoop.  Must be called with signals unblocked,
+ * and the result passed to SessionPoolHandleEvents once they're blocked again.
+ */
+static int
+SessionPoolWait(struct timeval *timeout)
+{
+	long		timeout_ms;
+
+	timeout_ms = timeout->tv_sec * 1000L + timeout->tv_usec / 1000L;
+
+	return WaitEventSetWait(PoolWaitSet, timeout_ms, PoolOccurredEvents,
+							PoolWaitSetSize, 0);
+}
+
+/*
+ * Process the events returned by SessionPoolWait.  Listen sockets that are
+ * ready are reported in *rmask, as select() would, and their number returned.
+ */
+static int
+SessionPoolHandleEvents(int nevents, fd_set *rmask)
+{
+	int			nlisten = 0;
+	int			i;
+
+	FD_ZERO(rmask);
+
+	for (i = 0; i < nevents; i++)
+	{
+		WaitEvent  *event = &PoolOccurredEvents[i];
+		PoolEventOwner *owner = (PoolEventOwner *) event->user_data;
+
+		if (event->events & WL_LATCH_SET)
+			ResetLatch(&PoolLatch);
+		else if (owner == NULL)
+		{
+			FD_SET(event->fd, rmask);
+			nlisten++;
+		}
+		else if (owner->is_session)
+			SessionPoolSessionReadable((PooledSession *)
+									   ((char *) owner - offsetof(PooledSession, event)));
+		else
+			SessionPoolHandleMessage((Backend *)
+									 ((char *) owner - offsetof(Backend, pool_event)));
+	}
+
+	return nlisten;
+}
+
+/*
+ * Start watching a pool channel or session socket in PoolWaitSet.
+ */
+static void
+SessionPoolWatch(PoolEventOwner *owner, pgsocket sock)
+{
+	Assert(owner->pos < 0);
+	owner->pos = AddWaitEventToSet(PoolWaitSet, WL_SOCKET_READABLE, sock,
+								   NULL, owner);
+}
+
+/*
+ * Stop watching a pool channel or session socket, if we are.
+ */
+static void
+SessionPoolUnwatch(PoolEventOwner *owner)
+{
+	PoolEventOwner *moved;
+
+	if (owner->pos < 0)
+		return;
+
+	/* Another event takes its place in the set */
+	moved = (PoolEventOwner *) RemoveWaitEventFromSet(PoolWaitSet, owner->pos);
+	if (moved != NULL)
+		moved->pos = owner->pos;
+	owner->pos = -1;
+}
+
+/*
+ * Count the backends that can serve sessions of the given kind.
+ */
+static int
+SessionPoolCountBackends(const SessionPoolKey *key)
+{
+	dlist_iter	iter;
+	int			count = 0;
+
+	dlist_foreach(iter, &BackendList)
+	{
+		Backend    *bp = dlist_container(Backend, elem, iter.cur);
+
+		if (bp->pool_key != NULL && SessionPoolKeyEquals(bp->pool_key, key))
+			count++;
+	}
+
+	return count;
+}
+
+/*
+ * Tell a pooled or pre-forked backend to exit.
+ */
+static void
+SessionPoolDismiss(Backend *bp)
+{
+	SessionPoolMessage msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = SPM_EXIT;
+	if (!SessionPoolSend(bp->pool_channel, &msg, PGINVALID_SOCKET))
+		ereport(LOG,
+				(errcode_for_socket_access(),
+				 errmsg("could not send to connection pool channel of server process %d: %m",
+						(int) bp->pid)));
+	bp->pool_idle = false;
+	if (bp->prefork_idle)
+	{
+		bp->prefork_idle = false;
+		NumIdlePreforked--;
+	}
+}
+
+/*
+ * Read the messages waiting on a backend's pool channel.
+ *
+ * This is also used on the channels of backends that have exited, to rescue
+ * any session handed back just before that; bp->pid is 0 for those.
+ */
+static void
+SessionPoolHandleMessage(Backend *bp)
+{
+	SessionPoolMessage msg;
+	pgsocket	sock;
+
+	for (;;)
+	{
+		if (!SessionPoolReceive(bp->pool_channel, &msg, &sock))
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			{
+				if (bp->pid != 0)
+					ereport(LOG,
+							(errcode_for_socket_access(),
+							 errmsg("could not receive from connection pool channel of server process %d: %m",
+									(int) bp->pid)));
+				SessionPoolUnwatch(&bp->pool_event);
+			}
+			return;
+		}
+
+		/* The first session handed back tells what the backend can serve */
+		if (bp->pool_key == NULL && bp->pid != 0 &&
+			(msg.type == SPM_RETURN || msg.type == SPM_RELEASE))
+		{
+			bp->pool_key = (SessionPoolKey *) malloc(sizeof(SessionPoolKey));
+			if (bp->pool_key == NULL)
+				ereport(LOG,
+						(errcode(ERRCODE_OUT_OF_MEMORY),
+						 errmsg("out of memory")));
+			else
+				memcpy(bp->pool_key, &msg.key, sizeof(SessionPoolKey));
+		}
+
+		if (msg.type == SPM_RETURN && sock != PGINVALID_SOCKET)
+		{
+			PooledSession *session = NULL;
+
+			if (NumPooledSessions < max_pooled_sessions)
+				session = (PooledSession *) malloc(sizeof(PooledSession));
+
+			if (session == NULL)
+			{
+				/* No room, so the backend had better keep its session */
+				msg.type = SPM_ASSIGN;
+				if (bp->pid == 0 ||
+					!SessionPoolSend(bp->pool_channel, &msg, sock))
+					ereport(LOG,
+							(errmsg("could not keep pooled session, closing it")));
+				StreamClose(sock);
+				continue;
+			}
+
+			session->sock = sock;
+			session->event.is_session = true;
+			session->event.pos = -1;
+			session->session_pid = msg.sessionPid;
+			session->session_key = msg.sessionKey;
+			memcpy(&session->key, &msg.key, sizeof(SessionPoolKey));
+			(void) pg_set_noblock(sock);
+
+			dlist_push_tail(&IdleSessions, &session->elem);
+			NumPooledSessions++;
+			SessionPoolWatch(&session->event, sock);
+		}
+		else if (msg.type == SPM_RETURN || msg.type == SPM_RELEASE)
+		{
+			if (sock != PGINVALID_SOCKET)
+				StreamClose(sock);
+		}
+		else
+		{
+			ereport(LOG,
+					(errmsg("unexpected message type %d on connection pool channel",
+							(int) msg.type)));
+			if (sock != PGINVALID_SOCKET)
+				StreamClose(sock);
+			continue;
+		}
+
+		if (bp->pid == 0)
+			continue;
+		if (bp->pool_key != NULL)
+			SessionPoolBackendIdle(bp);
+		else
+			SessionPoolDismiss(bp);
+	}
+}
+
+/*
+ * A backend has no session to serve: find it one, or let it wait for one,
+ * or tell it to exit if its kind of session has more than enough backends.
+ */
+static void
+SessionPoolBackendIdle(Backend *bp)
+{
+	dlist_iter	iter;
+
+	bp->pool_idle = true;
+
+	dlist_foreach(iter, &ReadySessions)
+	{
+		PooledSession *session = dlist_container(PooledSession, elem, iter.cur);
+
+		if (SessionPoolKeyEquals(&session->key, bp->pool_key))
+		{
+			if (SessionPoolAssign(bp, session))
+				return;
+			break;
+		}
+	}
+
+	if (bp->pool_idle &&
+		SessionPoolCountBackends(bp->pool_key) > connection_pool_size)
+		SessionPoolDismiss(bp);
+}
+
+/*
+ * An idle session's socket has become readable: either the client has sent
+ * its next query, or it has gone away.
+ */
+static void
+SessionPoolSessionReadable(PooledSession *session)
+{
+	char		c;
+	ssize_t		rc;
+
+	rc = recv(session->sock, &c, 1, MSG_PEEK);
+	if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		return;
+	if (rc <= 0)
+	{
+		SessionPoolDropSession(session);
+		return;
+	}
+
+	SessionPoolUnwatch(&session->event);
+	dlist_delete(&session->elem);
+	dlist_push_tail(&ReadySessions, &session->elem);
+
+	(void) SessionPoolDispatch(session);
+}
+
+/*
+ * Try to get a session in ReadySessions served, by an idle backend or by a
+ * new one.  Returns false if it has to keep waiting.
+ */
+static bool
+SessionPoolDispatch(PooledSession *session)
+{
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &BackendList)
+	{
+		Backend    *bp = dlist_container(Backend, elem, iter.cur);
+
+		if (bp->pool_idle && SessionPoolKeyEquals(bp->pool_key, &session->key) &&
+			SessionPoolAssign(bp, session))
+			return true;
+	}
+
+	if (SessionPoolCountBackends(&session->key) < connection_pool_size &&
+		(canAcceptConnections() == CAC_OK ||
+		 (NumIdlePreforked > 0 && PreforkedBackendsUsable())))
+		return SessionPoolStartBackend(session);
+
+	return false;
+}
+
+/*
+ * Pass a session in ReadySessions to an idle backend.
+ */
+static bool
+SessionPoolAssign(Backend *bp, PooledSession *session)
+{
+	SessionPoolMessage msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = SPM_ASSIGN;
+	msg.sessionPid = session->session_pid;
+	msg.sessionKey = session->session_key;
+	memcpy(&msg.key, &session->key, sizeof(SessionPoolKey));
+
+	bp->pool_idle = false;
+	if (!SessionPoolSend(bp->pool_channel, &msg, session->sock))
+	{
+		ereport(LOG,
+				(errcode_for_socket_access(),
+				 errmsg("could not pass session to server process %d: %m",
+						(int) bp->pid)));
+		return false;
+	}
+	bp->session_pid = session->session_pid;
+	bp->session_key = session->session_key;
+
+	/* The backend has its own descriptor for the socket now */
+	dlist_delete(&session->elem);
+	NumPooledSessions--;
+	StreamClose(session->sock);
+	free(session);
+
+	return true;
+}
+
+/*
+ * Start a new backend to serve a session in ReadySessions.  The session is
+ * consumed even if that fails, since there is no telling how far the
+ * backend got.
+ */
+static bool
+SessionPoolStartBackend(PooledSession *session)
+{
+	Port	   *port;
+
+	dlist_delete(&session->elem);
+	NumPooledSessions--;
+
+	port = ConnAdopt(session->sock);
+	if (port != NULL &&
+		(port->pool_key = (SessionPoolKey *) malloc(sizeof(SessionPoolKey))) == NULL)
+	{
+		ereport(LOG,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+		ConnFree(port);
+		port = NULL;
+	}
+	if (port == NULL)
+	{
+		StreamClose(session->sock);
+		free(session);
+		return true;
+	}
+
+	memcpy(port->pool_key, &session->key, sizeof(SessionPoolKey));
+	port->pool_session_pid = session->session_pid;
+	port->pool_session_key = session->session_key;
+	free(session);
+
+	BackendStartup(port);
+
+	/* On success, BackendStartup has taken the key */
+	if (port->pool_key != NULL)
+		free(port->pool_key);
+	StreamClose(port->sock);
+	ConnFree(port);
+
+	return true;
+}
+
+/*
+ * Close a pooled session and forget about it.
+ */
+static void
+SessionPoolDropSession(PooledSession *session)
+{
+	SessionPoolUnwatch(&session->event);
+	dlist_delete(&session->elem);
+	NumPooledSessions--;
+	StreamClose(session->sock);
+	free(session);
+}
+
+/*
+ * Connection pool housekeeping, done on every iteration of ServerLoop.  The
+ * channels of exited pre-forked backends are cleaned up here even when
+ * pooling is disabled.
+ */
+static void
+SessionPoolMaintenance(void)
+{
+	dlist_mutable_iter miter;
+	dlist_iter	iter;
+
+	/* Finish cleaning up after exited backends */
+	dlist_foreach_modify(miter, &DeadPoolBackends)
+	{
+		Backend    *bp = dlist_container(Backend, elem, miter.cur);
+
+		SessionPoolHandleMessage(bp);
+		SessionPoolUnwatch(&bp->pool_event);
+		closesocket(bp->pool_channel);
+		dlist_delete(miter.cur);
+		if (bp->pool_key != NULL)
+			free(bp->pool_key);
+		free(bp);
+	}
+
+	if (PoolWaitSet == NULL)
+		return;
+
+	/* Don't keep clients waiting on a server that is going away */
+	if (Shutdown >= FastShutdown || FatalError)
+	{
+		dlist_foreach_modify(miter, &IdleSessions)
+			SessionPoolDropSession(dlist_container(PooledSession, elem, miter.cur));
+		dlist_foreach_modify(miter, &ReadySessions)
+			SessionPoolDropSession(dlist_container(PooledSession, elem, miter.cur));
+		return;
+	}
+
+	/*
+	 * Serve sessions that have been waiting for a backend.  During a smart
+	 * shutdown, no new backends can be started, so drop those that no backend
+	 * is left to serve.
+	 */
+	dlist_foreach_modify(miter, &ReadySessions)
+	{
+		PooledSession *session = dlist_container(PooledSession, elem, miter.cur);
+
+		if (!SessionPoolDispatch(session) && Shutdown > NoShutdown &&
+			SessionPoolCountBackends(&session->key) == 0)
+			SessionPoolDropSession(session);
+	}
+
+	/*
+	 * Likewise, idle backends only get in the way of a smart shutdown once
+	 * there are no sessions left for them to serve.
+	 */
+	if (Shutdown > NoShutdown)
+	{
+		dlist_foreach(iter, &BackendList)
+		{
+			Backend    *bp = dlist_container(Backend, elem, iter.cur);
+			bool		needed = false;
+			dlist_iter	siter;
+
+			if (!bp->pool_idle)
+				continue;
+
+			dlist_foreach(siter, &IdleSessions)
+			{
+				PooledSession *session = dlist_container(PooledSession, elem, siter.cur);
+
+				if (SessionPoolKeyEquals(&session->key, bp->pool_key))
+				{
+					needed = true;
+					break;
+				}
+			}
+
+			if (!needed)
+				SessionPoolDismiss(bp);
+		}
+	}
+}
+
+
+/*
+ * Pre-forked backends
+ *
+ * To spare new connections the wait for a fork and for the part of backend
+ * startup that doesn't depend on the connection, ServerLoop keeps
+ * PreforkedBackends children forked ahead of time.  Such a child takes a
+ * PGPROC, joins the ProcArray and the shared invalidation queue, and sets up
+ * the relation and catalog caches with the shared catalogs' relcache entries
+ * (see PreInitPostgres), then waits on its pool channel for the postmaster to
+ * pass it a connection: either a freshly accepted one or a pooled session
+ * that needs a backend.  It carries on from there as BackendStartup's child
+ * would, skipping what it has done already.
+ *
+ * The PGPROC is a regular backend's.  Only the startup packet tells whether
+ * the connection is a replication connection, so a pre-forked backend that
+ * turns out to be a walsender trades it for a walsender's PGPROC then (see
+ * ProcBecomeWalSender), and is accounted for like any other walsender from
+ * there on.  Since each idle one holds a PGPROC, there are never more of them
+ * than max_connections allows for beside the backends already running, and
+ * they leave room among the children for the autovacuum workers, background
+ * workers and walsenders that may yet be started.
+ *
+ * Pre-forked backends keep the configuration and pg_hba.conf of the time they
+ * were forked, so they are replaced on every reload.
+ */
+
+/*
+ * Fork a backend to wait for a connection.  Returns false on failure.
+ */
+static bool
+PreforkBackend(void)
+{
+#ifdef EXEC_BACKEND
+	/* check_preforked_backends doesn't let us get here */
+	return false;
+#else
+	Backend    *bn;
+	pgsocket	childEnd;
+	pid_t		pid;
+
+	bn = (Backend *) malloc(sizeof(Backend));
+	if (!bn)
+	{
+		ereport(LOG,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+		return false;
+	}
+
+	/* As in BackendStartup, the child inherits its cancel key */
+	if (!RandomCancelKey(&MyCancelKey))
+	{
+		free(bn);
+		ereport(LOG,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not generate random cancel key")));
+		return false;
+	}
+
+	if (!SessionPoolCreateChannel(&bn->pool_channel, &childEnd))
+	{
+		free(bn);
+		ereport(LOG,
+				(errcode_for_socket_access(),
+				 errmsg("could not create channel for pre-forked server process: %m")));
+		return false;
+	}
+
+	bn->cancel_key = MyCancelKey;
+	bn->dead_end = false;
+	bn->child_slot = MyPMChildSlot = AssignPostmasterChildSlot();
+	bn->bgworker_notify = false;
+	bn->pool_key = NULL;
+	bn->pool_idle = false;
+
+	pid = fork_process();
+	if (pid == 0)				/* child */
+	{
+		closesocket(bn->pool_channel);
+		free(bn);
+
+		/* Detangle from postmaster */
+		InitPostmasterChild();
+
+		/* Close the postmaster's sockets */
+		ClosePostmasterPorts(false);
+
+		/* Wait for a connection, and serve it */
+		PreforkedBackendMain(childEnd);
+	}
+
+	closesocket(childEnd);
+
+	if (pid < 0)
+	{
+		/* in parent, fork failed */
+		int			save_errno = errno;
+
+		(void) ReleasePostmasterChildSlot(bn->child_slot);
+		closesocket(bn->pool_channel);
+		free(bn);
+		errno = save_errno;
+		ereport(LOG,
+				(errmsg("could not fork pre-forked server process: %m")));
+		return false;
+	}
+
+	/* in parent, successful fork */
+	ereport(DEBUG2,
+			(errmsg_internal("forked new backend ahead of time, pid=%d",
+							 (int) pid)));
+
+	bn->pid = pid;
+	bn->bkend_type = BACKEND_TYPE_NORMAL;
+	bn->prefork_idle = true;
+	bn->session_pid = bn->pid;
+	bn->session_key = bn->cancel_key;
+	bn->pool_event.is_session = false;
+	bn->pool_event.pos = -1;
+	if (PoolWaitSet != NULL)
+		SessionPoolWatch(&bn->pool_event, bn->pool_channel);
+	dlist_push_head(&BackendList, &bn->elem);
+	NumIdlePreforked++;
+
+	return true;
+#endif							/* EXEC_BACKEND */
+}
+
+/*
+ * Pass a new connection, or a pooled session that needs a backend, to an
+ * idle pre-forked backend.  Returns false if none could take it, in which
+ * case BackendStartup forks a backend for it as usual.
+ */
+static bool
+PreforkedBackendStartup(Port *port)
+{
+	dlist_iter	iter;
+
+	if (NumIdlePreforked == 0 || !PreforkedBackendsUsable())
+		return false;
+
+	dlist_foreach(iter, &BackendList)
+	{
+		Backend    *bp = dlist_container(Backend, elem, iter.cur);
+		SessionPoolMessage msg;
+
+		if (!bp->prefork_idle)
+			continue;
+
+		bp->prefork_idle = false;
+		NumIdlePreforked--;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.type = SPM_CONNECT;
+		if (port->pool_key != NULL)
+		{
+			msg.sessionPid = port->pool_session_pid;
+			msg.sessionKey = port->pool_session_key;
+			memcpy(&msg.key, port->pool_key, sizeof(SessionPoolKey));
+		}
+
+		if (!SessionPoolSend(bp->pool_channel, &msg, port->sock))
+		{
+			/* it's probably gone already; make sure it's useless */
+			ereport(LOG,
+					(errcode_for_socket_access(),
+					 errmsg("could not pass connection to pre-forked server process %d: %m",
+							(int) bp->pid)));
+			signal_child(bp->pid, SIGTERM);
+			continue;
+		}
+
+		ereport(DEBUG2,
+				(errmsg_internal("passed connection to pre-forked backend, pid=%d socket=%d",
+								 (int) bp->pid, (int) port->sock)));
+
+		/* From here on, treat it like BackendStartup's child */
+		if (PoolWaitSet == NULL)
+		{
+			closesocket(bp->pool_channel);
+			bp->pool_channel = PGINVALID_SOCKET;
+		}
+		else if (port->pool_key != NULL)
+		{
+			bp->pool_key = port->pool_key;
+			port->pool_key = NULL;
+			bp->session_pid = msg.sessionPid;
+			bp->session_key = msg.sessionKey;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Can idle pre-forked backends take connections?  They are counted as
+ * children already, so passing them a connection doesn't add to the number
+ * of children, and reaching the limit on that is no reason not to.
+ */
+static bool
+PreforkedBackendsUsable(void)
+{
+	CAC_state	cac = canAcceptConnections();
+
+	return cac == CAC_OK ||
+		(cac == CAC_TOOMANY && pmState != PM_WAIT_BACKUP);
+}
+
+/*
+ * Is there room for another pre-forked backend?  It needs a regular
+ * backend's PGPROC, and every regular backend has one or is about to take
+ * one.  It also mustn't take a child slot that an autovacuum worker, a
+ * background worker or a walsender could need.
+ */
+static bool
+PreforkedBackendFits(void)
+{
+	if (canAcceptConnections() != CAC_OK)
+		return false;
+	if (CountChildren(BACKEND_TYPE_NORMAL) >= MaxConnections)
+		return false;
+	return CountChildren(BACKEND_TYPE_ALL) + autovacuum_max_workers +
+		max_worker_processes + max_wal_senders < MaxLivePostmasterChildren();
+}
+
+/*
+ * Keep PreforkedBackends pre-forked backends waiting for connections, or none
+ * if no connections are being accepted.  Done on every iteration of
+ * ServerLoop.
+ *
+ * When there's no room for more, we keep the ones we have but don't fork
+ * more.  Dismissing them there would make room, only for the next iteration
+ * to fork them again.
+ */
+static void
+PreforkedBackendsMaintenance(void)
+{
+	if (!PreforkedBackendsUsable())
+	{
+		DismissPreforkedBackends(0);
+		return;
+	}
+
+	DismissPreforkedBackends(PreforkedBackends);
+
+	while (NumIdlePreforked < PreforkedBackends && PreforkedBackendFits())
+	{
+		if (!PreforkBackend())
+			break;
+	}
+}
+
+/*
+ * Is there a child slot for an autovacuum worker or a background worker?
+ * PreforkedBackendFits leaves room for them, but if there's none all the
+ * same, dismiss an idle pre-forked backend so that the next try finds one.
+ */
+static bool
+WorkerChildSlotAvailable(void)
+{
+	if (CountChildren(BACKEND_TYPE_ALL) < MaxLivePostmasterChildren())
+		return true;
 
-		/* If we have lost the archiver, try to start a new one. */
-		if (PgArchPID == 0 && PgArchStartupAllowed())
-			PgArchPID = pgarch_start();
+	if (NumIdlePreforked > 0)
+		DismissPreforkedBackends(NumIdlePreforked - 1);
+	return false;
+}
 
-		/* If we need to signal the autovacuum launcher, do so now */
-		if (avlauncher_needs_signal)
-		{
-			avlauncher_needs_signal = false;
-			if (AutoVacPID != 0)
-				kill(AutoVacPID, SIGUSR2);
-		}
+/*
+ * Tell idle pre-forked backends to exit, all but "keep" of them.
+ */
+static void
+DismissPreforkedBackends(int keep)
+{
+	dlist_iter	iter;
 
-		/* If we need to start a WAL receiver, try to do that now */
-		if (WalReceiverRequested)
-			MaybeStartWalReceiver();
+	dlist_foreach(iter, &BackendList)
+	{
+		Backend    *bp = dlist_container(Backend, elem, iter.cur);
 
-		/* Get other worker processes running, if needed */
-		if (StartWorkerNeeded || HaveCrashedWorker)
-			maybe_start_bgworkers();
+		if (NumIdlePreforked <= keep)
+			break;
+		if (bp->prefork_idle)
+			SessionPoolDismiss(bp);
+	}
+}
 
-#ifdef HAVE_PTHREAD_IS_THREADED_NP
+#ifndef EXEC_BACKEND
+/*
+ * PreforkedBackendMain -- body of a pre-forked backend
+ *
+ * Do as much of a backend's initialization as doesn't depend on the
+ * connection, then wait for the postmaster to pass us one over our channel.
+ * While we wait, we're in the ProcArray and the shared invalidation queue
+ * like any idle backend, so we keep up with the invalidations sent to us,
+ * and exit on SIGTERM or a message telling us to.
+ */
+static void
+PreforkedBackendMain(pgsocket channel)
+{
+	SessionPoolMessage msg;
+	pgsocket	sock;
+	Port	   *port;
 
-		/*
-		 * With assertions enabled, check regularly for appearance of
-		 * additional threads.  All builds check at start and exit.
-		 */
-		Assert(pthread_is_threaded_np() == 0);
-#endif
+	/*
+	 * Set up signal handlers as PostgresMain does, which sets them again once
+	 * we have a connection.  There is no query to cancel yet.
+	 */
+	pqsignal(SIGHUP, PostgresSigHupHandler);
+	pqsignal(SIGINT, SIG_IGN);
+	pqsignal(SIGTERM, die);
+	pqsignal(SIGQUIT, quickdie);
+	InitializeTimeouts();		/* establishes SIGALRM handler */
+	pqsignal(SIGPIPE, SIG_IGN);
+	pqsignal(SIGUSR1, procsignal_sigusr1_handler);
+	pqsignal(SIGUSR2, SIG_IGN);
+	pqsignal(SIGFPE, FloatExceptionHandler);
+	pqsignal(SIGCHLD, SIG_DFL);
 
-		/*
-		 * Lastly, check to see if it's time to do some things that we don't
-		 * want to do every single time through the loop, because they're a
-		 * bit expensive.  Note that there's up to a minute of slop in when
-		 * these tasks will be performed, since DetermineSleepTime() will let
-		 * us sleep at most that long; except for SIGKILL timeout which has
-		 * special-case logic there.
-		 */
-		now = time(NULL);
+	PreInitPostgres();
+	ProcSetPreforkedIdle(true);
 
-		/*
-		 * If we already sent SIGQUIT to children and they are slow to shut
-		 * down, it's time to send them SIGKILL.  This doesn't happen
-		 * normally, but under certain conditions backends can get stuck while
-		 * shutting down.  This is a last measure to get them unwedged.
-		 *
-		 * Note we also do this during recovery from a process crash.
-		 */
-		if ((Shutdown >= ImmediateShutdown || (FatalError && !SendStop)) &&
-			AbortStartTime != 0 &&
-			(now - AbortStartTime) >= SIGKILL_CHILDREN_AFTER_SECS)
-		{
-			/* We were gentle with them before. Not anymore */
-			TerminateChildren(SIGKILL);
-			/* reset flag so we don't SIGKILL again */
-			AbortStartTime = 0;
-		}
+	PG_SETMASK(&UnBlockSig);
 
-		/*
-		 * Once a minute, verify that postmaster.pid hasn't been removed or
-		 * overwritten.  If it has, we force a shutdown.  This avoids having
-		 * postmasters and child processes hanging around after their database
-		 * is gone, and maybe causing problems if a new database cluster is
-		 * created in the same place.  It also provides some protection
-		 * against a DBA foolishly removing postmaster.pid and manually
-		 * starting a new postmaster.  Data corruption is likely to ensue from
-		 * that anyway, but we can minimize the damage by aborting ASAP.
-		 */
-		if (now - last_lockfile_recheck_time >= 1 * SECS_PER_MINUTE)
+	for (;;)
+	{
+		int			rc;
+
+		rc = WaitLatchOrSocket(MyLatch,
+							   WL_LATCH_SET | WL_SOCKET_READABLE | WL_EXIT_ON_PM_DEATH,
+							   channel, -1L, 0);
+
+		if (rc & WL_LATCH_SET)
 		{
-			if (!RecheckDataDirLockFile())
+			ResetLatch(MyLatch);
+
+			if (ProcDiePending)
+				proc_exit(0);
+
+			/*
+			 * Catch up with the invalidation queue.  We're not in a
+			 * transaction and have no database yet, so all there is to
+			 * invalidate is the shared catalogs' relcache entries.
+			 */
+			if (catchupInterruptPending)
 			{
-				ereport(LOG,
-						(errmsg("performing immediate shutdown because data directory lock file is invalid")));
-				kill(MyProcPid, SIGQUIT);
+				catchupInterruptPending = false;
+				AcceptInvalidationMessages();
 			}
-			last_lockfile_recheck_time = now;
 		}
 
-		/*
-		 * Touch Unix socket and lock files every 58 minutes, to ensure that
-		 * they are not removed by overzealous /tmp-cleaning tasks.  We assume
-		 * no one runs cleaners with cutoff times of less than an hour ...
-		 */
-		if (now - last_touch_time >= 58 * SECS_PER_MINUTE)
+		if (!(rc & WL_SOCKET_READABLE))
+			continue;
+
+		if (!SessionPoolReceive(channel, &msg, &sock))
 		{
-			TouchSocketFiles();
-			TouchSocketLockFiles();
-			last_touch_time = now;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				continue;
+			ereport(FATAL,
+					(errcode_for_socket_access(),
+					 errmsg("could not receive from postmaster channel: %m")));
 		}
+
+		if (msg.type == SPM_EXIT)
+			proc_exit(0);
+
+		if (msg.type != SPM_CONNECT || sock == PGINVALID_SOCKET)
+			elog(FATAL, "unexpected connection pool message type %d",
+				 (int) msg.type);
+		break;
 	}
-}
 
-/*
- * Initialise the masks for select() for the ports we are listening on.
- * Return the number of sockets to listen on.
- */
-static int
-initMasks(fd_set *rmask)
-{
-	int			maxsock = -1;
-	int			i;
+	ProcSetPreforkedIdle(false);
 
-	FD_ZERO(rmask);
+	/* Back to the state BackendStartup's child starts in */
+	PG_SETMASK(&BlockSig);
 
-	for (i = 0; i < MAXLISTEN; i++)
-	{
-		int			fd = ListenSocket[i];
+	/* As far as anyone can tell, this backend starts now */
+	MyStartTimestamp = GetCurrentTimestamp();
+	MyStartTime = timestamptz_to_time_t(MyStartTimestamp);
 
-		if (fd == PGINVALID_SOCKET)
-			break;
-		FD_SET(fd, rmask);
+	port = ConnAdopt(sock);
+	if (port == NULL)
+		proc_exit(0);
+	port->canAcceptConnections = CAC_OK;
 
-		if (fd > maxsock)
-			maxsock = fd;
+	if (msg.sessionPid != 0)
+	{
+		port->pool_key = (SessionPoolKey *) malloc(sizeof(SessionPoolKey));
+		if (port->pool_key == NULL)
+			ereport(FATAL,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory")));
+		memcpy(port->pool_key, &msg.key, sizeof(SessionPoolKey));
+		port->pool_session_pid = msg.sessionPid;
+		port->pool_session_key = msg.sessionKey;
 	}
 
-	return maxsock + 1;
+	/* Without pooling, the postmaster has closed its end of the channel */
+	if (connection_pool_size > 0)
+		port->pool_channel = channel;
+	else
+		closesocket(channel);
+
+	BackendInitialize(port);
+
+	/* Only now do we know if we should have taken a walsender's PGPROC */
+	if (am_walsender)
+		ProcBecomeWalSender();
+
+	BackendRun(port);
 }
+#endif							/* EXEC_BACKEND */
 
 
 /*
@@ -2299,6 +3399,8 @@ processCancelRequest(Port *port, void *pkt)
 	int			backendPID;
 	int32		cancelAuthCode;
 	Backend    *bp;
+	int			pid;
+	int32		cancel_key;
 
 #ifndef EXEC_BACKEND
 	dlist_iter	iter;
@@ -2323,9 +3425,21 @@ processCancelRequest(Port *port, void *pkt)
 	{
 		bp = (Backend *) &ShmemBackendArray[i];
 #endif
-		if (bp->pid == backendPID)
+		/* A pooled backend answers for the session it is serving */
+		if (bp->pool_channel != PGINVALID_SOCKET)
+		{
+			pid = bp->session_pid;
+			cancel_key = bp->session_key;
+		}
+		else
+		{
+			pid = bp->pid;
+			cancel_key = bp->cancel_key;
+		}
+
+		if (pid == backendPID)
 		{
-			if (bp->cancel_key == cancelAuthCode)
+			if (cancel_key == cancelAuthCode)
 			{
 				/* Found a match; signal that backend to cancel current op */
 				ereport(DEBUG2,
@@ -2419,6 +3533,7 @@ ConnCreate(int serverFd)
 				 errmsg("out of memory")));
 		ExitPostmaster(1);
 	}
+	port->pool_channel = PGINVALID_SOCKET;
 
 	if (StreamConnection(serverFd, port) != STATUS_OK)
 	{
@@ -2448,6 +3563,59 @@ ConnCreate(int serverFd)
 }
 
 
+/*
+ * ConnAdopt -- create a local connection data structure for a client
+ * connection accepted earlier, possibly by another process
+ *
+ * Returns NULL on failure, after logging it.  The caller keeps ownership of
+ * the socket either way.
+ */
+static Port *
+ConnAdopt(pgsocket sock)
+{
+	Port	   *port;
+
+	if (!(port = (Port *) calloc(1, sizeof(Port))))
+	{
+		ereport(LOG,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+		return NULL;
+	}
+	port->sock = sock;
+	port->pool_channel = PGINVALID_SOCKET;
+
+	/* BackendInitialize wants to know who's there */
+	port->laddr.salen = sizeof(port->laddr.addr);
+	port->raddr.salen = sizeof(port->raddr.addr);
+	if (getsockname(port->sock, (struct sockaddr *) &port->laddr.addr,
+					&port->laddr.salen) < 0 ||
+		getpeername(port->sock, (struct sockaddr *) &port->raddr.addr,
+					&port->raddr.salen) < 0)
+	{
+		ereport(LOG,
+				(errcode_for_socket_access(),
+				 errmsg("could not get address of client connection: %m")));
+		free(port);
+		return NULL;
+	}
+
+#if defined(ENABLE_GSS) || defined(ENABLE_SSPI)
+	port->gss = (pg_gssinfo *) calloc(1, sizeof(pg_gssinfo));
+	if (!port->gss)
+	{
+		ereport(LOG,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+		free(port);
+		return NULL;
+	}
+#endif
+
+	return port;
+}
+
+
 /*
  * ConnFree -- free a local connection data structure
  */
@@ -2502,6 +3670,47 @@ ClosePostmasterPorts(bool am_syslogger)
 		}
 	}
 
+	/*
+	 * Close the connection pool's wait set, channels and sessions.  Leave the
+	 * BackendList entries alone otherwise, processCancelRequest needs them.
+	 * Pre-forked backends have channels even without pooling.
+	 */
+	if (PoolWaitSet != NULL)
+	{
+		FreeWaitEventSet(PoolWaitSet);
+		PoolWaitSet = NULL;
+	}
+
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &BackendList)
+		{
+			Backend    *bp = dlist_container(Backend, elem, iter.cur);
+
+			if (bp->pool_channel != PGINVALID_SOCKET)
+				closesocket(bp->pool_channel);
+		}
+		dlist_foreach(iter, &DeadPoolBackends)
+		{
+			Backend    *bp = dlist_container(Backend, elem, iter.cur);
+
+			closesocket(bp->pool_channel);
+		}
+		dlist_foreach(iter, &IdleSessions)
+		{
+			PooledSession *session = dlist_container(PooledSession, elem, iter.cur);
+
+			StreamClose(session->sock);
+		}
+		dlist_foreach(iter, &ReadySessions)
+		{
+			PooledSession *session = dlist_container(PooledSession, elem, iter.cur);
+
+			StreamClose(session->sock);
+		}
+	}
+
 	/* If using syslogger, close the read side of the pipe */
 	if (!am_syslogger)
 	{
@@ -2622,6 +3831,12 @@ SIGHUP_handler(SIGNAL_ARGS)
 			ereport(LOG,
 					(errmsg("pg_ident.conf was not reloaded")));
 
+		/*
+		 * Idle pre-forked backends still have the old configuration, and
+		 * couldn't reload pg_hba.conf if they tried; have them replaced.
+		 */
+		DismissPreforkedBackends(0);
+
 #ifdef USE_SSL
 		/* Reload SSL configuration as well */
 		if (EnableSSL)
@@ -2645,6 +3860,8 @@ SIGHUP_handler(SIGNAL_ARGS)
 #endif
 	}
 
+	WakeServerLoop();
+
 	PG_SETMASK(&UnBlockSig);
 
 	errno = save_errno;
@@ -2825,6 +4042,8 @@ pmdie(SIGNAL_ARGS)
 			break;
 	}
 
+	WakeServerLoop();
+
 	PG_SETMASK(&UnBlockSig);
 
 	errno = save_errno;
@@ -3141,6 +4360,8 @@ reaper(SIGNAL_ARGS)
 	 */
 	PostmasterStateMachine();
 
+	WakeServerLoop();
+
 	/* Done with signal handler */
 	PG_SETMASK(&UnBlockSig);
 
@@ -3327,7 +4548,7 @@ CleanupBackend(int pid,
 				BackgroundWorkerStopNotifications(bp->pid);
 			}
 			dlist_delete(iter.cur);
-			free(bp);
+			FreeBackendEntry(bp);
 			break;
 		}
 	}
@@ -3430,7 +4651,7 @@ HandleChildCrash(int pid, int exitstatus, const char *procname)
 #endif
 			}
 			dlist_delete(iter.cur);
-			free(bp);
+			FreeBackendEntry(bp);
 			/* Keep looping so we can signal remaining backends */
 		}
 		else
@@ -4024,6 +5245,10 @@ BackendStartup(Port *port)
 	Backend    *bn;				/* for backend cleanup */
 	pid_t		pid;
 
+	/* If a pre-forked backend is waiting, it can take the connection */
+	if (PreforkedBackendStartup(port))
+		return STATUS_OK;
+
 	/*
 	 * Create backend data structure.  Better before the fork() so we can
 	 * handle failure cleanly.
@@ -4069,12 +5294,27 @@ BackendStartup(Port *port)
 	/* Hasn't asked to be notified about any bgworkers yet */
 	bn->bgworker_notify = false;
 
+	/*
+	 * With connection pooling, give the backend a channel to hand back its
+	 * session through.  Without one, it just keeps the session to itself.
+	 */
+	bn->pool_channel = PGINVALID_SOCKET;
+	bn->pool_key = NULL;
+	bn->prefork_idle = false;
+	if (PoolWaitSet != NULL && !bn->dead_end &&
+		!SessionPoolCreateChannel(&bn->pool_channel, &port->pool_channel))
+		ereport(LOG,
+				(errcode_for_socket_access(),
+				 errmsg("could not create connection pool channel: %m")));
+
 #ifdef EXEC_BACKEND
 	pid = backend_forkexec(port);
 #else							/* !EXEC_BACKEND */
 	pid = fork_process();
 	if (pid == 0)				/* child */
 	{
+		if (bn->pool_channel != PGINVALID_SOCKET)
+			closesocket(bn->pool_channel);
 		free(bn);
 
 		/* Detangle from postmaster */
@@ -4098,11 +5338,19 @@ BackendStartup(Port *port)
 
 		if (!bn->dead_end)
 			(void) ReleasePostmasterChildSlot(bn->child_slot);
+		if (bn->pool_channel != PGINVALID_SOCKET)
+		{
+			closesocket(bn->pool_channel);
+			closesocket(port->pool_channel);
+			port->pool_channel = PGINVALID_SOCKET;
+		}
 		free(bn);
 		errno = save_errno;
 		ereport(LOG,
 				(errmsg("could not fork new process for connection: %m")));
-		report_fork_failure_to_client(port, save_errno);
+		/* a pooled session's client is not expecting a startup failure */
+		if (port->pool_key == NULL)
+			report_fork_failure_to_client(port, save_errno);
 		return STATUS_ERROR;
 	}
 
@@ -4119,6 +5367,31 @@ BackendStartup(Port *port)
 	bn->bkend_type = BACKEND_TYPE_NORMAL;	/* Can change later to WALSND */
 	dlist_push_head(&BackendList, &bn->elem);
 
+	if (bn->pool_channel != PGINVALID_SOCKET)
+	{
+		/* The backend's end of the channel is its business now */
+		closesocket(port->pool_channel);
+		port->pool_channel = PGINVALID_SOCKET;
+
+		/* A backend started for a pooled session serves its kind from now on */
+		bn->pool_key = port->pool_key;
+		port->pool_key = NULL;
+		bn->pool_idle = false;
+		if (bn->pool_key != NULL)
+		{
+			bn->session_pid = port->pool_session_pid;
+			bn->session_key = port->pool_session_key;
+		}
+		else
+		{
+			bn->session_pid = bn->pid;
+			bn->session_key = bn->cancel_key;
+		}
+		bn->pool_event.is_session = false;
+		bn->pool_event.pos = -1;
+		SessionPoolWatch(&bn->pool_event, bn->pool_channel);
+	}
+
 #ifdef EXEC_BACKEND
 	if (!bn->dead_end)
 		ShmemBackendArrayAdd(bn);
@@ -4299,9 +5572,21 @@ BackendInitialize(Port *port)
 
 	/*
 	 * Receive the startup packet (which might turn out to be a cancel request
-	 * packet).
+	 * packet).  A session handed over by the connection pool went through
+	 * that with another backend, so just recover what it said.  Otherwise,
+	 * the session will be known by this backend's BackendKeyData.
 	 */
-	status = ProcessStartupPacket(port, false);
+	if (port->pool_key != NULL)
+	{
+		SessionPoolRestorePort(port);
+		status = STATUS_OK;
+	}
+	else
+	{
+		port->pool_session_pid = MyProcPid;
+		port->pool_session_key = MyCancelKey;
+		status = ProcessStartupPacket(port, false);
+	}
 
 	/*
 	 * Stop here if it was bad or a cancel packet.  ProcessStartupPacket
@@ -5197,6 +6482,8 @@ sigusr1_handler(SIGNAL_ARGS)
 		signal_child(StartupPID, SIGUSR2);
 	}
 
+	WakeServerLoop();
+
 	PG_SETMASK(&UnBlockSig);
 
 	errno = save_errno;
@@ -5417,7 +6704,7 @@ StartAutovacuumWorker(void)
 	 * we have to check to avoid race-condition problems during DB state
 	 * changes.
 	 */
-	if (canAcceptConnections() == CAC_OK)
+	if (canAcceptConnections() == CAC_OK && WorkerChildSlotAvailable())
 	{
 		/*
 		 * Compute the cancel key that will be assigned to this session. We
@@ -5442,6 +6729,9 @@ StartAutovacuumWorker(void)
 			bn->dead_end = false;
 			bn->child_slot = MyPMChildSlot = AssignPostmasterChildSlot();
 			bn->bgworker_notify = false;
+			bn->pool_channel = PGINVALID_SOCKET;
+			bn->pool_key = NULL;
+			bn->prefork_idle = false;
 
 			bn->pid = StartAutoVacWorker();
 			if (bn->pid > 0)
@@ -5783,6 +7073,15 @@ assign_backendlist_entry(RegisteredBgWorker *rw)
 {
 	Backend    *bn;
 
+	/* Make sure AssignPostmasterChildSlot won't run out of slots */
+	if (!WorkerChildSlotAvailable())
+	{
+		ereport(LOG,
+				(errcode(ERRCODE_CONFIGURATION_LIMIT_EXCEEDED),
+				 errmsg("no slot available for new worker process")));
+		return false;
+	}
+
 	/*
 	 * Compute the cancel key that will be assigned to this session. We
 	 * probably don't need cancel keys for background workers, but we'd better
@@ -5811,6 +7110,9 @@ assign_backendlist_entry(RegisteredBgWorker *rw)
 	bn->bkend_type = BACKEND_TYPE_BGWORKER;
 	bn->dead_end = false;
 	bn->bgworker_notify = false;
+	bn->pool_channel = PGINVALID_SOCKET;
+	bn->pool_key = NULL;
+	bn->prefork_idle = false;
 
 	rw->rw_backend = bn;
 	rw->rw_child_slot = bn->child_slot;
@@ -6042,6 +7344,7 @@ save_backend_variables(BackendParameters *param, Port *port,
 	param->max_safe_fds = max_safe_fds;
 
 	param->MaxBackends = MaxBackends;
+	param->NBuffers = NBuffers;
 
 #ifdef WIN32
 	param->PostmasterHandle = PostmasterHandle;
@@ -6274,6 +7577,7 @@ restore_backend_variables(BackendParameters *param, Port *port)
 	max_safe_fds = param->max_safe_fds;
 
 	MaxBackends = param->MaxBackends;
+	NBuffers = param->NBuffers;
 
 #ifdef WIN32
 	PostmasterHandle = param->PostmasterHandle;
@@ -0,0 +1,480 @@
+/*-------------------------------------------------------------------------
+ *
+ * sessionpool.c
+ *	  Built-in connection pooling: the backend's side
+ *
+ * With connection_pool_size > 0, a backend whose client session is idle
+ * between transactions, and holds no state that a fresh backend for the same
+ * database, user and startup options wouldn't have, hands the client socket
+ * back to the postmaster.  It then waits for the postmaster to assign it
+ * another such session, or to tell it to exit.  The postmaster watches the
+ * idle sessions, and passes each one on when its client sends something,
+ * starting a new backend for it if need be.  See ServerLoop for that side.
+ *
+ * Sockets travel between the postmaster and a backend over a Unix-domain
+ * datagram socket pair, the backend's pool channel, as SCM_RIGHTS control
+ * messages.  A backend started for a session that has been through startup
+ * and authentication with some other backend skips both: the client is
+ * already waiting for the result of its next query.
+ *
+ * Session state that pins a session to its backend: settings changed with
+ * SET, prepared statements, holdable cursors, LISTEN, session-level advisory
+ * locks, temporary tables and sequence state (currval/lastval).  SSL
+ * sessions are never pooled, since the encryption state can't be handed
+ * over.  The unnamed prepared statement is dropped when a session is handed
+ * back.  State kept by extensions, such as libraries loaded with LOAD or the
+ * interpreters of procedural languages, isn't detected; an extension whose
+ * state must stay with its session can say so through
+ * session_pool_release_hook.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/postmaster/sessionpool.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+#include "access/xact.h"
+#include "catalog/namespace.h"
+#include "commands/async.h"
+#include "commands/prepare.h"
+#include "commands/sequence.h"
+#include "common/ip.h"
+#include "libpq/libpq.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "postmaster/sessionpool.h"
+#include "replication/walsender.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lock.h"
+#include "tcop/tcopprot.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/portal.h"
+#include "utils/ps_status.h"
+
+
+/* GUC parameters */
+int			connection_pool_size = 0;
+int			max_pooled_sessions = 1000;
+
+/* Hook for extensions to keep sessions from being handed back */
+session_pool_release_hook_type session_pool_release_hook = NULL;
+
+/* Which sessions this backend can serve; NULL if it can't be pooled */
+static SessionPoolKey *MySessionPoolKey = NULL;
+static bool MySessionPoolKeyValid = false;
+
+/* Remote address of the session being served, once one has been assigned */
+static char pool_remote_host[NI_MAXHOST];
+static char pool_remote_port[NI_MAXSERV];
+
+
+/*
+ * Create a pool channel.  Both ends are non-blocking.
+ */
+bool
+SessionPoolCreateChannel(pgsocket *postmasterEnd, pgsocket *backendEnd)
+{
+#ifdef SESSION_POOL_SUPPORTED
+	int			fds[2];
+
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) < 0)
+		return false;
+
+	if (!pg_set_noblock(fds[0]) || !pg_set_noblock(fds[1]))
+	{
+		int			save_errno = errno;
+
+		close(fds[0]);
+		close(fds[1]);
+		errno = save_errno;
+		return false;
+	}
+
+	*postmasterEnd = fds[0];
+	*backendEnd = fds[1];
+	return true;
+#else
+	errno = ENOSYS;
+	return false;
+#endif
+}
+
+/*
+ * Send a message over a pool channel, passing along 'sock' unless it's
+ * PGINVALID_SOCKET.  On failure, returns false with errno set.
+ */
+bool
+SessionPoolSend(pgsocket channel, const SessionPoolMessage *msg,
+				pgsocket sock)
+{
+#ifdef SESSION_POOL_SUPPORTED
+	struct msghdr mh;
+	struct iovec iov;
+	union
+	{
+		struct cmsghdr hdr;
+		char		buf[CMSG_SPACE(sizeof(int))];
+	}			cmsgbuf;
+	ssize_t		rc;
+
+	memset(&mh, 0, sizeof(mh));
+	iov.iov_base = (void *) msg;
+	iov.iov_len = sizeof(SessionPoolMessage);
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+
+	if (sock != PGINVALID_SOCKET)
+	{
+		struct cmsghdr *cmsg;
+
+		memset(&cmsgbuf, 0, sizeof(cmsgbuf));
+		mh.msg_control = cmsgbuf.buf;
+		mh.msg_controllen = sizeof(cmsgbuf.buf);
+		cmsg = CMSG_FIRSTHDR(&mh);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), &sock, sizeof(int));
+	}
+
+	do
+	{
+		rc = sendmsg(channel, &mh, 0);
+	} while (rc < 0 && errno == EINTR);
+
+	if (rc < 0)
+		return false;
+	if (rc != sizeof(SessionPoolMessage))
+	{
+		errno = EMSGSIZE;
+		return false;
+	}
+	return true;
+#else
+	errno = ENOSYS;
+	return false;
+#endif
+}
+
+/*
+ * Receive a message from a pool channel.  *sock is set to the socket that
+ * came with it, or PGINVALID_SOCKET.  On failure, returns false with errno
+ * set; EAGAIN means there was nothing to receive.
+ */
+bool
+SessionPoolReceive(pgsocket channel, SessionPoolMessage *msg, pgsocket *sock)
+{
+#ifdef SESSION_POOL_SUPPORTED
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	union
+	{
+		struct cmsghdr hdr;
+		char		buf[CMSG_SPACE(sizeof(int))];
+	}			cmsgbuf;
+	ssize_t		rc;
+
+	*sock = PGINVALID_SOCKET;
+
+	memset(&mh, 0, sizeof(mh));
+	iov.iov_base = msg;
+	iov.iov_len = sizeof(SessionPoolMessage);
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+	mh.msg_control = cmsgbuf.buf;
+	mh.msg_controllen = sizeof(cmsgbuf.buf);
+
+	do
+	{
+		rc = recvmsg(channel, &mh, 0);
+	} while (rc < 0 && errno == EINTR);
+
+	if (rc < 0)
+		return false;
+
+	for (cmsg = CMSG_FIRSTHDR(&mh); cmsg != NULL; cmsg = CMSG_NXTHDR(&mh, cmsg))
+	{
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+			memcpy(sock, CMSG_DATA(cmsg), sizeof(int));
+	}
+
+	if (rc != sizeof(SessionPoolMessage) || (mh.msg_flags & MSG_CTRUNC))
+	{
+		if (*sock != PGINVALID_SOCKET)
+			close(*sock);
+		*sock = PGINVALID_SOCKET;
+		errno = (rc == 0) ? ECONNRESET : EMSGSIZE;
+		return false;
+	}
+	return true;
+#else
+	errno = ENOSYS;
+	return false;
+#endif
+}
+
+/*
+ * Can sessions with these keys be served by the same backends?
+ */
+bool
+SessionPoolKeyEquals(const SessionPoolKey *a, const SessionPoolKey *b)
+{
+	return a->proto == b->proto &&
+		a->optionslen == b->optionslen &&
+		strcmp(a->database, b->database) == 0 &&
+		strcmp(a->user, b->user) == 0 &&
+		memcmp(a->options, b->options, a->optionslen) == 0;
+}
+
+/*
+ * Append a NUL-terminated string to key->options, if it fits.
+ */
+static bool
+AppendSessionPoolKeyOption(SessionPoolKey *key, const char *str)
+{
+	int			len = strlen(str) + 1;
+
+	if (key->optionslen + len > SESSION_POOL_OPTIONS_SIZE)
+		return false;
+	memcpy(key->options + key->optionslen, str, len);
+	key->optionslen += len;
+	return true;
+}
+
+/*
+ * Compute MySessionPoolKey from what the startup packet said.  It stays NULL
+ * if the startup options don't fit.
+ */
+static void
+InitSessionPoolKey(void)
+{
+	SessionPoolKey *key;
+	ListCell   *lc;
+
+	MySessionPoolKeyValid = true;
+
+	key = (SessionPoolKey *) MemoryContextAllocZero(TopMemoryContext,
+													sizeof(SessionPoolKey));
+	strlcpy(key->database, MyProcPort->database_name, NAMEDATALEN);
+	strlcpy(key->user, MyProcPort->user_name, NAMEDATALEN);
+	key->proto = FrontendProtocol;
+
+	if (!AppendSessionPoolKeyOption(key, MyProcPort->cmdline_options ?
+									MyProcPort->cmdline_options : ""))
+	{
+		pfree(key);
+		return;
+	}
+
+	foreach(lc, MyProcPort->guc_options)
+	{
+		if (!AppendSessionPoolKeyOption(key, (char *) lfirst(lc)))
+		{
+			pfree(key);
+			return;
+		}
+	}
+
+	MySessionPoolKey = key;
+}
+
+/*
+ * Fill in the startup packet fields of a Port started up for a pooled
+ * session, from port->pool_key.  Runs in BackendInitialize, in place of
+ * ProcessStartupPacket.
+ */
+void
+SessionPoolRestorePort(Port *port)
+{
+	SessionPoolKey *key = port->pool_key;
+	char	   *opt = key->options;
+	char	   *end = key->options + key->optionslen;
+
+	port->proto = FrontendProtocol = key->proto;
+	port->database_name = pstrdup(key->database);
+	port->user_name = pstrdup(key->user);
+
+	if (*opt != '\0')
+		port->cmdline_options = pstrdup(opt);
+	opt += strlen(opt) + 1;
+
+	while (opt < end)
+	{
+		port->guc_options = lappend(port->guc_options, pstrdup(opt));
+		opt += strlen(opt) + 1;
+	}
+}
+
+/*
+ * Can the current session be handed back to the connection pool?
+ *
+ * This is the case if pooling is enabled and the session has no state that a
+ * new backend with the same startup options wouldn't have.
+ */
+bool
+SessionPoolCanReleaseSession(void)
+{
+	Oid			tempNamespaceId;
+	Oid			tempToastNamespaceId;
+
+	if (connection_pool_size == 0 || MyProcPort == NULL ||
+		MyProcPort->pool_channel == PGINVALID_SOCKET ||
+		whereToSendOutput != DestRemote)
+		return false;
+
+	if (!MySessionPoolKeyValid)
+		InitSessionPoolKey();
+	if (MySessionPoolKey == NULL)
+		return false;
+
+	/* Replication and encrypted connections stay where they are */
+	if (am_walsender || MyProcPort->ssl_in_use)
+		return false;
+
+	/* We must be between transactions, with no protocol traffic pending */
+	if (IsTransactionOrTransactionBlock() ||
+		pq_buffer_has_data() || pq_is_send_pending())
+		return false;
+
+	if (HaveSessionGUCSettings() ||
+		PreparedStatementsExist() ||
+		PortalsExist() ||
+		Async_IsListening() ||
+		LockHasSessionLocks(USER_LOCKMETHOD) ||
+		SequenceCachesExist())
+		return false;
+
+	GetTempNamespaceState(&tempNamespaceId, &tempToastNamespaceId);
+	if (OidIsValid(tempNamespaceId))
+		return false;
+
+	if (session_pool_release_hook && !(*session_pool_release_hook) ())
+		return false;
+
+	return true;
+}
+
+/*
+ * Note the remote address of a newly assigned session, for the benefit of
+ * log_line_prefix and the like.
+ */
+static void
+SessionPoolUpdateRemoteAddress(void)
+{
+	Port	   *port = MyProcPort;
+
+	port->raddr.salen = sizeof(port->raddr.addr);
+	if (getpeername(port->sock, (struct sockaddr *) &port->raddr.addr,
+					&port->raddr.salen) < 0)
+		return;
+
+	pool_remote_host[0] = '\0';
+	pool_remote_port[0] = '\0';
+	if (pg_getnameinfo_all(&port->raddr.addr, port->raddr.salen,
+						   pool_remote_host, sizeof(pool_remote_host),
+						   pool_remote_port, sizeof(pool_remote_port),
+						   NI_NUMERICHOST | NI_NUMERICSERV) != 0)
+		return;
+
+	port->remote_host = pool_remote_host;
+	port->remote_port = pool_remote_port;
+	port->remote_hostname = NULL;
+}
+
+/*
+ * Hand the current session back to the postmaster, which must have been
+ * checked with SessionPoolCanReleaseSession, and wait to be assigned another
+ * one.  If keepSession is false, the session has ended, so there is nothing
+ * to hand back.
+ *
+ * Returns once this backend is serving a session again.  If it is told to
+ * exit instead, it does.
+ */
+void
+SessionPoolReleaseSession(bool keepSession)
+{
+	SessionPoolMessage msg;
+	pgsocket	sock;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = keepSession ? SPM_RETURN : SPM_RELEASE;
+	msg.sessionPid = MyProcPort->pool_session_pid;
+	msg.sessionKey = MyProcPort->pool_session_key;
+	memcpy(&msg.key, MySessionPoolKey, sizeof(SessionPoolKey));
+
+	if (!SessionPoolSend(MyProcPort->pool_channel, &msg,
+						 keepSession ? MyProcPort->sock : PGINVALID_SOCKET))
+	{
+		ereport(LOG,
+				(errcode_for_socket_access(),
+				 errmsg("could not return session to connection pool: %m")));
+		if (keepSession)
+			return;				/* just carry on serving it */
+		proc_exit(0);
+	}
+
+	/* From here on, the postmaster looks after the client */
+	pq_release_socket();
+	whereToSendOutput = DestNone;
+
+	set_ps_display("idle in pool", false);
+
+	for (;;)
+	{
+		int			rc;
+
+		rc = WaitLatchOrSocket(MyLatch,
+							   WL_LATCH_SET | WL_SOCKET_READABLE |
+							   WL_EXIT_ON_PM_DEATH,
+							   MyProcPort->pool_channel, -1L,
+							   WAIT_EVENT_POOLED_SESSION);
+
+		if (rc & WL_LATCH_SET)
+		{
+			ResetLatch(MyLatch);
+			/* handles termination, and sinval catchup while we're idle */
+			ProcessClientReadInterrupt(true);
+		}
+
+		if (!(rc & WL_SOCKET_READABLE))
+			continue;
+
+		if (!SessionPoolReceive(MyProcPort->pool_channel, &msg, &sock))
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				continue;
+			ereport(FATAL,
+					(errcode_for_socket_access(),
+					 errmsg("could not receive from connection pool: %m")));
+		}
+
+		if (msg.type == SPM_EXIT)
+			proc_exit(0);
+
+		if (msg.type != SPM_ASSIGN || sock == PGINVALID_SOCKET)
+			elog(FATAL, "unexpected connection pool message type %d",
+				 (int) msg.type);
+		break;
+	}
+
+	pq_adopt_socket(sock);
+	MyProcPort->pool_session_pid = msg.sessionPid;
+	MyProcPort->pool_session_key = msg.sessionKey;
+	SessionPoolUpdateRemoteAddress();
+
+	whereToSendOutput = DestRemote;
+}
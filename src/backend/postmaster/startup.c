@@ -30,6 +30,7 @@
 #include "storage/ipc.h"
 #include "storage/latch.h"
 #include "storage/pmsignal.h"
+#include "storage/procsignal.h"
 #include "storage/standby.h"
 #include "utils/guc.h"
 #include "utils/timeout.h"
@@ -150,6 +151,12 @@ HandleStartupProcInterrupts(void)
 		ProcessConfigFile(PGC_SIGHUP);
 	}
 
+	/*
+	 * Act on any global barriers.  Our SIGUSR1 handler doesn't tell us about
+	 * them, so just check every time.
+	 */
+	ProcessProcSignalBarrier();
+
 	/*
 	 * Check if we were requested to exit without finishing recovery.
 	 */
@@ -524,6 +524,7 @@ SnapBuildBuildSnapshot(SnapBuild *builder)
 	snapshot->subxip = NULL;
 
 	snapshot->suboverflowed = false;
+	snapshot->suboverflowxmin = snapshot->xmax;
 	snapshot->takenDuringRecovery = false;
 	snapshot->copied = false;
 	snapshot->curcid = FirstCommandId;
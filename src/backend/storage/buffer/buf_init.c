@@ -14,9 +14,56 @@
  */
 #include "postgres.h"
 
+#include <unistd.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
+#include "miscadmin.h"
 #include "storage/bufmgr.h"
 #include "storage/buf_internals.h"
+#include "storage/pg_shmem.h"
+#include "storage/procsignal.h"
+#include "utils/timestamp.h"
+
+
+/*
+ * Shared state of the buffer pool as a whole.  The number of buffers is
+ * kept here so that processes can learn of a resize; see ResizeBufferPool().
+ */
+typedef struct BufferPoolControl
+{
+	int			maxBuffers;		/* number of buffers memory is reserved for */
+	pg_atomic_uint32 numBuffers;	/* current size of the pool */
+} BufferPoolControl;
+
+/*
+ * How long to keep trying to evict the buffers being removed from the pool
+ * when shrinking it, before giving up because some of them stay pinned.
+ */
+#define BUFFER_RESIZE_EVICT_TIMEOUT_MS	10000
+
+/*
+ * How long ResizeBufferPool() waits at a time for all processes to adopt a
+ * new size, before returning to let the background writer do its other work.
+ */
+#define BUFFER_RESIZE_BARRIER_TIMEOUT_MS	100
+
+/*
+ * Progress of a resize of the buffer pool.  This is local to the background
+ * writer, which carries out the resize over as many calls of
+ * ResizeBufferPool() as it takes.
+ */
+typedef enum BufferResizeState
+{
+	BUFFER_RESIZE_IDLE,			/* no resize in progress */
+	BUFFER_RESIZE_GROWING,		/* larger size published */
+	BUFFER_RESIZE_LIMITING,		/* strategy stopped using removed buffers */
+	BUFFER_RESIZE_SHRINKING		/* smaller size published */
+} BufferResizeState;
 
+/* GUC variable */
+int			max_shared_buffers = 0;
 
 BufferDescPadded *BufferDescriptors;
 char	   *BufferBlocks;
@@ -24,6 +71,19 @@ LWLockMinimallyPadded *BufferIOLWLockArray = NULL;
 WritebackContext BackendWritebackContext;
 CkptSortItem *CkptBufferIds;
 
+static BufferPoolControl *BufferPoolCtl = NULL;
+
+static BufferResizeState resize_state = BUFFER_RESIZE_IDLE;
+static uint64 resize_barrier;	/* barrier generation to wait for */
+static int	resize_from;		/* pool size before the resize */
+static int	resize_to;			/* pool size after the resize */
+static int	resize_last_requested = -1;
+
+static void PlaceBufferPool(void);
+static void PartitionBufferPool(int nbuffers);
+static bool EvictBufferRange(int first, int last);
+static void ReleaseBufferRange(int first, int last);
+
 
 /*
  * Data Structures:
@@ -63,29 +123,50 @@ CkptSortItem *CkptBufferIds;
  *
  * This is called once during shared-memory initialization (either in the
  * postmaster, or in a standalone backend).
+ *
+ * All the per-buffer arrays are allocated for MaxNBuffers buffers, so that
+ * the pool can later grow without a restart.  The operating system doesn't
+ * back the buffer pages with memory until they're first used.
  */
 void
 InitBufferPool(void)
 {
-	bool		foundBufs,
+	bool		foundCtl,
+				foundBufs,
 				foundDescs,
 				foundIOLocks,
 				foundBufCkpt;
 
+	BufferPoolCtl = (BufferPoolControl *)
+		ShmemInitStruct("Buffer Pool Status", sizeof(BufferPoolControl),
+						&foundCtl);
+
+	if (!foundCtl)
+	{
+		MaxNBuffers = Max(max_shared_buffers, NBuffers);
+		BufferPoolCtl->maxBuffers = MaxNBuffers;
+		pg_atomic_init_u32(&BufferPoolCtl->numBuffers, NBuffers);
+	}
+	else
+		MaxNBuffers = BufferPoolCtl->maxBuffers;
+
 	/* Align descriptors to a cacheline boundary. */
 	BufferDescriptors = (BufferDescPadded *)
 		ShmemInitStruct("Buffer Descriptors",
-						NBuffers * sizeof(BufferDescPadded),
+						MaxNBuffers * sizeof(BufferDescPadded),
 						&foundDescs);
 
+	/* Align buffer pages for direct I/O; see io_direct */
 	BufferBlocks = (char *)
-		ShmemInitStruct("Buffer Blocks",
-						NBuffers * (Size) BLCKSZ, &foundBufs);
+		TYPEALIGN(PG_IO_ALIGN_SIZE,
+				  ShmemInitStruct("Buffer Blocks",
+								  MaxNBuffers * (Size) BLCKSZ + PG_IO_ALIGN_SIZE,
+								  &foundBufs));
 
 	/* Align lwlocks to cacheline boundary */
 	BufferIOLWLockArray = (LWLockMinimallyPadded *)
 		ShmemInitStruct("Buffer IO Locks",
-						NBuffers * (Size) sizeof(LWLockMinimallyPadded),
+						MaxNBuffers * (Size) sizeof(LWLockMinimallyPadded),
 						&foundIOLocks);
 
 	LWLockRegisterTranche(LWTRANCHE_BUFFER_IO_IN_PROGRESS, "buffer_io");
@@ -100,7 +181,7 @@ InitBufferPool(void)
 	 */
 	CkptBufferIds = (CkptSortItem *)
 		ShmemInitStruct("Checkpoint BufferIds",
-						NBuffers * sizeof(CkptSortItem), &foundBufCkpt);
+						MaxNBuffers * sizeof(CkptSortItem), &foundBufCkpt);
 
 	if (foundDescs || foundBufs || foundIOLocks || foundBufCkpt)
 	{
@@ -112,10 +193,14 @@ InitBufferPool(void)
 	{
 		int			i;
 
+		/* Must place the arrays on NUMA nodes before touching them */
+		PlaceBufferPool();
+
 		/*
-		 * Initialize all the buffer headers.
+		 * Initialize all the buffer headers, including those of buffers that
+		 * aren't part of the pool yet.
 		 */
-		for (i = 0; i < NBuffers; i++)
+		for (i = 0; i < MaxNBuffers; i++)
 		{
 			BufferDesc *buf = GetBufferDescriptor(i);
 
@@ -127,10 +212,10 @@ InitBufferPool(void)
 			buf->buf_id = i;
 
 			/*
-			 * Initially link all the buffers together as unused. Subsequent
-			 * management of this list is done by freelist.c.
+			 * Initially link all the buffers in the pool together as unused.
+			 * Subsequent management of this list is done by freelist.c.
 			 */
-			buf->freeNext = i + 1;
+			buf->freeNext = (i < NBuffers) ? i + 1 : FREENEXT_NOT_IN_LIST;
 
 			LWLockInitialize(BufferDescriptorGetContentLock(buf),
 							 LWTRANCHE_BUFFER_CONTENT);
@@ -151,6 +236,69 @@ InitBufferPool(void)
 						 &backend_flush_after);
 }
 
+/*
+ * Spread the buffer pool across NUMA nodes, as requested by numa_placement.
+ *
+ * With "interleave", the pages of each array are simply handed out to the
+ * nodes in turn.  With "partition", the buffers are divided into one
+ * contiguous range per node, and the descriptors, data pages and I/O locks
+ * of each range are placed on that node, so that the clock sweep can prefer
+ * buffers local to the backend running it.  The checkpoint sort array is
+ * only used by the checkpointer and is interleaved in either case.
+ */
+static void
+PlaceBufferPool(void)
+{
+	if (ShmemNumaNodes() <= 1)
+		return;
+
+	ShmemNumaInterleave(CkptBufferIds, MaxNBuffers * sizeof(CkptSortItem));
+
+	if (numa_placement == NUMA_PLACEMENT_INTERLEAVE)
+	{
+		ShmemNumaInterleave(BufferDescriptors,
+							MaxNBuffers * sizeof(BufferDescPadded));
+		ShmemNumaInterleave(BufferBlocks, MaxNBuffers * (Size) BLCKSZ);
+		ShmemNumaInterleave(BufferIOLWLockArray,
+							MaxNBuffers * sizeof(LWLockMinimallyPadded));
+		return;
+	}
+
+	PartitionBufferPool(NBuffers);
+}
+
+/*
+ * Place the ranges of buffers belonging to each NUMA node on that node, for
+ * a pool of nbuffers buffers.
+ *
+ * The ranges only divide up the buffers in use, so this is done again
+ * whenever the pool is resized.  The kernel applies the new placement only
+ * to memory touched from then on, such as the pages of buffers added by
+ * growing the pool; pages already in memory stay where they are.
+ */
+static void
+PartitionBufferPool(int nbuffers)
+{
+	int			nnodes = ShmemNumaNodes();
+	int			node;
+
+	if (nnodes <= 1 || numa_placement != NUMA_PLACEMENT_PARTITION)
+		return;
+
+	for (node = 0; node < nnodes; node++)
+	{
+		int			first = BufferNodeFirstBuffer(node, nnodes, nbuffers);
+		int			count = BufferNodeFirstBuffer(node + 1, nnodes, nbuffers) - first;
+
+		ShmemNumaBind(&BufferDescriptors[first],
+					  count * sizeof(BufferDescPadded), node);
+		ShmemNumaBind(BufferBlocks + first * (Size) BLCKSZ,
+					  count * (Size) BLCKSZ, node);
+		ShmemNumaBind(&BufferIOLWLockArray[first],
+					  count * sizeof(LWLockMinimallyPadded), node);
+	}
+}
+
 /*
  * BufferShmemSize
  *
@@ -162,13 +310,21 @@ BufferShmemSize(void)
 {
 	Size		size = 0;
 
+	/* everything is sized for the largest the pool may grow to */
+	MaxNBuffers = Max(max_shared_buffers, NBuffers);
+
+	/* size of the control struct */
+	size = add_size(size, MAXALIGN(sizeof(BufferPoolControl)));
+
 	/* size of buffer descriptors */
-	size = add_size(size, mul_size(NBuffers, sizeof(BufferDescPadded)));
+	size = add_size(size, mul_size(MaxNBuffers, sizeof(BufferDescPadded)));
 	/* to allow aligning buffer descriptors */
 	size = add_size(size, PG_CACHE_LINE_SIZE);
 
 	/* size of data pages */
-	size = add_size(size, mul_size(NBuffers, BLCKSZ));
+	size = add_size(size, mul_size(MaxNBuffers, BLCKSZ));
+	/* to allow aligning data pages */
+	size = add_size(size, PG_IO_ALIGN_SIZE);
 
 	/* size of stuff controlled by freelist.c */
 	size = add_size(size, StrategyShmemSize());
@@ -182,12 +338,221 @@ BufferShmemSize(void)
 	 * locks are not highly contentended, we lay out the array with minimal
 	 * padding.
 	 */
-	size = add_size(size, mul_size(NBuffers, sizeof(LWLockMinimallyPadded)));
+	size = add_size(size, mul_size(MaxNBuffers, sizeof(LWLockMinimallyPadded)));
 	/* to allow aligning the above */
 	size = add_size(size, PG_CACHE_LINE_SIZE);
 
 	/* size of checkpoint sort array in bufmgr.c */
-	size = add_size(size, mul_size(NBuffers, sizeof(CkptSortItem)));
+	size = add_size(size, mul_size(MaxNBuffers, sizeof(CkptSortItem)));
 
 	return size;
 }
+
+/*
+ * RefreshBufferPoolSize
+ *
+ * Adopt the current size of the buffer pool as NBuffers.  This is done by
+ * every process when it starts up, and whenever the pool has been resized.
+ */
+void
+RefreshBufferPoolSize(void)
+{
+	NBuffers = (int) pg_atomic_read_u32(&BufferPoolCtl->numBuffers);
+}
+
+/*
+ * BufferPoolResizePending
+ *
+ * Is there a change of shared_buffers that ResizeBufferPool() has yet to
+ * act on, or a resize it has yet to finish?
+ */
+bool
+BufferPoolResizePending(void)
+{
+	if (resize_state != BUFFER_RESIZE_IDLE)
+		return true;
+
+	return RequestedNBuffers != NBuffers &&
+		RequestedNBuffers != resize_last_requested;
+}
+
+/*
+ * ResizeBufferPool
+ *
+ * Make the buffer pool match the shared_buffers setting, within the limit
+ * set by max_shared_buffers.  This is done by the background writer, which
+ * calls this every time around its main loop while a resize is pending.
+ *
+ * To grow the pool, we tell all processes about the new size first, and
+ * only then let the buffer replacement strategy hand out the new buffers,
+ * so that no process can come across a buffer beyond what it thinks is the
+ * end of the pool.
+ *
+ * Shrinking goes the other way around: we first stop the strategy from
+ * handing out the buffers being removed, then write out and evict the pages
+ * they hold, and only then tell everyone about the new size.  If some of the
+ * buffers stay pinned for too long, we give up and keep the current size.
+ * The memory of the removed buffers is returned to the operating system.
+ *
+ * Each of those steps waits for all processes to absorb a procsignal
+ * barrier, but only for BUFFER_RESIZE_BARRIER_TIMEOUT_MS at a time: if some
+ * process hasn't got to it yet, we return and wait again on the next call.
+ * The checkpointer absorbs barriers only between checkpoints, so a resize
+ * can't complete in the middle of one, and holding up the background writer
+ * until the checkpoint is over would stop it from cleaning buffers.
+ */
+void
+ResizeBufferPool(void)
+{
+	int			i;
+
+	if (resize_state == BUFFER_RESIZE_IDLE)
+	{
+		int			newnbuffers = RequestedNBuffers;
+
+		/* Only try once for each new value of the setting */
+		if (RequestedNBuffers == resize_last_requested)
+			return;
+		resize_last_requested = RequestedNBuffers;
+
+		if (newnbuffers > MaxNBuffers)
+		{
+			ereport(LOG,
+					(errmsg("shared_buffers cannot be raised above %d buffers without a restart",
+							MaxNBuffers),
+					 errhint("Set max_shared_buffers to reserve memory for a larger buffer pool.")));
+			newnbuffers = MaxNBuffers;
+		}
+
+		if (newnbuffers == NBuffers)
+			return;
+
+		resize_from = NBuffers;
+		resize_to = newnbuffers;
+
+		if (resize_to > resize_from)
+		{
+			pg_atomic_write_u32(&BufferPoolCtl->numBuffers, resize_to);
+			resize_state = BUFFER_RESIZE_GROWING;
+		}
+		else
+		{
+			/*
+			 * Have everyone pass a barrier after the strategy has stopped
+			 * handing out the buffers, so that a process that picked one of
+			 * them just before has at least pinned it by the time we look.
+			 */
+			StrategySetUsableBuffers(resize_to);
+			resize_state = BUFFER_RESIZE_LIMITING;
+		}
+		resize_barrier =
+			EmitProcSignalBarrier(PROCSIGNAL_BARRIER_SHARED_BUFFERS);
+	}
+
+	for (;;)
+	{
+		if (!WaitForProcSignalBarrier(resize_barrier,
+									  BUFFER_RESIZE_BARRIER_TIMEOUT_MS))
+			return;
+
+		switch (resize_state)
+		{
+			case BUFFER_RESIZE_GROWING:
+				StrategySetUsableBuffers(resize_to);
+				for (i = resize_from; i < resize_to; i++)
+					StrategyFreeBuffer(GetBufferDescriptor(i));
+				break;
+
+			case BUFFER_RESIZE_LIMITING:
+				if (!EvictBufferRange(resize_to, resize_from))
+				{
+					StrategySetUsableBuffers(resize_from);
+					resize_state = BUFFER_RESIZE_IDLE;
+					ereport(LOG,
+							(errmsg("could not shrink shared buffers from %d to %d buffers",
+									resize_from, resize_to),
+							 errdetail("Some of the buffers to be removed remained pinned for more than %d seconds.",
+									   BUFFER_RESIZE_EVICT_TIMEOUT_MS / 1000)));
+					return;
+				}
+
+				pg_atomic_write_u32(&BufferPoolCtl->numBuffers, resize_to);
+				resize_barrier =
+					EmitProcSignalBarrier(PROCSIGNAL_BARRIER_SHARED_BUFFERS);
+				resize_state = BUFFER_RESIZE_SHRINKING;
+				continue;
+
+			case BUFFER_RESIZE_SHRINKING:
+				ReleaseBufferRange(resize_to, resize_from);
+				break;
+
+			case BUFFER_RESIZE_IDLE:
+				elog(ERROR, "no buffer pool resize in progress");
+		}
+
+		break;
+	}
+
+	PartitionBufferPool(resize_to);
+	resize_state = BUFFER_RESIZE_IDLE;
+
+	ereport(LOG,
+			(errmsg("shared buffers resized from %d to %d buffers",
+					resize_from, resize_to)));
+}
+
+/*
+ * Evict the pages held by buffers first .. last - 1, writing them out first
+ * if they're dirty.  Returns false if some buffers were still pinned when
+ * the timeout expired.
+ */
+static bool
+EvictBufferRange(int first, int last)
+{
+	TimestampTz start = GetCurrentTimestamp();
+
+	for (;;)
+	{
+		bool		done = true;
+		int			i;
+
+		for (i = first; i < last; i++)
+		{
+			if (!EvictSharedBuffer(GetBufferDescriptor(i)))
+				done = false;
+		}
+
+		if (done)
+			return true;
+
+		if (TimestampDifferenceExceeds(start, GetCurrentTimestamp(),
+									   BUFFER_RESIZE_EVICT_TIMEOUT_MS))
+			return false;
+
+		pg_usleep(10000L);
+	}
+}
+
+/*
+ * Give the memory backing the pages of buffers first .. last - 1 back to
+ * the operating system.  They read as zeroes if they're used again later.
+ */
+static void
+ReleaseBufferRange(int first, int last)
+{
+#ifdef MADV_REMOVE
+	Size		pagesize = UsedShmemPageSize;
+	uintptr_t	start;
+	uintptr_t	end;
+
+	if (pagesize == 0)
+		pagesize = sysconf(_SC_PAGESIZE);
+
+	start = TYPEALIGN(pagesize, (uintptr_t) (BufferBlocks + first * (Size) BLCKSZ));
+	end = TYPEALIGN_DOWN(pagesize, (uintptr_t) (BufferBlocks + last * (Size) BLCKSZ));
+
+	if (end > start &&
+		madvise((void *) start, end - start, MADV_REMOVE) != 0)
+		elog(LOG, "could not release memory of removed shared buffers: %m");
+#endif
+}
@@ -9,6 +9,9 @@
  * in most cases the caller needs to adjust the buffer header contents
  * before the lock is released (see notes in README).
  *
+ * Besides the hash table proper, we maintain a table of lookup hints that
+ * can be read without any lock; see BufTableLookupHint().
+ *
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -21,6 +24,8 @@
  */
 #include "postgres.h"
 
+#include "port/atomics.h"
+#include "port/pg_bitutils.h"
 #include "storage/bufmgr.h"
 #include "storage/buf_internals.h"
 
@@ -34,6 +39,37 @@ typedef struct
 
 static HTAB *SharedBufHash;
 
+/*
+ * The lookup hints are kept in an open-addressing table of buckets, each
+ * one cache line's worth of entries.  An entry holds a tag's hash code in
+ * its high half, and the ID of the buffer holding the page plus one in its
+ * low half; zero means the entry is free.  The bucket for a hash code is
+ * chosen by its low-order bits.  Since there are a multiple of
+ * NUM_BUFFER_PARTITIONS buckets, each bucket belongs to a single buffer
+ * mapping partition, so the exclusive partition lock held while inserting
+ * and deleting is enough to serialize the changes to a bucket.
+ *
+ * We allow four times as many entries as there are buffers, so that a
+ * bucket very rarely fills up.  If one does, we just don't record a hint;
+ * lookups of that page then take the slow path.
+ */
+#define BUF_HINT_BUCKET_SIZE	8
+
+typedef struct
+{
+	pg_atomic_uint64 entries[BUF_HINT_BUCKET_SIZE];
+} BufHintBucket;
+
+static BufHintBucket *BufHintBuckets;
+static uint32 BufHintMask;
+
+#define BufHintEntry(hashcode, buf_id) \
+	(((uint64) (hashcode) << 32) | (uint64) ((buf_id) + 1))
+
+static uint32 BufHintNumBuckets(int size);
+static void BufHintInsert(uint32 hashcode, int buf_id);
+static void BufHintDelete(uint32 hashcode, int buf_id);
+
 
 /*
  * Estimate space needed for mapping hashtable
@@ -42,7 +78,8 @@ static HTAB *SharedBufHash;
 Size
 BufTableShmemSize(int size)
 {
-	return hash_estimate_size(size, sizeof(BufferLookupEnt));
+	return add_size(hash_estimate_size(size, sizeof(BufferLookupEnt)),
+					mul_size(BufHintNumBuckets(size), sizeof(BufHintBucket)));
 }
 
 /*
@@ -53,6 +90,8 @@ void
 InitBufTable(int size)
 {
 	HASHCTL		info;
+	uint32		nbuckets;
+	bool		found;
 
 	/* assume no locking is needed yet */
 
@@ -65,6 +104,21 @@ InitBufTable(int size)
 								  size, size,
 								  &info,
 								  HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+
+	nbuckets = BufHintNumBuckets(size);
+	BufHintMask = nbuckets - 1;
+	BufHintBuckets = (BufHintBucket *)
+		ShmemInitStruct("Shared Buffer Lookup Hints",
+						nbuckets * sizeof(BufHintBucket), &found);
+	if (!found)
+	{
+		uint32		i;
+		int			j;
+
+		for (i = 0; i < nbuckets; i++)
+			for (j = 0; j < BUF_HINT_BUCKET_SIZE; j++)
+				pg_atomic_init_u64(&BufHintBuckets[i].entries[j], 0);
+	}
 }
 
 /*
@@ -106,6 +160,36 @@ BufTableLookup(BufferTag *tagPtr, uint32 hashcode)
 	return result->id;
 }
 
+/*
+ * BufTableLookupHint
+ *		Find a buffer that probably holds the page with the given hash code;
+ *		return its buffer ID, or -1 if there is none
+ *
+ * This needs no lock, and doesn't write to shared memory.  The answer is
+ * only a hint: the buffer may have been reassigned to another page by the
+ * time we look at it, or it may hold a different page whose tag happens to
+ * hash to the same value.  The caller must pin the buffer, without advancing
+ * its usage count, and then check that it holds the expected page; a pinned
+ * buffer's tag can't change.  If this returns -1, the page may still be in
+ * shared buffers, so the caller must fall back to a regular BufTableLookup().
+ */
+int
+BufTableLookupHint(uint32 hashcode)
+{
+	BufHintBucket *bucket = &BufHintBuckets[hashcode & BufHintMask];
+	int			i;
+
+	for (i = 0; i < BUF_HINT_BUCKET_SIZE; i++)
+	{
+		uint64		entry = pg_atomic_read_u64(&bucket->entries[i]);
+
+		if (entry != 0 && (uint32) (entry >> 32) == hashcode)
+			return (int) (uint32) entry - 1;
+	}
+
+	return -1;
+}
+
 /*
  * BufTableInsert
  *		Insert a hashtable entry for given tag and buffer ID,
@@ -137,17 +221,20 @@ BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 
 	result->id = buf_id;
 
+	BufHintInsert(hashcode, buf_id);
+
 	return -1;
 }
 
 /*
  * BufTableDelete
- *		Delete the hashtable entry for given tag (which must exist)
+ *		Delete the hashtable entry for given tag (which must exist), which
+ *		maps to the given buffer ID
  *
  * Caller must hold exclusive lock on BufMappingLock for tag's partition
  */
 void
-BufTableDelete(BufferTag *tagPtr, uint32 hashcode)
+BufTableDelete(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 {
 	BufferLookupEnt *result;
 
@@ -160,4 +247,65 @@ BufTableDelete(BufferTag *tagPtr, uint32 hashcode)
 
 	if (!result)				/* shouldn't happen */
 		elog(ERROR, "shared buffer hash table corrupted");
+
+	BufHintDelete(hashcode, buf_id);
+}
+
+/*
+ * Number of hint buckets for a hash table of the given size: a power of two,
+ * and at least NUM_BUFFER_PARTITIONS.
+ */
+static uint32
+BufHintNumBuckets(int size)
+{
+	uint64		nbuckets;
+
+	nbuckets = ((uint64) size * 4 + BUF_HINT_BUCKET_SIZE - 1) / BUF_HINT_BUCKET_SIZE;
+	nbuckets = Max(nbuckets, NUM_BUFFER_PARTITIONS);
+
+	return (uint32) 1 << pg_leftmost_one_pos64(nbuckets * 2 - 1);
+}
+
+/*
+ * Record a lookup hint.  Caller must hold exclusive lock on BufMappingLock
+ * for the tag's partition.
+ */
+static void
+BufHintInsert(uint32 hashcode, int buf_id)
+{
+	BufHintBucket *bucket = &BufHintBuckets[hashcode & BufHintMask];
+	int			i;
+
+	for (i = 0; i < BUF_HINT_BUCKET_SIZE; i++)
+	{
+		if (pg_atomic_read_u64(&bucket->entries[i]) == 0)
+		{
+			pg_atomic_write_u64(&bucket->entries[i],
+								BufHintEntry(hashcode, buf_id));
+			return;
+		}
+	}
+
+	/* bucket is full; do without a hint for this one */
+}
+
+/*
+ * Remove a lookup hint, if we recorded one.  Caller must hold exclusive lock
+ * on BufMappingLock for the tag's partition.
+ */
+static void
+BufHintDelete(uint32 hashcode, int buf_id)
+{
+	BufHintBucket *bucket = &BufHintBuckets[hashcode & BufHintMask];
+	uint64		entry = BufHintEntry(hashcode, buf_id);
+	int			i;
+
+	for (i = 0; i < BUF_HINT_BUCKET_SIZE; i++)
+	{
+		if (pg_atomic_read_u64(&bucket->entries[i]) == entry)
+		{
+			pg_atomic_write_u64(&bucket->entries[i], 0);
+			return;
+		}
+	}
 }
@@ -48,6 +48,7 @@
 #include "storage/proc.h"
 #include "storage/smgr.h"
 #include "storage/standby.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
 #include "utils/timestamp.h"
@@ -67,6 +68,13 @@
 
 #define DROP_RELS_BSEARCH_THRESHOLD		20
 
+/*
+ * When dropping the buffers of relations whose size we know, look up each
+ * block in the buffer mapping table rather than scanning the whole buffer
+ * pool, as long as there are fewer blocks to drop than this.
+ */
+#define BUF_DROP_FULL_SCAN_THRESHOLD		(uint64) (NBuffers / 32)
+
 typedef struct PrivateRefCountEntry
 {
 	Buffer		buffer;
@@ -128,9 +136,31 @@ int			backend_flush_after = 0;
  */
 int			target_prefetch_pages = 0;
 
-/* local state for StartBufferIO and related functions */
-static BufferDesc *InProgressBuf = NULL;
-static bool IsForInput;
+/*
+ * Maximum number of combined reads or writes, in blocks.  Reads and writes of
+ * consecutive blocks of the same relation fork are issued as a single
+ * vectored I/O of up to this many blocks.
+ */
+int			io_combine_limit = 16;
+
+/*
+ * local state for StartBufferIO and related functions
+ *
+ * A process may have I/O in progress on several buffers at once: a combined
+ * read or write of up to MAX_IO_COMBINE_LIMIT blocks, plus the write of one
+ * victim buffer that BufferAlloc may have to flush in the middle of setting
+ * up a combined read.
+ */
+#define MAX_IN_PROGRESS_IO (MAX_IO_COMBINE_LIMIT + 1)
+
+typedef struct InProgressIO
+{
+	BufferDesc *buf;
+	bool		forInput;
+} InProgressIO;
+
+static InProgressIO InProgressIOs[MAX_IN_PROGRESS_IO];
+static int	NumInProgressIOs = 0;
 
 /* local state for LockBufferForCleanup */
 static BufferDesc *PinCountWaitBuf = NULL;
@@ -432,12 +462,20 @@ static Buffer ReadBuffer_common(SMgrRelation reln, char relpersistence,
 				  ForkNumber forkNum, BlockNumber blockNum,
 				  ReadBufferMode mode, BufferAccessStrategy strategy,
 				  bool *hit);
-static bool PinBuffer(BufferDesc *buf, BufferAccessStrategy strategy);
+static bool PinBuffer(BufferDesc *buf, BufferAccessStrategy strategy,
+		  bool adjust_usage);
+static uint32 AdjustUsageCount(uint32 buf_state,
+				 BufferAccessStrategy strategy);
+static void BumpUsageCount(BufferDesc *buf, BufferAccessStrategy strategy);
+static BufferDesc *PinBufferByHint(BufferTag *tag, uint32 hashcode,
+				BufferAccessStrategy strategy, bool *valid);
 static void PinBuffer_Locked(BufferDesc *buf);
 static void UnpinBuffer(BufferDesc *buf, bool fixOwner);
 static void BufferSync(int flags);
 static uint32 WaitBufHdrUnlocked(BufferDesc *buf);
 static int	SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *flush_context);
+static int	SyncBufferRun(const int *buf_ids, int nbufs, int *nwritten,
+			  WritebackContext *wb_context);
 static void WaitIO(BufferDesc *buf);
 static bool StartBufferIO(BufferDesc *buf, bool forInput);
 static void TerminateBufferIO(BufferDesc *buf, bool clear_dirty,
@@ -453,6 +491,10 @@ static BufferDesc *BufferAlloc(SMgrRelation smgr,
 static void FlushBuffer(BufferDesc *buf, SMgrRelation reln);
 static void AtProcExit_Buffers(int code, Datum arg);
 static void CheckForBufferLeaks(void);
+static void FindAndDropRelFileNodeBuffers(RelFileNode rnode,
+							  ForkNumber forkNum,
+							  BlockNumber nForkBlock,
+							  BlockNumber firstDelBlock);
 static int	rnode_comparator(const void *p1, const void *p2);
 static int	buffertag_comparator(const void *p1, const void *p2);
 static int	ckpt_buforder_comparator(const void *pa, const void *pb);
@@ -693,6 +735,225 @@ ReadBufferWithoutRelcache(RelFileNode rnode, ForkNumber forkNum,
 							 mode, strategy, &hit);
 }
 
+/*
+ * ReadBuffers -- read a range of consecutive blocks of a relation fork in
+ *		RBM_NORMAL mode, combining the reads of those that are not yet in
+ *		shared buffers into a single smgrreadv() call.
+ *
+ * Up to nblocks buffers, holding blocks blockNum, blockNum + 1, ... are
+ * pinned and stored into buffers[].  The return value is the number of
+ * buffers actually returned, which is always at least one.  Fewer than
+ * nblocks are returned if a block after the first one is found to be in the
+ * buffer pool already, since that ends the run of blocks that can be read
+ * with one I/O; and at most io_combine_limit are read at a time.  The caller
+ * is expected to call again for the remaining blocks.
+ *
+ * Relations using local buffers are read one block at a time.
+ */
+int
+ReadBuffers(Relation reln, ForkNumber forkNum, BlockNumber blockNum,
+			int nblocks, Buffer *buffers, BufferAccessStrategy strategy)
+{
+	SMgrRelation smgr;
+	BufferDesc *bufHdrs[MAX_IO_COMBINE_LIMIT];
+	char	   *bufBlocks[MAX_IO_COMBINE_LIMIT];
+	int			nmiss;
+	int			nreturned;
+	bool		found;
+	instr_time	io_start,
+				io_time;
+	int			i;
+
+	Assert(nblocks > 0);
+	Assert(blockNum != P_NEW);
+
+	nblocks = Min(nblocks, io_combine_limit);
+	nblocks = Min(nblocks, MAX_IO_COMBINE_LIMIT);
+
+	if (nblocks == 1 || RelationUsesLocalBuffers(reln))
+	{
+		buffers[0] = ReadBufferExtended(reln, forkNum, blockNum, RBM_NORMAL,
+										strategy);
+		return 1;
+	}
+
+	/* Open it at the smgr level if not already done */
+	RelationOpenSmgr(reln);
+	smgr = reln->rd_smgr;
+
+	/*
+	 * Pin buffers for as many blocks as we can.  BufferAlloc marks those that
+	 * are not yet valid as IO_IN_PROGRESS.  The first block that's found in
+	 * the buffer pool ends the run.
+	 */
+	nmiss = 0;
+	nreturned = 0;
+	while (nreturned < nblocks)
+	{
+		BlockNumber blkno = blockNum + nreturned;
+		BufferDesc *bufHdr;
+
+		/* Make sure we will have room to remember the buffer pin */
+		ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
+		TRACE_POSTGRESQL_BUFFER_READ_START(forkNum, blkno,
+										   smgr->smgr_rnode.node.spcNode,
+										   smgr->smgr_rnode.node.dbNode,
+										   smgr->smgr_rnode.node.relNode,
+										   smgr->smgr_rnode.backend,
+										   false);
+
+		pgstat_count_buffer_read(reln);
+		bufHdr = BufferAlloc(smgr, reln->rd_rel->relpersistence, forkNum,
+							 blkno, strategy, &found);
+		buffers[nreturned++] = BufferDescriptorGetBuffer(bufHdr);
+
+		if (found)
+		{
+			pgstat_count_buffer_hit(reln);
+			pgBufferUsage.shared_blks_hit++;
+			VacuumPageHit++;
+			if (VacuumCostActive)
+				VacuumCostBalance += VacuumCostPageHit;
+
+			TRACE_POSTGRESQL_BUFFER_READ_DONE(forkNum, blkno,
+											  smgr->smgr_rnode.node.spcNode,
+											  smgr->smgr_rnode.node.dbNode,
+											  smgr->smgr_rnode.node.relNode,
+											  smgr->smgr_rnode.backend,
+											  false,
+											  found);
+			break;
+		}
+
+		pgBufferUsage.shared_blks_read++;
+		bufHdrs[nmiss] = bufHdr;
+		bufBlocks[nmiss] = (char *) BufHdrGetBlock(bufHdr);
+		nmiss++;
+	}
+
+	/* if the first block was already in the buffer pool, we're done */
+	if (nmiss == 0)
+		return nreturned;
+
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+
+	smgrreadv(smgr, forkNum, blockNum, bufBlocks, nmiss);
+
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_SUBTRACT(io_time, io_start);
+		pgstat_count_buffer_read_time(INSTR_TIME_GET_MICROSEC(io_time));
+		INSTR_TIME_ADD(pgBufferUsage.blk_read_time, io_time);
+	}
+
+	for (i = 0; i < nmiss; i++)
+	{
+		BlockNumber blkno = blockNum + i;
+
+		/* check for garbage data, as in ReadBuffer_common */
+		if (!PageIsVerified((Page) bufBlocks[i], blkno))
+		{
+			if (zero_damaged_pages)
+			{
+				ereport(WARNING,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("invalid page in block %u of relation %s; zeroing out page",
+								blkno,
+								relpath(smgr->smgr_rnode, forkNum))));
+				MemSet(bufBlocks[i], 0, BLCKSZ);
+			}
+			else
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("invalid page in block %u of relation %s",
+								blkno,
+								relpath(smgr->smgr_rnode, forkNum))));
+		}
+
+		/* Set BM_VALID, terminate IO, and wake up any waiters */
+		TerminateBufferIO(bufHdrs[i], false, BM_VALID);
+
+		VacuumPageMiss++;
+		if (VacuumCostActive)
+			VacuumCostBalance += VacuumCostPageMiss;
+
+		TRACE_POSTGRESQL_BUFFER_READ_DONE(forkNum, blkno,
+										  smgr->smgr_rnode.node.spcNode,
+										  smgr->smgr_rnode.node.dbNode,
+										  smgr->smgr_rnode.node.relNode,
+										  smgr->smgr_rnode.backend,
+										  false,
+										  false);
+	}
+
+	return nreturned;
+}
+
+/*
+ * ExtendBufferedRelBy -- extend a relation fork by several blocks at once
+ *
+ * Adds extend_by zero-filled blocks to the end of the fork with a single
+ * smgrzeroextend() call, and enters them into the buffer pool without
+ * reading them back in.  Returns the number of the first new block.  If
+ * buffers isn't NULL, the new buffers are returned in it, pinned but not
+ * locked; otherwise they are released right away.
+ *
+ * As with P_NEW, the caller must hold the relation extension lock, unless
+ * the relation is local to this backend.  The new pages are all zeroes
+ * (PageIsNew), so the caller has to initialize any page it puts to use.
+ */
+BlockNumber
+ExtendBufferedRelBy(Relation reln, ForkNumber forkNum, int extend_by,
+					Buffer *buffers, BufferAccessStrategy strategy)
+{
+	BlockNumber firstBlock;
+	int			i;
+
+	Assert(extend_by > 0);
+
+	/* Open it at the smgr level if not already done */
+	RelationOpenSmgr(reln);
+
+	/* See ReadBufferExtended */
+	if (RELATION_IS_OTHER_TEMP(reln))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot access temporary tables of other sessions")));
+
+	firstBlock = smgrnblocks(reln->rd_smgr, forkNum);
+	smgrzeroextend(reln->rd_smgr, forkNum, firstBlock, extend_by, false);
+
+	/*
+	 * The new blocks are known to contain zeroes, so set up buffers for them
+	 * with RBM_ZERO_AND_LOCK, which doesn't read them.  Double-check that
+	 * they really are empty, as P_NEW does; if there was a buffer for one of
+	 * them already, something has gone badly wrong.
+	 */
+	for (i = 0; i < extend_by; i++)
+	{
+		Buffer		buffer;
+
+		buffer = ReadBufferExtended(reln, forkNum, firstBlock + i,
+									RBM_ZERO_AND_LOCK, strategy);
+
+		if (!PageIsNew(BufferGetPage(buffer)))
+			elog(ERROR, "page %u of relation \"%s\" should be empty but is not",
+				 firstBlock + i, RelationGetRelationName(reln));
+
+		LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
+
+		if (buffers != NULL)
+			buffers[i] = buffer;
+		else
+			ReleaseBuffer(buffer);
+	}
+
+	return firstBlock;
+}
+
 
 /*
  * ReadBuffer_common -- common logic for all ReadBuffer variants
@@ -1014,23 +1275,33 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	newHash = BufTableHashCode(&newTag);
 	newPartitionLock = BufMappingPartitionLock(newHash);
 
-	/* see if the block is in the buffer pool already */
-	LWLockAcquire(newPartitionLock, LW_SHARED);
-	buf_id = BufTableLookup(&newTag, newHash);
-	if (buf_id >= 0)
+	/*
+	 * See if the block is in the buffer pool already.  Try without the
+	 * mapping lock first, and if that doesn't find it, look again properly.
+	 */
+	buf = PinBufferByHint(&newTag, newHash, strategy, &valid);
+	if (buf == NULL)
 	{
-		/*
-		 * Found it.  Now, pin the buffer so no one can steal it from the
-		 * buffer pool, and check to see if the correct data has been loaded
-		 * into the buffer.
-		 */
-		buf = GetBufferDescriptor(buf_id);
+		LWLockAcquire(newPartitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&newTag, newHash);
+		if (buf_id >= 0)
+		{
+			/*
+			 * Found it.  Now, pin the buffer so no one can steal it from the
+			 * buffer pool, and check to see if the correct data has been
+			 * loaded into the buffer.
+			 */
+			buf = GetBufferDescriptor(buf_id);
 
-		valid = PinBuffer(buf, strategy);
+			valid = PinBuffer(buf, strategy, true);
+		}
 
 		/* Can release the mapping lock as soon as we've pinned it */
 		LWLockRelease(newPartitionLock);
+	}
 
+	if (buf != NULL)
+	{
 		*foundPtr = true;
 
 		if (!valid)
@@ -1057,9 +1328,8 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 
 	/*
 	 * Didn't find it in the buffer pool.  We'll have to initialize a new
-	 * buffer.  Remember to unlock the mapping lock while doing the work.
+	 * buffer.
 	 */
-	LWLockRelease(newPartitionLock);
 
 	/* Loop here in case we have to try another victim buffer */
 	for (;;)
@@ -1238,7 +1508,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 
 			buf = GetBufferDescriptor(buf_id);
 
-			valid = PinBuffer(buf, strategy);
+			valid = PinBuffer(buf, strategy, true);
 
 			/* Can release the mapping lock as soon as we've pinned it */
 			LWLockRelease(newPartitionLock);
@@ -1283,7 +1553,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 			break;
 
 		UnlockBufHdr(buf, buf_state);
-		BufTableDelete(&newTag, newHash);
+		BufTableDelete(&newTag, newHash, buf->buf_id);
 		if (oldPartitionLock != NULL &&
 			oldPartitionLock != newPartitionLock)
 			LWLockRelease(oldPartitionLock);
@@ -1297,7 +1567,11 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	 * Clearing BM_VALID here is necessary, clearing the dirtybits is just
 	 * paranoia.  We also reset the usage_count since any recency of use of
 	 * the old content is no longer relevant.  (The usage_count starts out at
-	 * 1 so that the buffer can survive one clock-sweep pass.)
+	 * 1 so that the buffer can survive one clock-sweep pass.  With the
+	 * probation replacement policy it starts out at 0 instead, so that a page that is
+	 * not accessed again before the clock hand reaches it, such as one read
+	 * by a large scan, is the first to be evicted, and the clock hand has to
+	 * decrement fewer usage counts of frequently used pages to find it.)
 	 *
 	 * Make sure BM_PERMANENT is set for buffers that must be written at every
 	 * checkpoint.  Unlogged buffers only need to be written at shutdown
@@ -1309,15 +1583,17 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 				   BM_CHECKPOINT_NEEDED | BM_IO_ERROR | BM_PERMANENT |
 				   BUF_USAGECOUNT_MASK);
 	if (relpersistence == RELPERSISTENCE_PERMANENT || forkNum == INIT_FORKNUM)
-		buf_state |= BM_TAG_VALID | BM_PERMANENT | BUF_USAGECOUNT_ONE;
+		buf_state |= BM_TAG_VALID | BM_PERMANENT;
 	else
-		buf_state |= BM_TAG_VALID | BUF_USAGECOUNT_ONE;
+		buf_state |= BM_TAG_VALID;
+	if (buffer_replacement_policy != BUFFER_REPLACEMENT_PROBATION)
+		buf_state |= BUF_USAGECOUNT_ONE;
 
 	UnlockBufHdr(buf, buf_state);
 
 	if (oldPartitionLock != NULL)
 	{
-		BufTableDelete(&oldTag, oldHash);
+		BufTableDelete(&oldTag, oldHash, buf->buf_id);
 		if (oldPartitionLock != newPartitionLock)
 			LWLockRelease(oldPartitionLock);
 	}
@@ -1430,7 +1706,7 @@ retry:
 	 * Remove the buffer from the lookup hashtable, if it was in there.
 	 */
 	if (oldFlags & BM_TAG_VALID)
-		BufTableDelete(&oldTag, oldHash);
+		BufTableDelete(&oldTag, oldHash, buf->buf_id);
 
 	/*
 	 * Done with mapping lock.
@@ -1443,6 +1719,88 @@ retry:
 	StrategyFreeBuffer(buf);
 }
 
+/*
+ * EvictSharedBuffer -- write out and evict the page held by a shared buffer
+ *
+ * Unlike InvalidateBuffer, this is used while the page is still of interest
+ * to others, so a dirty page is written out first, and we give up rather
+ * than wait if the buffer is pinned.  Returns true if the buffer is left
+ * holding no page.  The buffer is not put on the freelist.
+ *
+ * This is used when shrinking the buffer pool, to empty the buffers being
+ * removed from it; the caller has made sure that the replacement strategy
+ * won't hand them out anymore.
+ */
+bool
+EvictSharedBuffer(BufferDesc *buf)
+{
+	BufferTag	oldTag;
+	uint32		oldHash;		/* hash value for oldTag */
+	LWLock	   *oldPartitionLock;	/* buffer partition lock for it */
+	uint32		buf_state;
+
+	/* Make sure we can handle the pin inside PinBuffer_Locked */
+	ReservePrivateRefCountEntry();
+	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
+	buf_state = LockBufHdr(buf);
+
+	if (BUF_STATE_GET_REFCOUNT(buf_state) != 0)
+	{
+		UnlockBufHdr(buf, buf_state);
+		return false;
+	}
+
+	if (!(buf_state & BM_TAG_VALID))
+	{
+		UnlockBufHdr(buf, buf_state);
+		return true;
+	}
+
+	/* Pin it, so that the page can't be replaced while we flush it */
+	PinBuffer_Locked(buf);
+
+	if (pg_atomic_read_u32(&buf->state) & BM_DIRTY)
+	{
+		LWLockAcquire(BufferDescriptorGetContentLock(buf), LW_SHARED);
+		FlushBuffer(buf, NULL);
+		LWLockRelease(BufferDescriptorGetContentLock(buf));
+	}
+
+	oldTag = buf->tag;
+	oldHash = BufTableHashCode(&oldTag);
+	oldPartitionLock = BufMappingPartitionLock(oldHash);
+
+	LWLockAcquire(oldPartitionLock, LW_EXCLUSIVE);
+	buf_state = LockBufHdr(buf);
+
+	/*
+	 * Somebody else could have pinned the buffer or dirtied the page again
+	 * meanwhile; if so, leave it alone and let the caller try again later.
+	 */
+	if (BUF_STATE_GET_REFCOUNT(buf_state) != 1 ||
+		(buf_state & BM_DIRTY) ||
+		!BUFFERTAGS_EQUAL(buf->tag, oldTag))
+	{
+		UnlockBufHdr(buf, buf_state);
+		LWLockRelease(oldPartitionLock);
+		UnpinBuffer(buf, true);
+		return false;
+	}
+
+	CLEAR_BUFFERTAG(buf->tag);
+	buf_state &= ~(BUF_FLAG_MASK | BUF_USAGECOUNT_MASK);
+	UnlockBufHdr(buf, buf_state);
+
+	BufTableDelete(&oldTag, oldHash, buf->buf_id);
+
+	LWLockRelease(oldPartitionLock);
+
+	UnpinBuffer(buf, true);
+
+	return true;
+}
+
 /*
  * MarkBufferDirty
  *
@@ -1551,6 +1909,51 @@ ReleaseAndReadBuffer(Buffer buffer,
 	return ReadBuffer(relation, blockNum);
 }
 
+/*
+ * PinBufferByHint -- try to find and pin the buffer holding a page, without
+ *		taking the buffer mapping lock
+ *
+ * The buffer suggested by the lock-free lookup hints is pinned, and then we
+ * check that it really holds the page we want.  That's enough, because a
+ * buffer's tag can only be changed while it's unpinned, with its header
+ * spinlock held; so once our pin is in place, either we see the new tag or
+ * the tag can't change until we release the pin.
+ *
+ * The buffer's usage_count is only advanced once we know it's the right
+ * one, so that a false hint doesn't make an unrelated page look popular.
+ *
+ * Returns the pinned buffer, setting *valid like PinBuffer's result, or NULL
+ * if the page wasn't found this way.  In that case the caller must look it
+ * up in the mapping table in the regular way; it may still be there.
+ */
+static BufferDesc *
+PinBufferByHint(BufferTag *tag, uint32 hashcode,
+				BufferAccessStrategy strategy, bool *valid)
+{
+	BufferDesc *buf;
+	int			buf_id;
+
+	buf_id = BufTableLookupHint(hashcode);
+	if (buf_id < 0)
+		return NULL;
+
+	buf = GetBufferDescriptor(buf_id);
+	*valid = PinBuffer(buf, strategy, false);
+
+	if ((pg_atomic_read_u32(&buf->state) & BM_TAG_VALID) &&
+		BUFFERTAGS_EQUAL(buf->tag, *tag))
+	{
+		/* As PinBuffer would have, if this is our first pin on it */
+		if (GetPrivateRefCount(BufferDescriptorGetBuffer(buf)) == 1)
+			BumpUsageCount(buf, strategy);
+		return buf;
+	}
+
+	/* It's been reused for another page, or the hint was a false match */
+	UnpinBuffer(buf, true);
+	return NULL;
+}
+
 /*
  * PinBuffer -- make buffer unavailable for replacement.
  *
@@ -1568,13 +1971,17 @@ ReleaseAndReadBuffer(Buffer buffer,
  * taking the buffer header lock; instead update the state variable in loop of
  * CAS operations. Hopefully it's just a single CAS.
  *
+ * If adjust_usage is false, the usage_count is left alone.  That's for
+ * callers that aren't sure yet that the buffer is the one they want; they
+ * can call BumpUsageCount once they are.
+ *
  * Note that ResourceOwnerEnlargeBuffers must have been done already.
  *
  * Returns true if buffer is BM_VALID, else false.  This provision allows
  * some callers to avoid an extra spinlock cycle.
  */
 static bool
-PinBuffer(BufferDesc *buf, BufferAccessStrategy strategy)
+PinBuffer(BufferDesc *buf, BufferAccessStrategy strategy, bool adjust_usage)
 {
 	Buffer		b = BufferDescriptorGetBuffer(buf);
 	bool		result;
@@ -1601,21 +2008,8 @@ PinBuffer(BufferDesc *buf, BufferAccessStrategy strategy)
 			/* increase refcount */
 			buf_state += BUF_REFCOUNT_ONE;
 
-			if (strategy == NULL)
-			{
-				/* Default case: increase usagecount unless already max. */
-				if (BUF_STATE_GET_USAGECOUNT(buf_state) < BM_MAX_USAGE_COUNT)
-					buf_state += BUF_USAGECOUNT_ONE;
-			}
-			else
-			{
-				/*
-				 * Ring buffers shouldn't evict others from pool.  Thus we
-				 * don't make usagecount more than 1.
-				 */
-				if (BUF_STATE_GET_USAGECOUNT(buf_state) == 0)
-					buf_state += BUF_USAGECOUNT_ONE;
-			}
+			if (adjust_usage)
+				buf_state = AdjustUsageCount(buf_state, strategy);
 
 			if (pg_atomic_compare_exchange_u32(&buf->state, &old_buf_state,
 											   buf_state))
@@ -1637,6 +2031,57 @@ PinBuffer(BufferDesc *buf, BufferAccessStrategy strategy)
 	return result;
 }
 
+/*
+ * AdjustUsageCount -- advance the usage_count in a buffer state for a new
+ *		pin, as described for PinBuffer
+ */
+static uint32
+AdjustUsageCount(uint32 buf_state, BufferAccessStrategy strategy)
+{
+	if (strategy == NULL)
+	{
+		/* Default case: increase usagecount unless already max. */
+		if (BUF_STATE_GET_USAGECOUNT(buf_state) < BM_MAX_USAGE_COUNT)
+			buf_state += BUF_USAGECOUNT_ONE;
+	}
+	else
+	{
+		/*
+		 * Ring buffers shouldn't evict others from pool.  Thus we don't make
+		 * usagecount more than 1.
+		 */
+		if (BUF_STATE_GET_USAGECOUNT(buf_state) == 0)
+			buf_state += BUF_USAGECOUNT_ONE;
+	}
+
+	return buf_state;
+}
+
+/*
+ * BumpUsageCount -- advance the usage_count of a buffer we have pinned
+ *		with PinBuffer(..., false)
+ */
+static void
+BumpUsageCount(BufferDesc *buf, BufferAccessStrategy strategy)
+{
+	uint32		old_buf_state;
+
+	old_buf_state = pg_atomic_read_u32(&buf->state);
+	for (;;)
+	{
+		uint32		buf_state;
+
+		if (old_buf_state & BM_LOCKED)
+			old_buf_state = WaitBufHdrUnlocked(buf);
+
+		buf_state = AdjustUsageCount(old_buf_state, strategy);
+		if (buf_state == old_buf_state ||
+			pg_atomic_compare_exchange_u32(&buf->state, &old_buf_state,
+										   buf_state))
+			break;
+	}
+}
+
 /*
  * PinBuffer_Locked -- as above, but caller already locked the buffer header.
  * The spinlock is released before return.
@@ -1796,9 +2241,6 @@ BufferSync(int flags)
 	int			mask = BM_DIRTY;
 	WritebackContext wb_context;
 
-	/* Make sure we can handle the pin inside SyncOneBuffer */
-	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
-
 	/*
 	 * Unless this is a shutdown checkpoint or we have been explicitly told,
 	 * we write only permanent, dirty buffers.  But at shutdown or end of
@@ -1963,6 +2405,7 @@ BufferSync(int flags)
 	while (!binaryheap_empty(ts_heap))
 	{
 		BufferDesc *bufHdr = NULL;
+		int			nprocessed;
 		CkptTsStatus *ts_stat = (CkptTsStatus *)
 		DatumGetPointer(binaryheap_first(ts_heap));
 
@@ -1971,37 +2414,80 @@ BufferSync(int flags)
 
 		bufHdr = GetBufferDescriptor(buf_id);
 
-		num_processed++;
-
 		/*
 		 * We don't need to acquire the lock here, because we're only looking
 		 * at a single bit. It's possible that someone else writes the buffer
 		 * and clears the flag right after we check, but that doesn't matter
-		 * since SyncOneBuffer will then do nothing.  However, there is a
+		 * since SyncBufferRun will then do nothing.  However, there is a
 		 * further race condition: it's conceivable that between the time we
-		 * examine the bit here and the time SyncOneBuffer acquires the lock,
+		 * examine the bit here and the time SyncBufferRun acquires the lock,
 		 * someone else not only wrote the buffer but replaced it with another
-		 * page and dirtied it.  In that improbable case, SyncOneBuffer will
+		 * page and dirtied it.  In that improbable case, SyncBufferRun will
 		 * write the buffer though we didn't need to.  It doesn't seem worth
 		 * guarding against this, though.
 		 */
+		nprocessed = 1;
 		if (pg_atomic_read_u32(&bufHdr->state) & BM_CHECKPOINT_NEEDED)
 		{
-			if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
+			int			run_buf_ids[MAX_IO_COMBINE_LIMIT];
+			int			nrun = 1;
+			int			nwritten;
+			int			max_run;
+			instr_time	io_start,
+						io_time;
+			CkptSortItem *first = &CkptBufferIds[ts_stat->index];
+
+			/*
+			 * Collect the following buffers that (still) need writing and, as
+			 * far as the sort order tells us, hold the next blocks of the same
+			 * relation fork, so that they can be written with a single I/O.
+			 * SyncBufferRun checks the buffer tags properly, since the sort
+			 * key doesn't include the database.
+			 */
+			run_buf_ids[0] = buf_id;
+			max_run = Min(io_combine_limit, MAX_IO_COMBINE_LIMIT);
+			max_run = Min(max_run, ts_stat->num_to_scan - ts_stat->num_scanned);
+			while (nrun < max_run)
+			{
+				CkptSortItem *next = &CkptBufferIds[ts_stat->index + nrun];
+
+				if (next->relNode != first->relNode ||
+					next->forkNum != first->forkNum ||
+					next->blockNum != first->blockNum + nrun ||
+					!(pg_atomic_read_u32(&GetBufferDescriptor(next->buf_id)->state) &
+					  BM_CHECKPOINT_NEEDED))
+					break;
+				run_buf_ids[nrun++] = next->buf_id;
+			}
+
+			if (CheckPointIOLatencyTarget > 0)
+				INSTR_TIME_SET_CURRENT(io_start);
+
+			nprocessed = SyncBufferRun(run_buf_ids, nrun, &nwritten,
+									   &wb_context);
+
+			/* feed the write latency to the checkpoint pacing logic */
+			if (CheckPointIOLatencyTarget > 0 && nwritten > 0)
 			{
-				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_id);
-				BgWriterStats.m_buf_written_checkpoints++;
-				num_written++;
+				INSTR_TIME_SET_CURRENT(io_time);
+				INSTR_TIME_SUBTRACT(io_time, io_start);
+				CheckpointNoteIOLatency(INSTR_TIME_GET_MILLISEC(io_time));
 			}
+
+			for (i = 0; i < nwritten; i++)
+				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(run_buf_ids[i]);
+			BgWriterStats.m_buf_written_checkpoints += nwritten;
+			num_written += nwritten;
 		}
 
 		/*
 		 * Measure progress independent of actually having to flush the buffer
 		 * - otherwise writing become unbalanced.
 		 */
-		ts_stat->progress += ts_stat->progress_slice;
-		ts_stat->num_scanned++;
-		ts_stat->index++;
+		num_processed += nprocessed;
+		ts_stat->progress += ts_stat->progress_slice * nprocessed;
+		ts_stat->num_scanned += nprocessed;
+		ts_stat->index += nprocessed;
 
 		/* Have all the buffers from the tablespace been processed? */
 		if (ts_stat->num_scanned == ts_stat->num_to_scan)
@@ -2060,6 +2546,7 @@ BgBufferSync(WritebackContext *wb_context)
 	 * point's advance rate and avoid scanning already-cleaned buffers.
 	 */
 	static bool saved_info_valid = false;
+	static int	prev_nbuffers = 0;
 	static int	prev_strategy_buf_id;
 	static uint32 prev_strategy_passes;
 	static int	next_to_clean;
@@ -2100,6 +2587,16 @@ BgBufferSync(WritebackContext *wb_context)
 	/* Report buffer alloc counts to pgstat */
 	BgWriterStats.m_buf_alloc += recent_alloc;
 
+	/*
+	 * If the buffer pool has been resized, the saved positions don't mean
+	 * anything anymore; start over.
+	 */
+	if (NBuffers != prev_nbuffers)
+	{
+		saved_info_valid = false;
+		prev_nbuffers = NBuffers;
+	}
+
 	/*
 	 * If we're not running the LRU scan, just stop after doing the stats
 	 * stuff.  We mark the saved state invalid so that we can recover sanely
@@ -2410,6 +2907,218 @@ SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context)
 	return result | BUF_WRITTEN;
 }
 
+/*
+ * SyncBufferRun -- process a run of buffers for BufferSync, writing out the
+ * ones that hold consecutive blocks of a relation fork with one smgrwritev.
+ *
+ * buf_ids[] lists buffers that the caller expects to hold consecutive blocks
+ * of one relation fork, in ascending order.  The first buffer is handled
+ * like SyncOneBuffer would (without skip_recently_used).  Each following one
+ * is added to the write only if it still needs to be checkpointed, really
+ * holds the next block, and can be share-locked without waiting; otherwise
+ * the run ends there.
+ *
+ * Returns the number of entries of buf_ids[] that were dealt with, which is
+ * always at least one, and sets *nwritten to the number of buffers written
+ * (zero if the first buffer turned out to be clean already).  The rest of
+ * the array is left for the caller to try again.
+ *
+ * Note: unlike SyncOneBuffer, this does its own ResourceOwnerEnlargeBuffers.
+ */
+static int
+SyncBufferRun(const int *buf_ids, int nbufs, int *nwritten,
+			  WritebackContext *wb_context)
+{
+	static char *pageCopies = NULL;
+	BufferDesc *bufHdrs[MAX_IO_COMBINE_LIMIT];
+	char	   *bufBlocks[MAX_IO_COMBINE_LIMIT];
+	BufferTag	tags[MAX_IO_COMBINE_LIMIT];
+	SMgrRelation reln;
+	ErrorContextCallback errcallback;
+	instr_time	io_start,
+				io_time;
+	XLogRecPtr	max_lsn = InvalidXLogRecPtr;
+	bool		need_xlog_flush = false;
+	int			n;
+	int			i;
+
+	Assert(nbufs >= 1 && nbufs <= MAX_IO_COMBINE_LIMIT);
+
+	*nwritten = 0;
+
+	/*
+	 * Pin and share-lock the buffers, and start output I/O on them.  Only
+	 * the first buffer's content lock may be waited for; see the notes at
+	 * StartBufferIO.
+	 */
+	for (n = 0; n < nbufs; n++)
+	{
+		BufferDesc *bufHdr = GetBufferDescriptor(buf_ids[n]);
+		uint32		buf_state;
+
+		ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+		ReservePrivateRefCountEntry();
+
+		buf_state = LockBufHdr(bufHdr);
+
+		if (!(buf_state & BM_VALID) || !(buf_state & BM_DIRTY))
+		{
+			/* It's clean, so nothing to do */
+			UnlockBufHdr(bufHdr, buf_state);
+			break;
+		}
+
+		if (n > 0 &&
+			(!(buf_state & BM_CHECKPOINT_NEEDED) ||
+			 (buf_state & BM_IO_IN_PROGRESS) ||
+			 !RelFileNodeEquals(bufHdr->tag.rnode, tags[0].rnode) ||
+			 bufHdr->tag.forkNum != tags[0].forkNum ||
+			 bufHdr->tag.blockNum != tags[0].blockNum + n))
+		{
+			/* Not the next block after all, or busy */
+			UnlockBufHdr(bufHdr, buf_state);
+			break;
+		}
+
+		PinBuffer_Locked(bufHdr);
+
+		if (n == 0)
+			LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
+		else if (!LWLockConditionalAcquire(BufferDescriptorGetContentLock(bufHdr),
+										   LW_SHARED))
+		{
+			UnpinBuffer(bufHdr, true);
+			break;
+		}
+
+		if (!StartBufferIO(bufHdr, false))
+		{
+			/* Someone else flushed the buffer before we could */
+			LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
+			UnpinBuffer(bufHdr, true);
+			break;
+		}
+
+		bufHdrs[n] = bufHdr;
+		tags[n] = bufHdr->tag;
+	}
+
+	if (n == 0)
+		return 1;
+
+	/* Setup error traceback support for ereport() */
+	errcallback.callback = shared_buffer_write_error_callback;
+	errcallback.arg = (void *) bufHdrs[0];
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	reln = smgropen(tags[0].rnode, InvalidBackendId);
+
+	/*
+	 * Collect the LSNs, and clear BM_JUST_DIRTIED so that we can tell if the
+	 * contents change while we're writing.  See FlushBuffer.
+	 */
+	for (i = 0; i < n; i++)
+	{
+		uint32		buf_state;
+		XLogRecPtr	recptr;
+
+		TRACE_POSTGRESQL_BUFFER_FLUSH_START(tags[i].forkNum,
+											tags[i].blockNum,
+											reln->smgr_rnode.node.spcNode,
+											reln->smgr_rnode.node.dbNode,
+											reln->smgr_rnode.node.relNode);
+
+		buf_state = LockBufHdr(bufHdrs[i]);
+		recptr = BufferGetLSN(bufHdrs[i]);
+		buf_state &= ~BM_JUST_DIRTIED;
+		UnlockBufHdr(bufHdrs[i], buf_state);
+
+		if (buf_state & BM_PERMANENT)
+		{
+			need_xlog_flush = true;
+			if (recptr > max_lsn)
+				max_lsn = recptr;
+		}
+	}
+
+	/* Enforce the WAL rule for the whole run at once */
+	if (need_xlog_flush)
+		XLogFlush(max_lsn);
+
+	/*
+	 * Set the page checksums if desired.  As in PageSetChecksumCopy, we must
+	 * work on private copies, since we hold only share locks; but we need one
+	 * copy per page, so we can't use that function's static buffer.  The
+	 * copies are aligned for direct I/O, so that the write doesn't have to
+	 * go through bounce buffers.
+	 */
+	for (i = 0; i < n; i++)
+	{
+		Page		page = (Page) BufHdrGetBlock(bufHdrs[i]);
+
+		if (PageIsNew(page) || !DataChecksumsEnabled())
+			bufBlocks[i] = (char *) page;
+		else
+		{
+			if (pageCopies == NULL)
+				pageCopies = (char *)
+					TYPEALIGN(PG_IO_ALIGN_SIZE,
+							  MemoryContextAlloc(TopMemoryContext,
+												 MAX_IO_COMBINE_LIMIT * BLCKSZ +
+												 PG_IO_ALIGN_SIZE));
+			bufBlocks[i] = pageCopies + i * BLCKSZ;
+			memcpy(bufBlocks[i], (char *) page, BLCKSZ);
+			PageSetChecksumInplace((Page) bufBlocks[i], tags[i].blockNum);
+		}
+	}
+
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+
+	smgrwritev(reln, tags[0].forkNum, tags[0].blockNum, bufBlocks, n, false);
+
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_SUBTRACT(io_time, io_start);
+		pgstat_count_buffer_write_time(INSTR_TIME_GET_MICROSEC(io_time));
+		INSTR_TIME_ADD(pgBufferUsage.blk_write_time, io_time);
+	}
+
+	pgBufferUsage.shared_blks_written += n;
+
+	/*
+	 * Mark the buffers as clean (unless BM_JUST_DIRTIED has become set), end
+	 * the io_in_progress state, and let go of them.
+	 */
+	for (i = 0; i < n; i++)
+	{
+		TerminateBufferIO(bufHdrs[i], true, 0);
+
+		TRACE_POSTGRESQL_BUFFER_FLUSH_DONE(tags[i].forkNum,
+										   tags[i].blockNum,
+										   reln->smgr_rnode.node.spcNode,
+										   reln->smgr_rnode.node.dbNode,
+										   reln->smgr_rnode.node.relNode);
+	}
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+
+	for (i = 0; i < n; i++)
+	{
+		LWLockRelease(BufferDescriptorGetContentLock(bufHdrs[i]));
+		UnpinBuffer(bufHdrs[i], true);
+	}
+
+	for (i = 0; i < n; i++)
+		ScheduleBufferTagForWriteback(wb_context, &tags[i]);
+
+	*nwritten = n;
+	return n;
+}
+
 /*
  *		AtEOXact_Buffers - clean up at end of transaction.
  *
@@ -2458,15 +3167,20 @@ InitBufferPoolAccess(void)
  * InitBufferPoolBackend --- second-stage initialization of a new backend
  *
  * This is called after we have acquired a PGPROC and so can safely get
- * LWLocks.  We don't currently need to do anything at this stage ...
- * except register a shmem-exit callback.  AtProcExit_Buffers needs LWLock
- * access, and thereby has to be called at the corresponding phase of
+ * LWLocks.  We register a shmem-exit callback here; AtProcExit_Buffers needs
+ * LWLock access, and thereby has to be called at the corresponding phase of
  * backend shutdown.
+ *
+ * We also learn the current size of the buffer pool, which may differ from
+ * what the postmaster started with.  This must happen after ProcSignalInit(),
+ * so that we're told about any resize that happens after this point.
  */
 void
 InitBufferPoolBackend(void)
 {
 	on_shmem_exit(AtProcExit_Buffers, 0);
+
+	RefreshBufferPoolSize();
 }
 
 /*
@@ -2879,16 +3593,18 @@ BufferGetLSNAtomic(Buffer buffer)
  *		that no other process could be trying to load more pages of the
  *		relation into buffers.
  *
- *		XXX currently it sequentially searches the buffer pool, should be
- *		changed to more clever ways of searching.  However, this routine
- *		is used only in code paths that aren't very performance-critical,
- *		and we shouldn't slow down the hot paths to make it faster ...
+ *		If we know the size of the relation fork (see smgrnblocks_cached)
+ *		and only a few blocks are to be dropped, we look each of them up in
+ *		the buffer mapping table.  Otherwise we have to scan the whole buffer
+ *		pool, which is expensive with a large shared_buffers setting.
  * --------------------------------------------------------------------
  */
 void
-DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
+DropRelFileNodeBuffers(SMgrRelation smgr_reln, ForkNumber forkNum,
 					   BlockNumber firstDelBlock)
 {
+	RelFileNodeBackend rnode = smgr_reln->smgr_rnode;
+	BlockNumber nForkBlock;
 	int			i;
 
 	/* If it's a local relation, it's localbuf.c's problem. */
@@ -2899,6 +3615,28 @@ DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
 		return;
 	}
 
+	/*
+	 * If we know exactly how long the fork is, and there's nothing or not
+	 * much to drop, find the buffers through the buffer mapping table.
+	 * Nobody else can be extending the fork, so the only buffers there can
+	 * be beyond its end are ones left by a failed extension, or by reading
+	 * past the end with zero_damaged_pages.  Those hold nothing but zeroes,
+	 * and the next extension takes them over.
+	 */
+	nForkBlock = smgrnblocks_cached(smgr_reln, forkNum);
+	if (nForkBlock != InvalidBlockNumber)
+	{
+		if (firstDelBlock >= nForkBlock)
+			return;
+
+		if (nForkBlock - firstDelBlock < BUF_DROP_FULL_SCAN_THRESHOLD)
+		{
+			FindAndDropRelFileNodeBuffers(rnode.node, forkNum, nForkBlock,
+										  firstDelBlock);
+			return;
+		}
+	}
+
 	for (i = 0; i < NBuffers; i++)
 	{
 		BufferDesc *bufHdr = GetBufferDescriptor(i);
@@ -2943,28 +3681,33 @@ DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
  * --------------------------------------------------------------------
  */
 void
-DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
+DropRelFileNodesAllBuffers(SMgrRelation *smgr_reln, int nnodes)
 {
 	int			i,
+				j,
 				n = 0;
+	SMgrRelation *rels;
+	BlockNumber (*block)[MAX_FORKNUM + 1];
+	uint64		nBlocksToInvalidate = 0;
 	RelFileNode *nodes;
+	bool		cached = true;
 	bool		use_bsearch;
 
 	if (nnodes == 0)
 		return;
 
-	nodes = palloc(sizeof(RelFileNode) * nnodes);	/* non-local relations */
+	rels = palloc(sizeof(SMgrRelation) * nnodes);	/* non-local relations */
 
 	/* If it's a local relation, it's localbuf.c's problem. */
 	for (i = 0; i < nnodes; i++)
 	{
-		if (RelFileNodeBackendIsTemp(rnodes[i]))
+		if (RelFileNodeBackendIsTemp(smgr_reln[i]->smgr_rnode))
 		{
-			if (rnodes[i].backend == MyBackendId)
-				DropRelFileNodeAllLocalBuffers(rnodes[i].node);
+			if (smgr_reln[i]->smgr_rnode.backend == MyBackendId)
+				DropRelFileNodeAllLocalBuffers(smgr_reln[i]->smgr_rnode.node);
 		}
 		else
-			nodes[n++] = rnodes[i].node;
+			rels[n++] = smgr_reln[i];
 	}
 
 	/*
@@ -2973,10 +3716,62 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
 	 */
 	if (n == 0)
 	{
-		pfree(nodes);
+		pfree(rels);
+		return;
+	}
+
+	/*
+	 * If we know the size of every fork of every relation, and the total is
+	 * small enough, drop the buffers through the buffer mapping table as in
+	 * DropRelFileNodeBuffers.  Forks that don't exist have nothing to drop.
+	 * The main fork always exists, so when sizes can't be trusted at all we
+	 * give up on the first fork without checking for the others' files.
+	 */
+	block = (BlockNumber (*)[MAX_FORKNUM + 1])
+		palloc(sizeof(BlockNumber) * n * (MAX_FORKNUM + 1));
+
+	for (i = 0; i < n && cached; i++)
+	{
+		for (j = 0; j <= MAX_FORKNUM; j++)
+		{
+			block[i][j] = smgrnblocks_cached(rels[i], j);
+			if (block[i][j] == InvalidBlockNumber)
+			{
+				if (j != MAIN_FORKNUM && !smgrexists(rels[i], j))
+				{
+					block[i][j] = 0;
+					continue;
+				}
+				cached = false;
+				break;
+			}
+			nBlocksToInvalidate += block[i][j];
+		}
+	}
+
+	if (cached && nBlocksToInvalidate < BUF_DROP_FULL_SCAN_THRESHOLD)
+	{
+		for (i = 0; i < n; i++)
+		{
+			for (j = 0; j <= MAX_FORKNUM; j++)
+			{
+				if (block[i][j] > 0)
+					FindAndDropRelFileNodeBuffers(rels[i]->smgr_rnode.node,
+												  j, block[i][j], 0);
+			}
+		}
+
+		pfree(block);
+		pfree(rels);
 		return;
 	}
 
+	pfree(block);
+
+	nodes = palloc(sizeof(RelFileNode) * n);
+	for (i = 0; i < n; i++)
+		nodes[i] = rels[i]->smgr_rnode.node;
+
 	/*
 	 * For low number of relations to drop just use a simple walk through, to
 	 * save the bsearch overhead. The threshold to use is rather a guess than
@@ -3002,8 +3797,6 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
 
 		if (!use_bsearch)
 		{
-			int			j;
-
 			for (j = 0; j < n; j++)
 			{
 				if (RelFileNodeEquals(bufHdr->tag.rnode, nodes[j]))
@@ -3032,6 +3825,67 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
 	}
 
 	pfree(nodes);
+	pfree(rels);
+}
+
+/* ---------------------------------------------------------------------
+ *		FindAndDropRelFileNodeBuffers
+ *
+ *		This function performs look up in BufMapping table and removes from
+ *		the buffer pool all the pages of the specified relation fork that
+ *		have block numbers >= firstDelBlock, given that the fork has exactly
+ *		nForkBlock blocks.  (In particular, with firstDelBlock = 0, all pages
+ *		are removed.)
+ * --------------------------------------------------------------------
+ */
+static void
+FindAndDropRelFileNodeBuffers(RelFileNode rnode, ForkNumber forkNum,
+							  BlockNumber nForkBlock,
+							  BlockNumber firstDelBlock)
+{
+	BlockNumber curBlock;
+
+	for (curBlock = firstDelBlock; curBlock < nForkBlock; curBlock++)
+	{
+		uint32		bufHash;	/* hash value for tag */
+		BufferTag	bufTag;		/* identity of requested block */
+		LWLock	   *bufPartitionLock;	/* buffer partition lock for it */
+		int			buf_id;
+		BufferDesc *bufHdr;
+		uint32		buf_state;
+
+		/* create a tag so we can lookup the buffer */
+		INIT_BUFFERTAG(bufTag, rnode, forkNum, curBlock);
+
+		/* determine its hash code and partition lock ID */
+		bufHash = BufTableHashCode(&bufTag);
+		bufPartitionLock = BufMappingPartitionLock(bufHash);
+
+		/* Check that it is in the buffer pool. If not, do nothing. */
+		LWLockAcquire(bufPartitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&bufTag, bufHash);
+		LWLockRelease(bufPartitionLock);
+
+		if (buf_id < 0)
+			continue;
+
+		bufHdr = GetBufferDescriptor(buf_id);
+
+		/*
+		 * We need to lock the buffer header and recheck if the buffer is
+		 * still associated with the same block because the buffer could be
+		 * evicted by some other backend loading blocks for a different
+		 * relation after we release lock on the BufMapping table.
+		 */
+		buf_state = LockBufHdr(bufHdr);
+
+		if (RelFileNodeEquals(bufHdr->tag.rnode, rnode) &&
+			bufHdr->tag.forkNum == forkNum &&
+			bufHdr->tag.blockNum >= firstDelBlock)
+			InvalidateBuffer(bufHdr);	/* releases spinlock */
+		else
+			UnlockBufHdr(bufHdr, buf_state);
+	}
 }
 
 /* ---------------------------------------------------------------------
@@ -3821,8 +4675,12 @@ IsBufferCleanupOK(Buffer buffer)
 /*
  *	Functions for buffer I/O handling
  *
- *	Note: We assume that nested buffer I/O never occurs.
- *	i.e at most one io_in_progress lock is held per proc.
+ *	Note: A process can hold the io_in_progress locks of several buffers at
+ *	once, while it performs a combined read or write of consecutive blocks
+ *	(see ReadBuffers and SyncBufferRun).  Such a run is only ever extended
+ *	in ascending block order within one relation fork, and a process never
+ *	waits for a buffer content lock while it has I/O in progress (it ends
+ *	the run instead), so two processes cannot wait for each other's I/O.
  *
  *	Also note that these are used only for shared buffers, not local ones.
  */
@@ -3862,7 +4720,7 @@ WaitIO(BufferDesc *buf)
 /*
  * StartBufferIO: begin I/O on this buffer
  *	(Assumptions)
- *	My process is executing no IO
+ *	My process is not already executing IO on this buffer
  *	The buffer is Pinned
  *
  * In some scenarios there are race conditions in which multiple backends
@@ -3882,7 +4740,7 @@ StartBufferIO(BufferDesc *buf, bool forInput)
 {
 	uint32		buf_state;
 
-	Assert(!InProgressBuf);
+	Assert(NumInProgressIOs < MAX_IN_PROGRESS_IO);
 
 	for (;;)
 	{
@@ -3921,8 +4779,9 @@ StartBufferIO(BufferDesc *buf, bool forInput)
 	buf_state |= BM_IO_IN_PROGRESS;
 	UnlockBufHdr(buf, buf_state);
 
-	InProgressBuf = buf;
-	IsForInput = forInput;
+	InProgressIOs[NumInProgressIOs].buf = buf;
+	InProgressIOs[NumInProgressIOs].forInput = forInput;
+	NumInProgressIOs++;
 
 	return true;
 }
@@ -3948,8 +4807,19 @@ static void
 TerminateBufferIO(BufferDesc *buf, bool clear_dirty, uint32 set_flag_bits)
 {
 	uint32		buf_state;
+	int			i;
 
-	Assert(buf == InProgressBuf);
+	/* Forget about this buffer's I/O; it's usually the most recent one */
+	for (i = NumInProgressIOs - 1; i >= 0; i--)
+	{
+		if (InProgressIOs[i].buf == buf)
+			break;
+	}
+	Assert(i >= 0);
+	NumInProgressIOs--;
+	if (i < NumInProgressIOs)
+		memmove(&InProgressIOs[i], &InProgressIOs[i + 1],
+				(NumInProgressIOs - i) * sizeof(InProgressIO));
 
 	buf_state = LockBufHdr(buf);
 
@@ -3962,8 +4832,6 @@ TerminateBufferIO(BufferDesc *buf, bool clear_dirty, uint32 set_flag_bits)
 	buf_state |= set_flag_bits;
 	UnlockBufHdr(buf, buf_state);
 
-	InProgressBuf = NULL;
-
 	LWLockRelease(BufferDescriptorGetIOLock(buf));
 }
 
@@ -3979,10 +4847,10 @@ TerminateBufferIO(BufferDesc *buf, bool clear_dirty, uint32 set_flag_bits)
 void
 AbortBufferIO(void)
 {
-	BufferDesc *buf = InProgressBuf;
-
-	if (buf)
+	while (NumInProgressIOs > 0)
 	{
+		BufferDesc *buf = InProgressIOs[NumInProgressIOs - 1].buf;
+		bool		forInput = InProgressIOs[NumInProgressIOs - 1].forInput;
 		uint32		buf_state;
 
 		/*
@@ -3995,7 +4863,7 @@ AbortBufferIO(void)
 
 		buf_state = LockBufHdr(buf);
 		Assert(buf_state & BM_IO_IN_PROGRESS);
-		if (IsForInput)
+		if (forInput)
 		{
 			Assert(!(buf_state & BM_DIRTY));
 
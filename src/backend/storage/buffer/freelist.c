@@ -16,12 +16,27 @@
 #include "postgres.h"
 
 #include "port/atomics.h"
+#include "port/pg_numa.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
+#include "storage/pg_shmem.h"
 #include "storage/proc.h"
 
 #define INT_ACCESS_ONCE(var)	((int)(*((volatile int *)&(var))))
 
+/* GUC variable */
+int			buffer_replacement_policy = BUFFER_REPLACEMENT_CLOCK;
+
+/*
+ * Clock sweep hand for the buffers of one NUMA node, used when the buffer
+ * pool is partitioned across nodes.  Each is padded to a cache line of its
+ * own, so that backends on different nodes don't contend for it.
+ */
+typedef union BufferNodeSweep
+{
+	pg_atomic_uint32 nextVictimBuffer;
+	char		pad[PG_CACHE_LINE_SIZE];
+} BufferNodeSweep;
 
 /*
  * The shared freelist control information.
@@ -53,11 +68,35 @@ typedef struct
 	uint32		completePasses; /* Complete cycles of the clock sweep */
 	pg_atomic_uint32 numBufferAllocs;	/* Buffers allocated since last reset */
 
+	/*
+	 * Cumulative statistics, for StrategyGetStats().  The first two are
+	 * protected by buffer_strategy_lock; numBufferAllocs is added into
+	 * totalBufferAllocs whenever it's reset.
+	 */
+	uint64		totalBufferAllocs;	/* Buffers allocated before last reset */
+	uint64		freelistAllocs; /* Buffers taken from the freelist */
+	pg_atomic_uint64 ringReuses;	/* Buffers reused from strategy rings */
+
 	/*
 	 * Bgworker process to be notified upon activity or -1 if none. See
 	 * StrategyNotifyBgWriter.
 	 */
 	int			bgwprocno;
+
+	/*
+	 * Number of NUMA nodes the buffer pool is partitioned across, and the
+	 * clock sweep hand of each.  numNodes is 1 unless numa_placement is
+	 * "partition"; the hands are then unused.
+	 */
+	int			numNodes;
+	BufferNodeSweep nodeSweep[PG_NUMA_MAX_NODES];
+
+	/*
+	 * Buffers with an id at or above this are never handed out.  This is
+	 * normally NBuffers, but is lowered ahead of NBuffers while the pool is
+	 * being shrunk.  See ResizeBufferPool().
+	 */
+	pg_atomic_uint32 numUsableBuffers;
 } BufferStrategyControl;
 
 /* Pointers to shared state */
@@ -98,8 +137,10 @@ typedef struct BufferAccessStrategyData
 
 
 /* Prototypes for internal functions */
+static BufferDesc *GetBufferFromNode(BufferAccessStrategy strategy,
+				  int usable, uint32 *buf_state);
 static BufferDesc *GetBufferFromRing(BufferAccessStrategy strategy,
-				  uint32 *buf_state);
+				  int usable, uint32 *buf_state);
 static void AddBufferToRing(BufferAccessStrategy strategy,
 				BufferDesc *buf);
 
@@ -203,15 +244,18 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 	BufferDesc *buf;
 	int			bgwprocno;
 	int			trycounter;
+	int			usable;
 	uint32		local_buf_state;	/* to avoid repeated (de-)referencing */
 
+	usable = (int) pg_atomic_read_u32(&StrategyControl->numUsableBuffers);
+
 	/*
 	 * If given a strategy object, see whether it can select a buffer. We
 	 * assume strategy objects don't need buffer_strategy_lock.
 	 */
 	if (strategy != NULL)
 	{
-		buf = GetBufferFromRing(strategy, buf_state);
+		buf = GetBufferFromRing(strategy, usable, buf_state);
 		if (buf != NULL)
 			return buf;
 	}
@@ -250,7 +294,22 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 	pg_atomic_fetch_add_u32(&StrategyControl->numBufferAllocs, 1);
 
 	/*
-	 * First check, without acquiring the lock, whether there's buffers in the
+	 * If the buffer pool is partitioned across NUMA nodes, first make one
+	 * pass over the buffers on the node we're running on.  Only if they are
+	 * all in use do we fall back to the freelist and the global clock sweep.
+	 * The local sweep may take buffers that are still on the freelist; those
+	 * are simply skipped when they come off the list, like any other buffer
+	 * that was reused in the meantime.
+	 */
+	if (StrategyControl->numNodes > 1)
+	{
+		buf = GetBufferFromNode(strategy, usable, buf_state);
+		if (buf != NULL)
+			return buf;
+	}
+
+	/*
+	 * Check, without acquiring the lock, whether there's buffers in the
 	 * freelist. Since we otherwise don't require the spinlock in every
 	 * StrategyGetBuffer() invocation, it'd be sad to acquire it here -
 	 * uselessly in most cases. That obviously leaves a race where a buffer is
@@ -284,6 +343,7 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 			/* Unconditionally remove buffer from freelist */
 			StrategyControl->firstFreeBuffer = buf->freeNext;
 			buf->freeNext = FREENEXT_NOT_IN_LIST;
+			StrategyControl->freelistAllocs++;
 
 			/*
 			 * Release the lock so someone else can access the freelist while
@@ -291,6 +351,10 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 			 */
 			SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 
+			/* Discard buffers that are being removed from the pool */
+			if (buf->buf_id >= usable)
+				continue;
+
 			/*
 			 * If the buffer is pinned or has a nonzero usage_count, we cannot
 			 * use it; discard it and retry.  (This can only happen if VACUUM
@@ -318,6 +382,10 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 	{
 		buf = GetBufferDescriptor(ClockSweepTick());
 
+		/* Skip over buffers that are being removed from the pool */
+		if (buf->buf_id >= usable)
+			continue;
+
 		/*
 		 * If the buffer is pinned or has a nonzero usage_count, we cannot use
 		 * it; decrement the usage_count (unless pinned) and keep scanning.
@@ -357,6 +425,64 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 	}
 }
 
+/*
+ * GetBufferFromNode -- returns a buffer from the calling backend's NUMA node,
+ *		or NULL if one pass of the node's clock sweep found none to use
+ *
+ * This works just like the main clock sweep in StrategyGetBuffer, except
+ * that it's confined to the range of buffers placed on one node.  It doesn't
+ * advance the main clock hand, so the bgwriter, which follows that hand,
+ * doesn't see this activity.
+ */
+static BufferDesc *
+GetBufferFromNode(BufferAccessStrategy strategy, int usable,
+				  uint32 *buf_state)
+{
+	int			nnodes = StrategyControl->numNodes;
+	int			node = pg_numa_get_node();
+	int			first;
+	int			nbuffers;
+	int			trycounter;
+	BufferNodeSweep *sweep;
+
+	if (node >= nnodes)
+		return NULL;
+
+	first = BufferNodeFirstBuffer(node, nnodes, usable);
+	nbuffers = BufferNodeFirstBuffer(node + 1, nnodes, usable) - first;
+	if (nbuffers <= 0)
+		return NULL;
+	sweep = &StrategyControl->nodeSweep[node];
+
+	for (trycounter = nbuffers; trycounter > 0; trycounter--)
+	{
+		BufferDesc *buf;
+		uint32		local_buf_state;
+		uint32		victim;
+
+		victim = pg_atomic_fetch_add_u32(&sweep->nextVictimBuffer, 1);
+		buf = GetBufferDescriptor(first + victim % nbuffers);
+
+		local_buf_state = LockBufHdr(buf);
+
+		if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0)
+		{
+			if (BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
+			{
+				/* Found a usable buffer */
+				if (strategy != NULL)
+					AddBufferToRing(strategy, buf);
+				*buf_state = local_buf_state;
+				return buf;
+			}
+			local_buf_state -= BUF_USAGECOUNT_ONE;
+		}
+		UnlockBufHdr(buf, local_buf_state);
+	}
+
+	return NULL;
+}
+
 /*
  * StrategyFreeBuffer: put a buffer on the freelist
  */
@@ -380,6 +506,53 @@ StrategyFreeBuffer(BufferDesc *buf)
 	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 }
 
+/*
+ * StrategySetUsableBuffers -- set the number of buffers the strategy may
+ *		hand out
+ *
+ * When lowering the limit, the buffers above it are also removed from the
+ * freelist, and the clock sweep hand is moved back to the start so that it
+ * doesn't waste its time skipping over them.  The caller is responsible for
+ * putting any buffers added by raising the limit on the freelist.
+ */
+void
+StrategySetUsableBuffers(int nbuffers)
+{
+	int			prev = -1;
+	int			next;
+
+	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+
+	pg_atomic_write_u32(&StrategyControl->numUsableBuffers, nbuffers);
+
+	next = StrategyControl->firstFreeBuffer;
+	while (next >= 0)
+	{
+		BufferDesc *buf = GetBufferDescriptor(next);
+
+		next = buf->freeNext;
+		if (buf->buf_id < nbuffers)
+		{
+			prev = buf->buf_id;
+			continue;
+		}
+
+		/* unlink it */
+		if (prev < 0)
+			StrategyControl->firstFreeBuffer = next;
+		else
+			GetBufferDescriptor(prev)->freeNext = next;
+		if (next < 0)
+			StrategyControl->lastFreeBuffer = prev;
+		buf->freeNext = FREENEXT_NOT_IN_LIST;
+	}
+
+	if (pg_atomic_read_u32(&StrategyControl->nextVictimBuffer) % NBuffers >= nbuffers)
+		pg_atomic_write_u32(&StrategyControl->nextVictimBuffer, 0);
+
+	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+}
+
 /*
  * StrategySyncStart -- tell BufferSync where to start syncing
  *
@@ -415,11 +588,41 @@ StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
 	if (num_buf_alloc)
 	{
 		*num_buf_alloc = pg_atomic_exchange_u32(&StrategyControl->numBufferAllocs, 0);
+		StrategyControl->totalBufferAllocs += *num_buf_alloc;
 	}
 	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 	return result;
 }
 
+/*
+ * StrategyGetStats -- report cumulative buffer replacement statistics
+ *
+ * The clock sweep counters are derived from the clock hand itself, so
+ * tracking them costs nothing extra in StrategyGetBuffer().
+ */
+void
+StrategyGetStats(BufferStrategyStats *stats)
+{
+	uint32		nextVictimBuffer;
+	uint64		passes;
+
+	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+	nextVictimBuffer = pg_atomic_read_u32(&StrategyControl->nextVictimBuffer);
+
+	/* See StrategySyncStart() */
+	passes = (uint64) StrategyControl->completePasses +
+		nextVictimBuffer / NBuffers;
+
+	stats->buffer_allocs = StrategyControl->totalBufferAllocs +
+		pg_atomic_read_u32(&StrategyControl->numBufferAllocs);
+	stats->freelist_allocs = StrategyControl->freelistAllocs;
+	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+
+	stats->ring_reuses = pg_atomic_read_u64(&StrategyControl->ringReuses);
+	stats->clock_sweep_passes = passes;
+	stats->clock_sweep_ticks = passes * NBuffers + nextVictimBuffer % NBuffers;
+}
+
 /*
  * StrategyNotifyBgWriter -- set or clear allocation notification latch
  *
@@ -456,7 +659,7 @@ StrategyShmemSize(void)
 	Size		size = 0;
 
 	/* size of lookup hash table ... see comment in StrategyInitialize */
-	size = add_size(size, BufTableShmemSize(NBuffers + NUM_BUFFER_PARTITIONS));
+	size = add_size(size, BufTableShmemSize(MaxNBuffers + NUM_BUFFER_PARTITIONS));
 
 	/* size of the shared replacement strategy control block */
 	size = add_size(size, MAXALIGN(sizeof(BufferStrategyControl)));
@@ -475,6 +678,7 @@ void
 StrategyInitialize(bool init)
 {
 	bool		found;
+	int			i;
 
 	/*
 	 * Initialize the shared buffer lookup hashtable.
@@ -484,9 +688,10 @@ StrategyInitialize(bool init)
 	 * usage is of course NBuffers entries, but BufferAlloc() tries to insert
 	 * a new entry before deleting the old.  In principle this could be
 	 * happening in each partition concurrently, so we could need as many as
-	 * NBuffers + NUM_BUFFER_PARTITIONS entries.
+	 * NBuffers + NUM_BUFFER_PARTITIONS entries.  The table is sized for the
+	 * largest the buffer pool may grow to without a restart.
 	 */
-	InitBufTable(NBuffers + NUM_BUFFER_PARTITIONS);
+	InitBufTable(MaxNBuffers + NUM_BUFFER_PARTITIONS);
 
 	/*
 	 * Get or create the shared strategy control block
@@ -518,9 +723,23 @@ StrategyInitialize(bool init)
 		/* Clear statistics */
 		StrategyControl->completePasses = 0;
 		pg_atomic_init_u32(&StrategyControl->numBufferAllocs, 0);
+		StrategyControl->totalBufferAllocs = 0;
+		StrategyControl->freelistAllocs = 0;
+		pg_atomic_init_u64(&StrategyControl->ringReuses, 0);
 
 		/* No pending notification */
 		StrategyControl->bgwprocno = -1;
+
+		/* Set up the per-node clock sweeps, if the pool is partitioned */
+		if (numa_placement == NUMA_PLACEMENT_PARTITION)
+			StrategyControl->numNodes = ShmemNumaNodes();
+		else
+			StrategyControl->numNodes = 1;
+		for (i = 0; i < PG_NUMA_MAX_NODES; i++)
+			pg_atomic_init_u32(&StrategyControl->nodeSweep[i].nextVictimBuffer, 0);
+
+		/* All the buffers in the pool can be used */
+		pg_atomic_init_u32(&StrategyControl->numUsableBuffers, NBuffers);
 	}
 	else
 		Assert(!init);
@@ -608,7 +827,8 @@ FreeAccessStrategy(BufferAccessStrategy strategy)
  * The bufhdr spin lock is held on the returned buffer.
  */
 static BufferDesc *
-GetBufferFromRing(BufferAccessStrategy strategy, uint32 *buf_state)
+GetBufferFromRing(BufferAccessStrategy strategy, int usable,
+				  uint32 *buf_state)
 {
 	BufferDesc *buf;
 	Buffer		bufnum;
@@ -625,7 +845,7 @@ GetBufferFromRing(BufferAccessStrategy strategy, uint32 *buf_state)
 	 * slot by calling AddBufferToRing with the new buffer.
 	 */
 	bufnum = strategy->buffers[strategy->current];
-	if (bufnum == InvalidBuffer)
+	if (bufnum == InvalidBuffer || bufnum > usable)
 	{
 		strategy->current_was_in_ring = false;
 		return NULL;
@@ -645,6 +865,7 @@ GetBufferFromRing(BufferAccessStrategy strategy, uint32 *buf_state)
 	if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
 		&& BUF_STATE_GET_USAGECOUNT(local_buf_state) <= 1)
 	{
+		pg_atomic_fetch_add_u64(&StrategyControl->ringReuses, 1);
 		strategy->current_was_in_ring = true;
 		*buf_state = local_buf_state;
 		return buf;
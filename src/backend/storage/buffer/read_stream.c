@@ -0,0 +1,197 @@
+/*-------------------------------------------------------------------------
+ *
+ * read_stream.c
+ *	  Mechanism for reading a sequence of blocks of a relation, combining
+ *	  the reads of consecutive blocks into larger I/Os.
+ *
+ * A read stream is given a callback that produces the block numbers to be
+ * read, in the order the caller wants the buffers back.  Whenever the caller
+ * asks for a buffer and none is queued up, the stream collects a run of
+ * consecutive block numbers from the callback, up to io_combine_limit of
+ * them, and hands the run to ReadBuffers(), which reads all the blocks that
+ * are not already in shared buffers with a single smgrreadv() call.  The
+ * resulting pinned buffers are then returned to the caller one by one.
+ *
+ * The callback may return InvalidBlockNumber to indicate that it has no more
+ * blocks to suggest for the moment; read_stream_next_buffer then returns
+ * InvalidBuffer once the queue has drained, and will consult the callback
+ * again on the next call.  If the caller's access pattern diverges from what
+ * the callback predicted, it can discard the queue with read_stream_reset(),
+ * adjust the callback's state, and carry on.
+ *
+ * Since the stream holds pins on the buffers it has read ahead, callers must
+ * make sure that doesn't get in the way of anything they do to the blocks
+ * they have already consumed, such as acquiring a cleanup lock.
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/buffer/read_stream.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "storage/read_stream.h"
+
+
+struct ReadStream
+{
+	Relation	rel;
+	ForkNumber	forknum;
+	BufferAccessStrategy strategy;
+
+	ReadStreamBlockNumberCB callback;
+	void	   *callback_private_data;
+
+	/*
+	 * Blocks received from the callback but not yet read: a run of
+	 * consecutive blocks, plus at most one more block that didn't fit onto
+	 * the end of the run.
+	 */
+	BlockNumber pending_start;
+	int			pending_nblocks;
+	BlockNumber lookahead;
+
+	/* Pinned buffers not yet returned to the caller */
+	int			nbuffers;
+	int			next_buffer;
+	Buffer		buffers[MAX_IO_COMBINE_LIMIT];
+};
+
+static bool read_stream_fill(ReadStream *stream);
+
+
+/*
+ * Create a new read stream for the given relation fork.  Blocks are read
+ * using the given buffer access strategy, which may be NULL.
+ */
+ReadStream *
+read_stream_begin_relation(Relation rel,
+						   ForkNumber forknum,
+						   BufferAccessStrategy strategy,
+						   ReadStreamBlockNumberCB callback,
+						   void *callback_private_data)
+{
+	ReadStream *stream;
+
+	stream = (ReadStream *) palloc(sizeof(ReadStream));
+	stream->rel = rel;
+	stream->forknum = forknum;
+	stream->strategy = strategy;
+	stream->callback = callback;
+	stream->callback_private_data = callback_private_data;
+	stream->pending_start = InvalidBlockNumber;
+	stream->pending_nblocks = 0;
+	stream->lookahead = InvalidBlockNumber;
+	stream->nbuffers = 0;
+	stream->next_buffer = 0;
+
+	return stream;
+}
+
+/*
+ * Return the next pinned buffer in the stream, or InvalidBuffer if the
+ * callback has no more blocks to offer.  The caller takes over the pin.
+ */
+Buffer
+read_stream_next_buffer(ReadStream *stream)
+{
+	if (stream->next_buffer >= stream->nbuffers &&
+		!read_stream_fill(stream))
+		return InvalidBuffer;
+
+	return stream->buffers[stream->next_buffer++];
+}
+
+/*
+ * Forget all blocks received from the callback that haven't been returned
+ * to the caller yet, releasing the pins held on any buffers already read.
+ * The next call to read_stream_next_buffer will start over by calling the
+ * callback.
+ */
+void
+read_stream_reset(ReadStream *stream)
+{
+	while (stream->next_buffer < stream->nbuffers)
+		ReleaseBuffer(stream->buffers[stream->next_buffer++]);
+
+	stream->nbuffers = 0;
+	stream->next_buffer = 0;
+	stream->pending_start = InvalidBlockNumber;
+	stream->pending_nblocks = 0;
+	stream->lookahead = InvalidBlockNumber;
+}
+
+/*
+ * Release all resources held by a read stream.
+ */
+void
+read_stream_end(ReadStream *stream)
+{
+	read_stream_reset(stream);
+	pfree(stream);
+}
+
+/*
+ * Read the next run of blocks into the stream's queue of buffers.  Returns
+ * false if the callback had no blocks for us.
+ */
+static bool
+read_stream_fill(ReadStream *stream)
+{
+	int			max_combine = Min(io_combine_limit, MAX_IO_COMBINE_LIMIT);
+	int			nread;
+
+	/* Start a new run with the block we had to set aside last time, if any */
+	if (stream->pending_nblocks == 0 &&
+		stream->lookahead != InvalidBlockNumber)
+	{
+		stream->pending_start = stream->lookahead;
+		stream->pending_nblocks = 1;
+		stream->lookahead = InvalidBlockNumber;
+	}
+
+	/* Extend the run with as many consecutive blocks as we're allowed */
+	while (stream->lookahead == InvalidBlockNumber &&
+		   stream->pending_nblocks < max_combine)
+	{
+		BlockNumber blkno;
+
+		blkno = stream->callback(stream, stream->callback_private_data);
+		if (blkno == InvalidBlockNumber)
+			break;
+
+		if (stream->pending_nblocks == 0)
+		{
+			stream->pending_start = blkno;
+			stream->pending_nblocks = 1;
+		}
+		else if (blkno == stream->pending_start + stream->pending_nblocks)
+			stream->pending_nblocks++;
+		else
+			stream->lookahead = blkno;
+	}
+
+	if (stream->pending_nblocks == 0)
+		return false;
+
+	/*
+	 * ReadBuffers may read fewer blocks than we asked for, if it finds some
+	 * of them in the buffer pool already; the rest remain pending.
+	 */
+	nread = ReadBuffers(stream->rel, stream->forknum, stream->pending_start,
+						stream->pending_nblocks, stream->buffers,
+						stream->strategy);
+	Assert(nread >= 1 && nread <= stream->pending_nblocks);
+
+	stream->pending_start += nread;
+	stream->pending_nblocks -= nread;
+	stream->nbuffers = nread;
+	stream->next_buffer = 0;
+
+	return true;
+}
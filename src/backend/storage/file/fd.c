@@ -85,6 +85,7 @@
 #include "catalog/pg_tablespace.h"
 #include "common/file_perm.h"
 #include "pgstat.h"
+#include "port/pg_iovec.h"
 #include "portability/mem.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
@@ -325,6 +326,17 @@ static void unlink_if_exists_fname(const char *fname, bool isdir, int elevel);
 static int	fsync_fname_ext(const char *fname, bool isdir, bool ignore_perm, int elevel);
 static int	fsync_parent_path(const char *fname, int elevel);
 
+#ifdef HAVE_PREADV
+#define pg_preadv preadv
+#else
+static ssize_t pg_preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+#endif
+#ifdef HAVE_PWRITEV
+#define pg_pwritev pwritev
+#else
+static ssize_t pg_pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+#endif
+
 
 /*
  * pg_fsync --- do fsync with or without writethrough
@@ -2014,6 +2026,327 @@ retry:
 	return returnCode;
 }
 
+/*
+ * FileReadV - read into several buffers with a single system call
+ *
+ * Like FileRead(), but scatters the data read from "offset" onward into the
+ * iovcnt buffers described by iov.  Returns the total number of bytes read,
+ * which may be less than requested at end of file, or -1 on error.
+ */
+int
+FileReadV(File file, const struct iovec *iov, int iovcnt, off_t offset,
+		  uint32 wait_event_info)
+{
+	int			returnCode;
+	Vfd		   *vfdP;
+
+	Assert(FileIsValid(file));
+	Assert(iovcnt > 0 && iovcnt <= PG_IOV_MAX);
+
+	DO_DB(elog(LOG, "FileReadV: %d (%s) " INT64_FORMAT " %d",
+			   file, VfdCache[file].fileName,
+			   (int64) offset,
+			   iovcnt));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	vfdP = &VfdCache[file];
+
+retry:
+	pgstat_report_wait_start(wait_event_info);
+	returnCode = pg_preadv(vfdP->fd, iov, iovcnt, offset);
+	pgstat_report_wait_end();
+
+	if (returnCode < 0)
+	{
+		/*
+		 * See comments in FileRead()
+		 */
+#ifdef WIN32
+		DWORD		error = GetLastError();
+
+		switch (error)
+		{
+			case ERROR_NO_SYSTEM_RESOURCES:
+				pg_usleep(1000L);
+				errno = EINTR;
+				break;
+			default:
+				_dosmaperr(error);
+				break;
+		}
+#endif
+		/* OK to retry if interrupted */
+		if (errno == EINTR)
+			goto retry;
+	}
+
+	return returnCode;
+}
+
+/*
+ * FileWriteV - write from several buffers with a single system call
+ *
+ * Like FileWrite(), but gathers the data to be written at "offset" from the
+ * iovcnt buffers described by iov.  Returns the total number of bytes
+ * written, or -1 on error.  As with FileWrite(), a short write without an
+ * errno is reported as ENOSPC.
+ */
+int
+FileWriteV(File file, const struct iovec *iov, int iovcnt, off_t offset,
+		   uint32 wait_event_info)
+{
+	int			returnCode;
+	Vfd		   *vfdP;
+	int			amount = 0;
+	int			i;
+
+	Assert(FileIsValid(file));
+	Assert(iovcnt > 0 && iovcnt <= PG_IOV_MAX);
+
+	DO_DB(elog(LOG, "FileWriteV: %d (%s) " INT64_FORMAT " %d",
+			   file, VfdCache[file].fileName,
+			   (int64) offset,
+			   iovcnt));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	vfdP = &VfdCache[file];
+
+	for (i = 0; i < iovcnt; i++)
+		amount += iov[i].iov_len;
+
+	/*
+	 * If enforcing temp_file_limit and it's a temp file, check to see if the
+	 * write would overrun temp_file_limit, and throw error if so.  See
+	 * FileWrite().
+	 */
+	if (temp_file_limit >= 0 && (vfdP->fdstate & FD_TEMP_FILE_LIMIT))
+	{
+		off_t		past_write = offset + amount;
+
+		if (past_write > vfdP->fileSize)
+		{
+			uint64		newTotal = temporary_files_size;
+
+			newTotal += past_write - vfdP->fileSize;
+			if (newTotal > (uint64) temp_file_limit * (uint64) 1024)
+				ereport(ERROR,
+						(errcode(ERRCODE_CONFIGURATION_LIMIT_EXCEEDED),
+						 errmsg("temporary file size exceeds temp_file_limit (%dkB)",
+								temp_file_limit)));
+		}
+	}
+
+retry:
+	errno = 0;
+	pgstat_report_wait_start(wait_event_info);
+	returnCode = pg_pwritev(vfdP->fd, iov, iovcnt, offset);
+	pgstat_report_wait_end();
+
+	/* if write didn't set errno, assume problem is no disk space */
+	if (returnCode != amount && errno == 0)
+		errno = ENOSPC;
+
+	if (returnCode >= 0)
+	{
+		/* Maintain fileSize and temporary_files_size if it's a temp file. */
+		if (vfdP->fdstate & FD_TEMP_FILE_LIMIT)
+		{
+			off_t		past_write = offset + returnCode;
+
+			if (past_write > vfdP->fileSize)
+			{
+				temporary_files_size += past_write - vfdP->fileSize;
+				vfdP->fileSize = past_write;
+			}
+		}
+	}
+	else
+	{
+		/*
+		 * See comments in FileRead()
+		 */
+#ifdef WIN32
+		DWORD		error = GetLastError();
+
+		switch (error)
+		{
+			case ERROR_NO_SYSTEM_RESOURCES:
+				pg_usleep(1000L);
+				errno = EINTR;
+				break;
+			default:
+				_dosmaperr(error);
+				break;
+		}
+#endif
+		/* OK to retry if interrupted */
+		if (errno == EINTR)
+			goto retry;
+	}
+
+	return returnCode;
+}
+
+/*
+ * FileZero - write zeroes into a region of a file
+ *
+ * Returns 0 on success, -1 otherwise, with errno set.  As with FileWrite(),
+ * a short write without an errno is reported as ENOSPC.
+ */
+int
+FileZero(File file, off_t offset, off_t amount, uint32 wait_event_info)
+{
+	/* static, so all zeroes; aligned when used, for direct I/O */
+	static char zbuffer_raw[BLCKSZ + PG_IO_ALIGN_SIZE];
+	char	   *zbuffer = (char *) TYPEALIGN(PG_IO_ALIGN_SIZE, zbuffer_raw);
+	struct iovec iov[PG_IOV_MAX];
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileZero: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) amount));
+
+	while (amount > 0)
+	{
+		int			iovcnt = 0;
+		int			chunk = 0;
+		int			written;
+
+		/* Point as many iovecs as we can at the same block of zeroes */
+		while (iovcnt < PG_IOV_MAX && chunk < amount)
+		{
+			iov[iovcnt].iov_base = zbuffer;
+			iov[iovcnt].iov_len = Min(BLCKSZ, amount - chunk);
+			chunk += iov[iovcnt].iov_len;
+			iovcnt++;
+		}
+
+		written = FileWriteV(file, iov, iovcnt, offset, wait_event_info);
+		if (written != chunk)
+			return -1;			/* errno is set by FileWriteV */
+
+		offset += chunk;
+		amount -= chunk;
+	}
+
+	return 0;
+}
+
+/*
+ * FileFallocate - allocate space for a region of a file
+ *
+ * Uses posix_fallocate() where available, which commonly avoids having the
+ * kernel allocate page cache for, and write out, the new region.  Falls back
+ * to FileZero() if that's not available or not supported by the file system.
+ * Either way the region reads as zeroes afterwards.  Returns 0 on success,
+ * -1 otherwise, with errno set.
+ */
+int
+FileFallocate(File file, off_t offset, off_t amount, uint32 wait_event_info)
+{
+#ifdef HAVE_POSIX_FALLOCATE
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileFallocate: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return -1;
+
+retry:
+	pgstat_report_wait_start(wait_event_info);
+	returnCode = posix_fallocate(VfdCache[file].fd, offset, amount);
+	pgstat_report_wait_end();
+
+	if (returnCode == 0)
+		return 0;
+	else if (returnCode == EINTR)
+		goto retry;
+
+	/* posix_fallocate() reports errors in its result, not errno */
+	errno = returnCode;
+
+	/* Fall back to writing zeroes if the file system can't do it */
+	if (returnCode != EINVAL && returnCode != EOPNOTSUPP)
+		return -1;
+#endif
+
+	return FileZero(file, offset, amount, wait_event_info);
+}
+
+#ifndef HAVE_PREADV
+/*
+ * Emulate preadv(2) with a series of pread(2) calls, for platforms that
+ * lack it.  Stops at the first short read, like the real thing would.
+ */
+static ssize_t
+pg_preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+{
+	ssize_t		sum = 0;
+	ssize_t		part;
+	int			i;
+
+	for (i = 0; i < iovcnt; ++i)
+	{
+		part = pg_pread(fd, iov[i].iov_base, iov[i].iov_len, offset);
+		if (part < 0)
+		{
+			if (i == 0)
+				return -1;
+			else
+				return sum;
+		}
+		sum += part;
+		offset += part;
+		if ((size_t) part < iov[i].iov_len)
+			return sum;
+	}
+	return sum;
+}
+#endif
+
+#ifndef HAVE_PWRITEV
+/*
+ * Emulate pwritev(2) with a series of pwrite(2) calls, for platforms that
+ * lack it.
+ */
+static ssize_t
+pg_pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+{
+	ssize_t		sum = 0;
+	ssize_t		part;
+	int			i;
+
+	for (i = 0; i < iovcnt; ++i)
+	{
+		part = pg_pwrite(fd, iov[i].iov_base, iov[i].iov_len, offset);
+		if (part < 0)
+		{
+			if (i == 0)
+				return -1;
+			else
+				return sum;
+		}
+		sum += part;
+		offset += part;
+		if ((size_t) part < iov[i].iov_len)
+			return sum;
+	}
+	return sum;
+}
+#endif
+
 int
 FileSync(File file, uint32 wait_event_info)
 {
@@ -43,7 +43,10 @@
 #include "storage/procarray.h"
 #include "storage/procsignal.h"
 #include "storage/sinvaladt.h"
+#include "storage/smgr.h"
 #include "storage/spin.h"
+#include "utils/catcache.h"
+#include "utils/plancache.h"
 #include "utils/snapmgr.h"
 
 /* GUCs */
@@ -123,6 +126,9 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, hash_estimate_size(SHMEM_INDEX_SIZE,
 												 sizeof(ShmemIndexEnt)));
 		size = add_size(size, BufferShmemSize());
+		size = add_size(size, SMgrShmemSize());
+		size = add_size(size, SharedCatCacheShmemSize());
+		size = add_size(size, SharedPlanCacheShmemSize());
 		size = add_size(size, LockShmemSize());
 		size = add_size(size, PredicateLockShmemSize());
 		size = add_size(size, ProcGlobalShmemSize());
@@ -223,6 +229,9 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	SUBTRANSShmemInit();
 	MultiXactShmemInit();
 	InitBufferPool();
+	SMgrShmemInit();
+	SharedCatCacheShmemInit();
+	SharedPlanCacheShmemInit();
 
 	/*
 	 * Set up lock manager
@@ -810,6 +810,59 @@ ModifyWaitEvent(WaitEventSet *set, int pos, uint32 events, Latch *latch)
 #endif
 }
 
+/*
+ * Remove the socket event at position 'pos' from the set.
+ *
+ * To keep the set dense, the last event of the set is moved into the vacated
+ * position.  Returns the user_data of the moved event, so that the caller can
+ * update its record of that event's position, or NULL if the removed event
+ * was the last one.  Latch and postmaster death events cannot be removed, and
+ * must therefore be added before any event that will be.  The socket must
+ * still be open when its event is removed.
+ */
+void *
+RemoveWaitEventFromSet(WaitEventSet *set, int pos)
+{
+	WaitEvent  *event;
+	WaitEvent  *last;
+
+	Assert(pos < set->nevents);
+
+	event = &set->events[pos];
+	last = &set->events[set->nevents - 1];
+
+	if (event->events & (WL_LATCH_SET | WL_POSTMASTER_DEATH) ||
+		last->events & (WL_LATCH_SET | WL_POSTMASTER_DEATH))
+		elog(ERROR, "cannot remove latch or postmaster death event");
+
+#if defined(WAIT_USE_EPOLL)
+	WaitEventAdjustEpoll(set, event, EPOLL_CTL_DEL);
+#elif defined(WAIT_USE_WIN32)
+	WSAEventSelect(event->fd, NULL, 0);
+	WSACloseEvent(set->handles[pos + 1]);
+	set->handles[pos + 1] = WSA_INVALID_EVENT;
+#endif
+
+	set->nevents--;
+	if (event == last)
+		return NULL;
+
+	*event = *last;
+	event->pos = pos;
+
+#if defined(WAIT_USE_EPOLL)
+	/* epoll hands back a pointer to the event, so point it at the new slot */
+	WaitEventAdjustEpoll(set, event, EPOLL_CTL_MOD);
+#elif defined(WAIT_USE_POLL)
+	set->pollfds[pos] = set->pollfds[set->nevents];
+#elif defined(WAIT_USE_WIN32)
+	set->handles[pos + 1] = set->handles[set->nevents + 1];
+	set->handles[set->nevents + 1] = WSA_INVALID_EVENT;
+#endif
+
+	return event->user_data;
+}
+
 #if defined(WAIT_USE_EPOLL)
 /*
  * action can be one of EPOLL_CTL_ADD | EPOLL_CTL_MOD | EPOLL_CTL_DEL
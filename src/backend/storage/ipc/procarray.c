@@ -1526,6 +1526,7 @@ GetSnapshotData(Snapshot snapshot)
 	int			count = 0;
 	int			subcount = 0;
 	bool		suboverflowed = false;
+	TransactionId suboverflowxmin;
 	TransactionId replication_slot_xmin = InvalidTransactionId;
 	TransactionId replication_slot_catalog_xmin = InvalidTransactionId;
 
@@ -1576,6 +1577,7 @@ GetSnapshotData(Snapshot snapshot)
 
 	/* initialize xmin calculation with xmax */
 	globalxmin = xmin = xmax;
+	suboverflowxmin = xmax;
 
 	snapshot->takenDuringRecovery = RecoveryInProgress();
 
@@ -1636,11 +1638,17 @@ GetSnapshotData(Snapshot snapshot)
 			snapshot->xip[count++] = xid;
 
 			/*
-			 * Save subtransaction XIDs if possible (if we've already
-			 * overflowed, there's no point).  Note that the subxact XIDs must
-			 * be later than their parent, so no need to check them against
-			 * xmin.  We could filter against xmax, but it seems better not to
-			 * do that much work while holding the ProcArrayLock.
+			 * Save subtransaction XIDs if possible.  Note that the subxact
+			 * XIDs must be later than their parent, so no need to check them
+			 * against xmin.  We could filter against xmax, but it seems
+			 * better not to do that much work while holding the
+			 * ProcArrayLock.
+			 *
+			 * If this backend's cache has overflowed, just remember its XID.
+			 * We keep collecting the other backends' subxids, because every
+			 * running subxact older than the oldest overflowed transaction
+			 * is then still listed in subxip[], and XidInMVCCSnapshot() only
+			 * has to consult pg_subtrans for the XIDs from there up.
 			 *
 			 * The other backend can add more subxids concurrently, but cannot
 			 * remove any.  Hence it's important to fetch nxids just once.
@@ -1650,25 +1658,26 @@ GetSnapshotData(Snapshot snapshot)
 			 *
 			 * Again, our own XIDs are not included in the snapshot.
 			 */
-			if (!suboverflowed)
+			if (pgxact->overflowed)
 			{
-				if (pgxact->overflowed)
-					suboverflowed = true;
-				else
-				{
-					int			nxids = pgxact->nxids;
+				suboverflowed = true;
+				if (NormalTransactionIdPrecedes(xid, suboverflowxmin))
+					suboverflowxmin = xid;
+			}
+			else
+			{
+				int			nxids = pgxact->nxids;
 
-					if (nxids > 0)
-					{
-						PGPROC	   *proc = &allProcs[pgprocno];
+				if (nxids > 0)
+				{
+					PGPROC	   *proc = &allProcs[pgprocno];
 
-						pg_read_barrier();	/* pairs with GetNewTransactionId */
+					pg_read_barrier();	/* pairs with GetNewTransactionId */
 
-						memcpy(snapshot->subxip + subcount,
-							   (void *) proc->subxids.xids,
-							   nxids * sizeof(TransactionId));
-						subcount += nxids;
-					}
+					memcpy(snapshot->subxip + subcount,
+						   (void *) proc->subxids.xids,
+						   nxids * sizeof(TransactionId));
+					subcount += nxids;
 				}
 			}
 		}
@@ -1709,6 +1718,9 @@ GetSnapshotData(Snapshot snapshot)
 
 		if (TransactionIdPrecedesOrEquals(xmin, procArray->lastOverflowedXid))
 			suboverflowed = true;
+
+		/* No partial subxid information is tracked in recovery */
+		suboverflowxmin = xmin;
 	}
 
 
@@ -1756,11 +1768,29 @@ GetSnapshotData(Snapshot snapshot)
 
 	RecentXmin = xmin;
 
+	/*
+	 * Subxids at or after the oldest overflowed transaction are useless,
+	 * since XidInMVCCSnapshot() has to look those up in pg_subtrans anyway,
+	 * so squeeze them out of subxip[].
+	 */
+	if (suboverflowed && !snapshot->takenDuringRecovery)
+	{
+		int			nkept = 0;
+
+		for (index = 0; index < subcount; index++)
+		{
+			if (TransactionIdPrecedes(snapshot->subxip[index], suboverflowxmin))
+				snapshot->subxip[nkept++] = snapshot->subxip[index];
+		}
+		subcount = nkept;
+	}
+
 	snapshot->xmin = xmin;
 	snapshot->xmax = xmax;
 	snapshot->xcnt = count;
 	snapshot->subxcnt = subcount;
 	snapshot->suboverflowed = suboverflowed;
+	snapshot->suboverflowxmin = suboverflowed ? suboverflowxmin : xmax;
 
 	snapshot->curcid = GetCurrentCommandId(false);
 
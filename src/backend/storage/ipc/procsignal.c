@@ -20,13 +20,16 @@
 #include "access/parallel.h"
 #include "commands/async.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "replication/walsender.h"
+#include "storage/bufmgr.h"
 #include "storage/latch.h"
 #include "storage/ipc.h"
 #include "storage/proc.h"
 #include "storage/shmem.h"
 #include "storage/sinval.h"
 #include "tcop/tcopprot.h"
+#include "utils/timestamp.h"
 
 
 /*
@@ -46,13 +49,30 @@
  * The flags are actually declared as "volatile sig_atomic_t" for maximum
  * portability.  This should ensure that loads and stores of the flag
  * values are atomic, allowing us to dispense with any explicit locking.
+ *
+ * In addition, each slot records the last global barrier generation the
+ * process has absorbed, and the kinds of barriers it has yet to act on.
+ * A slot that isn't in use has a barrier generation of PG_UINT64_MAX, so
+ * that processes waiting for a barrier don't wait for it.
  */
 typedef struct
 {
 	pid_t		pss_pid;
 	sig_atomic_t pss_signalFlags[NUM_PROCSIGNALS];
+	pg_atomic_uint64 pss_barrierGeneration;
+	pg_atomic_uint32 pss_barrierCheckMask;
 } ProcSignalSlot;
 
+/*
+ * Information that is global to the procsignal mechanism, followed by the
+ * array of slots.
+ */
+typedef struct
+{
+	pg_atomic_uint64 psh_barrierGeneration;
+	ProcSignalSlot psh_slot[FLEXIBLE_ARRAY_MEMBER];
+} ProcSignalHeader;
+
 /*
  * We reserve a slot for each possible BackendId, plus one for each
  * possible auxiliary process type.  (This scheme assumes there is not
@@ -60,11 +80,16 @@ typedef struct
  */
 #define NumProcSignalSlots	(MaxBackends + NUM_AUXPROCTYPES)
 
+#define BARRIER_SHOULD_CHECK(flags, type) \
+	(((flags) & (((uint32) 1) << (uint32) (type))) != 0)
+
+static ProcSignalHeader *ProcSignal = NULL;
 static ProcSignalSlot *ProcSignalSlots = NULL;
 static volatile ProcSignalSlot *MyProcSignalSlot = NULL;
 
 static bool CheckProcSignal(ProcSignalReason reason);
 static void CleanupProcSignalState(int status, Datum arg);
+static void HandleProcSignalBarrierInterrupt(void);
 
 /*
  * ProcSignalShmemSize
@@ -73,7 +98,11 @@ static void CleanupProcSignalState(int status, Datum arg);
 Size
 ProcSignalShmemSize(void)
 {
-	return NumProcSignalSlots * sizeof(ProcSignalSlot);
+	Size		size;
+
+	size = mul_size(NumProcSignalSlots, sizeof(ProcSignalSlot));
+	size = add_size(size, offsetof(ProcSignalHeader, psh_slot));
+	return size;
 }
 
 /*
@@ -86,12 +115,26 @@ ProcSignalShmemInit(void)
 	Size		size = ProcSignalShmemSize();
 	bool		found;
 
-	ProcSignalSlots = (ProcSignalSlot *)
-		ShmemInitStruct("ProcSignalSlots", size, &found);
+	ProcSignal = (ProcSignalHeader *)
+		ShmemInitStruct("ProcSignal", size, &found);
+	ProcSignalSlots = ProcSignal->psh_slot;
 
-	/* If we're first, set everything to zeroes */
+	/* If we're first, initialize. */
 	if (!found)
-		MemSet(ProcSignalSlots, 0, size);
+	{
+		int			i;
+
+		MemSet(ProcSignal, 0, size);
+		pg_atomic_init_u64(&ProcSignal->psh_barrierGeneration, 0);
+
+		for (i = 0; i < NumProcSignalSlots; i++)
+		{
+			ProcSignalSlot *slot = &ProcSignalSlots[i];
+
+			pg_atomic_init_u64(&slot->pss_barrierGeneration, PG_UINT64_MAX);
+			pg_atomic_init_u32(&slot->pss_barrierCheckMask, 0);
+		}
+	}
 }
 
 /*
@@ -118,6 +161,16 @@ ProcSignalInit(int pss_idx)
 	/* Clear out any leftover signal reasons */
 	MemSet(slot->pss_signalFlags, 0, NUM_PROCSIGNALS * sizeof(sig_atomic_t));
 
+	/*
+	 * Barriers emitted before this point don't concern us; any process-local
+	 * state they guard must be initialized from shared memory after this.
+	 * The full barrier implied by the atomic exchange makes sure that anyone
+	 * emitting a barrier later sees this slot as in use.
+	 */
+	pg_atomic_write_u32(&slot->pss_barrierCheckMask, 0);
+	pg_atomic_exchange_u64(&slot->pss_barrierGeneration,
+						   pg_atomic_read_u64(&ProcSignal->psh_barrierGeneration));
+
 	/* Mark slot with my PID */
 	slot->pss_pid = MyProcPid;
 
@@ -162,6 +215,9 @@ CleanupProcSignalState(int status, Datum arg)
 		return;					/* XXX better to zero the slot anyway? */
 	}
 
+	/* Don't make anyone wait for us to absorb barriers */
+	pg_atomic_write_u64(&slot->pss_barrierGeneration, PG_UINT64_MAX);
+
 	slot->pss_pid = 0;
 }
 
@@ -231,6 +287,168 @@ SendProcSignal(pid_t pid, ProcSignalReason reason, BackendId backendId)
 	return -1;
 }
 
+/*
+ * EmitProcSignalBarrier
+ *		Send a signal to every Postgres process
+ *
+ * The caller has updated some shared state that every process keeps a
+ * local copy of, or otherwise depends on.  Each process is asked to act on
+ * the change the next time it checks for interrupts, and the return value
+ * is a generation number that can be passed to WaitForProcSignalBarrier()
+ * to wait until all processes, including the caller, have done so.
+ *
+ * Processes that start up after this call are expected to pick up the new
+ * shared state while initializing; see ProcSignalInit().
+ */
+uint64
+EmitProcSignalBarrier(ProcSignalBarrierType type)
+{
+	uint32		flagbit = 1 << (uint32) type;
+	uint64		generation;
+	int			i;
+
+	/*
+	 * Set the flag in every slot first, so that a process that sees the new
+	 * generation also sees what it has to do about it.  It doesn't matter if
+	 * some of the slots are unused; ProcSignalInit() clears the flags.
+	 */
+	for (i = 0; i < NumProcSignalSlots; i++)
+		pg_atomic_fetch_or_u32(&ProcSignalSlots[i].pss_barrierCheckMask,
+							   flagbit);
+
+	generation =
+		pg_atomic_add_fetch_u64(&ProcSignal->psh_barrierGeneration, 1);
+
+	/*
+	 * Signal everyone.  As in SendProcSignal, a slot could be released or
+	 * recycled concurrently, but at worst some process gets a harmless
+	 * extra signal.
+	 */
+	for (i = NumProcSignalSlots - 1; i >= 0; i--)
+	{
+		volatile ProcSignalSlot *slot = &ProcSignalSlots[i];
+		pid_t		pid = slot->pss_pid;
+
+		if (pid != 0)
+		{
+			slot->pss_signalFlags[PROCSIG_BARRIER] = true;
+			kill(pid, SIGUSR1);
+
+			/*
+			 * Auxiliary processes only check for barriers in their main
+			 * loops, and their SIGUSR1 handlers don't set their latches, so
+			 * wake them up ourselves rather than wait for them to time out.
+			 */
+			if (i >= MaxBackends)
+			{
+				PGPROC	   *proc = AuxiliaryPidGetProc(pid);
+
+				if (proc != NULL)
+					SetLatch(&proc->procLatch);
+			}
+		}
+	}
+
+	return generation;
+}
+
+/*
+ * WaitForProcSignalBarrier
+ *		Wait until all processes have absorbed the given barrier generation
+ *
+ * The caller absorbs the barrier itself while waiting.  If that hasn't
+ * happened within timeout milliseconds, give up and return false; the
+ * caller can wait for the same generation again later.  A timeout of -1
+ * waits for as long as it takes.
+ */
+bool
+WaitForProcSignalBarrier(uint64 generation, long timeout)
+{
+	TimestampTz start = 0;
+	int			i;
+
+	if (timeout >= 0)
+		start = GetCurrentTimestamp();
+
+	for (i = NumProcSignalSlots - 1; i >= 0; i--)
+	{
+		volatile ProcSignalSlot *slot = &ProcSignalSlots[i];
+
+		while (pg_atomic_read_u64(&slot->pss_barrierGeneration) < generation)
+		{
+			ProcessProcSignalBarrier();
+
+			if (timeout >= 0 &&
+				TimestampDifferenceExceeds(start, GetCurrentTimestamp(),
+										   timeout))
+				return false;
+
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+							 10, WAIT_EVENT_PROC_SIGNAL_BARRIER);
+			ResetLatch(MyLatch);
+		}
+	}
+
+	/* Make sure we see the state the other processes saw */
+	pg_memory_barrier();
+
+	return true;
+}
+
+/*
+ * ProcessProcSignalBarrier
+ *		Act on any global barriers emitted since we last checked
+ *
+ * This is called from CHECK_FOR_INTERRUPTS() in regular backends whenever
+ * ProcSignalBarrierPending is set.  Auxiliary processes don't route SIGUSR1
+ * through procsignal_sigusr1_handler(), so the flag is never set for them;
+ * they call this every time around their main loop instead, which is cheap
+ * when there's nothing to do.  It must only be called at a point where the
+ * process doesn't depend on any state that a barrier might change.
+ */
+void
+ProcessProcSignalBarrier(void)
+{
+	uint64		generation;
+	uint32		flags;
+
+	ProcSignalBarrierPending = false;
+	if (MyProcSignalSlot == NULL)
+		return;
+
+	/*
+	 * Read the global generation before clearing our flags, so that we
+	 * can't claim to have absorbed a barrier whose flag we haven't seen.
+	 */
+	generation = pg_atomic_read_u64(&ProcSignal->psh_barrierGeneration);
+	if (pg_atomic_read_u64(&MyProcSignalSlot->pss_barrierGeneration) ==
+		generation)
+		return;
+
+	flags = pg_atomic_exchange_u32(&MyProcSignalSlot->pss_barrierCheckMask, 0);
+
+	if (BARRIER_SHOULD_CHECK(flags, PROCSIGNAL_BARRIER_SHARED_BUFFERS))
+		RefreshBufferPoolSize();
+
+	pg_atomic_write_u64(&MyProcSignalSlot->pss_barrierGeneration, generation);
+}
+
+/*
+ * HandleProcSignalBarrierInterrupt
+ *		Note that a global barrier has been emitted
+ *
+ * Called from the SIGUSR1 handler; the actual work is deferred to
+ * ProcessProcSignalBarrier().
+ */
+static void
+HandleProcSignalBarrierInterrupt(void)
+{
+	InterruptPending = true;
+	ProcSignalBarrierPending = true;
+	/* latch will be set by procsignal_sigusr1_handler */
+}
+
 /*
  * CheckProcSignal - check to see if a particular reason has been
  * signaled, and clear the signal flag.  Should be called after receiving
@@ -274,6 +492,9 @@ procsignal_sigusr1_handler(SIGNAL_ARGS)
 	if (CheckProcSignal(PROCSIG_WALSND_INIT_STOPPING))
 		HandleWalSndInitStopping();
 
+	if (CheckProcSignal(PROCSIG_BARRIER))
+		HandleProcSignalBarrierInterrupt();
+
 	if (CheckProcSignal(PROCSIG_RECOVERY_CONFLICT_DATABASE))
 		RecoveryConflictInterrupt(PROCSIG_RECOVERY_CONFLICT_DATABASE);
 
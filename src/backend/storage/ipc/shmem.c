@@ -67,6 +67,7 @@
 
 #include "access/transam.h"
 #include "miscadmin.h"
+#include "port/pg_numa.h"
 #include "storage/lwlock.h"
 #include "storage/pg_shmem.h"
 #include "storage/shmem.h"
@@ -265,6 +266,47 @@ ShmemAddrIsValid(const void *addr)
 	return (addr >= ShmemBase) && (addr < ShmemEnd);
 }
 
+/*
+ * ShmemNumaNodes -- number of NUMA nodes to spread shared memory across
+ *
+ * Returns 1 if numa_placement is off, or if NUMA isn't supported here.
+ */
+int
+ShmemNumaNodes(void)
+{
+	if (numa_placement == NUMA_PLACEMENT_OFF)
+		return 1;
+	return pg_numa_init();
+}
+
+/*
+ * ShmemNumaInterleave -- spread a shared memory area across all NUMA nodes
+ *
+ * This must be done before the memory is first touched.  Failure is not
+ * fatal; the memory just ends up wherever the kernel chooses to put it.
+ */
+void
+ShmemNumaInterleave(void *ptr, Size size)
+{
+	if (ShmemNumaNodes() > 1 &&
+		pg_numa_interleave_memory(ptr, size, UsedShmemPageSize) != 0)
+		elog(LOG, "could not interleave shared memory across NUMA nodes: %m");
+}
+
+/*
+ * ShmemNumaBind -- prefer placing a shared memory area on one NUMA node
+ *
+ * As for ShmemNumaInterleave, this must be done before the memory is first
+ * touched.
+ */
+void
+ShmemNumaBind(void *ptr, Size size, int node)
+{
+	if (ShmemNumaNodes() > 1 &&
+		pg_numa_bind_memory(ptr, size, UsedShmemPageSize, node) != 0)
+		elog(LOG, "could not bind shared memory to NUMA node %d: %m", node);
+}
+
 /*
  *	InitShmemIndex() --- set up or attach to shmem index table.
  */
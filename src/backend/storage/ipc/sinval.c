@@ -20,7 +20,9 @@
 #include "storage/ipc.h"
 #include "storage/proc.h"
 #include "storage/sinvaladt.h"
+#include "utils/catcache.h"
 #include "utils/inval.h"
+#include "utils/plancache.h"
 
 
 uint64		SharedInvalidMessageCounter;
@@ -48,7 +50,37 @@ volatile sig_atomic_t catchupInterruptPending = false;
 void
 SendSharedInvalidMessages(const SharedInvalidationMessage *msgs, int n)
 {
+	bool		planInval = false;
+
+	/*
+	 * Remove the affected entries from the shared catalog and plan caches
+	 * first, so that nobody who has processed our messages can find stale
+	 * entries there.
+	 */
+	if (shared_catalog_cache_entries > 0)
+	{
+		int			i;
+
+		for (i = 0; i < n; i++)
+		{
+			const SharedInvalidationMessage *msg = &msgs[i];
+
+			if (msg->id >= 0)
+				SharedCatCacheInvalidate(msg->cc.id, msg->cc.dbId,
+										 msg->cc.hashValue);
+			else if (msg->id == SHAREDINVALCATALOG_ID)
+				SharedCatCacheFlushDatabase(msg->cat.dbId);
+		}
+	}
+
+	if (shared_plan_cache_size > 0)
+		planInval = SharedPlanCacheInvalidate(msgs, n);
+
 	SIInsertDataEntries(msgs, n);
+
+	/* See the comments for SharedPlanEntry in plancache.c */
+	if (planInval)
+		SharedPlanCacheAdvanceGeneration();
 }
 
 /*
@@ -17,6 +17,8 @@
 #include <signal.h>
 #include <unistd.h>
 
+#include "access/htup_details.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #include "storage/backendid.h"
 #include "storage/ipc.h"
@@ -26,6 +28,7 @@
 #include "storage/sinvaladt.h"
 #include "storage/spin.h"
 #include "access/transam.h"
+#include "utils/builtins.h"
 
 
 /*
@@ -44,9 +47,9 @@
  * SICleanupQueue is called, and we try not to do that often.)
  *
  * In reality, the messages are stored in a circular buffer of MAXNUMMESSAGES
- * entries.  We translate MsgNum values into circular-buffer indexes by
- * computing MsgNum % MAXNUMMESSAGES (this should be fast as long as
- * MAXNUMMESSAGES is a constant and a power of 2).  As long as maxMsgNum
+ * entries, set by the sinval_queue_size parameter.  We translate MsgNum
+ * values into circular-buffer indexes by masking off the high-order bits,
+ * which requires MAXNUMMESSAGES to be a power of 2.  As long as maxMsgNum
  * doesn't exceed minMsgNum by more than MAXNUMMESSAGES, we have enough space
  * in the buffer.  If the buffer does overflow, we recover by setting the
  * "reset" flag for each backend that has fallen too far behind.  A backend
@@ -70,6 +73,16 @@
  * of "stuck" backends, we won't need a lot of extra interrupts, since ones
  * that aren't stuck will propagate their interrupts to the next guy.
  *
+ * That one-at-a-time relay can be too slow when many backends are idle and a
+ * burst of DDL fills the queue: each backend in the chain takes a while to
+ * wake up and catch up, and the ones at the end of the chain get reset.
+ * Since a reset forces a backend to rebuild all of its caches, many resets
+ * at once are expensive.  Therefore, once the queue holds at least
+ * CATCHUP_ALL_THRESHOLD messages, SICleanupQueue signals up to
+ * MAX_CATCHUP_SIGNALS far-behind backends at once.  The number of catchup
+ * interrupts sent and of resets forced is counted, and can be inspected with
+ * pg_stat_get_sinval().
+ *
  * We would have problems if the MsgNum values overflow an integer, so
  * whenever minMsgNum exceeds MSGNUMWRAPAROUND, we subtract MSGNUMWRAPAROUND
  * from all the MsgNum variables simultaneously.  MSGNUMWRAPAROUND can be
@@ -108,10 +121,12 @@
  * Configurable parameters.
  *
  * MAXNUMMESSAGES: max number of shared-inval messages we can buffer.
- * Must be a power of 2 for speed.
+ * Must be a power of 2; the sinval_queue_size check hook ensures that.
  *
  * MSGNUMWRAPAROUND: how often to reduce MsgNum variables to avoid overflow.
- * Must be a multiple of MAXNUMMESSAGES.  Should be large.
+ * Must be a multiple of MAXNUMMESSAGES.  Should be large.  Since
+ * MAXNUMMESSAGES is a power of 2 no larger than SINVAL_QUEUE_SIZE_MAX, a
+ * fixed power of 2 above that works.
  *
  * CLEANUP_MIN: the minimum number of messages that must be in the buffer
  * before we bother to call SICleanupQueue.
@@ -122,19 +137,34 @@
  * SIG_THRESHOLD: the minimum number of messages a backend must have fallen
  * behind before we'll send it PROCSIG_CATCHUP_INTERRUPT.
  *
+ * CATCHUP_ALL_THRESHOLD: the number of messages in the buffer at which
+ * SICleanupQueue starts signaling up to MAX_CATCHUP_SIGNALS far-behind
+ * backends instead of just one.
+ *
+ * MAX_CATCHUP_SIGNALS: the max number of catchup interrupts sent by one
+ * call of SICleanupQueue.
+ *
  * WRITE_QUANTUM: the max number of messages to push into the buffer per
  * iteration of SIInsertDataEntries.  Noncritical but should be less than
  * CLEANUP_QUANTUM, because we only consider calling SICleanupQueue once
  * per iteration.
  */
 
-#define MAXNUMMESSAGES 4096
-#define MSGNUMWRAPAROUND (MAXNUMMESSAGES * 262144)
+#define MAXNUMMESSAGES sinval_queue_size
+#define MSGNUMWRAPAROUND (1 << 30)
 #define CLEANUP_MIN (MAXNUMMESSAGES / 2)
 #define CLEANUP_QUANTUM (MAXNUMMESSAGES / 16)
 #define SIG_THRESHOLD (MAXNUMMESSAGES / 2)
+#define CATCHUP_ALL_THRESHOLD (MAXNUMMESSAGES / 4 * 3)
+#define MAX_CATCHUP_SIGNALS 32
 #define WRITE_QUANTUM 64
 
+/* Circular-buffer index of a MsgNum */
+#define SIBufferIndex(msgnum) ((msgnum) & (MAXNUMMESSAGES - 1))
+
+/* GUC variable */
+int			sinval_queue_size = 4096;
+
 /* Per-backend state in shared invalidation structure */
 typedef struct ProcState
 {
@@ -179,9 +209,18 @@ typedef struct SISeg
 	slock_t		msgnumLock;		/* spinlock protecting maxMsgNum */
 
 	/*
-	 * Circular buffer holding shared-inval messages
+	 * Statistics, protected by SInvalReadLock and SInvalWriteLock: they are
+	 * only updated while holding both exclusively, and may be read while
+	 * holding either.
 	 */
-	SharedInvalidationMessage buffer[MAXNUMMESSAGES];
+	uint64		numCatchupSignals;	/* # of catchup interrupts sent */
+	uint64		numResets;		/* # of backends forced into reset state */
+
+	/*
+	 * Circular buffer holding shared-inval messages (has MAXNUMMESSAGES
+	 * entries).  It follows the procState array in shared memory.
+	 */
+	SharedInvalidationMessage *buffer;
 
 	/*
 	 * Per-backend invalidation state info (has MaxBackends entries).
@@ -207,6 +246,9 @@ SInvalShmemSize(void)
 
 	size = offsetof(SISeg, procState);
 	size = add_size(size, mul_size(sizeof(ProcState), MaxBackends));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(sizeof(SharedInvalidationMessage),
+								   MAXNUMMESSAGES));
 
 	return size;
 }
@@ -221,6 +263,9 @@ CreateSharedInvalidationState(void)
 	int			i;
 	bool		found;
 
+	StaticAssertStmt(MSGNUMWRAPAROUND % SINVAL_QUEUE_SIZE_MAX == 0,
+					 "MSGNUMWRAPAROUND must be a multiple of the largest queue size");
+
 	/* Allocate space in shared memory */
 	shmInvalBuffer = (SISeg *)
 		ShmemInitStruct("shmInvalBuffer", SInvalShmemSize(), &found);
@@ -234,6 +279,12 @@ CreateSharedInvalidationState(void)
 	shmInvalBuffer->lastBackend = 0;
 	shmInvalBuffer->maxBackends = MaxBackends;
 	SpinLockInit(&shmInvalBuffer->msgnumLock);
+	shmInvalBuffer->numCatchupSignals = 0;
+	shmInvalBuffer->numResets = 0;
+	shmInvalBuffer->buffer = (SharedInvalidationMessage *)
+		((char *) shmInvalBuffer +
+		 MAXALIGN(offsetof(SISeg, procState) +
+				  sizeof(ProcState) * MaxBackends));
 
 	/* The buffer[] array is initially all unused, so we need not fill it */
 
@@ -480,7 +531,7 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 		max = segP->maxMsgNum;
 		while (nthistime-- > 0)
 		{
-			segP->buffer[max % MAXNUMMESSAGES] = *data++;
+			segP->buffer[SIBufferIndex(max)] = *data++;
 			max++;
 		}
 
@@ -603,7 +654,7 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
 	n = 0;
 	while (n < datasize && stateP->nextMsgNum < max)
 	{
-		data[n++] = segP->buffer[stateP->nextMsgNum % MAXNUMMESSAGES];
+		data[n++] = segP->buffer[SIBufferIndex(stateP->nextMsgNum)];
 		stateP->nextMsgNum++;
 	}
 
@@ -632,8 +683,9 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
  *
  * Possible side effects of this routine include marking one or more
  * backends as "reset" in the array, and sending PROCSIG_CATCHUP_INTERRUPT
- * to some backend that seems to be getting too far behind.  We signal at
- * most one backend at a time, for reasons explained at the top of the file.
+ * to some backend that seems to be getting too far behind.  We normally
+ * signal at most one backend at a time, and several only when the queue is
+ * nearly full, for reasons explained at the top of the file.
  *
  * Caution: because we transiently release write lock when we have to signal
  * some other backend, it is NOT guaranteed that there are still minFree
@@ -649,6 +701,10 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 				numMsgs,
 				i;
 	ProcState  *needSig = NULL;
+	bool		catchupAll;
+	pid_t		sigPids[MAX_CATCHUP_SIGNALS];
+	BackendId	sigBackendIds[MAX_CATCHUP_SIGNALS];
+	int			nsig = 0;
 
 	/* Lock out all writers and readers */
 	if (!callerHasWriteLock)
@@ -682,6 +738,7 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 		if (n < lowbound)
 		{
 			stateP->resetState = true;
+			segP->numResets++;
 			/* no point in signaling him ... */
 			continue;
 		}
@@ -726,20 +783,60 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 		segP->nextThreshold = (numMsgs / CLEANUP_QUANTUM + 1) * CLEANUP_QUANTUM;
 
 	/*
-	 * Lastly, signal anyone who needs a catchup interrupt.  Since
-	 * SendProcSignal() might not be fast, we don't want to hold locks while
-	 * executing it.
+	 * Decide whether the queue is nearly full by the minimum just computed.
+	 * The one left by the previous call may be older, which would make the
+	 * queue look fuller than it is.
+	 */
+	catchupAll = (numMsgs >= CATCHUP_ALL_THRESHOLD);
+
+	/*
+	 * Collect everyone who needs a catchup interrupt: the furthest-back
+	 * backend, plus, if the queue is nearly full, other unsignaled backends
+	 * that have fallen more than SIG_THRESHOLD behind.
 	 */
 	if (needSig)
 	{
-		pid_t		his_pid = needSig->procPid;
-		BackendId	his_backendId = (needSig - &segP->procState[0]) + 1;
-
 		needSig->signaled = true;
+		sigPids[nsig] = needSig->procPid;
+		sigBackendIds[nsig] = (needSig - &segP->procState[0]) + 1;
+		nsig++;
+	}
+	if (needSig && catchupAll)
+	{
+		int			sigbound = segP->maxMsgNum - SIG_THRESHOLD;
+
+		for (i = 0; i < segP->lastBackend && nsig < MAX_CATCHUP_SIGNALS; i++)
+		{
+			ProcState  *stateP = &segP->procState[i];
+
+			if (stateP->procPid == 0 || stateP->resetState ||
+				stateP->sendOnly || stateP->signaled ||
+				stateP->nextMsgNum >= sigbound)
+				continue;
+
+			stateP->signaled = true;
+			sigPids[nsig] = stateP->procPid;
+			sigBackendIds[nsig] = i + 1;
+			nsig++;
+		}
+	}
+	segP->numCatchupSignals += nsig;
+
+	/*
+	 * Lastly, send the catchup interrupts.  Since SendProcSignal() might not
+	 * be fast, we don't want to hold locks while executing it.
+	 */
+	if (nsig > 0)
+	{
 		LWLockRelease(SInvalReadLock);
 		LWLockRelease(SInvalWriteLock);
-		elog(DEBUG4, "sending sinval catchup signal to PID %d", (int) his_pid);
-		SendProcSignal(his_pid, PROCSIG_CATCHUP_INTERRUPT, his_backendId);
+		for (i = 0; i < nsig; i++)
+		{
+			elog(DEBUG4, "sending sinval catchup signal to PID %d",
+				 (int) sigPids[i]);
+			SendProcSignal(sigPids[i], PROCSIG_CATCHUP_INTERRUPT,
+						   sigBackendIds[i]);
+		}
 		if (callerHasWriteLock)
 			LWLockAcquire(SInvalWriteLock, LW_EXCLUSIVE);
 	}
@@ -752,6 +849,45 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 }
 
 
+/*
+ * pg_stat_get_sinval
+ *		Report the state of the shared invalidation queue
+ *
+ * Returns the size of the queue, the number of messages currently in it
+ * (not yet read by all backends, as of the last cleanup), the number of
+ * catchup interrupts sent and the number of backends forced to reset their
+ * caches since server start.
+ */
+Datum
+pg_stat_get_sinval(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_SINVAL_COLS 4
+	SISeg	   *segP = shmInvalBuffer;
+	TupleDesc	tupdesc;
+	Datum		values[PG_STAT_GET_SINVAL_COLS];
+	bool		nulls[PG_STAT_GET_SINVAL_COLS];
+	int			numMsgs;
+	uint64		numCatchupSignals;
+	uint64		numResets;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	LWLockAcquire(SInvalWriteLock, LW_SHARED);
+	numMsgs = segP->maxMsgNum - segP->minMsgNum;
+	numCatchupSignals = segP->numCatchupSignals;
+	numResets = segP->numResets;
+	LWLockRelease(SInvalWriteLock);
+
+	MemSet(nulls, 0, sizeof(nulls));
+	values[0] = Int32GetDatum(MAXNUMMESSAGES);
+	values[1] = Int32GetDatum(numMsgs);
+	values[2] = Int64GetDatum((int64) numCatchupSignals);
+	values[3] = Int64GetDatum((int64) numResets);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
 /*
  * GetNextLocalTransactionId --- allocate a new LocalTransactionId
  *
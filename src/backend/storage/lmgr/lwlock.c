@@ -451,6 +451,18 @@ InitializeLWLocks(void)
 	for (id = 0; id < NUM_PREDICATELOCK_PARTITIONS; id++, lock++)
 		LWLockInitialize(&lock->lock, LWTRANCHE_PREDICATE_LOCK_MANAGER);
 
+	/* Initialize shared relation size cache LWLocks in main array */
+	lock = MainLWLockArray + NUM_INDIVIDUAL_LWLOCKS +
+		NUM_BUFFER_PARTITIONS + NUM_LOCK_PARTITIONS +
+		NUM_PREDICATELOCK_PARTITIONS;
+	for (id = 0; id < NUM_SMGR_SHARED_RELATION_PARTITIONS; id++, lock++)
+		LWLockInitialize(&lock->lock, LWTRANCHE_SMGR_SHARED_RELATION);
+
+	/* Initialize shared catalog cache LWLocks in main array */
+	lock = MainLWLockArray + SHARED_CATCACHE_LWLOCK_OFFSET;
+	for (id = 0; id < NUM_SHARED_CATCACHE_PARTITIONS; id++, lock++)
+		LWLockInitialize(&lock->lock, LWTRANCHE_SHARED_CATCACHE);
+
 	/* Initialize named tranches. */
 	if (NamedLWLockTrancheRequests > 0)
 	{
@@ -522,6 +534,24 @@ RegisterLWLockTranches(void)
 	LWLockRegisterTranche(LWTRANCHE_PARALLEL_APPEND, "parallel_append");
 	LWLockRegisterTranche(LWTRANCHE_PARALLEL_HASH_JOIN, "parallel_hash_join");
 	LWLockRegisterTranche(LWTRANCHE_SXACT, "serializable_xact");
+	LWLockRegisterTranche(LWTRANCHE_SMGR_SHARED_RELATION,
+						  "smgr_shared_relation");
+	LWLockRegisterTranche(LWTRANCHE_SHARED_CATCACHE, "shared_catcache");
+	LWLockRegisterTranche(LWTRANCHE_SHARED_PLAN_CACHE, "shared_plan_cache");
+
+	/*
+	 * The SLRU bank locks keep the names of the single control locks they
+	 * replaced.
+	 */
+	LWLockRegisterTranche(LWTRANCHE_CLOG_SLRU, "CLogControlLock");
+	LWLockRegisterTranche(LWTRANCHE_COMMITTS_SLRU, "CommitTsControlLock");
+	LWLockRegisterTranche(LWTRANCHE_SUBTRANS_SLRU, "SubtransControlLock");
+	LWLockRegisterTranche(LWTRANCHE_MXACTOFFSET_SLRU,
+						  "MultiXactOffsetControlLock");
+	LWLockRegisterTranche(LWTRANCHE_MXACTMEMBER_SLRU,
+						  "MultiXactMemberControlLock");
+	LWLockRegisterTranche(LWTRANCHE_ASYNC_SLRU, "AsyncCtlLock");
+	LWLockRegisterTranche(LWTRANCHE_OLDSERXID_SLRU, "OldSerXidBankLock");
 
 	/* Register named tranches. */
 	for (i = 0; i < NamedLWLockTrancheRequests; i++)
@@ -88,6 +88,9 @@
  *	SerializableFinishedListLock
  *		- Protects the list of transactions which have completed but which
  *			may yet matter because they overlap still-active transactions.
+ *		- A transaction that no longer matters at all is taken off the
+ *			list under this lock, and can then be released without it:
+ *			nothing else can get at its list of locks any more.
  *
  *	SerializablePredicateLockListLock
  *		- Protects the linked list of locks held by a transaction.  Note
@@ -477,8 +480,12 @@ static void DropAllPredicateLocksFromTable(Relation relation,
 							   bool transfer);
 static void SetNewSxactGlobalXmin(void);
 static void ClearOldPredicateLocks(void);
+static void ReleaseFinishedSerializableXacts(SERIALIZABLEXACT **sxacts, int nsxacts);
 static void ReleaseOneSerializableXact(SERIALIZABLEXACT *sxact, bool partial,
 						   bool summarize);
+static void ReleaseSerializableXactLocks(SERIALIZABLEXACT *sxact, bool summarize);
+static void ReleaseSerializableXactConflicts(SERIALIZABLEXACT *sxact, bool partial,
+								 bool summarize);
 static bool XidIsConcurrent(TransactionId xid);
 static void CheckTargetForConflictsIn(PREDICATELOCKTARGETTAG *targettag);
 static void FlagRWConflict(SERIALIZABLEXACT *reader, SERIALIZABLEXACT *writer);
@@ -823,8 +830,8 @@ OldSerXidInit(void)
 	 */
 	OldSerXidSlruCtl->PagePrecedes = OldSerXidPagePrecedesLogically;
 	SimpleLruInit(OldSerXidSlruCtl, "oldserxid",
-				  NUM_OLDSERXID_BUFFERS, 0, OldSerXidLock, "pg_serial",
-				  LWTRANCHE_OLDSERXID_BUFFERS);
+				  serializable_buffers, 0, "pg_serial",
+				  LWTRANCHE_OLDSERXID_BUFFERS, LWTRANCHE_OLDSERXID_SLRU);
 	/* Override default assumption that writes should be fsync'd */
 	OldSerXidSlruCtl->do_fsync = false;
 
@@ -859,11 +866,17 @@ OldSerXidAdd(TransactionId xid, SerCommitSeqNo minConflictCommitSeqNo)
 	int			slotno;
 	int			firstZeroPage;
 	bool		isNewPage;
+	LWLock	   *lock;
 
 	Assert(TransactionIdIsValid(xid));
 
 	targetPage = OldSerXidPage(xid);
+	lock = SimpleLruGetBankLock(OldSerXidSlruCtl, targetPage);
 
+	/*
+	 * OldSerXidLock protects the control data; the SLRU buffers themselves
+	 * are protected by their bank locks, which are acquired after it.
+	 */
 	LWLockAcquire(OldSerXidLock, LW_EXCLUSIVE);
 
 	/*
@@ -903,17 +916,27 @@ OldSerXidAdd(TransactionId xid, SerCommitSeqNo minConflictCommitSeqNo)
 		/* Initialize intervening pages. */
 		while (firstZeroPage != targetPage)
 		{
+			LWLock	   *zerolock = SimpleLruGetBankLock(OldSerXidSlruCtl,
+														firstZeroPage);
+
+			LWLockAcquire(zerolock, LW_EXCLUSIVE);
 			(void) SimpleLruZeroPage(OldSerXidSlruCtl, firstZeroPage);
+			LWLockRelease(zerolock);
 			firstZeroPage = OldSerXidNextPage(firstZeroPage);
 		}
+		LWLockAcquire(lock, LW_EXCLUSIVE);
 		slotno = SimpleLruZeroPage(OldSerXidSlruCtl, targetPage);
 	}
 	else
+	{
+		LWLockAcquire(lock, LW_EXCLUSIVE);
 		slotno = SimpleLruReadPage(OldSerXidSlruCtl, targetPage, true, xid);
+	}
 
 	OldSerXidValue(slotno, xid) = minConflictCommitSeqNo;
 	OldSerXidSlruCtl->shared->page_dirty[slotno] = true;
 
+	LWLockRelease(lock);
 	LWLockRelease(OldSerXidLock);
 }
 
@@ -947,13 +970,13 @@ OldSerXidGetMinConflictCommitSeqNo(TransactionId xid)
 		return 0;
 
 	/*
-	 * The following function must be called without holding OldSerXidLock,
-	 * but will return with that lock held, which must then be released.
+	 * The following function must be called without holding the page's bank
+	 * lock, but will return with that lock held, which must then be released.
 	 */
 	slotno = SimpleLruReadPage_ReadOnly(OldSerXidSlruCtl,
 										OldSerXidPage(xid), xid);
 	val = OldSerXidValue(slotno, xid);
-	LWLockRelease(OldSerXidLock);
+	LWLockRelease(SimpleLruGetBankLock(OldSerXidSlruCtl, OldSerXidPage(xid)));
 	return val;
 }
 
@@ -1328,7 +1351,7 @@ PredicateLockShmemSize(void)
 
 	/* Shared memory structures for SLRU tracking of old committed xids. */
 	size = add_size(size, sizeof(OldSerXidControlData));
-	size = add_size(size, SimpleLruShmemSize(NUM_OLDSERXID_BUFFERS, 0));
+	size = add_size(size, SimpleLruShmemSize(serializable_buffers, 0));
 
 	return size;
 }
@@ -3465,6 +3488,8 @@ ReleasePredicateLocks(bool isCommit, bool isReadOnlySafe)
 			 * structure would already have caused a rollback, so any
 			 * remaining ones must be benign.
 			 */
+			Assert(PredXact->LastSxactCommitSeqNo >=
+				   PredXact->CanPartialClearThrough);
 			PredXact->CanPartialClearThrough = PredXact->LastSxactCommitSeqNo;
 		}
 	}
@@ -3688,83 +3713,126 @@ ReleasePredicateLocksLocal(void)
 	}
 }
 
+/*
+ * How many finished transactions ClearOldPredicateLocks takes off the
+ * finished list before it releases them.
+ */
+#define FINISHED_SXACT_BATCH_SIZE	64
+
 /*
  * Clear old predicate locks, belonging to committed transactions that are no
  * longer interesting to any in-progress transaction.
+ *
+ * Transactions that are no longer interesting at all are only taken off the
+ * finished list while we hold SerializableFinishedListLock, and released in
+ * batches after we have let go of it, so that backends finishing their own
+ * transactions don't queue up behind the release of all those locks.
  */
 static void
 ClearOldPredicateLocks(void)
 {
 	SERIALIZABLEXACT *finishedSxact;
+	SERIALIZABLEXACT *releasable[FINISHED_SXACT_BATCH_SIZE];
+	int			nreleasable;
 	PREDICATELOCK *predlock;
+	SerCommitSeqNo canPartialClearThrough;
 
 	/*
 	 * Loop through finished transactions. They are in commit order, so we can
-	 * stop as soon as we find one that's still interesting.
+	 * stop as soon as we find one that's still interesting.  If there are
+	 * more than fit in one batch, release that and start over.
 	 */
-	LWLockAcquire(SerializableFinishedListLock, LW_EXCLUSIVE);
-	finishedSxact = (SERIALIZABLEXACT *)
-		SHMQueueNext(FinishedSerializableTransactions,
-					 FinishedSerializableTransactions,
-					 offsetof(SERIALIZABLEXACT, finishedLink));
-	LWLockAcquire(SerializableXactHashLock, LW_SHARED);
-	while (finishedSxact)
+	for (;;)
 	{
-		SERIALIZABLEXACT *nextSxact;
+		nreleasable = 0;
 
-		nextSxact = (SERIALIZABLEXACT *)
+		LWLockAcquire(SerializableFinishedListLock, LW_EXCLUSIVE);
+		finishedSxact = (SERIALIZABLEXACT *)
 			SHMQueueNext(FinishedSerializableTransactions,
-						 &(finishedSxact->finishedLink),
+						 FinishedSerializableTransactions,
 						 offsetof(SERIALIZABLEXACT, finishedLink));
-		if (!TransactionIdIsValid(PredXact->SxactGlobalXmin)
-			|| TransactionIdPrecedesOrEquals(finishedSxact->finishedBefore,
-											 PredXact->SxactGlobalXmin))
-		{
-			/*
-			 * This transaction committed before any in-progress transaction
-			 * took its snapshot. It's no longer interesting.
-			 */
-			LWLockRelease(SerializableXactHashLock);
-			SHMQueueDelete(&(finishedSxact->finishedLink));
-			ReleaseOneSerializableXact(finishedSxact, false, false);
-			LWLockAcquire(SerializableXactHashLock, LW_SHARED);
-		}
-		else if (finishedSxact->commitSeqNo > PredXact->HavePartialClearedThrough
-				 && finishedSxact->commitSeqNo <= PredXact->CanPartialClearThrough)
+		LWLockAcquire(SerializableXactHashLock, LW_SHARED);
+		while (finishedSxact && nreleasable < FINISHED_SXACT_BATCH_SIZE)
 		{
-			/*
-			 * Any active transactions that took their snapshot before this
-			 * transaction committed are read-only, so we can clear part of
-			 * its state.
-			 */
-			LWLockRelease(SerializableXactHashLock);
+			SERIALIZABLEXACT *nextSxact;
 
-			if (SxactIsReadOnly(finishedSxact))
+			nextSxact = (SERIALIZABLEXACT *)
+				SHMQueueNext(FinishedSerializableTransactions,
+							 &(finishedSxact->finishedLink),
+							 offsetof(SERIALIZABLEXACT, finishedLink));
+			if (!TransactionIdIsValid(PredXact->SxactGlobalXmin)
+				|| TransactionIdPrecedesOrEquals(finishedSxact->finishedBefore,
+												 PredXact->SxactGlobalXmin))
 			{
-				/* A read-only transaction can be removed entirely */
+				/*
+				 * This transaction committed before any in-progress
+				 * transaction took its snapshot. It's no longer interesting.
+				 */
 				SHMQueueDelete(&(finishedSxact->finishedLink));
-				ReleaseOneSerializableXact(finishedSxact, false, false);
+				releasable[nreleasable++] = finishedSxact;
 			}
-			else
+			else if (finishedSxact->commitSeqNo > PredXact->HavePartialClearedThrough
+					 && finishedSxact->commitSeqNo <= PredXact->CanPartialClearThrough)
 			{
 				/*
-				 * A read-write transaction can only be partially cleared. We
-				 * need to keep the SERIALIZABLEXACT but can release the
-				 * SIREAD locks and conflicts in.
+				 * Any active transactions that took their snapshot before
+				 * this transaction committed are read-only, so we can clear
+				 * part of its state.
 				 */
-				ReleaseOneSerializableXact(finishedSxact, true, false);
-			}
+				if (SxactIsReadOnly(finishedSxact))
+				{
+					/* A read-only transaction can be removed entirely */
+					SHMQueueDelete(&(finishedSxact->finishedLink));
+					releasable[nreleasable++] = finishedSxact;
+				}
+				else
+				{
+					/*
+					 * A read-write transaction can only be partially cleared.
+					 * We need to keep the SERIALIZABLEXACT but can release
+					 * the SIREAD locks and conflicts in.  It stays on the
+					 * list, so this has to be done while we hold
+					 * SerializableFinishedListLock.
+					 */
+					LWLockRelease(SerializableXactHashLock);
+					ReleaseOneSerializableXact(finishedSxact, true, false);
+					LWLockAcquire(SerializableXactHashLock, LW_SHARED);
+				}
 
-			PredXact->HavePartialClearedThrough = finishedSxact->commitSeqNo;
-			LWLockAcquire(SerializableXactHashLock, LW_SHARED);
+				PredXact->HavePartialClearedThrough = finishedSxact->commitSeqNo;
+			}
+			else
+			{
+				/* Still interesting. */
+				break;
+			}
+			finishedSxact = nextSxact;
 		}
-		else
-		{
-			/* Still interesting. */
+
+		if (nreleasable < FINISHED_SXACT_BATCH_SIZE)
 			break;
-		}
-		finishedSxact = nextSxact;
+
+		LWLockRelease(SerializableXactHashLock);
+		LWLockRelease(SerializableFinishedListLock);
+		ReleaseFinishedSerializableXacts(releasable, nreleasable);
 	}
+
+	/*
+	 * Look at CanPartialClearThrough once, instead of once per summarized
+	 * lock, so as not to hammer SerializableXactHashLock when many locks have
+	 * been summarized.  That is safe because:
+	 *
+	 * - CanPartialClearThrough only moves forward, so a lock that is old
+	 * enough by the value seen now stays that way.  A newer value only means
+	 * that some locks are left for the next call to clear.
+	 *
+	 * - Locks are only added to OldCommittedSxact, or have their commitSeqNo
+	 * raised, by SummarizeOldestCommittedSxact, which holds
+	 * SerializableFinishedListLock like we do; or by transfers to a new
+	 * target, which hold SerializablePredicateLockListLock exclusively.  So
+	 * none can come in or change while we look at them.
+	 */
+	canPartialClearThrough = PredXact->CanPartialClearThrough;
 	LWLockRelease(SerializableXactHashLock);
 
 	/*
@@ -3778,24 +3846,20 @@ ClearOldPredicateLocks(void)
 	while (predlock)
 	{
 		PREDICATELOCK *nextpredlock;
-		bool		canDoPartialCleanup;
 
 		nextpredlock = (PREDICATELOCK *)
 			SHMQueueNext(&OldCommittedSxact->predicateLocks,
 						 &predlock->xactLink,
 						 offsetof(PREDICATELOCK, xactLink));
 
-		LWLockAcquire(SerializableXactHashLock, LW_SHARED);
 		Assert(predlock->commitSeqNo != 0);
 		Assert(predlock->commitSeqNo != InvalidSerCommitSeqNo);
-		canDoPartialCleanup = (predlock->commitSeqNo <= PredXact->CanPartialClearThrough);
-		LWLockRelease(SerializableXactHashLock);
 
 		/*
 		 * If this lock originally belonged to an old enough transaction, we
 		 * can release it.
 		 */
-		if (canDoPartialCleanup)
+		if (predlock->commitSeqNo <= canPartialClearThrough)
 		{
 			PREDICATELOCKTAG tag;
 			PREDICATELOCKTARGET *target;
@@ -3828,6 +3892,41 @@ ClearOldPredicateLocks(void)
 
 	LWLockRelease(SerializablePredicateLockListLock);
 	LWLockRelease(SerializableFinishedListLock);
+
+	ReleaseFinishedSerializableXacts(releasable, nreleasable);
+}
+
+/*
+ * Release finished transactions that ClearOldPredicateLocks has taken off the
+ * finished list.
+ *
+ * Off the list, a transaction can no longer be summarized or partially
+ * released by anyone else, so SerializableFinishedListLock isn't needed
+ * here.  Its locks can only be moved by transfers to a new target, which
+ * hold SerializablePredicateLockListLock exclusively.  We take that, and
+ * SerializableXactHashLock for the conflicts, once for the whole batch
+ * rather than once per transaction.
+ */
+static void
+ReleaseFinishedSerializableXacts(SERIALIZABLEXACT **sxacts, int nsxacts)
+{
+	int			i;
+
+	if (nsxacts == 0)
+		return;
+
+	LWLockAcquire(SerializablePredicateLockListLock, LW_SHARED);
+	for (i = 0; i < nsxacts; i++)
+	{
+		Assert(!SxactIsOnFinishedList(sxacts[i]));
+		ReleaseSerializableXactLocks(sxacts[i], false);
+	}
+	LWLockRelease(SerializablePredicateLockListLock);
+
+	LWLockAcquire(SerializableXactHashLock, LW_EXCLUSIVE);
+	for (i = 0; i < nsxacts; i++)
+		ReleaseSerializableXactConflicts(sxacts[i], false, false);
+	LWLockRelease(SerializableXactHashLock);
 }
 
 /*
@@ -3853,11 +3952,6 @@ static void
 ReleaseOneSerializableXact(SERIALIZABLEXACT *sxact, bool partial,
 						   bool summarize)
 {
-	PREDICATELOCK *predlock;
-	SERIALIZABLEXIDTAG sxidtag;
-	RWConflict	conflict,
-				nextConflict;
-
 	Assert(sxact != NULL);
 	Assert(SxactIsRolledBack(sxact) || SxactIsCommitted(sxact));
 	Assert(partial || !SxactIsOnFinishedList(sxact));
@@ -3868,6 +3962,26 @@ ReleaseOneSerializableXact(SERIALIZABLEXACT *sxact, bool partial,
 	 * them to OldCommittedSxact if summarize is true)
 	 */
 	LWLockAcquire(SerializablePredicateLockListLock, LW_SHARED);
+	ReleaseSerializableXactLocks(sxact, summarize);
+	LWLockRelease(SerializablePredicateLockListLock);
+
+	LWLockAcquire(SerializableXactHashLock, LW_EXCLUSIVE);
+	ReleaseSerializableXactConflicts(sxact, partial, summarize);
+	LWLockRelease(SerializableXactHashLock);
+}
+
+/*
+ * Release the predicate locks held by a finished transaction, or transfer
+ * them to OldCommittedSxact if summarize is true.  The caller holds
+ * SerializablePredicateLockListLock.
+ */
+static void
+ReleaseSerializableXactLocks(SERIALIZABLEXACT *sxact, bool summarize)
+{
+	PREDICATELOCK *predlock;
+
+	Assert(LWLockHeldByMe(SerializablePredicateLockListLock));
+
 	if (IsInParallelMode())
 		LWLockAcquire(&sxact->predicateLockListLock, LW_EXCLUSIVE);
 	predlock = (PREDICATELOCK *)
@@ -3951,10 +4065,24 @@ ReleaseOneSerializableXact(SERIALIZABLEXACT *sxact, bool partial,
 
 	if (IsInParallelMode())
 		LWLockRelease(&sxact->predicateLockListLock);
-	LWLockRelease(SerializablePredicateLockListLock);
+}
+
+/*
+ * Release a finished transaction's conflicts, and unless partial is true,
+ * its xid and the transaction itself.  The caller holds
+ * SerializableXactHashLock exclusively.
+ */
+static void
+ReleaseSerializableXactConflicts(SERIALIZABLEXACT *sxact, bool partial,
+								 bool summarize)
+{
+	SERIALIZABLEXIDTAG sxidtag;
+	RWConflict	conflict,
+				nextConflict;
+
+	Assert(LWLockHeldByMeInMode(SerializableXactHashLock, LW_EXCLUSIVE));
 
 	sxidtag.xid = sxact->topXid;
-	LWLockAcquire(SerializableXactHashLock, LW_EXCLUSIVE);
 
 	/* Release all outConflicts (unless 'partial' is true) */
 	if (!partial)
@@ -4001,7 +4129,6 @@ ReleaseOneSerializableXact(SERIALIZABLEXACT *sxact, bool partial,
 		ReleasePredXact(sxact);
 	}
 
-	LWLockRelease(SerializableXactHashLock);
 }
 
 /*
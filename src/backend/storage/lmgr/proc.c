@@ -90,10 +90,14 @@ static DeadLockState deadlock_state = DS_NOT_YET_CHECKED;
 /* Is a deadlock check pending? */
 static volatile sig_atomic_t got_deadlock_timeout;
 
+/* Is this an idle pre-forked backend, counted in ProcGlobal->preforkedProcs? */
+static bool preforkedIdle = false;
+
 static void RemoveProcFromArray(int code, Datum arg);
 static void ProcKill(int code, Datum arg);
 static void AuxiliaryProcKill(int code, Datum arg);
 static void CheckDeadLock(void);
+static Size FastPathLockShmemSizePerProc(void);
 
 
 /*
@@ -119,9 +123,28 @@ ProcGlobalShmemSize(void)
 	size = add_size(size, mul_size(NUM_AUXILIARY_PROCS, sizeof(PGXACT)));
 	size = add_size(size, mul_size(max_prepared_xacts, sizeof(PGXACT)));
 
+	/* Fast-path lock arrays */
+	size = add_size(size, mul_size(add_size(add_size(MaxBackends,
+													 NUM_AUXILIARY_PROCS),
+											max_prepared_xacts),
+								   FastPathLockShmemSizePerProc()));
+
 	return size;
 }
 
+/*
+ * Size of the fast-path lock arrays of one PGPROC.  The number of slots is
+ * set by max_fast_path_locks, so they live outside the PGPROC struct.
+ */
+static Size
+FastPathLockShmemSizePerProc(void)
+{
+	return add_size(MAXALIGN(mul_size(FastPathLockGroupsPerBackend,
+									  sizeof(uint64))),
+					MAXALIGN(mul_size(FastPathLockSlotsPerBackend(),
+									  sizeof(Oid))));
+}
+
 /*
  * Report number of semaphores needed by InitProcGlobal.
  */
@@ -165,6 +188,8 @@ InitProcGlobal(void)
 {
 	PGPROC	   *procs;
 	PGXACT	   *pgxacts;
+	char	   *fpPtr;
+	Size		fpSize;
 	int			i,
 				j;
 	bool		found;
@@ -183,6 +208,7 @@ InitProcGlobal(void)
 	ProcGlobal->autovacFreeProcs = NULL;
 	ProcGlobal->bgworkerFreeProcs = NULL;
 	ProcGlobal->walsenderFreeProcs = NULL;
+	ProcGlobal->preforkedProcs = 0;
 	ProcGlobal->startupProc = NULL;
 	ProcGlobal->startupProcPid = 0;
 	ProcGlobal->startupBufferPinWaitBufId = -1;
@@ -200,6 +226,14 @@ InitProcGlobal(void)
 	 * between groups.
 	 */
 	procs = (PGPROC *) ShmemAlloc(TotalProcs * sizeof(PGPROC));
+
+	/*
+	 * On NUMA machines, spread the PGPROCs across nodes before touching
+	 * them, so that no single node has to serve all the lock and latch
+	 * traffic.  The PGXACT array below is deliberately left alone, since
+	 * snapshots scan all of it and it's best kept compact.
+	 */
+	ShmemNumaInterleave(procs, TotalProcs * sizeof(PGPROC));
 	MemSet(procs, 0, TotalProcs * sizeof(PGPROC));
 	ProcGlobal->allProcs = procs;
 	/* XXX allProcCount isn't really all of them; it excludes prepared xacts */
@@ -217,10 +251,25 @@ InitProcGlobal(void)
 	MemSet(pgxacts, 0, TotalProcs * sizeof(PGXACT));
 	ProcGlobal->allPgXact = pgxacts;
 
+	/*
+	 * Allocate the fast-path lock arrays as well, since their size depends
+	 * on max_fast_path_locks.
+	 */
+	fpSize = FastPathLockShmemSizePerProc();
+	fpPtr = (char *) ShmemAlloc(TotalProcs * fpSize);
+	MemSet(fpPtr, 0, TotalProcs * fpSize);
+
 	for (i = 0; i < TotalProcs; i++)
 	{
 		/* Common initialization for all PGPROCs, regardless of type. */
 
+		/* Point the PGPROC at its fast-path lock arrays. */
+		procs[i].fpLockBits = (uint64 *) fpPtr;
+		procs[i].fpRelId = (Oid *) (fpPtr +
+									MAXALIGN(FastPathLockGroupsPerBackend *
+											 sizeof(uint64)));
+		fpPtr += fpSize;
+
 		/*
 		 * Set up per-PGPROC semaphore, latch, and backendLock. Prepared xact
 		 * dummy PGPROCs don't need these though - they're never associated
@@ -666,6 +715,10 @@ GetStartupBufferPinWaitBufId(void)
 /*
  * Check whether there are at least N free PGPROC objects.
  *
+ * The PGPROCs held by idle pre-forked backends count as free: those are
+ * waiting to serve the next connections, so they are no more taken than the
+ * ones on the freelist.
+ *
  * Note: this is designed on the assumption that N will generally be small.
  */
 bool
@@ -675,6 +728,7 @@ HaveNFreeProcs(int n)
 
 	SpinLockAcquire(ProcStructLock);
 
+	n -= ProcGlobal->preforkedProcs;
 	proc = ProcGlobal->freeProcs;
 
 	while (n > 0 && proc != NULL)
@@ -688,6 +742,68 @@ HaveNFreeProcs(int n)
 	return (n <= 0);
 }
 
+/*
+ * ProcSetPreforkedIdle -- mark a pre-forked backend as waiting for a
+ * connection, or as having got one
+ *
+ * While it waits, a pre-forked backend holds a regular backend's PGPROC that
+ * no connection is using yet; see HaveNFreeProcs.
+ */
+void
+ProcSetPreforkedIdle(bool idle)
+{
+	Assert(MyProc != NULL && MyProc->procgloballist == &ProcGlobal->freeProcs);
+
+	if (idle == preforkedIdle)
+		return;
+
+	SpinLockAcquire(ProcStructLock);
+	ProcGlobal->preforkedProcs += idle ? 1 : -1;
+	SpinLockRelease(ProcStructLock);
+
+	preforkedIdle = idle;
+}
+
+/*
+ * ProcBecomeWalSender -- move a pre-forked backend's PGPROC accounting over
+ * to the walsenders
+ *
+ * A pre-forked backend takes a regular backend's PGPROC before the startup
+ * packet tells it whether the connection is a replication connection.  If
+ * it is, trade places with a free walsender PGPROC: that one goes on the
+ * regular freelist, and ours goes back to the walsenders' when we exit.  The
+ * walsender then counts against max_wal_senders rather than max_connections,
+ * just as if InitProcess had given it the walsender PGPROC to begin with.
+ */
+void
+ProcBecomeWalSender(void)
+{
+	PGPROC	   *proc;
+
+	Assert(am_walsender && !preforkedIdle);
+	Assert(MyProc != NULL && MyProc->procgloballist == &ProcGlobal->freeProcs);
+
+	SpinLockAcquire(ProcStructLock);
+
+	proc = ProcGlobal->walsenderFreeProcs;
+	if (proc == NULL)
+	{
+		SpinLockRelease(ProcStructLock);
+		ereport(FATAL,
+				(errcode(ERRCODE_TOO_MANY_CONNECTIONS),
+				 errmsg("number of requested standby connections exceeds max_wal_senders (currently %d)",
+						max_wal_senders)));
+	}
+
+	ProcGlobal->walsenderFreeProcs = (PGPROC *) proc->links.next;
+	proc->links.next = (SHM_QUEUE *) ProcGlobal->freeProcs;
+	ProcGlobal->freeProcs = proc;
+	proc->procgloballist = &ProcGlobal->freeProcs;
+	MyProc->procgloballist = &ProcGlobal->walsenderFreeProcs;
+
+	SpinLockRelease(ProcStructLock);
+}
+
 /*
  * Check if the current process is awaiting a lock.
  */
@@ -897,6 +1013,13 @@ ProcKill(int code, Datum arg)
 	procgloballist = proc->procgloballist;
 	SpinLockAcquire(ProcStructLock);
 
+	/* An idle pre-forked backend's PGPROC no longer waits for a connection */
+	if (preforkedIdle)
+	{
+		ProcGlobal->preforkedProcs--;
+		preforkedIdle = false;
+	}
+
 	/*
 	 * If we're still a member of a locking group, that means we're a leader
 	 * which has somehow exited before its children.  The last remaining child
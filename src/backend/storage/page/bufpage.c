@@ -1179,9 +1179,13 @@ PageSetChecksumCopy(Page page, BlockNumber blkno)
 	 * call.  The point of palloc'ing here, rather than having a static char
 	 * array, is first to ensure adequate alignment for the checksumming code
 	 * and second to avoid wasting space in processes that never call this.
+	 * We align it for direct I/O, too.
 	 */
 	if (pageCopy == NULL)
-		pageCopy = MemoryContextAlloc(TopMemoryContext, BLCKSZ);
+		pageCopy = (char *)
+			TYPEALIGN(PG_IO_ALIGN_SIZE,
+					  MemoryContextAlloc(TopMemoryContext,
+										 BLCKSZ + PG_IO_ALIGN_SIZE));
 
 	memcpy(pageCopy, (char *) page, BLCKSZ);
 	((PageHeader) pageCopy)->pd_checksum = pg_checksum_page(pageCopy, blkno);
@@ -26,9 +26,11 @@
 #include <sys/file.h>
 
 #include "miscadmin.h"
+#include "access/xlogdefs.h"
 #include "access/xlogutils.h"
 #include "access/xlog.h"
 #include "pgstat.h"
+#include "port/pg_iovec.h"
 #include "portability/instr_time.h"
 #include "postmaster/bgwriter.h"
 #include "storage/fd.h"
@@ -114,6 +116,21 @@ typedef struct _MdfdVec
 
 static MemoryContext MdCxt;		/* context for all MdfdVec objects */
 
+/*
+ * GUC variable: open relation data files with O_DIRECT, bypassing the
+ * kernel's page cache.  Buffers handed to the I/O routines below must then
+ * be aligned to PG_IO_ALIGN_SIZE; shared and local buffers always are, and
+ * anything else is copied through an aligned bounce buffer.
+ */
+bool		io_direct = false;
+
+/* Extra open() flags for relation segment files */
+#define MD_OPEN_FLAGS	(io_direct ? PG_O_DIRECT : 0)
+
+/* Is this buffer suitably aligned for direct I/O? */
+#define MD_BUFFER_IS_ALIGNED(buffer) \
+	((uintptr_t) (buffer) % PG_IO_ALIGN_SIZE == 0)
+
 
 /*
  * In some contexts (currently, standalone backends and the checkpointer)
@@ -195,8 +212,14 @@ static MdfdVec *_mdfd_openseg(SMgrRelation reln, ForkNumber forkno,
 			  BlockNumber segno, int oflags);
 static MdfdVec *_mdfd_getseg(SMgrRelation reln, ForkNumber forkno,
 			 BlockNumber blkno, bool skipFsync, int behavior);
+static int	buffers_to_iovec(struct iovec *iov, char **buffers,
+				 int nblocks);
+static int	compute_remaining_iovec(struct iovec *iov, int iovcnt,
+						size_t transferred);
 static BlockNumber _mdnblocks(SMgrRelation reln, ForkNumber forknum,
 		   MdfdVec *seg);
+static char *md_bounce_buffer(void);
+static bool md_buffers_need_bounce(char **buffers, int nblocks);
 
 
 /*
@@ -304,14 +327,15 @@ mdcreate(SMgrRelation reln, ForkNumber forkNum, bool isRedo)
 
 	path = relpath(reln->smgr_rnode, forkNum);
 
-	fd = PathNameOpenFile(path, O_RDWR | O_CREAT | O_EXCL | PG_BINARY);
+	fd = PathNameOpenFile(path,
+						  O_RDWR | O_CREAT | O_EXCL | PG_BINARY | MD_OPEN_FLAGS);
 
 	if (fd < 0)
 	{
 		int			save_errno = errno;
 
 		if (isRedo)
-			fd = PathNameOpenFile(path, O_RDWR | PG_BINARY);
+			fd = PathNameOpenFile(path, O_RDWR | PG_BINARY | MD_OPEN_FLAGS);
 		if (fd < 0)
 		{
 			/* be sure to report the error reported by create, not open */
@@ -516,6 +540,9 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 
 	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
 
+	if (io_direct && !MD_BUFFER_IS_ALIGNED(buffer))
+		buffer = memcpy(md_bounce_buffer(), buffer, BLCKSZ);
+
 	if ((nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_EXTEND)) != BLCKSZ)
 	{
 		if (nbytes < 0)
@@ -539,6 +566,89 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) RELSEG_SIZE));
 }
 
+/*
+ *	mdzeroextend() -- Add new zeroed out blocks to the specified relation.
+ *
+ *		Similar to mdextend(), except the relation can be extended by
+ *		multiple blocks at once and the added blocks will be filled with
+ *		zeroes.
+ */
+void
+mdzeroextend(SMgrRelation reln, ForkNumber forknum,
+			 BlockNumber blocknum, int nblocks, bool skipFsync)
+{
+	MdfdVec    *v;
+	BlockNumber curblocknum = blocknum;
+	int			remblocks = nblocks;
+
+	Assert(nblocks > 0);
+
+	/* This assert is too expensive to have on normally ... */
+#ifdef CHECK_WRITE_VS_EXTEND
+	Assert(blocknum >= mdnblocks(reln, forknum));
+#endif
+
+	/*
+	 * If a relation manages to grow to 2^32-1 blocks, refuse to extend it any
+	 * more --- we mustn't create a block whose number actually is
+	 * InvalidBlockNumber or larger.
+	 */
+	if ((uint64) blocknum + nblocks >= (uint64) InvalidBlockNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("cannot extend file \"%s\" beyond %u blocks",
+						relpath(reln->smgr_rnode, forknum),
+						InvalidBlockNumber)));
+
+	while (remblocks > 0)
+	{
+		BlockNumber segstartblock = curblocknum % ((BlockNumber) RELSEG_SIZE);
+		off_t		seekpos = (off_t) BLCKSZ * segstartblock;
+		int			numblocks;
+		int			ret;
+
+		/* Don't cross a segment boundary in one go */
+		if (segstartblock + remblocks > RELSEG_SIZE)
+			numblocks = RELSEG_SIZE - segstartblock;
+		else
+			numblocks = remblocks;
+
+		v = _mdfd_getseg(reln, forknum, curblocknum, skipFsync, EXTENSION_CREATE);
+
+		Assert(segstartblock < RELSEG_SIZE);
+		Assert(segstartblock + numblocks <= RELSEG_SIZE);
+
+		/*
+		 * For more than a few blocks, let the kernel allocate the space with
+		 * posix_fallocate(), which commonly avoids dirtying page cache for
+		 * the new blocks.  For small extensions just write zeroes, since
+		 * fallocate defeats delayed allocation on some file systems.
+		 */
+		if (numblocks > 8)
+			ret = FileFallocate(v->mdfd_vfd,
+								seekpos, (off_t) BLCKSZ * numblocks,
+								WAIT_EVENT_DATA_FILE_EXTEND);
+		else
+			ret = FileZero(v->mdfd_vfd,
+						   seekpos, (off_t) BLCKSZ * numblocks,
+						   WAIT_EVENT_DATA_FILE_EXTEND);
+		if (ret != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not extend file \"%s\": %m",
+							FilePathName(v->mdfd_vfd)),
+					 errhint("Check free disk space.")));
+
+		if (!skipFsync && !SmgrIsTemp(reln))
+			register_dirty_segment(reln, forknum, v);
+
+		Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) RELSEG_SIZE));
+
+		remblocks -= numblocks;
+		curblocknum += numblocks;
+	}
+}
+
 /*
  *	mdopen() -- Open the specified relation.
  *
@@ -562,7 +672,7 @@ mdopen(SMgrRelation reln, ForkNumber forknum, int behavior)
 
 	path = relpath(reln->smgr_rnode, forknum);
 
-	fd = PathNameOpenFile(path, O_RDWR | PG_BINARY);
+	fd = PathNameOpenFile(path, O_RDWR | PG_BINARY | MD_OPEN_FLAGS);
 
 	if (fd < 0)
 	{
@@ -630,6 +740,13 @@ mdprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
 	off_t		seekpos;
 	MdfdVec    *v;
 
+	/*
+	 * With direct I/O, prefetching into the kernel's page cache would only
+	 * cost an extra read, since our reads bypass it.
+	 */
+	if (io_direct)
+		return;
+
 	v = _mdfd_getseg(reln, forknum, blocknum, false, EXTENSION_FAIL);
 
 	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
@@ -650,6 +767,10 @@ void
 mdwriteback(SMgrRelation reln, ForkNumber forknum,
 			BlockNumber blocknum, BlockNumber nblocks)
 {
+	/* With direct I/O, there's nothing in the kernel's cache to write back */
+	if (io_direct)
+		return;
+
 	/*
 	 * Issue flush requests in as few requests as possible; have to split at
 	 * segment boundaries though, since those are actually separate files.
@@ -716,7 +837,16 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 
 	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
 
-	nbytes = FileRead(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_READ);
+	if (io_direct && !MD_BUFFER_IS_ALIGNED(buffer))
+	{
+		char	   *bounce = md_bounce_buffer();
+
+		nbytes = FileRead(v->mdfd_vfd, bounce, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_READ);
+		if (nbytes > 0)
+			memcpy(buffer, bounce, nbytes);
+	}
+	else
+		nbytes = FileRead(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_READ);
 
 	TRACE_POSTGRESQL_SMGR_MD_READ_DONE(forknum, blocknum,
 									   reln->smgr_rnode.node.spcNode,
@@ -786,6 +916,9 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 
 	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
 
+	if (io_direct && !MD_BUFFER_IS_ALIGNED(buffer))
+		buffer = memcpy(md_bounce_buffer(), buffer, BLCKSZ);
+
 	nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_WRITE);
 
 	TRACE_POSTGRESQL_SMGR_MD_WRITE_DONE(forknum, blocknum,
@@ -817,6 +950,247 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 		register_dirty_segment(reln, forknum, v);
 }
 
+/*
+ *	mdreadv() -- Read the specified range of blocks from a relation.
+ *
+ *		The blocks are read with as few system calls as possible: one per
+ *		segment file touched, unless there are more than PG_IOV_MAX of them
+ *		or the kernel returns a short read.  As in mdread(), reading past EOF
+ *		is an error unless zero_damaged_pages is on or we are InRecovery, in
+ *		which case the missing blocks are returned as zeroes.
+ */
+void
+mdreadv(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		char **buffers, BlockNumber nblocks)
+{
+	/* With direct I/O, go one block at a time if some need bouncing */
+	if (md_buffers_need_bounce(buffers, nblocks))
+	{
+		BlockNumber i;
+
+		for (i = 0; i < nblocks; i++)
+			mdread(reln, forknum, blocknum + i, buffers[i]);
+		return;
+	}
+
+	while (nblocks > 0)
+	{
+		struct iovec iov[PG_IOV_MAX];
+		int			iovcnt;
+		off_t		seekpos;
+		int			nbytes;
+		MdfdVec    *v;
+		BlockNumber nblocks_this_segment;
+		size_t		transferred_this_segment;
+		size_t		size_this_segment;
+
+		v = _mdfd_getseg(reln, forknum, blocknum, false,
+						 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
+
+		seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+
+		Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+
+		nblocks_this_segment =
+			Min(nblocks,
+				RELSEG_SIZE - (blocknum % ((BlockNumber) RELSEG_SIZE)));
+		nblocks_this_segment = Min(nblocks_this_segment, lengthof(iov));
+
+		iovcnt = buffers_to_iovec(iov, buffers, nblocks_this_segment);
+		size_this_segment = nblocks_this_segment * BLCKSZ;
+		transferred_this_segment = 0;
+
+		/*
+		 * Inner loop to continue after a short read.  We'll keep going until
+		 * we hit EOF rather than assuming that a short read means we hit the
+		 * end.
+		 */
+		for (;;)
+		{
+			TRACE_POSTGRESQL_SMGR_MD_READ_START(forknum, blocknum,
+												reln->smgr_rnode.node.spcNode,
+												reln->smgr_rnode.node.dbNode,
+												reln->smgr_rnode.node.relNode,
+												reln->smgr_rnode.backend);
+			nbytes = FileReadV(v->mdfd_vfd, iov, iovcnt,
+							   seekpos + transferred_this_segment,
+							   WAIT_EVENT_DATA_FILE_READ);
+			TRACE_POSTGRESQL_SMGR_MD_READ_DONE(forknum, blocknum,
+											   reln->smgr_rnode.node.spcNode,
+											   reln->smgr_rnode.node.dbNode,
+											   reln->smgr_rnode.node.relNode,
+											   reln->smgr_rnode.backend,
+											   nbytes,
+											   size_this_segment - transferred_this_segment);
+
+			if (nbytes < 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read blocks %u..%u in file \"%s\": %m",
+								blocknum,
+								blocknum + nblocks_this_segment - 1,
+								FilePathName(v->mdfd_vfd))));
+
+			if (nbytes == 0)
+			{
+				/*
+				 * We are at or past EOF, or we read a partial block at EOF.
+				 * Normally this is an error; upper levels should never try
+				 * to read a nonexistent block.  However, if
+				 * zero_damaged_pages is ON or we are InRecovery, we should
+				 * instead return zeroes without complaining.  See mdread().
+				 */
+				if (zero_damaged_pages || InRecovery)
+				{
+					BlockNumber i;
+
+					for (i = transferred_this_segment / BLCKSZ;
+						 i < nblocks_this_segment;
+						 ++i)
+						MemSet(buffers[i], 0, BLCKSZ);
+					break;
+				}
+				else
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_CORRUPTED),
+							 errmsg("could not read blocks %u..%u in file \"%s\": read only %zu of %zu bytes",
+									blocknum,
+									blocknum + nblocks_this_segment - 1,
+									FilePathName(v->mdfd_vfd),
+									transferred_this_segment,
+									size_this_segment)));
+			}
+
+			/* One loop should usually be enough. */
+			transferred_this_segment += nbytes;
+			Assert(transferred_this_segment <= size_this_segment);
+			if (transferred_this_segment == size_this_segment)
+				break;
+
+			/* Adjust the iovec array to skip what we already have. */
+			iovcnt = compute_remaining_iovec(iov, iovcnt, nbytes);
+		}
+
+		nblocks -= nblocks_this_segment;
+		buffers += nblocks_this_segment;
+		blocknum += nblocks_this_segment;
+	}
+}
+
+/*
+ *	mdwritev() -- Write the supplied range of blocks at the appropriate
+ *				  location.
+ *
+ *		Like mdwrite(), this is to be used only for updating already-existing
+ *		blocks of a relation.  The blocks are written with as few system
+ *		calls as possible, as in mdreadv().
+ */
+void
+mdwritev(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		 char **buffers, BlockNumber nblocks, bool skipFsync)
+{
+	/* This assert is too expensive to have on normally ... */
+#ifdef CHECK_WRITE_VS_EXTEND
+	Assert(blocknum + nblocks <= mdnblocks(reln, forknum));
+#endif
+
+	/* With direct I/O, go one block at a time if some need bouncing */
+	if (md_buffers_need_bounce(buffers, nblocks))
+	{
+		BlockNumber i;
+
+		for (i = 0; i < nblocks; i++)
+			mdwrite(reln, forknum, blocknum + i, buffers[i], skipFsync);
+		return;
+	}
+
+	while (nblocks > 0)
+	{
+		struct iovec iov[PG_IOV_MAX];
+		int			iovcnt;
+		off_t		seekpos;
+		int			nbytes;
+		MdfdVec    *v;
+		BlockNumber nblocks_this_segment;
+		size_t		transferred_this_segment;
+		size_t		size_this_segment;
+
+		v = _mdfd_getseg(reln, forknum, blocknum, skipFsync,
+						 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
+
+		seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+
+		Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+
+		nblocks_this_segment =
+			Min(nblocks,
+				RELSEG_SIZE - (blocknum % ((BlockNumber) RELSEG_SIZE)));
+		nblocks_this_segment = Min(nblocks_this_segment, lengthof(iov));
+
+		iovcnt = buffers_to_iovec(iov, buffers, nblocks_this_segment);
+		size_this_segment = nblocks_this_segment * BLCKSZ;
+		transferred_this_segment = 0;
+
+		/* Inner loop to continue after a short write. */
+		for (;;)
+		{
+			TRACE_POSTGRESQL_SMGR_MD_WRITE_START(forknum, blocknum,
+												 reln->smgr_rnode.node.spcNode,
+												 reln->smgr_rnode.node.dbNode,
+												 reln->smgr_rnode.node.relNode,
+												 reln->smgr_rnode.backend);
+			nbytes = FileWriteV(v->mdfd_vfd, iov, iovcnt,
+								seekpos + transferred_this_segment,
+								WAIT_EVENT_DATA_FILE_WRITE);
+			TRACE_POSTGRESQL_SMGR_MD_WRITE_DONE(forknum, blocknum,
+												reln->smgr_rnode.node.spcNode,
+												reln->smgr_rnode.node.dbNode,
+												reln->smgr_rnode.node.relNode,
+												reln->smgr_rnode.backend,
+												nbytes,
+												size_this_segment - transferred_this_segment);
+
+			if (nbytes < 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not write blocks %u..%u in file \"%s\": %m",
+								blocknum,
+								blocknum + nblocks_this_segment - 1,
+								FilePathName(v->mdfd_vfd))));
+
+			if (nbytes == 0)
+			{
+				/* short write: complain appropriately */
+				ereport(ERROR,
+						(errcode(ERRCODE_DISK_FULL),
+						 errmsg("could not write blocks %u..%u in file \"%s\": wrote only %zu of %zu bytes",
+								blocknum,
+								blocknum + nblocks_this_segment - 1,
+								FilePathName(v->mdfd_vfd),
+								transferred_this_segment,
+								size_this_segment),
+						 errhint("Check free disk space.")));
+			}
+
+			/* One loop should usually be enough. */
+			transferred_this_segment += nbytes;
+			Assert(transferred_this_segment <= size_this_segment);
+			if (transferred_this_segment == size_this_segment)
+				break;
+
+			/* Adjust the iovec array to skip what we already wrote. */
+			iovcnt = compute_remaining_iovec(iov, iovcnt, nbytes);
+		}
+
+		if (!skipFsync && !SmgrIsTemp(reln))
+			register_dirty_segment(reln, forknum, v);
+
+		nblocks -= nblocks_this_segment;
+		buffers += nblocks_this_segment;
+		blocknum += nblocks_this_segment;
+	}
+}
+
 /*
  *	mdnblocks() -- Get the number of blocks stored in a relation.
  *
@@ -1023,6 +1397,7 @@ mdsync(void)
 	uint64		elapsed;
 	uint64		longest = 0;
 	uint64		total_elapsed = 0;
+	int			to_process = 0;
 
 	/*
 	 * This is only called during checkpoints, and checkpoints should only
@@ -1082,6 +1457,24 @@ mdsync(void)
 	/* Set flag to detect failure if we don't reach the end of the loop */
 	mdsync_in_progress = true;
 
+	/*
+	 * If the checkpointer paces the sync phase, count the segments to be
+	 * fsync'd first, so that it can tell how far along we are.
+	 */
+	if (CheckPointIOLatencyTarget > 0 && enableFsync)
+	{
+		hash_seq_init(&hstat, pendingOpsTable);
+		while ((entry = (PendingOperationEntry *) hash_seq_search(&hstat)) != NULL)
+		{
+			ForkNumber	forknum;
+
+			if (entry->cycle_ctr == mdsync_cycle_ctr)
+				continue;
+			for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+				to_process += bms_num_members(entry->requests[forknum]);
+		}
+	}
+
 	/* Now scan the hashtable for fsync requests to process */
 	absorb_counter = FSYNCS_PER_ABSORB;
 	hash_seq_init(&hstat, pendingOpsTable);
@@ -1206,6 +1599,11 @@ mdsync(void)
 								 FilePathName(seg->mdfd_vfd),
 								 (double) elapsed / 1000);
 
+						/* Let the checkpointer pace the fsyncs */
+						if (to_process > 0)
+							CheckpointSyncDelay((double) elapsed / 1000,
+												(double) processed / to_process);
+
 						break;	/* out of retry loop */
 					}
 
@@ -1780,7 +2178,7 @@ _mdfd_openseg(SMgrRelation reln, ForkNumber forknum, BlockNumber segno,
 	fullpath = _mdfd_segpath(reln, forknum, segno);
 
 	/* open the file */
-	fd = PathNameOpenFile(fullpath, O_RDWR | PG_BINARY | oflags);
+	fd = PathNameOpenFile(fullpath, O_RDWR | PG_BINARY | MD_OPEN_FLAGS | oflags);
 
 	pfree(fullpath);
 
@@ -1934,6 +2332,100 @@ _mdfd_getseg(SMgrRelation reln, ForkNumber forknum, BlockNumber blkno,
 	return v;
 }
 
+/*
+ * Return a BLCKSZ-sized buffer aligned for direct I/O, for use when the
+ * caller's buffer isn't.  It's static rather than palloc'd because we may
+ * be called in a critical section.
+ */
+static char *
+md_bounce_buffer(void)
+{
+	static char bounce_buffer[BLCKSZ + PG_IO_ALIGN_SIZE];
+
+	return (char *) TYPEALIGN(PG_IO_ALIGN_SIZE, bounce_buffer);
+}
+
+/*
+ * Do any of these buffers need to be copied through the bounce buffer?
+ */
+static bool
+md_buffers_need_bounce(char **buffers, int nblocks)
+{
+	int			i;
+
+	if (!io_direct)
+		return false;
+
+	for (i = 0; i < nblocks; i++)
+	{
+		if (!MD_BUFFER_IS_ALIGNED(buffers[i]))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Fill in an array of iovecs describing a set of BLCKSZ-sized buffers,
+ * merging neighbours that happen to be adjacent in memory.  Returns the
+ * number of iovecs used.
+ */
+static int
+buffers_to_iovec(struct iovec *iov, char **buffers, int nblocks)
+{
+	int			iovcnt = 0;
+	int			i;
+
+	Assert(nblocks >= 1);
+
+	for (i = 0; i < nblocks; ++i)
+	{
+		if (iovcnt > 0 &&
+			(char *) iov[iovcnt - 1].iov_base + iov[iovcnt - 1].iov_len == buffers[i])
+		{
+			/* Contiguous with the previous buffer, so just extend it. */
+			iov[iovcnt - 1].iov_len += BLCKSZ;
+		}
+		else
+		{
+			iov[iovcnt].iov_base = buffers[i];
+			iov[iovcnt].iov_len = BLCKSZ;
+			iovcnt++;
+		}
+	}
+
+	return iovcnt;
+}
+
+/*
+ * After a partial read or write, adjust an array of iovecs in place so that
+ * it describes only the part that has not been transferred yet.  Returns the
+ * number of iovecs remaining.
+ */
+static int
+compute_remaining_iovec(struct iovec *iov, int iovcnt, size_t transferred)
+{
+	int			skip = 0;
+
+	/* Skip over the iovecs that have been completely transferred. */
+	while (skip < iovcnt && transferred >= iov[skip].iov_len)
+	{
+		transferred -= iov[skip].iov_len;
+		skip++;
+	}
+
+	iovcnt -= skip;
+	if (iovcnt == 0)
+		return 0;
+	if (skip > 0)
+		memmove(iov, iov + skip, sizeof(*iov) * iovcnt);
+
+	/* Trim the first remaining iovec, which may be partially done. */
+	iov[0].iov_base = (char *) iov[0].iov_base + transferred;
+	iov[0].iov_len -= transferred;
+
+	return iovcnt;
+}
+
 /*
  * Get number of blocks present in a single disk file
  */
@@ -17,10 +17,13 @@
  */
 #include "postgres.h"
 
+#include "access/xlog.h"
 #include "commands/tablespace.h"
 #include "lib/ilist.h"
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
 #include "storage/smgr.h"
 #include "utils/hsearch.h"
 #include "utils/inval.h"
@@ -48,12 +51,21 @@ typedef struct f_smgr
 								bool isRedo);
 	void		(*smgr_extend) (SMgrRelation reln, ForkNumber forknum,
 								BlockNumber blocknum, char *buffer, bool skipFsync);
+	void		(*smgr_zeroextend) (SMgrRelation reln, ForkNumber forknum,
+									BlockNumber blocknum, int nblocks,
+									bool skipFsync);
 	void		(*smgr_prefetch) (SMgrRelation reln, ForkNumber forknum,
 								  BlockNumber blocknum);
 	void		(*smgr_read) (SMgrRelation reln, ForkNumber forknum,
 							  BlockNumber blocknum, char *buffer);
 	void		(*smgr_write) (SMgrRelation reln, ForkNumber forknum,
 							   BlockNumber blocknum, char *buffer, bool skipFsync);
+	void		(*smgr_readv) (SMgrRelation reln, ForkNumber forknum,
+							   BlockNumber blocknum, char **buffers,
+							   BlockNumber nblocks);
+	void		(*smgr_writev) (SMgrRelation reln, ForkNumber forknum,
+								BlockNumber blocknum, char **buffers,
+								BlockNumber nblocks, bool skipFsync);
 	void		(*smgr_writeback) (SMgrRelation reln, ForkNumber forknum,
 								   BlockNumber blocknum, BlockNumber nblocks);
 	BlockNumber (*smgr_nblocks) (SMgrRelation reln, ForkNumber forknum);
@@ -76,9 +88,12 @@ static const f_smgr smgrsw[] = {
 		.smgr_exists = mdexists,
 		.smgr_unlink = mdunlink,
 		.smgr_extend = mdextend,
+		.smgr_zeroextend = mdzeroextend,
 		.smgr_prefetch = mdprefetch,
 		.smgr_read = mdread,
 		.smgr_write = mdwrite,
+		.smgr_readv = mdreadv,
+		.smgr_writev = mdwritev,
 		.smgr_writeback = mdwriteback,
 		.smgr_nblocks = mdnblocks,
 		.smgr_truncate = mdtruncate,
@@ -100,10 +115,146 @@ static HTAB *SMgrRelationHash = NULL;
 
 static dlist_head	unowned_relns;
 
+/*
+ * In addition, there is a hashtable in shared memory that caches the sizes
+ * of the forks of permanent and unlogged relations, so that we don't have to
+ * ask the kernel with lseek() every time somebody wants to know how long a
+ * relation is.  It's kept up to date by smgrextend(), smgrzeroextend() and
+ * smgrtruncate(), during recovery too, and entries are removed when
+ * relations are dropped.
+ *
+ * The table is partitioned like the buffer mapping table.  To keep it
+ * coherent with concurrent extension, a missing size is looked up from the
+ * storage manager while holding the partition lock exclusively, and a
+ * backend that extends a relation updates a cached size only after the new
+ * block has been added.  That way a size that is entered into the table
+ * already reflects any extension that did not update it.
+ *
+ * The sizes are kept in a fixed array of smgr_shared_relations slots, and
+ * the hash table maps each cached relation to its slot.  When all the slots
+ * are taken, the least recently used one is recycled, using a clock sweep
+ * as in the buffer manager: each lookup sets the slot's usage flag, and the
+ * clock hand clears the flags it passes until it finds a slot whose flag is
+ * clear.
+ *
+ * Each slot belongs to one partition, and is protected by that partition's
+ * lock.  A slot in use belongs to the partition of the relation in it; to
+ * take a slot from another partition, we must hold both partitions' locks.
+ * The clock sweep already holds the lock of the partition it's looking for
+ * a slot for, so it only tries to get the other lock, and moves on to the
+ * next slot if it can't have it right away.  That avoids deadlocks.
+ */
+typedef struct SMgrSharedRelation
+{
+	RelFileNode rnode;			/* the relation, if in_use */
+	BlockNumber nblocks[MAX_FORKNUM + 1];	/* InvalidBlockNumber if unknown */
+	int			partition;		/* partition whose lock protects the slot */
+	bool		in_use;			/* does the slot hold a relation? */
+	pg_atomic_uint32 usage;		/* used since the clock hand last passed? */
+} SMgrSharedRelation;
+
+typedef struct SMgrSharedRelationEnt
+{
+	RelFileNode rnode;			/* hash key, must be first */
+	int			slot;			/* index into SMgrSharedRelations */
+} SMgrSharedRelationEnt;
+
+typedef struct SMgrSharedRelationControl
+{
+	pg_atomic_uint32 clockHand; /* next slot to look at, modulo the size */
+	SMgrSharedRelation slots[FLEXIBLE_ARRAY_MEMBER];
+} SMgrSharedRelationControl;
+
+#define SMgrSharedRelationHashPartition(hashcode) \
+	((hashcode) % NUM_SMGR_SHARED_RELATION_PARTITIONS)
+#define SMgrSharedRelationPartitionLockByIndex(i) \
+	(&MainLWLockArray[SMGR_SHARED_RELATION_LWLOCK_OFFSET + (i)].lock)
+#define SMgrSharedRelationPartitionLock(hashcode) \
+	SMgrSharedRelationPartitionLockByIndex(SMgrSharedRelationHashPartition(hashcode))
+
+/* GUC variable */
+int			smgr_shared_relations = 10000;
+
+static HTAB *SMgrSharedRelationHash = NULL;
+static SMgrSharedRelationControl *SMgrSharedRelations = NULL;
+
 /* local function prototypes */
 static void smgrshutdown(int code, Datum arg);
+static void smgr_shared_extend(SMgrRelation reln, ForkNumber forknum,
+				   BlockNumber nblocks);
+static void smgr_shared_forget(SMgrRelation reln, ForkNumber forknum);
+static SMgrSharedRelation *smgr_shared_lookup(RelFileNode *rnode,
+				   uint32 hashcode);
+static SMgrSharedRelation *smgr_shared_enter(RelFileNode *rnode,
+				  uint32 hashcode);
+static void smgr_shared_remove(SMgrSharedRelation *sr);
 
 
+/*
+ * SMgrShmemSize --- report amount of shared memory needed for the shared
+ * relation size cache
+ */
+Size
+SMgrShmemSize(void)
+{
+	Size		size;
+
+	if (smgr_shared_relations <= 0)
+		return 0;
+
+	size = offsetof(SMgrSharedRelationControl, slots);
+	size = add_size(size, mul_size(smgr_shared_relations,
+								   sizeof(SMgrSharedRelation)));
+	size = add_size(size, hash_estimate_size(smgr_shared_relations,
+											 sizeof(SMgrSharedRelationEnt)));
+	return size;
+}
+
+/*
+ * SMgrShmemInit --- set up the shared relation size cache
+ */
+void
+SMgrShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (smgr_shared_relations <= 0)
+		return;
+
+	SMgrSharedRelations = (SMgrSharedRelationControl *)
+		ShmemInitStruct("Shared Relation Size Cache Slots",
+						offsetof(SMgrSharedRelationControl, slots) +
+						smgr_shared_relations * sizeof(SMgrSharedRelation),
+						&found);
+	if (!found)
+	{
+		int			i;
+
+		/* Spread the free slots over the partitions */
+		pg_atomic_init_u32(&SMgrSharedRelations->clockHand, 0);
+		for (i = 0; i < smgr_shared_relations; i++)
+		{
+			SMgrSharedRelation *sr = &SMgrSharedRelations->slots[i];
+
+			sr->partition = i % NUM_SMGR_SHARED_RELATION_PARTITIONS;
+			sr->in_use = false;
+			pg_atomic_init_u32(&sr->usage, 0);
+		}
+	}
+
+	info.keysize = sizeof(RelFileNode);
+	info.entrysize = sizeof(SMgrSharedRelationEnt);
+	info.num_partitions = NUM_SMGR_SHARED_RELATION_PARTITIONS;
+
+	SMgrSharedRelationHash = ShmemInitHash("Shared Relation Size Cache",
+										   smgr_shared_relations,
+										   smgr_shared_relations,
+										   &info,
+										   HASH_ELEM | HASH_BLOBS |
+										   HASH_PARTITION | HASH_FIXED_SIZE);
+}
+
 /*
  *	smgrinit(), smgrshutdown() -- Initialize or shut down storage
  *								  managers.
@@ -186,9 +337,12 @@ smgropen(RelFileNode rnode, BackendId backend)
 		reln->smgr_vm_nblocks = InvalidBlockNumber;
 		reln->smgr_which = 0;	/* we only have md.c at present */
 
-		/* mark it not open */
+		/* mark it not open, and its size unknown */
 		for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		{
 			reln->md_num_open_segs[forknum] = 0;
+			reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+		}
 
 		/* it has no owner yet */
 		dlist_push_tail(&unowned_relns, &reln->node);
@@ -386,15 +540,16 @@ smgrdounlink(SMgrRelation reln, bool isRedo)
 	int			which = reln->smgr_which;
 	ForkNumber	forknum;
 
-	/* Close the forks at smgr level */
-	for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
-		smgrsw[which].smgr_close(reln, forknum);
-
 	/*
 	 * Get rid of any remaining buffers for the relation.  bufmgr will just
-	 * drop them without bothering to write the contents.
+	 * drop them without bothering to write the contents.  This may need to
+	 * check which forks exist, so do it before closing them.
 	 */
-	DropRelFileNodesAllBuffers(&rnode, 1);
+	DropRelFileNodesAllBuffers(&reln, 1);
+
+	/* Close the forks at smgr level */
+	for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		smgrsw[which].smgr_close(reln, forknum);
 
 	/*
 	 * It'd be nice to tell the stats collector to forget it immediately, too.
@@ -421,6 +576,10 @@ smgrdounlink(SMgrRelation reln, bool isRedo)
 	 * xact.
 	 */
 	smgrsw[which].smgr_unlink(rnode, InvalidForkNumber, isRedo);
+
+	for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+	smgr_shared_forget(reln, InvalidForkNumber);
 }
 
 /*
@@ -446,6 +605,13 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 	if (nrels == 0)
 		return;
 
+	/*
+	 * Get rid of any remaining buffers for the relations.  bufmgr will just
+	 * drop them without bothering to write the contents.  This may need to
+	 * check which forks exist, so do it before closing them.
+	 */
+	DropRelFileNodesAllBuffers(rels, nrels);
+
 	/*
 	 * create an array which contains all relations to be dropped, and close
 	 * each relation's forks at the smgr level while at it
@@ -463,12 +629,6 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 			smgrsw[which].smgr_close(rels[i], forknum);
 	}
 
-	/*
-	 * Get rid of any remaining buffers for the relations.  bufmgr will just
-	 * drop them without bothering to write the contents.
-	 */
-	DropRelFileNodesAllBuffers(rnodes, nrels);
-
 	/*
 	 * It'd be nice to tell the stats collector to forget them immediately,
 	 * too. But we can't because we don't know the OIDs.
@@ -498,7 +658,11 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 		int			which = rels[i]->smgr_which;
 
 		for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		{
 			smgrsw[which].smgr_unlink(rnodes[i], forknum, isRedo);
+			rels[i]->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+		}
+		smgr_shared_forget(rels[i], InvalidForkNumber);
 	}
 
 	pfree(rnodes);
@@ -527,7 +691,7 @@ smgrdounlinkfork(SMgrRelation reln, ForkNumber forknum, bool isRedo)
 	 * Get rid of any remaining buffers for the fork.  bufmgr will just drop
 	 * them without bothering to write the contents.
 	 */
-	DropRelFileNodeBuffers(rnode, forknum, 0);
+	DropRelFileNodeBuffers(reln, forknum, 0);
 
 	/*
 	 * It'd be nice to tell the stats collector to forget it immediately, too.
@@ -554,6 +718,8 @@ smgrdounlinkfork(SMgrRelation reln, ForkNumber forknum, bool isRedo)
 	 * xact.
 	 */
 	smgrsw[which].smgr_unlink(rnode, forknum, isRedo);
+	reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+	smgr_shared_forget(reln, forknum);
 }
 
 /*
@@ -571,6 +737,40 @@ smgrextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 {
 	smgrsw[reln->smgr_which].smgr_extend(reln, forknum, blocknum,
 										 buffer, skipFsync);
+
+	/*
+	 * Keep the cached size up to date if we just added the block following
+	 * the known end of the fork; otherwise we no longer know the size.
+	 */
+	if (reln->smgr_cached_nblocks[forknum] == blocknum)
+		reln->smgr_cached_nblocks[forknum] = blocknum + 1;
+	else
+		reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+
+	smgr_shared_extend(reln, forknum, blocknum + 1);
+}
+
+/*
+ *	smgrzeroextend() -- Add new zeroed out blocks to a file.
+ *
+ *		Similar to smgrextend(), except the relation can be extended by
+ *		multiple blocks at once, starting at blocknum, and the added blocks
+ *		are filled with zeroes.
+ */
+void
+smgrzeroextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			   int nblocks, bool skipFsync)
+{
+	smgrsw[reln->smgr_which].smgr_zeroextend(reln, forknum, blocknum,
+											 nblocks, skipFsync);
+
+	/* Maintain the cached sizes, as in smgrextend() */
+	if (reln->smgr_cached_nblocks[forknum] == blocknum)
+		reln->smgr_cached_nblocks[forknum] = blocknum + nblocks;
+	else
+		reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+
+	smgr_shared_extend(reln, forknum, blocknum + nblocks);
 }
 
 /*
@@ -620,6 +820,36 @@ smgrwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 										buffer, skipFsync);
 }
 
+/*
+ *	smgrreadv() -- read a range of consecutive blocks from a relation into
+ *				   the supplied buffers.
+ *
+ *		This is equivalent to calling smgrread() for each of blocknum ..
+ *		blocknum + nblocks - 1 in turn, but lets the storage manager combine
+ *		the reads into fewer, larger requests.
+ */
+void
+smgrreadv(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		  char **buffers, BlockNumber nblocks)
+{
+	smgrsw[reln->smgr_which].smgr_readv(reln, forknum, blocknum,
+										buffers, nblocks);
+}
+
+/*
+ *	smgrwritev() -- Write out a range of consecutive blocks.
+ *
+ *		This is equivalent to calling smgrwrite() for each block in turn;
+ *		the same restrictions apply.
+ */
+void
+smgrwritev(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		   char **buffers, BlockNumber nblocks, bool skipFsync)
+{
+	smgrsw[reln->smgr_which].smgr_writev(reln, forknum, blocknum,
+										 buffers, nblocks, skipFsync);
+}
+
 
 /*
  *	smgrwriteback() -- Trigger kernel writeback for the supplied range of
@@ -640,7 +870,81 @@ smgrwriteback(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 BlockNumber
 smgrnblocks(SMgrRelation reln, ForkNumber forknum)
 {
-	return smgrsw[reln->smgr_which].smgr_nblocks(reln, forknum);
+	BlockNumber result;
+
+	/* Use the cached size if it can be trusted */
+	result = smgrnblocks_cached(reln, forknum);
+	if (result == InvalidBlockNumber)
+	{
+		if (SMgrSharedRelationHash == NULL || SmgrIsTemp(reln))
+			result = smgrsw[reln->smgr_which].smgr_nblocks(reln, forknum);
+		else
+		{
+			RelFileNode rnode = reln->smgr_rnode.node;
+			uint32		hashcode;
+			LWLock	   *partitionLock;
+			SMgrSharedRelation *sr;
+
+			/*
+			 * Ask the storage manager, and remember the answer in the shared
+			 * cache.  We must hold the partition lock exclusively while doing
+			 * that, see the comments at the top of the file.
+			 */
+			hashcode = get_hash_value(SMgrSharedRelationHash, &rnode);
+			partitionLock = SMgrSharedRelationPartitionLock(hashcode);
+
+			LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+			result = smgrsw[reln->smgr_which].smgr_nblocks(reln, forknum);
+			sr = smgr_shared_enter(&rnode, hashcode);
+			if (sr != NULL)
+				sr->nblocks[forknum] = result;
+			LWLockRelease(partitionLock);
+		}
+	}
+
+	reln->smgr_cached_nblocks[forknum] = result;
+
+	return result;
+}
+
+/*
+ *	smgrnblocks_cached() -- Get the cached number of blocks in the supplied
+ *							relation.
+ *
+ *		Returns InvalidBlockNumber if the size isn't known.  The size in
+ *		the shared cache reflects every extension and truncation that has
+ *		completed, see the comments at the top of the file.  The size last
+ *		seen by this backend, when it's not in the shared cache, is only
+ *		reliable
+ *		during recovery: the startup process is then the only process that
+ *		extends or truncates relations, so nobody else can have changed the
+ *		size behind our back.
+ */
+BlockNumber
+smgrnblocks_cached(SMgrRelation reln, ForkNumber forknum)
+{
+	RelFileNode rnode = reln->smgr_rnode.node;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	SMgrSharedRelation *sr;
+	BlockNumber result;
+
+	if (InRecovery &&
+		reln->smgr_cached_nblocks[forknum] != InvalidBlockNumber)
+		return reln->smgr_cached_nblocks[forknum];
+
+	if (SMgrSharedRelationHash == NULL || SmgrIsTemp(reln))
+		return InvalidBlockNumber;
+
+	hashcode = get_hash_value(SMgrSharedRelationHash, &rnode);
+	partitionLock = SMgrSharedRelationPartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_SHARED);
+	sr = smgr_shared_lookup(&rnode, hashcode);
+	result = sr ? sr->nblocks[forknum] : InvalidBlockNumber;
+	LWLockRelease(partitionLock);
+
+	return result;
 }
 
 /*
@@ -656,7 +960,7 @@ smgrtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
 	 * Get rid of any buffers for the about-to-be-deleted blocks. bufmgr will
 	 * just drop them without bothering to write the contents.
 	 */
-	DropRelFileNodeBuffers(reln->smgr_rnode, forknum, nblocks);
+	DropRelFileNodeBuffers(reln, forknum, nblocks);
 
 	/*
 	 * Send a shared-inval message to force other backends to close any smgr
@@ -671,9 +975,37 @@ smgrtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
 	CacheInvalidateSmgr(reln->smgr_rnode);
 
 	/*
-	 * Do the truncation.
+	 * Do the truncation.  Forget the cached size first, in case we fail
+	 * partway through.
 	 */
-	smgrsw[reln->smgr_which].smgr_truncate(reln, forknum, nblocks);
+	reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+	if (SMgrSharedRelationHash == NULL || SmgrIsTemp(reln))
+		smgrsw[reln->smgr_which].smgr_truncate(reln, forknum, nblocks);
+	else
+	{
+		RelFileNode rnode = reln->smgr_rnode.node;
+		uint32		hashcode;
+		LWLock	   *partitionLock;
+		SMgrSharedRelation *sr;
+
+		/*
+		 * Hold the partition lock while truncating, so that nobody can look
+		 * up and cache the size while the truncation is in progress.  If we
+		 * fail partway through, the shared size stays unknown.
+		 */
+		hashcode = get_hash_value(SMgrSharedRelationHash, &rnode);
+		partitionLock = SMgrSharedRelationPartitionLock(hashcode);
+
+		LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+		sr = smgr_shared_lookup(&rnode, hashcode);
+		if (sr != NULL)
+			sr->nblocks[forknum] = InvalidBlockNumber;
+		smgrsw[reln->smgr_which].smgr_truncate(reln, forknum, nblocks);
+		if (sr != NULL)
+			sr->nblocks[forknum] = nblocks;
+		LWLockRelease(partitionLock);
+	}
+	reln->smgr_cached_nblocks[forknum] = nblocks;
 }
 
 /*
@@ -782,3 +1114,242 @@ AtEOXact_SMgr(void)
 		smgrclose(rel);
 	}
 }
+
+/*
+ * DropDatabaseRelationSizes -- forget the cached sizes of all relations of
+ * a database
+ *
+ * Used when a database is dropped or moved to another tablespace, since
+ * its files are then removed without going through smgrdounlink().
+ */
+void
+DropDatabaseRelationSizes(Oid dbid)
+{
+	int			i;
+
+	if (SMgrSharedRelationHash == NULL)
+		return;
+
+	/* Lock all partitions, in order, as in GetLockStatusData */
+	for (i = 0; i < NUM_SMGR_SHARED_RELATION_PARTITIONS; i++)
+		LWLockAcquire(SMgrSharedRelationPartitionLockByIndex(i), LW_EXCLUSIVE);
+
+	for (i = 0; i < smgr_shared_relations; i++)
+	{
+		SMgrSharedRelation *sr = &SMgrSharedRelations->slots[i];
+
+		if (sr->in_use && sr->rnode.dbNode == dbid)
+			smgr_shared_remove(sr);
+	}
+
+	for (i = NUM_SMGR_SHARED_RELATION_PARTITIONS; --i >= 0;)
+		LWLockRelease(SMgrSharedRelationPartitionLockByIndex(i));
+}
+
+/*
+ * smgr_shared_extend -- note in the shared cache that a fork has been
+ * extended to at least nblocks blocks
+ *
+ * Only sizes that are already known are updated; see the comments at the
+ * top of the file for why that's enough.
+ */
+static void
+smgr_shared_extend(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
+{
+	RelFileNode rnode = reln->smgr_rnode.node;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	SMgrSharedRelation *sr;
+
+	if (SMgrSharedRelationHash == NULL || SmgrIsTemp(reln))
+		return;
+
+	hashcode = get_hash_value(SMgrSharedRelationHash, &rnode);
+	partitionLock = SMgrSharedRelationPartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+	sr = smgr_shared_lookup(&rnode, hashcode);
+	if (sr != NULL && sr->nblocks[forknum] != InvalidBlockNumber &&
+		sr->nblocks[forknum] < nblocks)
+		sr->nblocks[forknum] = nblocks;
+	LWLockRelease(partitionLock);
+}
+
+/*
+ * smgr_shared_forget -- remove the cached size of an unlinked fork, or of
+ * all forks if forknum is InvalidForkNumber, from the shared cache
+ */
+static void
+smgr_shared_forget(SMgrRelation reln, ForkNumber forknum)
+{
+	RelFileNode rnode = reln->smgr_rnode.node;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	SMgrSharedRelation *sr;
+
+	if (SMgrSharedRelationHash == NULL || SmgrIsTemp(reln))
+		return;
+
+	hashcode = get_hash_value(SMgrSharedRelationHash, &rnode);
+	partitionLock = SMgrSharedRelationPartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+	sr = smgr_shared_lookup(&rnode, hashcode);
+	if (sr != NULL)
+	{
+		if (forknum == InvalidForkNumber)
+			smgr_shared_remove(sr);
+		else
+			sr->nblocks[forknum] = InvalidBlockNumber;
+	}
+	LWLockRelease(partitionLock);
+}
+
+/*
+ * smgr_shared_lookup -- find the slot of a relation in the shared cache
+ *
+ * Returns NULL if the relation isn't cached.  The caller must hold the
+ * relation's partition lock.
+ */
+static SMgrSharedRelation *
+smgr_shared_lookup(RelFileNode *rnode, uint32 hashcode)
+{
+	SMgrSharedRelationEnt *ent;
+	SMgrSharedRelation *sr;
+
+	ent = (SMgrSharedRelationEnt *)
+		hash_search_with_hash_value(SMgrSharedRelationHash, rnode,
+									hashcode, HASH_FIND, NULL);
+	if (ent == NULL)
+		return NULL;
+
+	sr = &SMgrSharedRelations->slots[ent->slot];
+	Assert(sr->in_use && RelFileNodeEquals(sr->rnode, *rnode));
+	Assert(sr->partition == SMgrSharedRelationHashPartition(hashcode));
+
+	/* Tell the clock sweep that it's been used */
+	if (pg_atomic_read_u32(&sr->usage) == 0)
+		pg_atomic_write_u32(&sr->usage, 1);
+
+	return sr;
+}
+
+/*
+ * smgr_shared_enter -- find or make a slot for a relation in the shared
+ * cache
+ *
+ * A new slot has the sizes of all forks unknown.  Returns NULL if the clock
+ * sweep goes around twice without finding a slot, which only happens if the
+ * locks of the other partitions are busy.  The caller must hold the
+ * relation's partition lock exclusively.
+ */
+static SMgrSharedRelation *
+smgr_shared_enter(RelFileNode *rnode, uint32 hashcode)
+{
+	int			partition = SMgrSharedRelationHashPartition(hashcode);
+	SMgrSharedRelationEnt *ent;
+	SMgrSharedRelation *sr = NULL;
+	bool		found;
+	int			i;
+	ForkNumber	forknum;
+
+	Assert(LWLockHeldByMeInMode(SMgrSharedRelationPartitionLock(hashcode),
+								LW_EXCLUSIVE));
+
+	sr = smgr_shared_lookup(rnode, hashcode);
+	if (sr != NULL)
+		return sr;
+
+	for (i = 0; i < 2 * smgr_shared_relations; i++)
+	{
+		uint32		slot;
+		int			other;
+		LWLock	   *otherLock = NULL;
+
+		slot = pg_atomic_fetch_add_u32(&SMgrSharedRelations->clockHand, 1) %
+			smgr_shared_relations;
+		sr = &SMgrSharedRelations->slots[slot];
+
+		/*
+		 * Get the lock of the partition the slot belongs to, if it's not
+		 * ours.  The slot can move to another partition until we have the
+		 * lock, so check again after.
+		 */
+		other = sr->partition;
+		if (other != partition)
+		{
+			otherLock = SMgrSharedRelationPartitionLockByIndex(other);
+			if (!LWLockConditionalAcquire(otherLock, LW_EXCLUSIVE))
+			{
+				sr = NULL;
+				continue;
+			}
+			if (sr->partition != other)
+			{
+				LWLockRelease(otherLock);
+				sr = NULL;
+				continue;
+			}
+		}
+
+		if (sr->in_use)
+		{
+			/* Spare it if it has been used since we last came by */
+			if (pg_atomic_read_u32(&sr->usage) != 0)
+			{
+				pg_atomic_write_u32(&sr->usage, 0);
+				if (otherLock)
+					LWLockRelease(otherLock);
+				sr = NULL;
+				continue;
+			}
+			smgr_shared_remove(sr);
+		}
+
+		/* The slot is free; take it over into our partition */
+		sr->partition = partition;
+		if (otherLock)
+			LWLockRelease(otherLock);
+		break;
+	}
+
+	if (sr == NULL)
+		return NULL;
+
+	/*
+	 * There is never more than one hash entry per slot, so the fixed-size
+	 * table can't be full.
+	 */
+	ent = (SMgrSharedRelationEnt *)
+		hash_search_with_hash_value(SMgrSharedRelationHash, rnode,
+									hashcode, HASH_ENTER_NULL, &found);
+	if (ent == NULL)
+		elog(ERROR, "shared relation size cache corrupted");
+	Assert(!found);
+	ent->slot = sr - SMgrSharedRelations->slots;
+
+	sr->rnode = *rnode;
+	for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		sr->nblocks[forknum] = InvalidBlockNumber;
+	sr->in_use = true;
+	pg_atomic_write_u32(&sr->usage, 1);
+
+	return sr;
+}
+
+/*
+ * smgr_shared_remove -- remove a relation from the shared cache, leaving
+ * its slot free
+ *
+ * The caller must hold the lock of the slot's partition exclusively.
+ */
+static void
+smgr_shared_remove(SMgrSharedRelation *sr)
+{
+	Assert(sr->in_use);
+
+	if (hash_search(SMgrSharedRelationHash, &sr->rnode,
+					HASH_REMOVE, NULL) == NULL)
+		elog(ERROR, "shared relation size cache corrupted");
+	sr->in_use = false;
+}
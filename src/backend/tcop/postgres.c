@@ -57,6 +57,7 @@
 #include "pg_getopt.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/postmaster.h"
+#include "postmaster/sessionpool.h"
 #include "replication/logicallauncher.h"
 #include "replication/logicalworker.h"
 #include "replication/slot.h"
@@ -3148,6 +3149,9 @@ ProcessInterrupts(void)
 
 	}
 
+	if (ProcSignalBarrierPending)
+		ProcessProcSignalBarrier();
+
 	if (ParallelMessagePending)
 		HandleParallelMessages();
 }
@@ -3846,21 +3850,27 @@ PostgresMain(int argc, char *argv[],
 		InitializeMaxBackends();
 	}
 
-	/* Early initialization */
-	BaseInit();
-
 	/*
-	 * Create a per-backend PGPROC struct in shared memory, except in the
-	 * EXEC_BACKEND case where this was done in SubPostmasterMain. We must do
-	 * this before we can use LWLocks (and in the EXEC_BACKEND case we already
-	 * had to do some stuff with LWLocks).
+	 * Early initialization, unless a pre-forked backend did that already
+	 * while it waited for a connection; see PreInitPostgres.
 	 */
+	if (!BackendPreinitialized)
+	{
+		BaseInit();
+
+		/*
+		 * Create a per-backend PGPROC struct in shared memory, except in the
+		 * EXEC_BACKEND case where this was done in SubPostmasterMain. We
+		 * must do this before we can use LWLocks (and in the EXEC_BACKEND
+		 * case we already had to do some stuff with LWLocks).
+		 */
 #ifdef EXEC_BACKEND
-	if (!IsUnderPostmaster)
-		InitProcess();
+		if (!IsUnderPostmaster)
+			InitProcess();
 #else
-	InitProcess();
+		InitProcess();
 #endif
+	}
 
 	/* We need to allow SIGINT, etc during the initial transaction */
 	PG_SETMASK(&UnBlockSig);
@@ -3913,9 +3923,10 @@ PostgresMain(int argc, char *argv[],
 	process_session_preload_libraries();
 
 	/*
-	 * Send this backend's cancellation info to the frontend.
+	 * Send this backend's cancellation info to the frontend.  A session
+	 * handed over by the connection pool keeps the key it was given first.
 	 */
-	if (whereToSendOutput == DestRemote)
+	if (whereToSendOutput == DestRemote && MyProcPort->pool_key == NULL)
 	{
 		StringInfoData buf;
 
@@ -4094,12 +4105,24 @@ PostgresMain(int argc, char *argv[],
 	if (!ignore_till_sync)
 		send_ready_for_query = true;	/* initially, or after error */
 
+	/*
+	 * The client of a session handed over by the connection pool has already
+	 * sent its next query, and isn't waiting to be told we're ready.
+	 */
+	if (MyProcPort != NULL && MyProcPort->pool_key != NULL)
+	{
+		send_ready_for_query = false;
+		MyProcPort->pool_key = NULL;
+	}
+
 	/*
 	 * Non-error queries loop here.
 	 */
 
 	for (;;)
 	{
+		bool		session_idle = false;
+
 		/*
 		 * At top of loop, reset extended-query-message flag, so that any
 		 * errors encountered in "idle" state don't provoke skip.
@@ -4169,6 +4192,8 @@ PostgresMain(int argc, char *argv[],
 
 				set_ps_display("idle", false);
 				pgstat_report_activity(STATE_IDLE, NULL);
+
+				session_idle = true;
 			}
 
 			ReadyForQuery(whereToSendOutput);
@@ -4183,6 +4208,19 @@ PostgresMain(int argc, char *argv[],
 		 */
 		DoingCommandRead = true;
 
+		/*
+		 * (2b) If the session is idle and holds no state a fresh backend
+		 * wouldn't have, hand it back to the connection pool until the client
+		 * sends its next query.  That may come to some other backend, while
+		 * we get to serve some other session.  The unnamed statement is not
+		 * kept across this.
+		 */
+		if (session_idle && SessionPoolCanReleaseSession())
+		{
+			drop_unnamed_stmt();
+			SessionPoolReleaseSession(true);
+		}
+
 		/*
 		 * (3) read a command (loop blocks here)
 		 */
@@ -4438,6 +4476,20 @@ PostgresMain(int argc, char *argv[],
 			case 'X':
 			case EOF:
 
+				/*
+				 * If nothing is left over from the session, stay around to
+				 * serve other sessions from the connection pool.  We're as
+				 * good as idle while waiting for one.
+				 */
+				if (SessionPoolCanReleaseSession())
+				{
+					drop_unnamed_stmt();
+					DoingCommandRead = true;
+					SessionPoolReleaseSession(false);
+					DoingCommandRead = false;
+					break;
+				}
+
 				/*
 				 * Reset whereToSendOutput to prevent ereport from attempting
 				 * to send any more messages to client.
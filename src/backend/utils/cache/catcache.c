@@ -29,6 +29,8 @@
 #include "storage/ipc.h"		/* for on_proc_exit */
 #endif
 #include "storage/lmgr.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/fmgroids.h"
@@ -37,6 +39,7 @@
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
+#include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
 
@@ -63,6 +66,81 @@
 /* Cache management header --- pointer is NULL until created */
 static CatCacheHeader *CacheHdr = NULL;
 
+/*
+ * Shared catalog cache
+ *
+ * Optionally, positive catcache entries are also kept in a hashtable in
+ * shared memory, which SearchCatCacheMiss consults before reading the
+ * catalog.  A backend that has to load an entry from the catalog enters it
+ * there for others to use.  The table is keyed by cache ID, the database the
+ * tuple belongs to (InvalidOid for shared catalogs) and the hash value of
+ * the search keys, the same triple that catcache invalidation messages
+ * carry.  Entries whose search keys collide on the hash value are not
+ * cached at all beyond the first.
+ *
+ * Coherency: SendSharedInvalidMessages removes the entries that a message
+ * invalidates before the message is queued, so a backend that has processed
+ * the message cannot see the stale entry any more.  That leaves a race with
+ * a backend that read the old version of the tuple from the catalog and
+ * enters it after the removal.  To close it, each partition has a
+ * generation counter that every removal advances.  A backend remembers the
+ * counter before reading the catalog, and enters the tuple only if the
+ * counter hasn't moved by then.  The catalog snapshot it reads with must
+ * also be newer than any removal that happened before that point; since
+ * taking a new snapshot on every miss would be costly, a global count of
+ * removals tells whether any happened since the backend last took one.
+ *
+ * Backends only use the shared cache when they can see exactly what is
+ * committed: not while the current transaction has an XID (it may have
+ * modified catalog rows), nor while a historic snapshot is active during
+ * logical decoding.
+ *
+ * Each entry has room for a tuple of SHARED_CATCACHE_MAX_TUPLE bytes;
+ * larger tuples are not shared.  The table has a fixed number of entries,
+ * set by shared_catalog_cache_entries; once it is full, nothing more is
+ * entered until invalidations remove some entries.
+ */
+#define SHARED_CATCACHE_MAX_TUPLE	512
+
+typedef struct SharedCatCacheKey
+{
+	int			cacheId;		/* catcache ID */
+	Oid			dbId;			/* database ID, or InvalidOid if shared */
+	uint32		hashValue;		/* hash value of the search keys */
+} SharedCatCacheKey;
+
+typedef struct SharedCatCacheEntry
+{
+	SharedCatCacheKey key;		/* hash key, must be first */
+	ItemPointerData t_self;		/* t_self of the cached tuple */
+	Oid			t_tableOid;		/* t_tableOid of the cached tuple */
+	uint32		t_len;			/* length of the cached tuple */
+	union
+	{
+		char		data[SHARED_CATCACHE_MAX_TUPLE];
+		double		force_align_d;
+		int64		force_align_i64;
+	}			tuple;			/* HeapTupleHeader of the cached tuple */
+} SharedCatCacheEntry;
+
+#define SharedCatCacheHashPartition(hashcode) \
+	((hashcode) % NUM_SHARED_CATCACHE_PARTITIONS)
+#define SharedCatCachePartitionLock(hashcode) \
+	(&MainLWLockArray[SHARED_CATCACHE_LWLOCK_OFFSET + \
+		SharedCatCacheHashPartition(hashcode)].lock)
+
+/* GUC variable */
+int			shared_catalog_cache_entries = 0;
+
+static HTAB *SharedCatCacheHash = NULL;
+
+/* Per-partition generation counters, protected by the partition locks */
+static uint64 *SharedCatCacheGenerations = NULL;
+
+/* Count of removals from all partitions, and its value last seen by us */
+static pg_atomic_uint64 *SharedCatCacheInvalidations = NULL;
+static uint64 SharedCatCacheSeenInvalidations = 0;
+
 static inline HeapTuple SearchCatCacheInternal(CatCache *cache,
 					   int nkeys,
 					   Datum v1, Datum v2,
@@ -96,6 +174,14 @@ static CatCTup *CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp,
 
 static void CatCacheFreeKeys(TupleDesc tupdesc, int nkeys, int *attnos,
 				 Datum *keys);
+static bool SharedCatCacheUsable(void);
+static void SharedCatCacheMakeKey(CatCache *cache, uint32 hashValue,
+					  SharedCatCacheKey *key);
+static HeapTuple SharedCatCacheLookup(CatCache *cache, int nkeys,
+					 uint32 hashValue, Datum *arguments,
+					 uint64 *generation);
+static void SharedCatCacheInsert(CatCache *cache, uint32 hashValue,
+					 HeapTuple tuple, uint64 generation);
 static void CatCacheCopyKeys(TupleDesc tupdesc, int nkeys, int *attnos,
 				 Datum *srckeys, Datum *dstkeys);
 
@@ -1322,6 +1408,8 @@ SearchCatCacheMiss(CatCache *cache,
 	HeapTuple	ntp;
 	CatCTup    *ct;
 	Datum		arguments[CATCACHE_MAXKEYS];
+	bool		useShared;
+	uint64		generation = 0;
 
 	/* Initialize local parameter array */
 	arguments[0] = v1;
@@ -1329,6 +1417,56 @@ SearchCatCacheMiss(CatCache *cache,
 	arguments[2] = v3;
 	arguments[3] = v4;
 
+	/*
+	 * If the shared catalog cache is enabled, look there first.  If the tuple
+	 * isn't there either, we'll enter what we read from the catalog, but
+	 * only if no invalidation of this partition of the shared cache happened
+	 * after this point.
+	 */
+	useShared = SharedCatCacheUsable();
+	if (useShared)
+	{
+		uint64		invalidations;
+
+		ntp = SharedCatCacheLookup(cache, nkeys, hashValue, arguments,
+								   &generation);
+		if (ntp != NULL)
+		{
+			ct = CatalogCacheCreateEntry(cache, ntp, arguments,
+										 hashValue, hashIndex,
+										 false);
+			heap_freetuple(ntp);
+			/* immediately set the refcount to 1 */
+			ResourceOwnerEnlargeCatCacheRefs(CurrentResourceOwner);
+			ct->refcount++;
+			ResourceOwnerRememberCatCacheRef(CurrentResourceOwner, &ct->tuple);
+
+			CACHE_elog(DEBUG2, "SearchCatCache(%s): found in shared cache",
+					   cache->cc_relname);
+#ifdef CATCACHE_STATS
+			cache->cc_newloads++;
+#endif
+			return &ct->tuple;
+		}
+
+		/*
+		 * We must also read what was committed at this point or later.  Our
+		 * catalog snapshot might predate a commit whose invalidation removed
+		 * the tuple before we looked, and then we'd enter the old version.
+		 * That invalidation would have been counted after the last time we
+		 * got here and discarded the snapshot, so unless the count moved
+		 * since then, the snapshot we have is new enough.  The count must be
+		 * read after the generation, so that it includes any invalidation
+		 * the generation does.
+		 */
+		invalidations = pg_atomic_read_u64(SharedCatCacheInvalidations);
+		if (invalidations != SharedCatCacheSeenInvalidations)
+		{
+			InvalidateCatalogSnapshot();
+			SharedCatCacheSeenInvalidations = invalidations;
+		}
+	}
+
 	/*
 	 * Ok, need to make a lookup in the relation, copy the scankey and fill
 	 * out any per-call fields.
@@ -1374,6 +1512,9 @@ SearchCatCacheMiss(CatCache *cache,
 		ResourceOwnerEnlargeCatCacheRefs(CurrentResourceOwner);
 		ct->refcount++;
 		ResourceOwnerRememberCatCacheRef(CurrentResourceOwner, &ct->tuple);
+		/* offer the (detoasted) tuple to other backends too */
+		if (useShared)
+			SharedCatCacheInsert(cache, hashValue, &ct->tuple, generation);
 		break;					/* assume only one match */
 	}
 
@@ -1425,6 +1566,267 @@ SearchCatCacheMiss(CatCache *cache,
 	return &ct->tuple;
 }
 
+/*
+ * SharedCatCacheShmemSize --- report amount of shared memory needed for the
+ * shared catalog cache
+ */
+Size
+SharedCatCacheShmemSize(void)
+{
+	Size		size;
+
+	if (shared_catalog_cache_entries <= 0)
+		return 0;
+
+	size = hash_estimate_size(shared_catalog_cache_entries,
+							  sizeof(SharedCatCacheEntry));
+	size = add_size(size, mul_size(NUM_SHARED_CATCACHE_PARTITIONS,
+								   sizeof(uint64)));
+	size = add_size(size, sizeof(pg_atomic_uint64));
+
+	return size;
+}
+
+/*
+ * SharedCatCacheShmemInit --- set up the shared catalog cache
+ */
+void
+SharedCatCacheShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (shared_catalog_cache_entries <= 0)
+		return;
+
+	SharedCatCacheGenerations = (uint64 *)
+		ShmemInitStruct("Shared Catalog Cache Generations",
+						NUM_SHARED_CATCACHE_PARTITIONS * sizeof(uint64),
+						&found);
+	if (!found)
+		memset(SharedCatCacheGenerations, 0,
+			   NUM_SHARED_CATCACHE_PARTITIONS * sizeof(uint64));
+
+	SharedCatCacheInvalidations = (pg_atomic_uint64 *)
+		ShmemInitStruct("Shared Catalog Cache Invalidations",
+						sizeof(pg_atomic_uint64),
+						&found);
+	if (!found)
+		pg_atomic_init_u64(SharedCatCacheInvalidations, 0);
+
+	info.keysize = sizeof(SharedCatCacheKey);
+	info.entrysize = sizeof(SharedCatCacheEntry);
+	info.num_partitions = NUM_SHARED_CATCACHE_PARTITIONS;
+
+	SharedCatCacheHash = ShmemInitHash("Shared Catalog Cache",
+									   shared_catalog_cache_entries,
+									   shared_catalog_cache_entries,
+									   &info,
+									   HASH_ELEM | HASH_BLOBS |
+									   HASH_PARTITION);
+}
+
+/*
+ * Can the shared catalog cache be used right now?  See the comments at the
+ * top of the file.
+ */
+static bool
+SharedCatCacheUsable(void)
+{
+	return SharedCatCacheHash != NULL &&
+		!IsBootstrapProcessingMode() &&
+		!HistoricSnapshotActive() &&
+		!TransactionIdIsValid(GetTopTransactionIdIfAny());
+}
+
+/*
+ * Build the shared catalog cache key for a tuple of the given cache
+ */
+static void
+SharedCatCacheMakeKey(CatCache *cache, uint32 hashValue,
+					  SharedCatCacheKey *key)
+{
+	key->cacheId = cache->id;
+	key->dbId = cache->cc_relisshared ? InvalidOid : MyDatabaseId;
+	key->hashValue = hashValue;
+}
+
+/*
+ * Look for a tuple in the shared catalog cache.
+ *
+ * Returns a palloc'd copy of the tuple if found.  Otherwise returns NULL
+ * and sets *generation to the generation of the partition the tuple belongs
+ * in, to be passed to SharedCatCacheInsert later.
+ */
+static HeapTuple
+SharedCatCacheLookup(CatCache *cache, int nkeys, uint32 hashValue,
+					 Datum *arguments, uint64 *generation)
+{
+	SharedCatCacheKey key;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	SharedCatCacheEntry *entry;
+	HeapTuple	result = NULL;
+
+	SharedCatCacheMakeKey(cache, hashValue, &key);
+	hashcode = get_hash_value(SharedCatCacheHash, &key);
+	partitionLock = SharedCatCachePartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_SHARED);
+	entry = (SharedCatCacheEntry *)
+		hash_search_with_hash_value(SharedCatCacheHash, &key, hashcode,
+									HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		HeapTupleData tuple;
+		Datum		keys[CATCACHE_MAXKEYS];
+		int			i;
+
+		tuple.t_len = entry->t_len;
+		tuple.t_self = entry->t_self;
+		tuple.t_tableOid = entry->t_tableOid;
+		tuple.t_data = (HeapTupleHeader) entry->tuple.data;
+
+		/* The entry may be for different keys with the same hash value */
+		for (i = 0; i < nkeys; i++)
+		{
+			bool		isnull;
+
+			keys[i] = heap_getattr(&tuple, cache->cc_keyno[i],
+								   cache->cc_tupdesc, &isnull);
+			Assert(!isnull);
+		}
+		if (CatalogCacheCompareTuple(cache, nkeys, keys, arguments))
+			result = heap_copytuple(&tuple);
+	}
+	*generation = SharedCatCacheGenerations[SharedCatCacheHashPartition(hashcode)];
+	LWLockRelease(partitionLock);
+
+	return result;
+}
+
+/*
+ * Enter a tuple read from the catalog into the shared catalog cache, unless
+ * its partition has been invalidated since the given generation, the tuple
+ * is too large, or the cache is full.
+ */
+static void
+SharedCatCacheInsert(CatCache *cache, uint32 hashValue, HeapTuple tuple,
+					 uint64 generation)
+{
+	SharedCatCacheKey key;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	SharedCatCacheEntry *entry;
+	bool		found;
+
+	if (tuple->t_len > SHARED_CATCACHE_MAX_TUPLE)
+		return;
+
+	/*
+	 * Don't let the table grow into the shared memory slack that other
+	 * shared hash tables rely on.  The count is read without locking all
+	 * partitions, so this is only approximate.
+	 */
+	if (hash_get_num_entries(SharedCatCacheHash) >= shared_catalog_cache_entries)
+		return;
+
+	SharedCatCacheMakeKey(cache, hashValue, &key);
+	hashcode = get_hash_value(SharedCatCacheHash, &key);
+	partitionLock = SharedCatCachePartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+	if (SharedCatCacheGenerations[SharedCatCacheHashPartition(hashcode)] ==
+		generation)
+	{
+		entry = (SharedCatCacheEntry *)
+			hash_search_with_hash_value(SharedCatCacheHash, &key, hashcode,
+										HASH_ENTER_NULL, &found);
+		if (entry != NULL && !found)
+		{
+			entry->t_self = tuple->t_self;
+			entry->t_tableOid = tuple->t_tableOid;
+			entry->t_len = tuple->t_len;
+			memcpy(entry->tuple.data, tuple->t_data, tuple->t_len);
+		}
+	}
+	LWLockRelease(partitionLock);
+}
+
+/*
+ * SharedCatCacheInvalidate
+ *
+ *	Remove the shared catalog cache entry matching a catcache invalidation
+ *	message, if there is one.  The partition's generation is advanced in any
+ *	case, so that a backend that has just read the old tuple from the catalog
+ *	doesn't enter it.
+ */
+void
+SharedCatCacheInvalidate(int cacheId, Oid dbId, uint32 hashValue)
+{
+	SharedCatCacheKey key;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+
+	if (SharedCatCacheHash == NULL)
+		return;
+
+	key.cacheId = cacheId;
+	key.dbId = dbId;
+	key.hashValue = hashValue;
+	hashcode = get_hash_value(SharedCatCacheHash, &key);
+	partitionLock = SharedCatCachePartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+	SharedCatCacheGenerations[SharedCatCacheHashPartition(hashcode)]++;
+	pg_atomic_fetch_add_u64(SharedCatCacheInvalidations, 1);
+	hash_search_with_hash_value(SharedCatCacheHash, &key, hashcode,
+								HASH_REMOVE, NULL);
+	LWLockRelease(partitionLock);
+}
+
+/*
+ * SharedCatCacheFlushDatabase
+ *
+ *	Remove all shared catalog cache entries of the given database (or of
+ *	shared catalogs, if dbId is InvalidOid).  This is used for invalidation
+ *	messages that cover a whole catalog, which are rare enough that we don't
+ *	bother to find out which caches are affected, and when a database is
+ *	dropped.
+ */
+void
+SharedCatCacheFlushDatabase(Oid dbId)
+{
+	HASH_SEQ_STATUS status;
+	SharedCatCacheEntry *entry;
+	int			i;
+
+	if (SharedCatCacheHash == NULL)
+		return;
+
+	/* Lock all partitions, in order, as in GetLockStatusData */
+	for (i = 0; i < NUM_SHARED_CATCACHE_PARTITIONS; i++)
+		LWLockAcquire(&MainLWLockArray[SHARED_CATCACHE_LWLOCK_OFFSET + i].lock,
+					  LW_EXCLUSIVE);
+
+	hash_seq_init(&status, SharedCatCacheHash);
+	while ((entry = (SharedCatCacheEntry *) hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.dbId != dbId)
+			continue;
+		if (hash_search(SharedCatCacheHash, &entry->key,
+						HASH_REMOVE, NULL) == NULL)
+			elog(ERROR, "shared catalog cache corrupted");
+	}
+
+	for (i = 0; i < NUM_SHARED_CATCACHE_PARTITIONS; i++)
+		SharedCatCacheGenerations[i]++;
+	pg_atomic_fetch_add_u64(SharedCatCacheInvalidations, 1);
+
+	for (i = NUM_SHARED_CATCACHE_PARTITIONS; --i >= 0;)
+		LWLockRelease(&MainLWLockArray[SHARED_CATCACHE_LWLOCK_OFFSET + i].lock);
+}
+
 /*
  *	ReleaseCatCache
  *
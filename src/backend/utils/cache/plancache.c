@@ -38,6 +38,9 @@
  * catalogs to be infrequent enough that more-detailed tracking is not worth
  * the effort.
  *
+ * Optionally, generic plans are also shared between backends through a
+ * cache in shared memory; see the comments for SharedPlanEntry below.
+ *
  * In addition to full-fledged query plans, we provide a facility for
  * detecting invalidations of simple scalar expressions.  This is fairly
  * bare-bones; it's the caller's responsibility to build a new expression
@@ -56,18 +59,30 @@
 
 #include <limits.h>
 
+#include "access/htup_details.h"
 #include "access/transam.h"
+#include "access/xact.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_class.h"
 #include "executor/executor.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/optimizer.h"
 #include "parser/analyze.h"
 #include "parser/parsetree.h"
+#include "storage/ipc.h"
 #include "storage/lmgr.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
 #include "tcop/pquery.h"
 #include "tcop/utility.h"
+#include "utils/builtins.h"
+#include "utils/dsa.h"
+#include "utils/guc.h"
+#include "utils/hashutils.h"
 #include "utils/inval.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/resowner_private.h"
 #include "utils/rls.h"
@@ -96,6 +111,104 @@ static dlist_head saved_plan_list = DLIST_STATIC_INIT(saved_plan_list);
  */
 static dlist_head cached_expression_list = DLIST_STATIC_INIT(cached_expression_list);
 
+/*
+ * Shared plan cache
+ *
+ * If shared_plan_cache_size is set, generic plans are also kept in shared
+ * memory, so that a backend that needs a generic plan for a query that some
+ * other backend has already planned can copy that plan instead of running
+ * the planner.  This is aimed at applications that prepare the same
+ * statements in many connections.
+ *
+ * Entries are keyed by the string form of the analyzed and rewritten query
+ * list, which identifies the objects the query refers to by OID and so
+ * covers both the query text and the search_path it was analyzed under.
+ * The key also includes the database, the current user, the cursor options
+ * and a hash of the settings that influence the planner.  For speed, the
+ * hashtable itself is keyed by a hash of the query string; the string is
+ * kept with the plan and compared on lookup.
+ *
+ * Plan trees are full of pointers, so they can't be used in place.  The
+ * query string and nodeToString() output of the plan are stored in a DSA
+ * area that lives in the main shared memory segment, and a backend that
+ * finds a plan there rebuilds it in local memory with stringToNode().  The
+ * local copy is then treated exactly like a plan made locally, including
+ * invalidation by PlanCacheRelCallback and friends.  A plan found in the
+ * cache comes without the locks the planner would have taken on the
+ * relations it added to the range table, such as the partitions and
+ * inheritance children of the tables in the query, so the backend takes
+ * them with AcquireExecutorLocks before using it, and plans afresh if the
+ * invalidations processed meanwhile show the plan to be stale.
+ *
+ * Each entry also remembers the relations and the other objects the plan
+ * depends on.  SendSharedInvalidMessages removes the entries affected by
+ * the invalidation messages it is about to send before queuing them, using
+ * the same rules as the local invalidation callbacks below, so a backend
+ * that has processed the messages can't find a stale plan any more.  To
+ * keep a backend that made its plan before the change from entering it
+ * afterwards, every such removal advances a generation counter, and so does
+ * SendSharedInvalidMessages again once the messages have been queued.  A
+ * backend remembers the generation before planning, then processes pending
+ * invalidation messages, and enters its plan only if the generation is still
+ * the same afterwards.
+ *
+ * Plans are not shared, in either direction, while the current transaction
+ * has an XID, since it may have made catalog changes nobody else can see.
+ * Plans referencing temporary tables, transient plans, plans containing
+ * nodes that can only be read back with an extension's help, and plans with
+ * more than SHARED_PLAN_MAX_DEPS dependencies of either kind aren't entered.
+ * Once the hashtable or the DSA area is full, the least recently used plans
+ * are evicted to make room for new ones.
+ */
+#define SHARED_PLAN_MAX_DEPS		32
+
+/* Number of hashtable entries per kilobyte of shared_plan_cache_size */
+#define SHARED_PLAN_KB_PER_ENTRY	4
+
+typedef struct SharedPlanKey
+{
+	Oid			dbId;			/* database the plan was made in */
+	Oid			roleId;			/* user the plan was made for */
+	int			cursorOptions;	/* cursor options of the plansource */
+	uint32		settingsHash;	/* GetPlannerSettingsHash() at planning */
+	uint32		queryHash;		/* hash of the query string */
+} SharedPlanKey;
+
+typedef struct SharedPlanEntry
+{
+	SharedPlanKey key;			/* hash key, must be first */
+	dsa_pointer data;			/* query string followed by plan string */
+	pg_atomic_uint64 lastUsed;	/* useCount when entered or last found */
+	Size		querylen;		/* length of query string, with terminator */
+	Size		planlen;		/* length of plan string, with terminator */
+	int			nrelations;		/* number of valid relationOids entries */
+	int			ninvalitems;	/* number of valid invalItems entries */
+	Oid			relationOids[SHARED_PLAN_MAX_DEPS];
+	struct
+	{
+		int			cacheId;
+		uint32		hashValue;
+	}			invalItems[SHARED_PLAN_MAX_DEPS];
+} SharedPlanEntry;
+
+typedef struct SharedPlanCacheControl
+{
+	LWLock		lock;			/* protects all of the shared plan cache */
+	uint64		generation;		/* advanced by invalidations */
+	pg_atomic_uint64 hits;		/* plans found, for pg_stat_get_shared_plans() */
+	pg_atomic_uint64 useCount;	/* advanced by every lookup and insertion */
+	/* the DSA area holding the query and plan strings follows */
+} SharedPlanCacheControl;
+
+#define SharedPlanCacheAreaPlace() \
+	((char *) SharedPlanCtl + MAXALIGN(sizeof(SharedPlanCacheControl)))
+
+static SharedPlanCacheControl *SharedPlanCtl = NULL;
+static HTAB *SharedPlanHash = NULL;
+
+/* This backend's attachment to the DSA area, made on first use */
+static dsa_area *SharedPlanArea = NULL;
+
 static void ReleaseGenericPlan(CachedPlanSource *plansource);
 static List *RevalidateCachedQuery(CachedPlanSource *plansource,
 					  QueryEnvironment *queryEnv);
@@ -114,9 +227,26 @@ static TupleDesc PlanCacheComputeResultDesc(List *stmt_list);
 static void PlanCacheRelCallback(Datum arg, Oid relid);
 static void PlanCacheObjectCallback(Datum arg, int cacheid, uint32 hashvalue);
 static void PlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue);
-
-/* GUC parameter */
+static Size SharedPlanCacheAreaSize(void);
+static int	SharedPlanCacheMaxEntries(void);
+static bool SharedPlanCacheUsable(CachedPlanSource *plansource,
+					  ParamListInfo boundParams, QueryEnvironment *queryEnv);
+static void SharedPlanCacheAttach(void);
+static List *SharedPlanCacheLookup(SharedPlanKey *key, const char *querystr,
+					  Size querylen, uint64 *generation);
+static void SharedPlanCacheInsert(SharedPlanKey *key, const char *querystr,
+					  Size querylen, CachedPlanSource *plansource,
+					  List *plist, uint64 generation);
+static uint64 SharedPlanCacheGeneration(void);
+static bool SharedPlanCacheEvictOne(void);
+static void SharedPlanCacheRemoveEntry(SharedPlanEntry *entry);
+static bool SharedPlanMessageIsRelevant(const SharedInvalidationMessage *msg);
+static bool SharedPlanEntryIsInvalidatedBy(SharedPlanEntry *entry,
+							   const SharedInvalidationMessage *msg);
+
+/* GUC parameters */
 int			plan_cache_mode;
+int			shared_plan_cache_size = 0;
 
 /*
  * InitPlanCache: initialize module during InitPostgres.
@@ -884,6 +1014,11 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	MemoryContext plan_context;
 	MemoryContext oldcxt = CurrentMemoryContext;
 	ListCell   *lc;
+	bool		useShared;
+	SharedPlanKey sharedKey;
+	char	   *sharedQuery = NULL;
+	Size		sharedQueryLen = 0;
+	uint64		sharedGeneration = 0;
 
 	/*
 	 * Normally the querytree should be valid already, but if it's not,
@@ -915,26 +1050,90 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	}
 
 	/*
-	 * If a snapshot is already set (the normal case), we can just use that
-	 * for planning.  But if it isn't, and we need one, install one.
+	 * If we're making a generic plan and the shared plan cache can be used,
+	 * see whether another backend has made this plan already.  If not, note
+	 * the cache's generation and then bring our caches up to date, so that
+	 * we can offer our plan to others afterwards; see the comments for
+	 * SharedPlanEntry.
 	 */
-	snapshot_set = false;
-	if (!ActiveSnapshotSet() &&
-		plansource->raw_parse_tree &&
-		analyze_requires_snapshot(plansource->raw_parse_tree))
+	plist = NIL;
+	useShared = SharedPlanCacheUsable(plansource, boundParams, queryEnv);
+	if (useShared)
 	{
-		PushActiveSnapshot(GetTransactionSnapshot());
-		snapshot_set = true;
+		sharedQuery = nodeToString(plansource->query_list);
+		sharedQueryLen = strlen(sharedQuery) + 1;
+		sharedKey.dbId = MyDatabaseId;
+		sharedKey.roleId = GetUserId();
+		sharedKey.cursorOptions = plansource->cursor_options;
+		sharedKey.settingsHash = GetPlannerSettingsHash();
+		sharedKey.queryHash = DatumGetUInt32(hash_any((unsigned char *) sharedQuery,
+													  sharedQueryLen - 1));
+		plist = SharedPlanCacheLookup(&sharedKey, sharedQuery, sharedQueryLen,
+									  &sharedGeneration);
+
+		/*
+		 * A plan from the cache hasn't been through our planner, which would
+		 * have locked the partitions and inheritance children it added to
+		 * the range table, so lock everything it uses now.  If the
+		 * invalidations processed while doing so removed the entry or made
+		 * our querytree obsolete, the plan can't be trusted; plan afresh,
+		 * and don't offer the result to others, since our key may be stale.
+		 */
+		if (plist != NIL)
+		{
+			AcquireExecutorLocks(plist, true);
+			if (!plansource->is_valid ||
+				SharedPlanCacheGeneration() != sharedGeneration)
+			{
+				AcquireExecutorLocks(plist, false);
+				plist = NIL;
+				useShared = false;
+				if (!plansource->is_valid)
+				{
+					List	   *newqlist = RevalidateCachedQuery(plansource,
+																 queryEnv);
+
+					if (newqlist != NIL)
+						qlist = newqlist;
+				}
+			}
+		}
+		else
+			AcceptInvalidationMessages();
 	}
 
-	/*
-	 * Generate the plan.
-	 */
-	plist = pg_plan_queries(qlist, plansource->cursor_options, boundParams);
+	if (plist == NIL)
+	{
+		/*
+		 * If a snapshot is already set (the normal case), we can just use
+		 * that for planning.  But if it isn't, and we need one, install one.
+		 */
+		snapshot_set = false;
+		if (!ActiveSnapshotSet() &&
+			plansource->raw_parse_tree &&
+			analyze_requires_snapshot(plansource->raw_parse_tree))
+		{
+			PushActiveSnapshot(GetTransactionSnapshot());
+			snapshot_set = true;
+		}
 
-	/* Release snapshot if we got one */
-	if (snapshot_set)
-		PopActiveSnapshot();
+		/*
+		 * Generate the plan.
+		 */
+		plist = pg_plan_queries(qlist, plansource->cursor_options, boundParams);
+
+		/* Release snapshot if we got one */
+		if (snapshot_set)
+			PopActiveSnapshot();
+
+		/*
+		 * Offer the plan to other backends, unless the invalidation messages
+		 * we processed above made our querytree obsolete.
+		 */
+		if (useShared && plansource->is_valid)
+			SharedPlanCacheInsert(&sharedKey, sharedQuery, sharedQueryLen,
+								  plansource, plist, sharedGeneration);
+	}
 
 	/*
 	 * Normally we make a dedicated memory context for the CachedPlan and its
@@ -2022,3 +2221,584 @@ ResetPlanCache(void)
 		cexpr->is_valid = false;
 	}
 }
+
+/*
+ * Size of the DSA area holding the shared plan cache's strings
+ */
+static Size
+SharedPlanCacheAreaSize(void)
+{
+	return Max(mul_size((Size) shared_plan_cache_size, 1024),
+			   dsa_minimum_size());
+}
+
+/*
+ * Maximum number of entries in the shared plan cache
+ */
+static int
+SharedPlanCacheMaxEntries(void)
+{
+	return Max(shared_plan_cache_size / SHARED_PLAN_KB_PER_ENTRY, 64);
+}
+
+/*
+ * SharedPlanCacheShmemSize --- report amount of shared memory needed for the
+ * shared plan cache
+ */
+Size
+SharedPlanCacheShmemSize(void)
+{
+	Size		size;
+
+	if (shared_plan_cache_size <= 0)
+		return 0;
+
+	size = MAXALIGN(sizeof(SharedPlanCacheControl));
+	size = add_size(size, SharedPlanCacheAreaSize());
+	size = add_size(size, hash_estimate_size(SharedPlanCacheMaxEntries(),
+											 sizeof(SharedPlanEntry)));
+
+	return size;
+}
+
+/*
+ * SharedPlanCacheShmemInit --- set up the shared plan cache
+ */
+void
+SharedPlanCacheShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (shared_plan_cache_size <= 0)
+		return;
+
+	SharedPlanCtl = (SharedPlanCacheControl *)
+		ShmemInitStruct("Shared Plan Cache",
+						add_size(MAXALIGN(sizeof(SharedPlanCacheControl)),
+								 SharedPlanCacheAreaSize()),
+						&found);
+	if (!found)
+	{
+		dsa_area   *area;
+
+		LWLockInitialize(&SharedPlanCtl->lock, LWTRANCHE_SHARED_PLAN_CACHE);
+		SharedPlanCtl->generation = 0;
+		pg_atomic_init_u64(&SharedPlanCtl->hits, 0);
+		pg_atomic_init_u64(&SharedPlanCtl->useCount, 0);
+
+		/*
+		 * Create the DSA area, and don't let it create DSM segments beyond
+		 * the space reserved here.  The creator's reference is never
+		 * released, which keeps the area alive however backends come and
+		 * go.  Backends attach to it themselves when they first need it, so
+		 * we don't keep the creator's backend-local handle.
+		 */
+		area = dsa_create_in_place(SharedPlanCacheAreaPlace(),
+								   SharedPlanCacheAreaSize(),
+								   LWTRANCHE_SHARED_PLAN_CACHE, NULL);
+		dsa_set_size_limit(area, SharedPlanCacheAreaSize());
+		dsa_detach(area);
+	}
+
+	info.keysize = sizeof(SharedPlanKey);
+	info.entrysize = sizeof(SharedPlanEntry);
+
+	SharedPlanHash = ShmemInitHash("Shared Plan Cache Index",
+								   SharedPlanCacheMaxEntries(),
+								   SharedPlanCacheMaxEntries(),
+								   &info,
+								   HASH_ELEM | HASH_BLOBS);
+}
+
+/*
+ * Can the shared plan cache be used for making a plan for the given
+ * plansource?  See the comments for SharedPlanEntry.
+ */
+static bool
+SharedPlanCacheUsable(CachedPlanSource *plansource,
+					  ParamListInfo boundParams, QueryEnvironment *queryEnv)
+{
+	ListCell   *lc;
+
+	if (SharedPlanCtl == NULL)
+		return false;
+
+	/* Only generic plans of saved plansources are shared */
+	if (boundParams != NULL || !plansource->is_saved ||
+		plansource->is_oneshot || queryEnv != NULL)
+		return false;
+
+	if (TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		return false;
+
+	/* Utility statements aren't planned, and can't always be serialized */
+	foreach(lc, plansource->query_list)
+	{
+		Query	   *query = lfirst_node(Query, lc);
+
+		if (query->commandType == CMD_UTILITY)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Attach to the shared plan cache's DSA area, if not done yet
+ */
+static void
+SharedPlanCacheAttach(void)
+{
+	MemoryContext oldcxt;
+
+	if (SharedPlanArea != NULL)
+		return;
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	SharedPlanArea = dsa_attach_in_place(SharedPlanCacheAreaPlace(), NULL);
+	MemoryContextSwitchTo(oldcxt);
+
+	on_shmem_exit(dsa_on_shmem_exit_release_in_place,
+				  PointerGetDatum(SharedPlanCacheAreaPlace()));
+}
+
+/*
+ * Look for a plan in the shared plan cache.
+ *
+ * Returns the plan's statement list, rebuilt in the current memory context,
+ * if found.  Otherwise returns NIL and sets *generation to the cache's
+ * generation, to be passed to SharedPlanCacheInsert later.
+ */
+static List *
+SharedPlanCacheLookup(SharedPlanKey *key, const char *querystr,
+					  Size querylen, uint64 *generation)
+{
+	SharedPlanEntry *entry;
+	char	   *planstr = NULL;
+	List	   *plist;
+
+	SharedPlanCacheAttach();
+
+	LWLockAcquire(&SharedPlanCtl->lock, LW_SHARED);
+	entry = (SharedPlanEntry *) hash_search(SharedPlanHash, key,
+											HASH_FIND, NULL);
+	if (entry != NULL && entry->querylen == querylen)
+	{
+		char	   *data = dsa_get_address(SharedPlanArea, entry->data);
+
+		/* The entry may be for a different query with the same hash */
+		if (memcmp(data, querystr, querylen) == 0)
+		{
+			planstr = palloc(entry->planlen);
+			memcpy(planstr, data + querylen, entry->planlen);
+			pg_atomic_write_u64(&entry->lastUsed,
+								pg_atomic_fetch_add_u64(&SharedPlanCtl->useCount, 1));
+		}
+	}
+	*generation = SharedPlanCtl->generation;
+	LWLockRelease(&SharedPlanCtl->lock);
+
+	if (planstr == NULL)
+		return NIL;
+
+	pg_atomic_fetch_add_u64(&SharedPlanCtl->hits, 1);
+	plist = (List *) stringToNode(planstr);
+	pfree(planstr);
+
+	return plist;
+}
+
+/*
+ * Enter a plan we have made into the shared plan cache, unless an
+ * invalidation happened since the given generation, or the plan isn't
+ * suitable for sharing.  If the cache is full, the least recently used
+ * plans are evicted to make room.
+ */
+static void
+SharedPlanCacheInsert(SharedPlanKey *key, const char *querystr,
+					  Size querylen, CachedPlanSource *plansource,
+					  List *plist, uint64 generation)
+{
+	List	   *relationOids;
+	List	   *invalItems;
+	char	   *planstr;
+	Size		planlen;
+	dsa_pointer dp;
+	char	   *data;
+	SharedPlanEntry *entry;
+	bool		found;
+	ListCell   *lc;
+
+	/* Collect the dependencies of both the querytree and the plan */
+	relationOids = list_copy(plansource->relationOids);
+	invalItems = list_copy(plansource->invalItems);
+	foreach(lc, plist)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+
+		if (plannedstmt->transientPlan)
+			return;
+		relationOids = list_concat_unique_oid(relationOids,
+											  plannedstmt->relationOids);
+		invalItems = list_concat(invalItems,
+								 list_copy(plannedstmt->invalItems));
+	}
+	if (list_length(relationOids) > SHARED_PLAN_MAX_DEPS ||
+		list_length(invalItems) > SHARED_PLAN_MAX_DEPS)
+		return;
+
+	/* Temporary tables are private to this backend */
+	foreach(lc, relationOids)
+	{
+		if (get_rel_persistence(lfirst_oid(lc)) == RELPERSISTENCE_TEMP)
+			return;
+	}
+
+	/*
+	 * A backend can only read back custom scans and extensible nodes if it
+	 * has loaded the extension providing them, so don't share such plans.
+	 */
+	planstr = nodeToString(plist);
+	if (strstr(planstr, "{CUSTOMSCAN ") != NULL ||
+		strstr(planstr, "{EXTENSIBLENODE ") != NULL)
+		return;
+	planlen = strlen(planstr) + 1;
+	if (querylen + planlen > MaxAllocSize)
+		return;
+
+	/*
+	 * Make room in the DSA area by evicting plans, unless an invalidation
+	 * has already made ours unwelcome.  Give up if even an empty area has
+	 * no room for it.
+	 */
+	SharedPlanCacheAttach();
+	for (;;)
+	{
+		bool		evicted;
+
+		dp = dsa_allocate_extended(SharedPlanArea, querylen + planlen,
+								   DSA_ALLOC_NO_OOM);
+		if (DsaPointerIsValid(dp))
+			break;
+
+		LWLockAcquire(&SharedPlanCtl->lock, LW_EXCLUSIVE);
+		evicted = SharedPlanCtl->generation == generation &&
+			SharedPlanCacheEvictOne();
+		LWLockRelease(&SharedPlanCtl->lock);
+		if (!evicted)
+			return;
+	}
+	data = dsa_get_address(SharedPlanArea, dp);
+	memcpy(data, querystr, querylen);
+	memcpy(data + querylen, planstr, planlen);
+
+	LWLockAcquire(&SharedPlanCtl->lock, LW_EXCLUSIVE);
+	if (SharedPlanCtl->generation == generation)
+	{
+		if (hash_get_num_entries(SharedPlanHash) >= SharedPlanCacheMaxEntries() &&
+			hash_search(SharedPlanHash, key, HASH_FIND, NULL) == NULL)
+			(void) SharedPlanCacheEvictOne();
+
+		entry = (SharedPlanEntry *) hash_search(SharedPlanHash, key,
+												HASH_ENTER_NULL, &found);
+		if (entry != NULL && !found)
+		{
+			entry->data = dp;
+			pg_atomic_init_u64(&entry->lastUsed,
+							   pg_atomic_fetch_add_u64(&SharedPlanCtl->useCount, 1));
+			entry->querylen = querylen;
+			entry->planlen = planlen;
+			entry->nrelations = 0;
+			foreach(lc, relationOids)
+				entry->relationOids[entry->nrelations++] = lfirst_oid(lc);
+			entry->ninvalitems = 0;
+			foreach(lc, invalItems)
+			{
+				PlanInvalItem *item = (PlanInvalItem *) lfirst(lc);
+
+				entry->invalItems[entry->ninvalitems].cacheId = item->cacheId;
+				entry->invalItems[entry->ninvalitems].hashValue = item->hashValue;
+				entry->ninvalitems++;
+			}
+			dp = InvalidDsaPointer;
+		}
+	}
+	LWLockRelease(&SharedPlanCtl->lock);
+
+	/* Free our copy if it didn't make it into the cache */
+	if (DsaPointerIsValid(dp))
+		dsa_free(SharedPlanArea, dp);
+}
+
+/*
+ * Return the shared plan cache's current generation
+ */
+static uint64
+SharedPlanCacheGeneration(void)
+{
+	uint64		generation;
+
+	LWLockAcquire(&SharedPlanCtl->lock, LW_SHARED);
+	generation = SharedPlanCtl->generation;
+	LWLockRelease(&SharedPlanCtl->lock);
+
+	return generation;
+}
+
+/*
+ * Evict the least recently used plan from the shared plan cache.  Returns
+ * false if the cache is empty.  Caller must hold the lock exclusively.
+ *
+ * This scans the whole hashtable, but it is only done when a new plan is
+ * entered into a full cache, which is rare compared to lookups.
+ */
+static bool
+SharedPlanCacheEvictOne(void)
+{
+	HASH_SEQ_STATUS status;
+	SharedPlanEntry *entry;
+	SharedPlanEntry *victim = NULL;
+	uint64		victimLastUsed = 0;
+
+	hash_seq_init(&status, SharedPlanHash);
+	while ((entry = (SharedPlanEntry *) hash_seq_search(&status)) != NULL)
+	{
+		uint64		lastUsed = pg_atomic_read_u64(&entry->lastUsed);
+
+		if (victim == NULL || lastUsed < victimLastUsed)
+		{
+			victim = entry;
+			victimLastUsed = lastUsed;
+		}
+	}
+
+	if (victim == NULL)
+		return false;
+
+	SharedPlanCacheRemoveEntry(victim);
+	return true;
+}
+
+/*
+ * Remove an entry from the shared plan cache.  Caller must hold the lock
+ * exclusively.
+ */
+static void
+SharedPlanCacheRemoveEntry(SharedPlanEntry *entry)
+{
+	dsa_free(SharedPlanArea, entry->data);
+	if (hash_search(SharedPlanHash, &entry->key, HASH_REMOVE, NULL) == NULL)
+		elog(ERROR, "shared plan cache corrupted");
+}
+
+/*
+ * Could the given invalidation message invalidate any plan?  This follows
+ * the callbacks registered by InitPlanCache.
+ */
+static bool
+SharedPlanMessageIsRelevant(const SharedInvalidationMessage *msg)
+{
+	if (msg->id >= 0)
+	{
+		switch (msg->cc.id)
+		{
+			case PROCOID:
+			case TYPEOID:
+			case NAMESPACEOID:
+			case OPEROID:
+			case AMOPOPID:
+			case FOREIGNSERVEROID:
+			case FOREIGNDATAWRAPPEROID:
+				return true;
+			default:
+				return false;
+		}
+	}
+	return msg->id == SHAREDINVALCATALOG_ID ||
+		msg->id == SHAREDINVALRELCACHE_ID;
+}
+
+/*
+ * Does the given invalidation message invalidate the given shared plan?
+ * This mirrors PlanCacheRelCallback, PlanCacheObjectCallback and
+ * PlanCacheSysCallback.  Messages that flush whole catalogs aren't worth
+ * tracking in detail; they invalidate all plans of the database.
+ */
+static bool
+SharedPlanEntryIsInvalidatedBy(SharedPlanEntry *entry,
+							   const SharedInvalidationMessage *msg)
+{
+	int			i;
+
+	if (msg->id >= 0)
+	{
+		if (msg->cc.dbId != InvalidOid && msg->cc.dbId != entry->key.dbId)
+			return false;
+		switch (msg->cc.id)
+		{
+			case PROCOID:
+			case TYPEOID:
+				for (i = 0; i < entry->ninvalitems; i++)
+				{
+					if (entry->invalItems[i].cacheId == msg->cc.id &&
+						(msg->cc.hashValue == 0 ||
+						 entry->invalItems[i].hashValue == msg->cc.hashValue))
+						return true;
+				}
+				return false;
+			case NAMESPACEOID:
+			case OPEROID:
+			case AMOPOPID:
+			case FOREIGNSERVEROID:
+			case FOREIGNDATAWRAPPEROID:
+				return true;
+			default:
+				return false;
+		}
+	}
+	else if (msg->id == SHAREDINVALCATALOG_ID)
+	{
+		return msg->cat.dbId == InvalidOid || msg->cat.dbId == entry->key.dbId;
+	}
+	else if (msg->id == SHAREDINVALRELCACHE_ID)
+	{
+		if (msg->rc.dbId != InvalidOid && msg->rc.dbId != entry->key.dbId)
+			return false;
+		if (msg->rc.relId == InvalidOid)
+			return true;
+		for (i = 0; i < entry->nrelations; i++)
+		{
+			if (entry->relationOids[i] == msg->rc.relId)
+				return true;
+		}
+		return false;
+	}
+	return false;
+}
+
+/*
+ * SharedPlanCacheInvalidate
+ *
+ *	Remove the shared plan cache entries invalidated by a batch of
+ *	invalidation messages that are about to be sent.  Returns true if any of
+ *	the messages could affect a plan; the caller must then call
+ *	SharedPlanCacheAdvanceGeneration once the messages have been queued.
+ */
+bool
+SharedPlanCacheInvalidate(const SharedInvalidationMessage *msgs, int n)
+{
+	HASH_SEQ_STATUS status;
+	SharedPlanEntry *entry;
+	bool		relevant = false;
+	int			i;
+
+	if (SharedPlanCtl == NULL)
+		return false;
+
+	/* Most messages are of no interest; don't take the lock for those */
+	for (i = 0; i < n && !relevant; i++)
+		relevant = SharedPlanMessageIsRelevant(&msgs[i]);
+	if (!relevant)
+		return false;
+
+	SharedPlanCacheAttach();
+
+	LWLockAcquire(&SharedPlanCtl->lock, LW_EXCLUSIVE);
+	SharedPlanCtl->generation++;
+	hash_seq_init(&status, SharedPlanHash);
+	while ((entry = (SharedPlanEntry *) hash_seq_search(&status)) != NULL)
+	{
+		for (i = 0; i < n; i++)
+		{
+			if (SharedPlanEntryIsInvalidatedBy(entry, &msgs[i]))
+			{
+				SharedPlanCacheRemoveEntry(entry);
+				break;
+			}
+		}
+	}
+	LWLockRelease(&SharedPlanCtl->lock);
+
+	return true;
+}
+
+/*
+ * SharedPlanCacheAdvanceGeneration
+ *
+ *	Keep backends that made a plan before invalidation messages were queued,
+ *	but noted the generation after SharedPlanCacheInvalidate removed the
+ *	entries, from entering that plan.
+ */
+void
+SharedPlanCacheAdvanceGeneration(void)
+{
+	if (SharedPlanCtl == NULL)
+		return;
+
+	LWLockAcquire(&SharedPlanCtl->lock, LW_EXCLUSIVE);
+	SharedPlanCtl->generation++;
+	LWLockRelease(&SharedPlanCtl->lock);
+}
+
+/*
+ * SharedPlanCacheFlushDatabase
+ *
+ *	Remove all shared plan cache entries of the given database.  This is
+ *	used when a database is dropped.
+ */
+void
+SharedPlanCacheFlushDatabase(Oid dbId)
+{
+	HASH_SEQ_STATUS status;
+	SharedPlanEntry *entry;
+
+	if (SharedPlanCtl == NULL)
+		return;
+
+	SharedPlanCacheAttach();
+
+	LWLockAcquire(&SharedPlanCtl->lock, LW_EXCLUSIVE);
+	SharedPlanCtl->generation++;
+	hash_seq_init(&status, SharedPlanHash);
+	while ((entry = (SharedPlanEntry *) hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.dbId == dbId)
+			SharedPlanCacheRemoveEntry(entry);
+	}
+	LWLockRelease(&SharedPlanCtl->lock);
+}
+
+/*
+ * pg_stat_get_shared_plans
+ *		Report the state of the shared plan cache
+ *
+ * Returns the number of plans in the cache and the number of times a plan
+ * was found there since server start, or nulls if the cache is disabled.
+ */
+Datum
+pg_stat_get_shared_plans(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_SHARED_PLANS_COLS 2
+	TupleDesc	tupdesc;
+	Datum		values[PG_STAT_GET_SHARED_PLANS_COLS];
+	bool		nulls[PG_STAT_GET_SHARED_PLANS_COLS];
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	if (SharedPlanCtl == NULL)
+	{
+		MemSet(nulls, true, sizeof(nulls));
+	}
+	else
+	{
+		MemSet(nulls, 0, sizeof(nulls));
+		LWLockAcquire(&SharedPlanCtl->lock, LW_SHARED);
+		values[0] = Int64GetDatum(hash_get_num_entries(SharedPlanHash));
+		LWLockRelease(&SharedPlanCtl->lock);
+		values[1] = Int64GetDatum((int64) pg_atomic_read_u64(&SharedPlanCtl->hits));
+	}
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -33,6 +33,7 @@ volatile sig_atomic_t ProcDiePending = false;
 volatile sig_atomic_t ClientConnectionLost = false;
 volatile sig_atomic_t IdleInTransactionSessionTimeoutPending = false;
 volatile sig_atomic_t ConfigReloadPending = false;
+volatile sig_atomic_t ProcSignalBarrierPending = false;
 volatile uint32 InterruptHoldoffCount = 0;
 volatile uint32 QueryCancelHoldoffCount = 0;
 volatile uint32 CritSectionCount = 0;
@@ -110,6 +111,9 @@ bool		IsUnderPostmaster = false;
 bool		IsBinaryUpgrade = false;
 bool		IsBackgroundWorker = false;
 
+/* Set once a pre-forked backend has run PreInitPostgres */
+bool		BackendPreinitialized = false;
+
 bool		ExitOnAnyError = false;
 
 int			DateStyle = USE_ISO_DATES;
@@ -127,13 +131,33 @@ int			max_parallel_maintenance_workers = 2;
  *
  * MaxBackends is computed by PostmasterMain after modules have had a chance to
  * register background workers.
+ *
+ * NBuffers is the current size of the shared buffer pool.  It starts out
+ * as the shared_buffers setting, RequestedNBuffers, but after that it only
+ * changes when the background writer resizes the pool; see
+ * ResizeBufferPool().
+ * MaxNBuffers is the size the pool's memory was reserved for.
  */
 int			NBuffers = 1000;
+int			RequestedNBuffers = 1000;
+int			MaxNBuffers = 1000;
 int			MaxConnections = 90;
 int			max_worker_processes = 8;
 int			max_parallel_workers = 8;
 int			MaxBackends = 0;
 
+/*
+ * Number of buffers of each SLRU cache.  For those that default to 0, the
+ * size is derived from shared_buffers instead.
+ */
+int			transaction_buffers = 0;
+int			subtransaction_buffers = 0;
+int			multixact_offset_buffers = 16;
+int			multixact_member_buffers = 32;
+int			commit_timestamp_buffers = 0;
+int			notify_buffers = 16;
+int			serializable_buffers = 32;
+
 int			VacuumCostPageHit = 1;	/* GUC parameters for vacuum */
 int			VacuumCostPageMiss = 10;
 int			VacuumCostPageDirty = 20;
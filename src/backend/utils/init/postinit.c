@@ -69,6 +69,7 @@ static HeapTuple GetDatabaseTupleByOid(Oid dboid);
 static void PerformAuthentication(Port *port);
 static void CheckMyDatabase(const char *name, bool am_superuser, bool override_allow_connections);
 static void InitCommunication(void);
+static void InitPostgresEarly(void);
 static void ShutdownPostgres(int code, Datum arg);
 static void StatementTimeoutHandler(void);
 static void LockTimeoutHandler(void);
@@ -234,16 +235,18 @@ PerformAuthentication(Port *port)
 	enable_timeout_after(STATEMENT_TIMEOUT, AuthenticationTimeout * 1000);
 
 	/*
-	 * Now perform authentication exchange.
+	 * Now perform authentication exchange.  A session handed over by the
+	 * connection pool was authenticated by the backend that accepted it.
 	 */
-	ClientAuthentication(port); /* might not return, if failure */
+	if (port->pool_key == NULL)
+		ClientAuthentication(port); /* might not return, if failure */
 
 	/*
 	 * Done with authentication.  Disable the timeout, and log if needed.
 	 */
 	disable_timeout(STATEMENT_TIMEOUT, false);
 
-	if (Log_connections)
+	if (Log_connections && port->pool_key == NULL)
 	{
 		if (am_walsender)
 		{
@@ -560,41 +563,37 @@ BaseInit(void)
 }
 
 
-/* --------------------------------
- * InitPostgres
- *		Initialize POSTGRES.
- *
- * The database can be specified by name, using the in_dbname parameter, or by
- * OID, using the dboid parameter.  In the latter case, the actual database
- * name can be returned to the caller in out_dbname.  If out_dbname isn't
- * NULL, it must point to a buffer of size NAMEDATALEN.
- *
- * Similarly, the username can be passed by name, using the username parameter,
- * or by OID using the useroid parameter.
- *
- * In bootstrap mode no parameters are used.  The autovacuum launcher process
- * doesn't use any parameters either, because it only goes far enough to be
- * able to read pg_database; it doesn't connect to any particular database.
- * In walsender mode only username is used.
- *
- * As of PostgreSQL 8.2, we expect InitProcess() was already called, so we
- * already have a PGPROC struct ... but it's not completely filled in yet.
+/*
+ * PreInitPostgres
+ *		Initialize a backend as far as that can go before it knows which
+ *		database it is to connect to.
  *
- * Note:
- *		Be very careful with the order of calls in the InitPostgres function.
- * --------------------------------
+ * A pre-forked backend calls this while it waits for the postmaster to pass
+ * it a connection; BaseInit, InitProcess and the first part of InitPostgres
+ * are then skipped once it has one.  The backend joins the ProcArray and the
+ * shared-invalidation queue here, so from now on it has to absorb the
+ * invalidations sent to it.
  */
 void
-InitPostgres(const char *in_dbname, Oid dboid, const char *username,
-			 Oid useroid, char *out_dbname, bool override_allow_connections)
+PreInitPostgres(void)
 {
-	bool		bootstrap = IsBootstrapProcessingMode();
-	bool		am_superuser;
-	char	   *fullpath;
-	char		dbname[NAMEDATALEN];
+	Assert(IsUnderPostmaster && !BackendPreinitialized);
 
-	elog(DEBUG3, "InitPostgres");
+	BaseInit();
+	InitProcess();
+	InitPostgresEarly();
+
+	BackendPreinitialized = true;
+}
 
+/*
+ * InitPostgresEarly
+ *		The first part of InitPostgres, up to loading the shared catalogs'
+ *		relcache entries.  None of it depends on the database or user.
+ */
+static void
+InitPostgresEarly(void)
+{
 	/*
 	 * Add my PGPROC struct to the ProcArray.
 	 *
@@ -618,19 +617,6 @@ InitPostgres(const char *in_dbname, Oid dboid, const char *username,
 	/* Now that we have a BackendId, we can participate in ProcSignal */
 	ProcSignalInit(MyBackendId);
 
-	/*
-	 * Also set up timeout handlers needed for backend operation.  We need
-	 * these in every case except bootstrap.
-	 */
-	if (!bootstrap)
-	{
-		RegisterTimeout(DEADLOCK_TIMEOUT, CheckDeadLockAlert);
-		RegisterTimeout(STATEMENT_TIMEOUT, StatementTimeoutHandler);
-		RegisterTimeout(LOCK_TIMEOUT, LockTimeoutHandler);
-		RegisterTimeout(IDLE_IN_TRANSACTION_SESSION_TIMEOUT,
-						IdleInTransactionSessionTimeoutHandler);
-	}
-
 	/*
 	 * bufmgr needs another initialization call too
 	 */
@@ -685,7 +671,7 @@ InitPostgres(const char *in_dbname, Oid dboid, const char *username,
 	EnablePortalManager();
 
 	/* Initialize stats collection --- must happen before first xact */
-	if (!bootstrap)
+	if (!IsBootstrapProcessingMode())
 		pgstat_initialize();
 
 	/*
@@ -703,6 +689,64 @@ InitPostgres(const char *in_dbname, Oid dboid, const char *username,
 	 * entirely possible, we need the AbortTransaction call to clean up.
 	 */
 	before_shmem_exit(ShutdownPostgres, 0);
+}
+
+/* --------------------------------
+ * InitPostgres
+ *		Initialize POSTGRES.
+ *
+ * The database can be specified by name, using the in_dbname parameter, or by
+ * OID, using the dboid parameter.  In the latter case, the actual database
+ * name can be returned to the caller in out_dbname.  If out_dbname isn't
+ * NULL, it must point to a buffer of size NAMEDATALEN.
+ *
+ * Similarly, the username can be passed by name, using the username parameter,
+ * or by OID using the useroid parameter.
+ *
+ * In bootstrap mode no parameters are used.  The autovacuum launcher process
+ * doesn't use any parameters either, because it only goes far enough to be
+ * able to read pg_database; it doesn't connect to any particular database.
+ * In walsender mode only username is used.
+ *
+ * As of PostgreSQL 8.2, we expect InitProcess() was already called, so we
+ * already have a PGPROC struct ... but it's not completely filled in yet.
+ *
+ * Note:
+ *		Be very careful with the order of calls in the InitPostgres function.
+ * --------------------------------
+ */
+void
+InitPostgres(const char *in_dbname, Oid dboid, const char *username,
+			 Oid useroid, char *out_dbname, bool override_allow_connections)
+{
+	bool		bootstrap = IsBootstrapProcessingMode();
+	bool		am_superuser;
+	char	   *fullpath;
+	char		dbname[NAMEDATALEN];
+
+	elog(DEBUG3, "InitPostgres");
+
+	/*
+	 * Do the part that doesn't depend on the database, unless a pre-forked
+	 * backend did it already.
+	 */
+	if (!BackendPreinitialized)
+		InitPostgresEarly();
+
+	/*
+	 * Also set up timeout handlers needed for backend operation.  We need
+	 * these in every case except bootstrap.  A pre-forked backend can't have
+	 * done this ahead of time, since BackendInitialize resets the timeout
+	 * module.
+	 */
+	if (!bootstrap)
+	{
+		RegisterTimeout(DEADLOCK_TIMEOUT, CheckDeadLockAlert);
+		RegisterTimeout(STATEMENT_TIMEOUT, StatementTimeoutHandler);
+		RegisterTimeout(LOCK_TIMEOUT, LockTimeoutHandler);
+		RegisterTimeout(IDLE_IN_TRANSACTION_SESSION_TIMEOUT,
+						IdleInTransactionSessionTimeoutHandler);
+	}
 
 	/* The autovacuum launcher is done here */
 	if (IsAutoVacuumLauncherProcess())
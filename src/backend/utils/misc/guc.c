@@ -29,6 +29,7 @@
 #include "access/commit_ts.h"
 #include "access/gin.h"
 #include "access/rmgr.h"
+#include "access/slru.h"
 #include "access/tableam.h"
 #include "access/transam.h"
 #include "access/twophase.h"
@@ -63,6 +64,7 @@
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/bgwriter.h"
 #include "postmaster/postmaster.h"
+#include "postmaster/sessionpool.h"
 #include "postmaster/syslogger.h"
 #include "postmaster/walwriter.h"
 #include "replication/logicallauncher.h"
@@ -78,12 +80,16 @@
 #include "storage/pg_shmem.h"
 #include "storage/proc.h"
 #include "storage/predicate.h"
+#include "storage/sinvaladt.h"
+#include "storage/smgr.h"
 #include "tcop/tcopprot.h"
 #include "tsearch/ts_cache.h"
 #include "utils/builtins.h"
 #include "utils/bytea.h"
+#include "utils/catcache.h"
 #include "utils/guc_tables.h"
 #include "utils/float.h"
+#include "utils/hashutils.h"
 #include "utils/memutils.h"
 #include "utils/pg_locale.h"
 #include "utils/pg_lsn.h"
@@ -186,11 +192,26 @@ static const char *show_tcp_keepalives_idle(void);
 static const char *show_tcp_keepalives_interval(void);
 static const char *show_tcp_keepalives_count(void);
 static bool check_maxconnections(int *newval, void **extra, GucSource source);
+static bool check_connection_pool_size(int *newval, void **extra, GucSource source);
+static bool check_preforked_backends(int *newval, void **extra, GucSource source);
 static bool check_max_worker_processes(int *newval, void **extra, GucSource source);
 static bool check_autovacuum_max_workers(int *newval, void **extra, GucSource source);
 static bool check_max_wal_senders(int *newval, void **extra, GucSource source);
 static bool check_autovacuum_work_mem(int *newval, void **extra, GucSource source);
 static bool check_effective_io_concurrency(int *newval, void **extra, GucSource source);
+static bool check_numa_placement(int *newval, void **extra, GucSource source);
+static bool check_io_direct(bool *newval, void **extra, GucSource source);
+static bool check_transaction_buffers(int *newval, void **extra, GucSource source);
+static bool check_subtrans_buffers(int *newval, void **extra, GucSource source);
+static bool check_multixact_offset_buffers(int *newval, void **extra, GucSource source);
+static bool check_multixact_member_buffers(int *newval, void **extra, GucSource source);
+static bool check_commit_ts_buffers(int *newval, void **extra, GucSource source);
+static bool check_notify_buffers(int *newval, void **extra, GucSource source);
+static bool check_serial_buffers(int *newval, void **extra, GucSource source);
+static bool check_max_fast_path_locks(int *newval, void **extra, GucSource source);
+static bool check_sinval_queue_size(int *newval, void **extra, GucSource source);
+static void assign_max_fast_path_locks(int newval, void *extra);
+static void assign_shared_buffers(int newval, void *extra);
 static void assign_effective_io_concurrency(int newval, void *extra);
 static void assign_pgstat_temp_directory(const char *newval, void *extra);
 static bool check_application_name(char **newval, void **extra, GucSource source);
@@ -411,6 +432,22 @@ static const struct config_enum_entry huge_pages_options[] = {
 	{NULL, 0, false}
 };
 
+static const struct config_enum_entry numa_placement_options[] = {
+	{"off", NUMA_PLACEMENT_OFF, false},
+	{"interleave", NUMA_PLACEMENT_INTERLEAVE, false},
+	{"partition", NUMA_PLACEMENT_PARTITION, false},
+	{"false", NUMA_PLACEMENT_OFF, true},
+	{"no", NUMA_PLACEMENT_OFF, true},
+	{"0", NUMA_PLACEMENT_OFF, true},
+	{NULL, 0, false}
+};
+
+static const struct config_enum_entry buffer_replacement_policy_options[] = {
+	{"clock", BUFFER_REPLACEMENT_CLOCK, false},
+	{"probation", BUFFER_REPLACEMENT_PROBATION, false},
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry force_parallel_mode_options[] = {
 	{"off", FORCE_PARALLEL_OFF, false},
 	{"on", FORCE_PARALLEL_ON, false},
@@ -543,6 +580,7 @@ int			ssl_renegotiation_limit;
  * need to be duplicated in all the different implementations of pg_shmem.c.
  */
 int			huge_pages;
+int			numa_placement;
 
 /*
  * These variables are all dummies that don't do anything, except in some
@@ -977,6 +1015,15 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_hashjoin_bloom", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables pushing bloom filters from hash joins down to sequential scans."),
+			NULL
+		},
+		&enable_hashjoin_bloom,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_gathermerge", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of gather merge plans."),
@@ -1909,6 +1956,16 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"io_direct", PGC_POSTMASTER, RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Uses direct I/O for relation data files, bypassing the kernel's page cache."),
+			NULL
+		},
+		&io_direct,
+		false,
+		check_io_direct, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, false, NULL, NULL, NULL
@@ -2098,18 +2155,91 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"connection_pool_size", PGC_POSTMASTER, CONN_AUTH_SETTINGS,
+			gettext_noop("Sets the number of backends kept to serve the sessions of each database, user and set of startup options."),
+			gettext_noop("Zero disables connection pooling.")
+		},
+		&connection_pool_size,
+		0, 0, MAX_BACKENDS,
+		check_connection_pool_size, NULL, NULL
+	},
+
+	{
+		{"max_pooled_sessions", PGC_POSTMASTER, CONN_AUTH_SETTINGS,
+			gettext_noop("Sets the maximum number of idle sessions held by the connection pool."),
+			NULL
+		},
+		&max_pooled_sessions,
+		1000, 1, INT_MAX / 4,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"preforked_backends", PGC_SIGHUP, CONN_AUTH_SETTINGS,
+			gettext_noop("Sets the number of server processes started ahead of time to take new connections."),
+			NULL
+		},
+		&PreforkedBackends,
+		0, 0, MAX_BACKENDS,
+		check_preforked_backends, NULL, NULL
+	},
+
 	/*
 	 * We sometimes multiply the number of shared buffers by two without
 	 * checking for overflow, so we mustn't allow more than INT_MAX / 2.
 	 */
 	{
-		{"shared_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+		{"shared_buffers", PGC_SIGHUP, RESOURCES_MEM,
 			gettext_noop("Sets the number of shared memory buffers used by the server."),
 			NULL,
 			GUC_UNIT_BLOCKS
 		},
-		&NBuffers,
+		&RequestedNBuffers,
 		1024, 16, INT_MAX / 2,
+		NULL, assign_shared_buffers, NULL
+	},
+
+	{
+		{"max_shared_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of shared memory buffers the server reserves memory for."),
+			gettext_noop("shared_buffers can be raised up to this value without a restart. "
+						 "Zero means the initial value of shared_buffers."),
+			GUC_UNIT_BLOCKS
+		},
+		&max_shared_buffers,
+		0, 0, INT_MAX / 2,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"smgr_shared_relations", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of relations whose sizes are cached in shared memory."),
+			gettext_noop("Zero disables the cache.")
+		},
+		&smgr_shared_relations,
+		10000, 0, INT_MAX / 2,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"shared_catalog_cache_entries", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of system catalog tuples cached in shared memory."),
+			gettext_noop("Zero disables the cache.")
+		},
+		&shared_catalog_cache_entries,
+		0, 0, INT_MAX / 2,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"shared_plan_cache_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the amount of shared memory used to share generic plans between sessions."),
+			gettext_noop("Zero disables the shared plan cache."),
+			GUC_UNIT_KB
+		},
+		&shared_plan_cache_size,
+		0, 0, MAX_KILOBYTES,
 		NULL, NULL, NULL
 	},
 
@@ -2124,6 +2254,93 @@ static struct config_int ConfigureNamesInt[] =
 		check_temp_buffers, NULL, NULL
 	},
 
+	{
+		{"transaction_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the transaction status cache."),
+			gettext_noop("Specify 0 to have this value determined as a fraction of shared_buffers."),
+			GUC_UNIT_BLOCKS
+		},
+		&transaction_buffers,
+		0, 0, SLRU_MAX_ALLOWED_BUFFERS,
+		check_transaction_buffers, NULL, NULL
+	},
+
+	{
+		{"subtransaction_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the subtransaction cache."),
+			gettext_noop("Specify 0 to have this value determined as a fraction of shared_buffers."),
+			GUC_UNIT_BLOCKS
+		},
+		&subtransaction_buffers,
+		0, 0, SLRU_MAX_ALLOWED_BUFFERS,
+		check_subtrans_buffers, NULL, NULL
+	},
+
+	{
+		{"multixact_offset_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the MultiXact offset cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&multixact_offset_buffers,
+		16, 16, SLRU_MAX_ALLOWED_BUFFERS,
+		check_multixact_offset_buffers, NULL, NULL
+	},
+
+	{
+		{"multixact_member_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the MultiXact member cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&multixact_member_buffers,
+		32, 16, SLRU_MAX_ALLOWED_BUFFERS,
+		check_multixact_member_buffers, NULL, NULL
+	},
+
+	{
+		{"commit_timestamp_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the commit timestamp cache."),
+			gettext_noop("Specify 0 to have this value determined as a fraction of shared_buffers."),
+			GUC_UNIT_BLOCKS
+		},
+		&commit_timestamp_buffers,
+		0, 0, SLRU_MAX_ALLOWED_BUFFERS,
+		check_commit_ts_buffers, NULL, NULL
+	},
+
+	{
+		{"notify_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the LISTEN/NOTIFY message cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&notify_buffers,
+		16, 16, SLRU_MAX_ALLOWED_BUFFERS,
+		check_notify_buffers, NULL, NULL
+	},
+
+	{
+		{"serializable_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the dedicated buffer pool used for the serializable transaction cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&serializable_buffers,
+		32, 16, SLRU_MAX_ALLOWED_BUFFERS,
+		check_serial_buffers, NULL, NULL
+	},
+
+	{
+		{"sinval_queue_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of messages the shared cache invalidation queue can hold."),
+			gettext_noop("The value is rounded up to a power of 2.")
+		},
+		&sinval_queue_size,
+		4096, SINVAL_QUEUE_SIZE_MIN, SINVAL_QUEUE_SIZE_MAX,
+		check_sinval_queue_size, NULL, NULL
+	},
+
 	{
 		{"port", PGC_POSTMASTER, CONN_AUTH_SETTINGS,
 			gettext_noop("Sets the TCP port the server listens on."),
@@ -2423,6 +2640,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"max_fast_path_locks", PGC_POSTMASTER, LOCK_MANAGEMENT,
+			gettext_noop("Sets the number of relation locks each backend can hold outside the shared lock table."),
+			gettext_noop("The value is rounded up to a multiple of 16.")
+		},
+		&max_fast_path_locks,
+		64, FP_LOCK_SLOTS_PER_GROUP,
+		FP_LOCK_SLOTS_PER_GROUP * FP_LOCK_GROUPS_PER_BACKEND_MAX,
+		check_max_fast_path_locks, assign_max_fast_path_locks, NULL
+	},
+
 	{
 		{"max_pred_locks_per_transaction", PGC_POSTMASTER, LOCK_MANAGEMENT,
 			gettext_noop("Sets the maximum number of predicate locks per transaction."),
@@ -2539,6 +2767,19 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"checkpoint_io_latency_target", PGC_SIGHUP, WAL_CHECKPOINTS,
+			gettext_noop("Sets the write latency above which checkpoints slow down their I/O."),
+			gettext_noop("Checkpoint writes and fsyncs that take longer than this "
+						 "make the checkpointer pause, as far as the checkpoint schedule "
+						 "allows. Zero disables I/O latency based pacing."),
+			GUC_UNIT_MS
+		},
+		&CheckPointIOLatencyTarget,
+		0, 0, 10000,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"checkpoint_flush_after", PGC_SIGHUP, WAL_CHECKPOINTS,
 			gettext_noop("Number of pages after which previously performed writes are flushed to disk."),
@@ -2736,6 +2977,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"io_combine_limit", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Limit on the size of data reads and writes."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&io_combine_limit,
+		16, 1, MAX_IO_COMBINE_LIMIT,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"max_worker_processes",
 			PGC_POSTMASTER,
@@ -4400,6 +4652,26 @@ static struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"numa_placement", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets how shared buffers are placed on NUMA nodes."),
+			NULL
+		},
+		&numa_placement,
+		NUMA_PLACEMENT_OFF, numa_placement_options,
+		check_numa_placement, NULL, NULL
+	},
+
+	{
+		{"buffer_replacement_policy", PGC_SIGHUP, RESOURCES_MEM,
+			gettext_noop("Sets the policy for choosing shared buffers to replace."),
+			NULL
+		},
+		&buffer_replacement_policy,
+		BUFFER_REPLACEMENT_CLOCK, buffer_replacement_policy_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"force_parallel_mode", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Forces use of parallel query facilities."),
@@ -5923,6 +6195,13 @@ BeginReportingGUCOptions(void)
 
 	reporting_enabled = true;
 
+	/*
+	 * The client of a session handed over by the connection pool has been
+	 * sent the initial values already.
+	 */
+	if (MyProcPort->pool_key != NULL)
+		return;
+
 	/* Transmit initial values of interesting variables */
 	for (i = 0; i < num_guc_variables; i++)
 	{
@@ -7531,6 +7810,95 @@ GetConfigOptionFlags(const char *name, bool missing_ok)
 	return record->flags;
 }
 
+/*
+ * Compute a hash of the current values of the settings that can influence
+ * the planner's choices, that is, those in the query tuning and memory and
+ * asynchronous behavior resource groups.
+ *
+ * This is used by the shared plan cache to avoid handing out a plan that
+ * was made under different settings.  A collision can at worst result in a
+ * plan that's not the one these settings would have produced.
+ */
+uint32
+GetPlannerSettingsHash(void)
+{
+	uint32		result = 0;
+	int			i;
+
+	for (i = 0; i < num_guc_variables; i++)
+	{
+		struct config_generic *conf = guc_variables[i];
+		uint32		h;
+
+		switch (conf->group)
+		{
+			case RESOURCES_MEM:
+			case RESOURCES_ASYNCHRONOUS:
+			case QUERY_TUNING_METHOD:
+			case QUERY_TUNING_COST:
+			case QUERY_TUNING_GEQO:
+			case QUERY_TUNING_OTHER:
+				break;
+			default:
+				continue;
+		}
+
+		switch (conf->vartype)
+		{
+			case PGC_BOOL:
+				h = (uint32) *((struct config_bool *) conf)->variable;
+				break;
+			case PGC_INT:
+				h = (uint32) *((struct config_int *) conf)->variable;
+				break;
+			case PGC_REAL:
+				{
+					double		val = *((struct config_real *) conf)->variable;
+
+					h = DatumGetUInt32(hash_any((unsigned char *) &val,
+												sizeof(val)));
+				}
+				break;
+			case PGC_STRING:
+				{
+					char	   *val = *((struct config_string *) conf)->variable;
+
+					h = val ? DatumGetUInt32(hash_any((unsigned char *) val,
+													  strlen(val))) : 0;
+				}
+				break;
+			case PGC_ENUM:
+				h = (uint32) *((struct config_enum *) conf)->variable;
+				break;
+			default:
+				h = 0;
+				break;
+		}
+		result = hash_combine(result, h);
+	}
+
+	return result;
+}
+
+/*
+ * Has any variable been changed by SET in this session?  Outside of a
+ * transaction, this is what distinguishes the session's settings from those
+ * a new session with the same startup options would get.
+ */
+bool
+HaveSessionGUCSettings(void)
+{
+	int			i;
+
+	for (i = 0; i < num_guc_variables; i++)
+	{
+		if (guc_variables[i]->source == PGC_S_SESSION)
+			return true;
+	}
+
+	return false;
+}
+
 
 /*
  * flatten_set_variable_args
@@ -11056,6 +11424,32 @@ check_maxconnections(int *newval, void **extra, GucSource source)
 	return true;
 }
 
+static bool
+check_connection_pool_size(int *newval, void **extra, GucSource source)
+{
+#ifndef SESSION_POOL_SUPPORTED
+	if (*newval != 0)
+	{
+		GUC_check_errdetail("connection_pool_size must be set to 0 on this platform.");
+		return false;
+	}
+#endif
+	return true;
+}
+
+static bool
+check_preforked_backends(int *newval, void **extra, GucSource source)
+{
+#ifndef SESSION_POOL_SUPPORTED
+	if (*newval != 0)
+	{
+		GUC_check_errdetail("preforked_backends must be set to 0 on this platform.");
+		return false;
+	}
+#endif
+	return true;
+}
+
 static bool
 check_autovacuum_max_workers(int *newval, void **extra, GucSource source)
 {
@@ -11141,6 +11535,114 @@ assign_effective_io_concurrency(int newval, void *extra)
 #endif							/* USE_PREFETCH */
 }
 
+static void
+assign_shared_buffers(int newval, void *extra)
+{
+	/*
+	 * Until the postmaster has created the buffer pool, the setting
+	 * determines its size directly.  After that, the pool is resized by the
+	 * background writer, which tells other processes about it through shared
+	 * memory.  Child processes get the initial size from the postmaster.
+	 */
+	if (!IsUnderPostmaster && BufferBlocks == NULL)
+		NBuffers = newval;
+}
+
+static bool
+check_numa_placement(int *newval, void **extra, GucSource source)
+{
+#ifndef HAVE_LIBNUMA
+	if (*newval != NUMA_PLACEMENT_OFF)
+	{
+		GUC_check_errdetail("numa_placement must be set to off in builds without libnuma support.");
+		return false;
+	}
+#endif
+	return true;
+}
+
+static bool
+check_io_direct(bool *newval, void **extra, GucSource source)
+{
+#if PG_O_DIRECT == 0
+	if (*newval)
+	{
+		GUC_check_errdetail("io_direct is not supported on this platform.");
+		return false;
+	}
+#endif
+	return true;
+}
+
+static bool
+check_transaction_buffers(int *newval, void **extra, GucSource source)
+{
+	return check_slru_buffers("transaction_buffers", newval);
+}
+
+static bool
+check_subtrans_buffers(int *newval, void **extra, GucSource source)
+{
+	return check_slru_buffers("subtransaction_buffers", newval);
+}
+
+static bool
+check_multixact_offset_buffers(int *newval, void **extra, GucSource source)
+{
+	return check_slru_buffers("multixact_offset_buffers", newval);
+}
+
+static bool
+check_multixact_member_buffers(int *newval, void **extra, GucSource source)
+{
+	return check_slru_buffers("multixact_member_buffers", newval);
+}
+
+static bool
+check_commit_ts_buffers(int *newval, void **extra, GucSource source)
+{
+	return check_slru_buffers("commit_timestamp_buffers", newval);
+}
+
+static bool
+check_notify_buffers(int *newval, void **extra, GucSource source)
+{
+	return check_slru_buffers("notify_buffers", newval);
+}
+
+static bool
+check_serial_buffers(int *newval, void **extra, GucSource source)
+{
+	return check_slru_buffers("serializable_buffers", newval);
+}
+
+static bool
+check_max_fast_path_locks(int *newval, void **extra, GucSource source)
+{
+	/* Fast-path slots come in whole groups */
+	*newval = ((*newval + FP_LOCK_SLOTS_PER_GROUP - 1) /
+			   FP_LOCK_SLOTS_PER_GROUP) * FP_LOCK_SLOTS_PER_GROUP;
+	return true;
+}
+
+static void
+assign_max_fast_path_locks(int newval, void *extra)
+{
+	FastPathLockGroupsPerBackend = newval / FP_LOCK_SLOTS_PER_GROUP;
+}
+
+static bool
+check_sinval_queue_size(int *newval, void **extra, GucSource source)
+{
+	int			size = SINVAL_QUEUE_SIZE_MIN;
+
+	/* The queue is a circular buffer indexed by masking, see sinvaladt.c */
+	while (size < *newval)
+		size <<= 1;
+	*newval = size;
+	return true;
+}
+
 static void
 assign_pgstat_temp_directory(const char *newval, void *extra)
 {
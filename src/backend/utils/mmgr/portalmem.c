@@ -1204,6 +1204,15 @@ pg_cursor(PG_FUNCTION_ARGS)
 	return (Datum) 0;
 }
 
+/*
+ * Do any portals exist?  Outside a transaction, only holdable cursors can.
+ */
+bool
+PortalsExist(void)
+{
+	return hash_get_num_entries(PortalHashTable) > 0;
+}
+
 bool
 ThereAreNoReadyPortals(void)
 {
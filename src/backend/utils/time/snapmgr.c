@@ -243,6 +243,7 @@ typedef struct SerializedSnapshotData
 	uint32		xcnt;
 	int32		subxcnt;
 	bool		suboverflowed;
+	TransactionId suboverflowxmin;
 	bool		takenDuringRecovery;
 	CommandId	curcid;
 	TimestampTz whenTaken;
@@ -601,6 +602,7 @@ SetTransactionSnapshot(Snapshot sourcesnap, VirtualTransactionId *sourcevxid,
 	memcpy(CurrentSnapshot->subxip, sourcesnap->subxip,
 		   sourcesnap->subxcnt * sizeof(TransactionId));
 	CurrentSnapshot->suboverflowed = sourcesnap->suboverflowed;
+	CurrentSnapshot->suboverflowxmin = sourcesnap->suboverflowxmin;
 	CurrentSnapshot->takenDuringRecovery = sourcesnap->takenDuringRecovery;
 	/* NB: curcid should NOT be copied, it's a local matter */
 
@@ -691,13 +693,12 @@ CopySnapshot(Snapshot snapshot)
 		newsnap->xip = NULL;
 
 	/*
-	 * Setup subXID array. Don't bother to copy it if it had overflowed,
-	 * though, because it's not used anywhere in that case. Except if it's a
-	 * snapshot taken during recovery; all the top-level XIDs are in subxip as
-	 * well in that case, so we mustn't lose them.
+	 * Setup subXID array.  Even if it had overflowed, the XIDs preceding
+	 * suboverflowxmin are still used, and a snapshot taken during recovery
+	 * keeps all the top-level XIDs in subxip as well, so we mustn't lose
+	 * them.
 	 */
-	if (snapshot->subxcnt > 0 &&
-		(!snapshot->suboverflowed || snapshot->takenDuringRecovery))
+	if (snapshot->subxcnt > 0)
 	{
 		newsnap->subxip = (TransactionId *) ((char *) newsnap + subxipoff);
 		memcpy(newsnap->subxip, snapshot->subxip,
@@ -1527,6 +1528,8 @@ ImportSnapshot(const char *idstr)
 		snapshot.xip[i] = parseXidFromText("xip:", &filebuf, path);
 
 	snapshot.suboverflowed = parseIntFromText("sof:", &filebuf, path);
+	/* exported snapshots don't carry the partial subxip[] data */
+	snapshot.suboverflowxmin = snapshot.xmin;
 
 	if (!snapshot.suboverflowed)
 	{
@@ -2055,8 +2058,7 @@ EstimateSnapshotSpace(Snapshot snap)
 	/* We allocate any XID arrays needed in the same palloc block. */
 	size = add_size(sizeof(SerializedSnapshotData),
 					mul_size(snap->xcnt, sizeof(TransactionId)));
-	if (snap->subxcnt > 0 &&
-		(!snap->suboverflowed || snap->takenDuringRecovery))
+	if (snap->subxcnt > 0)
 		size = add_size(size,
 						mul_size(snap->subxcnt, sizeof(TransactionId)));
 
@@ -2081,19 +2083,12 @@ SerializeSnapshot(Snapshot snapshot, char *start_address)
 	serialized_snapshot.xcnt = snapshot->xcnt;
 	serialized_snapshot.subxcnt = snapshot->subxcnt;
 	serialized_snapshot.suboverflowed = snapshot->suboverflowed;
+	serialized_snapshot.suboverflowxmin = snapshot->suboverflowxmin;
 	serialized_snapshot.takenDuringRecovery = snapshot->takenDuringRecovery;
 	serialized_snapshot.curcid = snapshot->curcid;
 	serialized_snapshot.whenTaken = snapshot->whenTaken;
 	serialized_snapshot.lsn = snapshot->lsn;
 
-	/*
-	 * Ignore the SubXID array if it has overflowed, unless the snapshot was
-	 * taken during recovery - in that case, top-level XIDs are in subxip as
-	 * well, and we mustn't lose them.
-	 */
-	if (serialized_snapshot.suboverflowed && !snapshot->takenDuringRecovery)
-		serialized_snapshot.subxcnt = 0;
-
 	/* Copy struct to possibly-unaligned buffer */
 	memcpy(start_address,
 		   &serialized_snapshot, sizeof(SerializedSnapshotData));
@@ -2105,10 +2100,9 @@ SerializeSnapshot(Snapshot snapshot, char *start_address)
 			   snapshot->xip, snapshot->xcnt * sizeof(TransactionId));
 
 	/*
-	 * Copy SubXID array. Don't bother to copy it if it had overflowed,
-	 * though, because it's not used anywhere in that case. Except if it's a
-	 * snapshot taken during recovery; all the top-level XIDs are in subxip as
-	 * well in that case, so we mustn't lose them.
+	 * Copy SubXID array.  Even an overflowed one is still used for the XIDs
+	 * preceding suboverflowxmin, and a snapshot taken during recovery keeps
+	 * all the top-level XIDs in subxip as well.
 	 */
 	if (serialized_snapshot.subxcnt > 0)
 	{
@@ -2155,6 +2149,7 @@ RestoreSnapshot(char *start_address)
 	snapshot->subxip = NULL;
 	snapshot->subxcnt = serialized_snapshot.subxcnt;
 	snapshot->suboverflowed = serialized_snapshot.suboverflowed;
+	snapshot->suboverflowxmin = serialized_snapshot.suboverflowxmin;
 	snapshot->takenDuringRecovery = serialized_snapshot.takenDuringRecovery;
 	snapshot->curcid = serialized_snapshot.curcid;
 	snapshot->whenTaken = serialized_snapshot.whenTaken;
@@ -2239,8 +2234,14 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 		 * XIDs and top-level XIDs.  If the snapshot overflowed, we have to
 		 * use pg_subtrans to convert a subxact XID to its parent XID, but
 		 * then we need only look at top-level XIDs not subxacts.
+		 *
+		 * An overflowed snapshot still has full subxact data for XIDs older
+		 * than every transaction whose subxact cache overflowed, since a
+		 * subxact's XID always follows its parent's.  So only XIDs from
+		 * suboverflowxmin up need to go to pg_subtrans.
 		 */
-		if (!snapshot->suboverflowed)
+		if (!snapshot->suboverflowed ||
+			TransactionIdPrecedes(xid, snapshot->suboverflowxmin))
 		{
 			/* we have full data, so search subxip */
 			int32		j;
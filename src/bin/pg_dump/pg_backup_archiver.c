@@ -1878,6 +1878,10 @@ buildTocEntryArrays(ArchiveHandle *AH)
 		 * TOC entry that has a DATA item.  We compute this by reversing the
 		 * TABLE DATA item's dependency, knowing that a TABLE DATA item has
 		 * just one dependency and it is the TABLE item.
+		 *
+		 * If pg_dump split the table's data into several TABLE DATA items,
+		 * which it marks as chunks, they are chained together through
+		 * nextTableData, starting from the item recorded in tableDataId.
 		 */
 		if (strcmp(te->desc, "TABLE DATA") == 0 && te->nDeps > 0)
 		{
@@ -1891,6 +1895,8 @@ buildTocEntryArrays(ArchiveHandle *AH)
 			if (tableId <= 0 || tableId > maxDumpId)
 				exit_horribly(modulename, "bad table dumpId for TABLE DATA item\n");
 
+			if (te->tableDataChunk)
+				te->nextTableData = AH->tableDataId[tableId];
 			AH->tableDataId[tableId] = te->dumpId;
 		}
 	}
@@ -2579,6 +2585,7 @@ WriteToc(ArchiveHandle *AH)
 		WriteStr(AH, te->namespace);
 		WriteStr(AH, te->tablespace);
 		WriteStr(AH, te->tableam);
+		WriteInt(AH, te->tableDataChunk ? 1 : 0);
 		WriteStr(AH, te->owner);
 		WriteStr(AH, "false");
 
@@ -2684,6 +2691,9 @@ ReadToc(ArchiveHandle *AH)
 		if (AH->version >= K_VERS_1_14)
 			te->tableam = ReadStr(AH);
 
+		if (AH->version >= K_VERS_1_15)
+			te->tableDataChunk = (ReadInt(AH) != 0);
+
 		te->owner = ReadStr(AH);
 		if (AH->version < K_VERS_1_9 || strcmp(ReadStr(AH), "true") == 0)
 			write_msg(modulename,
@@ -4659,6 +4669,10 @@ fix_dependencies(ArchiveHandle *AH)
  * Change dependencies on table items to depend on table data items instead,
  * but only in POST_DATA items.
  *
+ * If a table's data was split into several TABLE DATA items, the dependency
+ * is repointed to all of them, so that the item waits for the whole table to
+ * be loaded.
+ *
  * Also, for any item having such dependency(s), set its dataLength to the
  * largest dataLength of the table data items it depends on.  This ensures
  * that parallel restore will prioritize larger jobs (index builds, FK
@@ -4670,13 +4684,16 @@ repoint_table_dependencies(ArchiveHandle *AH)
 {
 	TocEntry   *te;
 	int			i;
+	int			nDeps;
 	DumpId		olddep;
 
 	for (te = AH->toc->next; te != AH->toc; te = te->next)
 	{
 		if (te->section != SECTION_POST_DATA)
 			continue;
-		for (i = 0; i < te->nDeps; i++)
+		/* don't look at any dependencies we append below */
+		nDeps = te->nDeps;
+		for (i = 0; i < nDeps; i++)
 		{
 			olddep = te->dependencies[i];
 			if (olddep <= AH->maxDumpId &&
@@ -4684,11 +4701,28 @@ repoint_table_dependencies(ArchiveHandle *AH)
 			{
 				DumpId		tabledataid = AH->tableDataId[olddep];
 				TocEntry   *tabledatate = AH->tocsByDumpId[tabledataid];
+				pgoff_t		tableLength = tabledatate->dataLength;
 
 				te->dependencies[i] = tabledataid;
-				te->dataLength = Max(te->dataLength, tabledatate->dataLength);
 				ahlog(AH, 2, "transferring dependency %d -> %d to %d\n",
 					  te->dumpId, olddep, tabledataid);
+
+				/* add dependencies on the other parts of a split table */
+				while (tabledatate->nextTableData != 0)
+				{
+					tabledataid = tabledatate->nextTableData;
+					tabledatate = AH->tocsByDumpId[tabledataid];
+					tableLength += tabledatate->dataLength;
+
+					te->dependencies = (DumpId *)
+						pg_realloc(te->dependencies,
+								   (te->nDeps + 1) * sizeof(DumpId));
+					te->dependencies[te->nDeps++] = tabledataid;
+					ahlog(AH, 2, "transferring dependency %d -> %d to %d\n",
+						  te->dumpId, olddep, tabledataid);
+				}
+
+				te->dataLength = Max(te->dataLength, tableLength);
 			}
 		}
 	}
@@ -4802,6 +4836,10 @@ reduce_dependencies(ArchiveHandle *AH, TocEntry *te,
 /*
  * Set the created flag on the DATA member corresponding to the given
  * TABLE member
+ *
+ * If the table's data was split into several DATA members, leave them alone:
+ * they are loaded independently, so none of them may be preceded by the
+ * TRUNCATE that the created flag implies.
  */
 static void
 mark_create_done(ArchiveHandle *AH, TocEntry *te)
@@ -4810,7 +4848,8 @@ mark_create_done(ArchiveHandle *AH, TocEntry *te)
 	{
 		TocEntry   *ted = AH->tocsByDumpId[AH->tableDataId[te->dumpId]];
 
-		ted->created = true;
+		if (!ted->tableDataChunk)
+			ted->created = true;
 	}
 }
 
@@ -4829,6 +4868,13 @@ inhibit_data_for_failed_table(ArchiveHandle *AH, TocEntry *te)
 		TocEntry   *ted = AH->tocsByDumpId[AH->tableDataId[te->dumpId]];
 
 		ted->reqs = 0;
+
+		/* likewise for the other parts of a split table */
+		while (ted->nextTableData != 0)
+		{
+			ted = AH->tocsByDumpId[ted->nextTableData];
+			ted->reqs = 0;
+		}
 	}
 }
 
@@ -95,6 +95,7 @@ typedef z_stream *z_streamp;
 #define K_VERS_1_13 MAKE_ARCHIVE_VERSION(1, 13, 0)	/* change search_path
 													 * behavior */
 #define K_VERS_1_14 MAKE_ARCHIVE_VERSION(1, 14, 0)	/* add tableam */
+#define K_VERS_1_15 MAKE_ARCHIVE_VERSION(1, 15, 0)	/* add table data chunks */
 
 /*
  * Current archive version number (the format we can output)
@@ -103,7 +104,7 @@ typedef z_stream *z_streamp;
  * https://postgr.es/m/20190227123217.GA27552@alvherre.pgsql
  */
 #define K_VERS_MAJOR 1
-#define K_VERS_MINOR 14
+#define K_VERS_MINOR 15
 #define K_VERS_REV 0
 #define K_VERS_SELF MAKE_ARCHIVE_VERSION(K_VERS_MAJOR, K_VERS_MINOR, K_VERS_REV);
 
@@ -386,6 +387,8 @@ struct _tocEntry
 	char	   *defn;
 	char	   *dropStmt;
 	char	   *copyStmt;
+	bool		tableDataChunk; /* TABLE DATA item holding one block range of
+								 * a table whose data was split */
 	DumpId	   *dependencies;	/* dumpIds of objects this one depends on */
 	int			nDeps;			/* number of dependencies */
 
@@ -397,6 +400,8 @@ struct _tocEntry
 	pgoff_t		dataLength;		/* item's data size; 0 if none or unknown */
 	teReqs		reqs;			/* do we need schema and/or data of object */
 	bool		created;		/* set for DATA member if TABLE was created */
+	DumpId		nextTableData;	/* next TABLE DATA item of the same table, if
+								 * the table's data was split; else 0 */
 
 	/* working state (needed only for parallel restore) */
 	struct _tocEntry *pending_prev; /* list links for pending-items list; */
@@ -167,6 +167,12 @@ static void expand_table_name_patterns(Archive *fout,
 						   bool strict_names);
 static NamespaceInfo *findNamespace(Archive *fout, Oid nsoid);
 static void dumpTableData(Archive *fout, TableDataInfo *tdinfo);
+static TocEntry *dumpTableDataEntry(Archive *fout, TableDataInfo *tdinfo,
+				   DumpId dumpId, const char *copyStmt,
+				   DataDumperPtr dumpFn);
+static void dumpTableDataChunks(Archive *fout, TableDataInfo *tdinfo,
+					const char *copyStmt, DataDumperPtr dumpFn,
+					BlockNumber relpages, BlockNumber chunkpages);
 static void refreshMatViewData(Archive *fout, TableDataInfo *tdinfo);
 static void guessConstraintInheritance(TableInfo *tblinfo, int numTables);
 static void dumpComment(Archive *fout, const char *type, const char *name,
@@ -320,6 +326,7 @@ main(int argc, char **argv)
 	const char *dumpsnapshot = NULL;
 	char	   *use_role = NULL;
 	long		rowsPerInsert;
+	long		tableChunkPages;
 	int			numWorkers = 1;
 	trivalue	prompt_password = TRI_DEFAULT;
 	int			compressLevel = -1;
@@ -392,6 +399,7 @@ main(int argc, char **argv)
 		{"no-sync", no_argument, NULL, 7},
 		{"on-conflict-do-nothing", no_argument, &dopt.do_nothing, 1},
 		{"rows-per-insert", required_argument, NULL, 10},
+		{"table-chunk-pages", required_argument, NULL, 11},
 
 		{NULL, 0, NULL, 0}
 	};
@@ -607,6 +615,21 @@ main(int argc, char **argv)
 				dopt.dump_inserts = (int) rowsPerInsert;
 				break;
 
+			case 11:			/* pages per table data chunk */
+				errno = 0;
+				tableChunkPages = strtol(optarg, &endptr, 10);
+
+				if (endptr == optarg || *endptr != '\0' ||
+					tableChunkPages <= 0 || tableChunkPages > INT_MAX ||
+					errno == ERANGE)
+				{
+					write_msg(NULL, "table-chunk-pages must be in range %d..%d\n",
+							  1, INT_MAX);
+					exit_nicely(1);
+				}
+				dopt.table_chunk_pages = (int) tableChunkPages;
+				break;
+
 			default:
 				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
 				exit_nicely(1);
@@ -712,6 +735,10 @@ main(int argc, char **argv)
 	if (archiveFormat != archDirectory && numWorkers > 1)
 		exit_horribly(NULL, "parallel backup only supported by the directory format\n");
 
+	/* Split table data only in the directory archive format */
+	if (archiveFormat != archDirectory && dopt.table_chunk_pages > 0)
+		exit_horribly(NULL, "option --table-chunk-pages is only supported by the directory format\n");
+
 	/* Open the output file */
 	fout = CreateArchive(filename, archiveFormat, compressLevel, dosync,
 						 archiveMode, setupDumpWorker);
@@ -755,6 +782,17 @@ main(int argc, char **argv)
 	if (fout->isStandby)
 		dopt.no_unlogged_table_data = true;
 
+	/*
+	 * Splitting table data relies on ctid range conditions being executed as
+	 * a TID Range Scan; on older servers every chunk would read the whole
+	 * table, so don't bother.
+	 */
+	if (dopt.table_chunk_pages > 0 && fout->remoteVersion < 120000)
+	{
+		write_msg(NULL, "WARNING: option --table-chunk-pages is not supported by this server version, ignoring it\n");
+		dopt.table_chunk_pages = 0;
+	}
+
 	/* Select the appropriate subquery to convert user IDs to names */
 	if (fout->remoteVersion >= 80100)
 		username_subquery = "SELECT rolname FROM pg_catalog.pg_roles WHERE oid =";
@@ -1038,6 +1076,8 @@ help(const char *progname)
 	printf(_("  --snapshot=SNAPSHOT          use given snapshot for the dump\n"));
 	printf(_("  --strict-names               require table and/or schema include patterns to\n"
 			 "                               match at least one entity each\n"));
+	printf(_("  --table-chunk-pages=NPAGES   split data of larger tables into chunks of NPAGES\n"
+			 "                               pages\n"));
 	printf(_("  --use-set-session-authorization\n"
 			 "                               use SET SESSION AUTHORIZATION commands instead of\n"
 			 "                               ALTER OWNER commands to set ownership\n"));
@@ -1828,7 +1868,7 @@ dumpTableData_copy(Archive *fout, void *dcontext)
 		}
 		else
 			appendPQExpBufferStr(q, "* ");
-		appendPQExpBuffer(q, "FROM %s %s) TO stdout;",
+		appendPQExpBuffer(q, "FROM ONLY %s %s) TO stdout;",
 						  fmtQualifiedDumpable(tbinfo),
 						  tdinfo->filtercond);
 	}
@@ -2177,6 +2217,87 @@ getRootTableInfo(TableInfo *tbinfo)
 	return parentTbinfo;
 }
 
+/*
+ * dumpTableDataEntry -
+ *	  make the ArchiveEntry for (part of) the contents of a table
+ */
+static TocEntry *
+dumpTableDataEntry(Archive *fout, TableDataInfo *tdinfo, DumpId dumpId,
+				   const char *copyStmt, DataDumperPtr dumpFn)
+{
+	TableInfo  *tbinfo = tdinfo->tdtable;
+
+	return ArchiveEntry(fout, tdinfo->dobj.catId, dumpId,
+						ARCHIVE_OPTS(.tag = tbinfo->dobj.name,
+									 .namespace = tbinfo->dobj.namespace->dobj.name,
+									 .owner = tbinfo->rolname,
+									 .description = "TABLE DATA",
+									 .section = SECTION_DATA,
+									 .createStmt = "",
+									 .dropStmt = "",
+									 .copyStmt = copyStmt,
+									 .deps = &(tbinfo->dobj.dumpId),
+									 .nDeps = 1,
+									 .dumpFn = dumpFn,
+									 .dumpArg = tdinfo));
+}
+
+/*
+ * dumpTableDataChunks -
+ *	  dump the contents of a large table as several TABLE DATA items
+ *
+ * Each item covers a range of chunkpages heap blocks, selected with a ctid
+ * range condition, so that the items can be dumped and restored by separate
+ * workers.  The first item keeps the TableDataInfo's dump ID; the others get
+ * fresh ones.  The first and last ranges are left open-ended, so that rows
+ * stored beyond relpages (which is only an estimate) are not lost.
+ *
+ * The items are marked as chunks in the archive, and chained together by the
+ * archiver when the archive is read back; see buildTocEntryArrays().
+ */
+static void
+dumpTableDataChunks(Archive *fout, TableDataInfo *tdinfo,
+					const char *copyStmt, DataDumperPtr dumpFn,
+					BlockNumber relpages, BlockNumber chunkpages)
+{
+	BlockNumber startpage = 0;
+
+	for (;;)
+	{
+		TableDataInfo *chunk;
+		PQExpBuffer cond = createPQExpBuffer();
+		DumpId		dumpId;
+		bool		last;
+		TocEntry   *te;
+
+		/* compare remaining pages, to avoid overflowing BlockNumber */
+		last = (relpages - startpage <= chunkpages);
+
+		appendPQExpBufferStr(cond, "WHERE ");
+		if (startpage > 0)
+			appendPQExpBuffer(cond, "ctid >= '(%u,0)'", startpage);
+		if (startpage > 0 && !last)
+			appendPQExpBufferStr(cond, " AND ");
+		if (!last)
+			appendPQExpBuffer(cond, "ctid < '(%u,0)'",
+							  startpage + chunkpages);
+
+		chunk = (TableDataInfo *) pg_malloc(sizeof(TableDataInfo));
+		memcpy(chunk, tdinfo, sizeof(TableDataInfo));
+		chunk->filtercond = pg_strdup(cond->data);
+		destroyPQExpBuffer(cond);
+
+		dumpId = (startpage == 0) ? tdinfo->dobj.dumpId : createDumpId();
+		te = dumpTableDataEntry(fout, chunk, dumpId, copyStmt, dumpFn);
+		te->dataLength = last ? relpages - startpage : chunkpages;
+		te->tableDataChunk = true;
+
+		if (last)
+			break;
+		startpage += chunkpages;
+	}
+}
+
 /*
  * dumpTableData -
  *	  dump the contents of a single table
@@ -2235,32 +2356,35 @@ dumpTableData(Archive *fout, TableDataInfo *tdinfo)
 	 */
 	if (tdinfo->dobj.dump & DUMP_COMPONENT_DATA)
 	{
-		TocEntry   *te;
-
-		te = ArchiveEntry(fout, tdinfo->dobj.catId, tdinfo->dobj.dumpId,
-						  ARCHIVE_OPTS(.tag = tbinfo->dobj.name,
-									   .namespace = tbinfo->dobj.namespace->dobj.name,
-									   .owner = tbinfo->rolname,
-									   .description = "TABLE DATA",
-									   .section = SECTION_DATA,
-									   .createStmt = "",
-									   .dropStmt = "",
-									   .copyStmt = copyStmt,
-									   .deps = &(tbinfo->dobj.dumpId),
-									   .nDeps = 1,
-									   .dumpFn = dumpFn,
-									   .dumpArg = tdinfo));
-
 		/*
-		 * Set the TocEntry's dataLength in case we are doing a parallel dump
-		 * and want to order dump jobs by table size.  We choose to measure
-		 * dataLength in table pages during dump, so no scaling is needed.
-		 * However, relpages is declared as "integer" in pg_class, and hence
-		 * also in TableInfo, but it's really BlockNumber a/k/a unsigned int.
-		 * Cast so that we get the right interpretation of table sizes
-		 * exceeding INT_MAX pages.
+		 * relpages is declared as "integer" in pg_class, and hence also in
+		 * TableInfo, but it's really BlockNumber a/k/a unsigned int.  Cast so
+		 * that we get the right interpretation of table sizes exceeding
+		 * INT_MAX pages.
 		 */
-		te->dataLength = (BlockNumber) tbinfo->relpages;
+		BlockNumber relpages = (BlockNumber) tbinfo->relpages;
+		BlockNumber chunkpages = (BlockNumber) dopt->table_chunk_pages;
+
+		if (chunkpages > 0 && relpages > chunkpages &&
+			tbinfo->relkind == RELKIND_RELATION &&
+			tdinfo->filtercond == NULL)
+			dumpTableDataChunks(fout, tdinfo, copyStmt, dumpFn,
+								relpages, chunkpages);
+		else
+		{
+			TocEntry   *te;
+
+			te = dumpTableDataEntry(fout, tdinfo, tdinfo->dobj.dumpId,
+									copyStmt, dumpFn);
+
+			/*
+			 * Set the TocEntry's dataLength in case we are doing a parallel
+			 * dump and want to order dump jobs by table size.  We choose to
+			 * measure dataLength in table pages during dump, so no scaling
+			 * is needed.
+			 */
+			te->dataLength = relpages;
+		}
 	}
 
 	destroyPQExpBuffer(copyBuf);
@@ -4,7 +4,7 @@ use warnings;
 use Config;
 use PostgresNode;
 use TestLib;
-use Test::More tests => 72;
+use Test::More tests => 78;
 
 my $tempdir       = TestLib::tempdir;
 my $tempdir_short = TestLib::tempdir_short;
@@ -106,6 +106,16 @@ command_fails_like(
 	qr/\Qpg_dump: compression level must be in range 0..9\E/,
 	'pg_dump: compression level must be in range 0..9');
 
+command_fails_like(
+	[ 'pg_dump', '--table-chunk-pages', '0' ],
+	qr/\Qpg_dump: table-chunk-pages must be in range 1..2147483647\E/,
+	'pg_dump: table-chunk-pages must be in range 1..2147483647');
+
+command_fails_like(
+	[ 'pg_dump', '--table-chunk-pages', '1000', '-Fc' ],
+	qr/\Qpg_dump: option --table-chunk-pages is only supported by the directory format\E/,
+	'pg_dump: option --table-chunk-pages is only supported by the directory format');
+
 command_fails_like(
 	[ 'pg_restore', '--if-exists' ],
 	qr/\Qpg_restore: option --if-exists requires option -c\/--clean\E/,
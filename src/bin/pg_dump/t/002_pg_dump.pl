@@ -3186,8 +3186,9 @@ if ($collation_check_stderr !~ /ERROR: /)
 $node->psql('postgres', 'create database regress_pg_dump_test;');
 
 # Start with number of command_fails_like()*2 tests below (each
-# command_fails_like is actually 2 tests)
-my $num_tests = 12;
+# command_fails_like is actually 2 tests), plus the split table data
+# tests at the end
+my $num_tests = 12 + 7;
 
 foreach my $run (sort keys %pgdump_runs)
 {
@@ -3422,6 +3423,65 @@ foreach my $run (sort keys %pgdump_runs)
 	}
 }
 
+#########################################
+# Dump a table with --table-chunk-pages, so that its data is split into
+# several TABLE DATA entries, and restore it into another database.  The
+# table has an inheritance child, whose rows must not be dumped as part of
+# the parent's chunks.
+
+$node->safe_psql('postgres', 'CREATE DATABASE regress_chunk_src;');
+$node->safe_psql('postgres', 'CREATE DATABASE regress_chunk_dst;');
+$node->safe_psql(
+	'regress_chunk_src', q{
+	CREATE TABLE chunked (id int, filler text);
+	CREATE TABLE chunked_child () INHERITS (chunked);
+	INSERT INTO chunked SELECT g, repeat(md5(g::text), 4)
+		FROM generate_series(1, 5000) g;
+	INSERT INTO chunked_child SELECT g, 'child' FROM generate_series(1, 10) g;
+	ANALYZE chunked;
+	ANALYZE chunked_child;
+});
+
+$node->command_ok(
+	[
+		'pg_dump',                '--no-sync',
+		'--format=directory',     '--jobs=4',
+		'--table-chunk-pages=10', "--file=$tempdir/chunked",
+		'regress_chunk_src'
+	],
+	'table-chunk-pages: pg_dump runs');
+
+my ($chunk_toc, $chunk_stderr) =
+  run_command([ 'pg_restore', '--list', "$tempdir/chunked" ]);
+my $chunk_entries = () = $chunk_toc =~ /TABLE DATA public chunked /g;
+ok($chunk_entries > 1,
+	"table-chunk-pages: table data split into $chunk_entries entries");
+
+# Older versions of pg_restore would truncate the table before loading each
+# chunk, so the archive must be marked as one they can't read
+like($chunk_toc, qr/^;\s+Dump Version: 1\.15-0$/m,
+	'table-chunk-pages: archive version marks split table data');
+
+$node->command_ok(
+	[
+		'pg_restore',               '--jobs=4',
+		'--dbname=regress_chunk_dst', "$tempdir/chunked"
+	],
+	'table-chunk-pages: pg_restore runs');
+
+my $chunk_query =
+  q{SELECT count(*), md5(string_agg(id || ':' || filler, ',' ORDER BY id))
+	FROM ONLY chunked};
+is( $node->safe_psql('regress_chunk_dst', $chunk_query),
+	$node->safe_psql('regress_chunk_src', $chunk_query),
+	'table-chunk-pages: restored table has the same rows');
+
+is($node->safe_psql('regress_chunk_dst', 'SELECT count(*) FROM chunked_child'),
+	'10', 'table-chunk-pages: child rows restored once');
+
+is($node->safe_psql('regress_chunk_dst', 'SELECT count(*) FROM chunked'),
+	'5010', 'table-chunk-pages: no rows duplicated through inheritance');
+
 #########################################
 # Stop the database instance, which will be removed at the end of the tests.
 
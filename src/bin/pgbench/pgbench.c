@@ -494,7 +494,9 @@ typedef enum MetaCommand
 	META_IF,					/* \if */
 	META_ELIF,					/* \elif */
 	META_ELSE,					/* \else */
-	META_ENDIF					/* \endif */
+	META_ENDIF,					/* \endif */
+	META_STARTPIPELINE,			/* \startpipeline */
+	META_ENDPIPELINE			/* \endpipeline */
 } MetaCommand;
 
 typedef enum QueryMode
@@ -2610,6 +2612,10 @@ getMetaCommand(const char *cmd)
 		mc = META_ENDIF;
 	else if (pg_strcasecmp(cmd, "gset") == 0)
 		mc = META_GSET;
+	else if (pg_strcasecmp(cmd, "startpipeline") == 0)
+		mc = META_STARTPIPELINE;
+	else if (pg_strcasecmp(cmd, "endpipeline") == 0)
+		mc = META_ENDPIPELINE;
 	else
 		mc = META_NONE;
 	return mc;
@@ -2757,6 +2763,36 @@ chooseScript(TState *thread)
 	return i - 1;
 }
 
+/*
+ * Prepare the SQL commands in the chosen script, if not done yet for this
+ * connection.
+ */
+static void
+prepareCommands(CState *st)
+{
+	int			j;
+	Command   **commands = sql_script[st->use_file].commands;
+
+	if (st->prepared[st->use_file])
+		return;
+
+	for (j = 0; commands[j] != NULL; j++)
+	{
+		PGresult   *res;
+		char		name[MAX_PREPARE_NAME];
+
+		if (commands[j]->type != SQL_COMMAND)
+			continue;
+		preparedStatementName(name, st->use_file, j);
+		res = PQprepare(st->con, name,
+						commands[j]->argv[0], commands[j]->argc - 1, NULL);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			fprintf(stderr, "%s", PQerrorMessage(st->con));
+		PQclear(res);
+	}
+	st->prepared[st->use_file] = true;
+}
+
 /* Send a SQL command, using the chosen querymode */
 static bool
 sendCommand(CState *st, Command *command)
@@ -2792,27 +2828,8 @@ sendCommand(CState *st, Command *command)
 		char		name[MAX_PREPARE_NAME];
 		const char *params[MAX_ARGS];
 
-		if (!st->prepared[st->use_file])
-		{
-			int			j;
-			Command   **commands = sql_script[st->use_file].commands;
-
-			for (j = 0; commands[j] != NULL; j++)
-			{
-				PGresult   *res;
-				char		name[MAX_PREPARE_NAME];
-
-				if (commands[j]->type != SQL_COMMAND)
-					continue;
-				preparedStatementName(name, st->use_file, j);
-				res = PQprepare(st->con, name,
-								commands[j]->argv[0], commands[j]->argc - 1, NULL);
-				if (PQresultStatus(res) != PGRES_COMMAND_OK)
-					fprintf(stderr, "%s", PQerrorMessage(st->con));
-				PQclear(res);
-			}
-			st->prepared[st->use_file] = true;
-		}
+		/* this is a no-op in pipeline mode; see \startpipeline */
+		prepareCommands(st);
 
 		getQueryParams(st, command, params);
 		preparedStatementName(name, st->use_file, st->command);
@@ -2918,6 +2935,20 @@ readCommandResponse(CState *st, char *varprefix)
 				/* otherwise the result is simply thrown away by PQclear below */
 				break;
 
+			case PGRES_PIPELINE_SYNC:
+				if (debug)
+					fprintf(stderr, "client %d pipeline ending\n", st->id);
+				if (PQexitPipelineMode(st->con) != 1)
+				{
+					fprintf(stderr, "client %d failed to exit pipeline mode: %s",
+							st->id, PQerrorMessage(st->con));
+					st->ecnt++;
+					PQclear(res);
+					discard_response(st);
+					return false;
+				}
+				break;
+
 			default:
 				/* anything else is unexpected */
 				fprintf(stderr,
@@ -3291,7 +3322,15 @@ advanceConnectionState(TState *thread, CState *st, StatsData *agg)
 
 				/* store or discard the query results */
 				if (readCommandResponse(st, sql_script[st->use_file].commands[st->command]->varprefix))
-					st->state = CSTATE_END_COMMAND;
+				{
+					/*
+					 * Outside of pipeline mode, we're done with this command.
+					 * In pipeline mode, keep reading results until the
+					 * pipeline sync point, which ends pipeline mode.
+					 */
+					if (PQpipelineStatus(st->con) != PQ_PIPELINE_ON)
+						st->state = CSTATE_END_COMMAND;
+				}
 				else
 					st->state = CSTATE_ABORTED;
 				break;
@@ -3344,6 +3383,16 @@ advanceConnectionState(TState *thread, CState *st, StatsData *agg)
 				 */
 			case CSTATE_END_TX:
 
+				/* an unterminated pipeline would leave results unread */
+				if (PQpipelineStatus(st->con) != PQ_PIPELINE_OFF)
+				{
+					fprintf(stderr,
+							"client %d aborted: end of script reached with pipeline open\n",
+							st->id);
+					st->state = CSTATE_ABORTED;
+					break;
+				}
+
 				/* transaction finished: calculate latency and do log */
 				processXactStats(thread, st, &now, false, agg);
 
@@ -3400,11 +3449,23 @@ doExecuteCommand(TState *thread, CState *st, instr_time now)
 	/* execute the command */
 	if (command->type == SQL_COMMAND)
 	{
-		if (!sendCommand(st, command))
+		/* results are only read at \endpipeline, so \gset can't work */
+		if (command->varprefix != NULL &&
+			PQpipelineStatus(st->con) != PQ_PIPELINE_OFF)
+		{
+			commandFailed(st, "gset", "\\gset is not allowed in pipeline mode");
+			st->state = CSTATE_ABORTED;
+		}
+		else if (!sendCommand(st, command))
 		{
 			commandFailed(st, "SQL", "SQL command send failed");
 			st->state = CSTATE_ABORTED;
 		}
+		else if (PQpipelineStatus(st->con) != PQ_PIPELINE_OFF)
+		{
+			/* results are collected at \endpipeline */
+			st->state = CSTATE_END_COMMAND;
+		}
 		else
 			st->state = CSTATE_WAIT_RESULT;
 	}
@@ -3549,6 +3610,62 @@ doExecuteCommand(TState *thread, CState *st, instr_time now)
 				return now;
 			}
 		}
+		else if (command->meta == META_STARTPIPELINE)
+		{
+			/*
+			 * In pipeline mode, we use a workflow based on libpq pipeline
+			 * functions.
+			 */
+			if (querymode == QUERY_SIMPLE)
+			{
+				commandFailed(st, "startpipeline", "cannot use pipeline mode with the simple query protocol");
+				st->state = CSTATE_ABORTED;
+				return now;
+			}
+
+			if (PQpipelineStatus(st->con) != PQ_PIPELINE_OFF)
+			{
+				commandFailed(st, "startpipeline", "already in pipeline mode");
+				st->state = CSTATE_ABORTED;
+				return now;
+			}
+
+			/*
+			 * Statements can't be prepared synchronously once in pipeline
+			 * mode, so prepare the whole script now.
+			 */
+			if (querymode == QUERY_PREPARED)
+				prepareCommands(st);
+
+			if (PQenterPipelineMode(st->con) != 1)
+			{
+				commandFailed(st, "startpipeline", "failed to enter pipeline mode");
+				st->state = CSTATE_ABORTED;
+				return now;
+			}
+		}
+		else if (command->meta == META_ENDPIPELINE)
+		{
+			if (PQpipelineStatus(st->con) != PQ_PIPELINE_ON)
+			{
+				commandFailed(st, "endpipeline", "not in pipeline mode");
+				st->state = CSTATE_ABORTED;
+				return now;
+			}
+			if (!PQpipelineSync(st->con))
+			{
+				commandFailed(st, "endpipeline", "failed to send a pipeline sync");
+				st->state = CSTATE_ABORTED;
+				return now;
+			}
+
+			/*
+			 * Now collect the pending results; the pipeline is exited when
+			 * the PGRES_PIPELINE_SYNC result arrives.
+			 */
+			st->state = CSTATE_WAIT_RESULT;
+			return now;
+		}
 
 		/*
 		 * executing the expression or shell command might have taken a
@@ -4485,7 +4602,9 @@ process_backslash_command(PsqlScanState sstate, const char *source)
 			syntax_error(source, lineno, my_command->first_line, my_command->argv[0],
 						 "missing command", NULL, -1);
 	}
-	else if (my_command->meta == META_ELSE || my_command->meta == META_ENDIF)
+	else if (my_command->meta == META_ELSE || my_command->meta == META_ENDIF ||
+			 my_command->meta == META_STARTPIPELINE ||
+			 my_command->meta == META_ENDPIPELINE)
 	{
 		if (my_command->argc != 1)
 			syntax_error(source, lineno, my_command->first_line, my_command->argv[0],
@@ -570,6 +570,35 @@ SELECT 0 AS i4, 4 AS i4 \gset
 \set i debug(:i5)
 } });
 
+# working \startpipeline
+pgbench(
+	'-t 10 -M extended', 0,
+	[ qr{type: .*/001_pgbench_pipeline}, qr{processed: 10/10} ],
+	[],
+	'pgbench pipeline',
+	{   '001_pgbench_pipeline' => q{
+-- test startpipeline
+\startpipeline
+} . "select 1;\n" x 10 . q{
+\endpipeline
+} });
+
+# working \startpipeline in prepared query mode
+pgbench(
+	'-t 10 -M prepared', 0,
+	[ qr{type: .*/001_pgbench_pipeline_prep}, qr{processed: 10/10} ],
+	[],
+	'pgbench pipeline prepared',
+	{   '001_pgbench_pipeline_prep' => q{
+-- test startpipeline
+\startpipeline
+\endpipeline
+\startpipeline
+select 1;
+select 1;
+\endpipeline
+} });
+
 # trigger many expression errors
 my @errors = (
 
@@ -783,6 +812,26 @@ SELECT LEAST(}.join(', ', (':i') x 256).q{)}
 	[   'gset bad name', 2,
 		[qr{error storing into variable bad name!}],
 		q{SELECT 1 AS "bad name!" \gset} ],
+
+	# PIPELINE
+	[   'pipeline without end', 2,
+		[qr{end of script reached with pipeline open}],
+		q{\startpipeline} ],
+	[   'endpipeline without start', 2,
+		[qr{not in pipeline mode}],
+		q{\endpipeline} ],
+	[   'nested startpipeline', 2,
+		[qr{already in pipeline mode}],
+		q{\startpipeline
+\startpipeline} ],
+	[   'gset in pipeline', 2,
+		[qr{gset is not allowed in pipeline mode}],
+		q{\startpipeline
+SELECT 1 \gset
+\endpipeline} ],
+	[   'startpipeline with argument', 1,
+		[qr{unexpected argument}],
+		q{\startpipeline 1} ],
 	);
 
 for my $e (@errors)
@@ -61,6 +61,11 @@ typedef struct HeapScanDescData
 	/* rs_numblocks is usually InvalidBlockNumber, meaning "scan whole rel" */
 	BufferAccessStrategy rs_strategy;	/* access strategy for reads */
 
+	/* state for combining reads, used only by serial forward scans */
+	struct ReadStream *rs_read_stream;	/* NULL if not in use */
+	BlockNumber rs_stream_nextblock;	/* next block to feed to the stream */
+	BlockNumber rs_stream_numblocks;	/* blocks left to feed, if limited */
+
 	HeapTupleData rs_ctup;		/* current tuple in scan, if any */
 
 	/* these fields only used in page-at-a-time mode and for bitmap scans */
@@ -126,6 +131,11 @@ extern void heap_endscan(TableScanDesc scan);
 extern HeapTuple heap_getnext(TableScanDesc scan, ScanDirection direction);
 extern bool heap_getnextslot(TableScanDesc sscan,
 				 ScanDirection direction, struct TupleTableSlot *slot);
+extern void heap_set_tidrange(TableScanDesc sscan, ItemPointer mintid,
+				  ItemPointer maxtid);
+extern bool heap_getnextslot_tidrange(TableScanDesc sscan,
+						  ScanDirection direction,
+						  struct TupleTableSlot *slot);
 
 extern bool heap_fetch(Relation relation, Snapshot snapshot,
 		   HeapTuple tuple, Buffer *userbuf);
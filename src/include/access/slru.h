@@ -35,6 +35,17 @@
 /* Maximum length of an SLRU name */
 #define SLRU_MAX_NAME_LENGTH	32
 
+/*
+ * The buffer slots of an SLRU are divided into banks of SLRU_BANK_SIZE slots.
+ * A given page can only ever be held in one bank, chosen by its page number,
+ * and each bank has its own lock.  The number of slots is therefore always a
+ * multiple of SLRU_BANK_SIZE.
+ */
+#define SLRU_BANK_SIZE			16
+
+/* Maximum number of slots an SLRU may be configured with (1GB of buffers) */
+#define SLRU_MAX_ALLOWED_BUFFERS	((1024 * 1024 * 1024) / BLCKSZ)
+
 /*
  * Page status codes.  Note that these do not include the "dirty" bit.
  * page_dirty can be true only in the VALID or WRITE_IN_PROGRESS states;
@@ -54,11 +65,12 @@ typedef enum
  */
 typedef struct SlruSharedData
 {
-	LWLock	   *ControlLock;
-
 	/* Number of buffers managed by this SLRU structure */
 	int			num_slots;
 
+	/* Number of banks, each with its own lock; num_slots / SLRU_BANK_SIZE */
+	int			num_banks;
+
 	/*
 	 * Arrays holding info for each buffer slot.  Page number is undefined
 	 * when status is EMPTY, as is page_lru_count.
@@ -82,26 +94,28 @@ typedef struct SlruSharedData
 
 	/*----------
 	 * We mark a page "most recently used" by setting
-	 *		page_lru_count[slotno] = ++cur_lru_count;
-	 * The oldest page is therefore the one with the highest value of
-	 *		cur_lru_count - page_lru_count[slotno]
+	 *		page_lru_count[slotno] = ++bank_cur_lru_count[bankno];
+	 * The oldest page in a bank is therefore the one with the highest value of
+	 *		bank_cur_lru_count[bankno] - page_lru_count[slotno]
 	 * The counts will eventually wrap around, but this calculation still
 	 * works as long as no page's age exceeds INT_MAX counts.
 	 *----------
 	 */
-	int			cur_lru_count;
+	int		   *bank_cur_lru_count;
 
 	/*
 	 * latest_page_number is the page number of the current end of the log;
 	 * this is not critical data, since we use it only to avoid swapping out
-	 * the latest page.
+	 * the latest page.  It is read without holding any bank lock, hence
+	 * atomic.
 	 */
-	int			latest_page_number;
+	pg_atomic_uint32 latest_page_number;
 
 	/* LWLocks */
 	int			lwlock_tranche_id;
 	char		lwlock_tranche_name[SLRU_MAX_NAME_LENGTH];
 	LWLockPadded *buffer_locks;
+	LWLockPadded *bank_locks;
 } SlruSharedData;
 
 typedef SlruSharedData *SlruShared;
@@ -114,6 +128,9 @@ typedef struct SlruCtlData
 {
 	SlruShared	shared;
 
+	/* Number of banks; copied from shared memory for quick access */
+	int			num_banks;
+
 	/*
 	 * This flag tells whether to fsync writes (true for pg_xact and multixact
 	 * stuff, false for pg_subtrans and pg_notify).
@@ -136,10 +153,40 @@ typedef struct SlruCtlData
 
 typedef SlruCtlData *SlruCtl;
 
+/*
+ * Get the bank number that holds, or would hold, the given page.
+ */
+static inline int
+SimpleLruGetBankNo(SlruCtl ctl, int pageno)
+{
+	return (uint32) pageno % ctl->num_banks;
+}
+
+/*
+ * Get the lock protecting the buffer slots the given page can be held in.
+ * It must be held to look up, read in, or modify that page.
+ */
+static inline LWLock *
+SimpleLruGetBankLock(SlruCtl ctl, int pageno)
+{
+	return &ctl->shared->bank_locks[SimpleLruGetBankNo(ctl, pageno)].lock;
+}
+
+/*
+ * Get the lock protecting the bank that a buffer slot belongs to.
+ */
+static inline LWLock *
+SimpleLruGetSlotBankLock(SlruCtl ctl, int slotno)
+{
+	return &ctl->shared->bank_locks[slotno / SLRU_BANK_SIZE].lock;
+}
 
 extern Size SimpleLruShmemSize(int nslots, int nlsns);
+extern int	SimpleLruAutotuneBuffers(int divisor, int max);
+extern bool check_slru_buffers(const char *name, int *newval);
 extern void SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
-			  LWLock *ctllock, const char *subdir, int tranche_id);
+			  const char *subdir, int tranche_id, int bank_tranche_id);
+extern void SimpleLruSetLatestPage(SlruCtl ctl, int pageno);
 extern int	SimpleLruZeroPage(SlruCtl ctl, int pageno);
 extern int SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 				  TransactionId xid);
@@ -189,6 +189,29 @@ typedef struct TableAmRoutine
 	bool		(*scan_getnextslot) (TableScanDesc scan,
 									 ScanDirection direction, TupleTableSlot *slot);
 
+	/*
+	 * Restrict the scan to tuples with TIDs between `mintid` and `maxtid`,
+	 * both inclusive.  Called after scan_begin / scan_rescan and before the
+	 * first scan_getnextslot_tidrange call.  The AM is free to narrow the
+	 * set of blocks it reads, but must return exactly the tuples within the
+	 * range.
+	 *
+	 * Optional callback; set to NULL (together with
+	 * scan_getnextslot_tidrange) if the AM cannot support TID range scans,
+	 * in which case the planner will not generate them.
+	 */
+	void		(*scan_set_tidrange) (TableScanDesc scan,
+									  ItemPointer mintid,
+									  ItemPointer maxtid);
+
+	/*
+	 * Return next tuple from a TID range scan, store in slot.  Only tuples
+	 * within the range set by scan_set_tidrange may be returned.
+	 */
+	bool		(*scan_getnextslot_tidrange) (TableScanDesc scan,
+											  ScanDirection direction,
+											  TupleTableSlot *slot);
+
 
 	/* ------------------------------------------------------------------------
 	 * Parallel table scan related functions.
@@ -523,6 +546,62 @@ table_scan_getnextslot(TableScanDesc sscan, ScanDirection direction, TupleTableS
 }
 
 
+/*
+ * table_beginscan_tidrange is the entry point for setting up a TableScanDesc
+ * for a TID range scan.  The range must be established with
+ * table_rescan_tidrange() before fetching any tuples.  Neither a buffer
+ * access strategy nor syncscan is used, since the scan usually covers only a
+ * small portion of the relation and must start at the beginning of the range.
+ */
+static inline TableScanDesc
+table_beginscan_tidrange(Relation rel, Snapshot snapshot,
+						 ItemPointer mintid, ItemPointer maxtid)
+{
+	TableScanDesc sscan;
+
+	sscan = rel->rd_tableam->scan_begin(rel, snapshot, 0, NULL, NULL,
+										false, false, true,
+										false, false, false);
+
+	/* Set the range of TIDs to scan */
+	sscan->rs_rd->rd_tableam->scan_set_tidrange(sscan, mintid, maxtid);
+
+	return sscan;
+}
+
+/*
+ * Restart a TID range scan, possibly with a new range of TIDs.
+ */
+static inline void
+table_rescan_tidrange(TableScanDesc sscan, ItemPointer mintid,
+					  ItemPointer maxtid)
+{
+	/* Ensure table_beginscan_tidrange() was used. */
+	Assert(!sscan->rs_allow_strat && !sscan->rs_allow_sync);
+
+	sscan->rs_rd->rd_tableam->scan_rescan(sscan, NULL, false, false, false, false);
+	sscan->rs_rd->rd_tableam->scan_set_tidrange(sscan, mintid, maxtid);
+}
+
+/*
+ * Return next tuple from a TID range scan, store in slot.  Only tuples within
+ * the range set by table_beginscan_tidrange / table_rescan_tidrange are
+ * returned.
+ */
+static inline bool
+table_scan_getnextslot_tidrange(TableScanDesc sscan, ScanDirection direction,
+								TupleTableSlot *slot)
+{
+	/* Ensure table_beginscan_tidrange() was used. */
+	Assert(!sscan->rs_allow_strat && !sscan->rs_allow_sync);
+
+	slot->tts_tableOid = RelationGetRelid(sscan->rs_rd);
+	return sscan->rs_rd->rd_tableam->scan_getnextslot_tidrange(sscan,
+															   direction,
+															   slot);
+}
+
+
 /* ----------------------------------------------------------------------------
  * Parallel table scan related functions.
  * ----------------------------------------------------------------------------
@@ -53,6 +53,6 @@
  */
 
 /*							yyyymmddN */
-#define CATALOG_VERSION_NO	201903271
+#define CATALOG_VERSION_NO	201903282
 
 #endif
@@ -17,11 +17,6 @@
 
 #include "fmgr.h"
 
-/*
- * The number of SLRU page buffers we use for the notification queue.
- */
-#define NUM_ASYNC_BUFFERS	8
-
 extern bool Trace_notify;
 extern volatile sig_atomic_t notifyInterruptPending;
 
@@ -37,6 +32,7 @@ extern void Async_Notify(const char *channel, const char *payload);
 extern void Async_Listen(const char *channel);
 extern void Async_Unlisten(const char *channel);
 extern void Async_UnlistenAll(void);
+extern bool Async_IsListening(void);
 
 /* perform (or cancel) outbound notify processing at transaction commit */
 extern void PreCommit_Notify(void);
@@ -59,6 +59,7 @@ extern ObjectAddress DefineSequence(ParseState *pstate, CreateSeqStmt *stmt);
 extern ObjectAddress AlterSequence(ParseState *pstate, AlterSeqStmt *stmt);
 extern void DeleteSequenceTuple(Oid relid);
 extern void ResetSequence(Oid seq_relid);
+extern bool SequenceCachesExist(void);
 extern void ResetSequenceCaches(void);
 
 extern void seq_redo(XLogReaderState *rptr);
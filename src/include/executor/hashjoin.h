@@ -14,6 +14,7 @@
 #ifndef HASHJOIN_H
 #define HASHJOIN_H
 
+#include "lib/bloomfilter.h"
 #include "nodes/execnodes.h"
 #include "port/atomics.h"
 #include "storage/barrier.h"
@@ -110,6 +111,14 @@ typedef struct HashSkewBucket
 #define SKEW_WORK_MEM_PERCENT  2
 #define SKEW_MIN_OUTER_FRACTION  0.01
 
+/*
+ * A bloom filter of the inner hash values, pushed down to the outer scan, is
+ * limited to BLOOM_WORK_MEM_PERCENT of work_mem, and its space is taken out
+ * of the hash table's budget.  bloomfilter.c never makes a filter smaller than
+ * 1MB, so there is no filter when work_mem is too small for that.
+ */
+#define BLOOM_WORK_MEM_PERCENT	25
+
 /*
  * To reduce palloc overhead, the HashJoinTuples for the current batch are
  * packed in 32kB buffers instead of pallocing each tuple individually.
@@ -240,6 +249,7 @@ typedef struct ParallelHashJoinState
 	int			nbuckets;		/* number of buckets */
 	ParallelHashGrowth growth;	/* control batch/bucket growth */
 	dsa_pointer chunk_work_queue;	/* chunk work queue */
+	dsa_pointer bloomfilter;	/* bloom filter of inner hash values, if any */
 	int			nparticipants;
 	size_t		space_allowed;
 	size_t		total_tuples;	/* total number of inner tuples */
@@ -339,6 +349,15 @@ typedef struct HashJoinTableData
 	bool	   *hashStrict;		/* is each hash join operator strict? */
 	Oid		   *collations;
 
+	/*
+	 * If requested by the Hash node, a bloom filter of the hash values of all
+	 * inner tuples, which the outer scan can probe to discard tuples that
+	 * cannot have a match.  It's set only once the inner relation has been
+	 * completely hashed; with Parallel Hash it points into the DSA area.
+	 */
+	bloom_filter *bloomfilter;
+	Size		bloomSpace;		/* size of one bloom filter, or 0 */
+
 	Size		spaceUsed;		/* memory space currently used by tuples */
 	Size		spaceAllowed;	/* upper limit for space used */
 	Size		spacePeak;		/* peak space used */
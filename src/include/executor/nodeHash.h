@@ -49,6 +49,10 @@ extern bool ExecHashGetHashValue(HashJoinTable hashtable,
 					 bool outer_tuple,
 					 bool keep_nulls,
 					 uint32 *hashvalue);
+extern int	ExecHashBloomWorkMem(void);
+extern bool ExecHashBloomLacksTuple(HashJoinTable hashtable,
+						ExprContext *econtext,
+						List *hashkeys);
 extern void ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 						  uint32 hashvalue,
 						  int *bucketno,
@@ -17,7 +17,11 @@ typedef struct bloom_filter bloom_filter;
 
 extern bloom_filter *bloom_create(int64 total_elems, int bloom_work_mem,
 			 uint64 seed);
+extern Size bloom_estimate(int64 total_elems, int bloom_work_mem);
+extern bloom_filter *bloom_init(void *space, int64 total_elems,
+		   int bloom_work_mem, uint64 seed);
 extern void bloom_free(bloom_filter *filter);
+extern void bloom_union(bloom_filter *dst, bloom_filter *src);
 extern void bloom_add_element(bloom_filter *filter, unsigned char *elem,
 				  size_t len);
 extern bool bloom_lacks_element(bloom_filter *filter, unsigned char *elem,
@@ -150,6 +150,16 @@ typedef struct Port
 	 */
 	HbaLine    *hba;
 
+	/*
+	 * Connection pooling state, see postmaster/sessionpool.c.  pool_key is
+	 * set only while starting up a backend for a session that was established
+	 * by another backend.
+	 */
+	pgsocket	pool_channel;	/* channel to postmaster, or PGINVALID_SOCKET */
+	struct SessionPoolKey *pool_key;
+	int			pool_session_pid;	/* BackendKeyData of the session */
+	int32		pool_session_key;
+
 	/*
 	 * TCP keepalive settings.
 	 *
@@ -489,6 +489,19 @@ typedef struct TidScan
 	List	   *tidquals;		/* qual(s) involving CTID = something */
 } TidScan;
 
+/* ----------------
+ *		tid range scan node
+ *
+ * tidrangequals is an implicitly AND'ed list of qual expressions of the form
+ * "CTID relop pseudoconstant", where relop is one of >,>=,<,<=.
+ * ----------------
+ */
+typedef struct TidRangeScan
+{
+	Scan		scan;
+	List	   *tidrangequals;	/* qual(s) involving CTID op something */
+} TidRangeScan;
+
 /* ----------------
  *		subquery scan node
  *
@@ -737,6 +750,7 @@ typedef struct HashJoin
 {
 	Join		join;
 	List	   *hashclauses;
+	bool		bloom_filter;	/* push a filter on inner keys to outer scan? */
 } HashJoin;
 
 /* ----------------
@@ -109,6 +109,13 @@
  */
 #define ALIGNOF_BUFFER	32
 
+/*
+ * Alignment required for buffers used with direct I/O (O_DIRECT).  Most
+ * file systems and devices need no more than the logical sector size, but
+ * some require the memory page size, so we use that.
+ */
+#define PG_IO_ALIGN_SIZE	4096
+
 /*
  * Disable UNIX sockets for certain operating systems.
  */
@@ -0,0 +1,42 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_iovec.h
+ *	  Header for vectored I/O functions, to use in place of <sys/uio.h>.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/port/pg_iovec.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PG_IOVEC_H
+#define PG_IOVEC_H
+
+#include <limits.h>
+
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+
+/* If <sys/uio.h> is missing, define our own POSIX-compatible iovec struct. */
+#ifdef WIN32
+struct iovec
+{
+	void	   *iov_base;
+	size_t		iov_len;
+};
+#endif
+
+/*
+ * If <limits.h> doesn't define IOV_MAX, assume the POSIX minimum.  We cap the
+ * number of vectors we'll use in a single call ourselves, so that arrays of
+ * struct iovec can be kept on the stack.
+ */
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+
+#define PG_IOV_MAX Min(IOV_MAX, 32)
+
+#endif							/* PG_IOVEC_H */
@@ -0,0 +1,27 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_numa.h
+ *	  Miscellaneous functions for NUMA-aware memory placement.
+ *
+ * These are thin wrappers around libnuma.  In builds without libnuma, or on
+ * machines where the kernel doesn't support NUMA, they report a single node
+ * and leave memory placement to the operating system.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ * src/include/port/pg_numa.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PG_NUMA_H
+#define PG_NUMA_H
+
+/* Upper limit on the number of NUMA nodes we make use of */
+#define PG_NUMA_MAX_NODES	64
+
+extern int	pg_numa_init(void);
+extern int	pg_numa_get_node(void);
+extern int	pg_numa_interleave_memory(void *ptr, Size size, Size pagesize);
+extern int	pg_numa_bind_memory(void *ptr, Size size, Size pagesize, int node);
+
+#endif							/* PG_NUMA_H */
@@ -0,0 +1,90 @@
+/*-------------------------------------------------------------------------
+ *
+ * sessionpool.h
+ *	  Exports from postmaster/sessionpool.c.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ * src/include/postmaster/sessionpool.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SESSIONPOOL_H
+#define SESSIONPOOL_H
+
+#include "libpq/libpq-be.h"
+#include "libpq/pqcomm.h"
+
+/* GUC options */
+extern int	connection_pool_size;
+extern int	max_pooled_sessions;
+
+/*
+ * Hook for extensions that keep session state of their own, such as open
+ * connections to other servers: return false to keep the current session
+ * with this backend.
+ */
+typedef bool (*session_pool_release_hook_type) (void);
+extern PGDLLIMPORT session_pool_release_hook_type session_pool_release_hook;
+
+/* Room for startup packet options in a SessionPoolKey */
+#define SESSION_POOL_OPTIONS_SIZE	1024
+
+/*
+ * Sessions can only be served by backends connected to the same database as
+ * the same user, with the same startup packet options.  The options are the
+ * command-line options followed by alternating GUC names and values, all as
+ * NUL-terminated strings.
+ */
+typedef struct SessionPoolKey
+{
+	char		database[NAMEDATALEN];
+	char		user[NAMEDATALEN];
+	ProtocolVersion proto;
+	int			optionslen;		/* bytes used in options[] */
+	char		options[SESSION_POOL_OPTIONS_SIZE];
+} SessionPoolKey;
+
+/*
+ * Messages exchanged by the postmaster and a pooled or pre-forked backend over
+ * the backend's pool channel.  A RETURN, ASSIGN or CONNECT message carries the
+ * client's socket along with it.  A CONNECT message has a zero sessionPid
+ * unless it's for a pooled session.
+ */
+typedef enum SessionPoolMessageType
+{
+	SPM_RETURN,					/* backend to postmaster: session is idle */
+	SPM_RELEASE,				/* backend to postmaster: session has ended */
+	SPM_ASSIGN,					/* postmaster to backend: serve this session */
+	SPM_CONNECT,				/* postmaster to pre-forked backend: serve this
+								 * connection */
+	SPM_EXIT					/* postmaster to backend: exit */
+} SessionPoolMessageType;
+
+typedef struct SessionPoolMessage
+{
+	SessionPoolMessageType type;
+	int			sessionPid;		/* BackendKeyData sent to the client */
+	int32		sessionKey;
+	SessionPoolKey key;
+} SessionPoolMessage;
+
+/* Is connection pooling supported on this platform? */
+#if defined(HAVE_UNIX_SOCKETS) && !defined(WIN32) && !defined(EXEC_BACKEND)
+#define SESSION_POOL_SUPPORTED
+#endif
+
+extern bool SessionPoolCreateChannel(pgsocket *postmasterEnd,
+						 pgsocket *backendEnd);
+extern bool SessionPoolSend(pgsocket channel, const SessionPoolMessage *msg,
+				pgsocket sock);
+extern bool SessionPoolReceive(pgsocket channel, SessionPoolMessage *msg,
+				   pgsocket *sock);
+extern bool SessionPoolKeyEquals(const SessionPoolKey *a,
+					 const SessionPoolKey *b);
+
+extern void SessionPoolRestorePort(Port *port);
+extern bool SessionPoolCanReleaseSession(void);
+extern void SessionPoolReleaseSession(bool keepSession);
+
+#endif							/* SESSIONPOOL_H */
@@ -229,6 +229,15 @@ typedef union BufferDescPadded
 
 extern PGDLLIMPORT LWLockMinimallyPadded *BufferIOLWLockArray;
 
+/*
+ * With numa_placement = partition, the nbuffers buffers in use are divided
+ * into one contiguous range per NUMA node.  This gives the first buffer of a
+ * node's range; the range ends where the next node's begins.  The ranges
+ * move when the pool is resized.
+ */
+#define BufferNodeFirstBuffer(node, nnodes, nbuffers) \
+	((int) (((uint64) (nbuffers) * (node)) / (nnodes)))
+
 /*
  * The freeNext field is either the index of the next freelist entry,
  * or one of these special values:
@@ -304,16 +313,32 @@ extern CkptSortItem *CkptBufferIds;
 extern void WritebackContextInit(WritebackContext *context, int *max_pending);
 extern void IssuePendingWritebacks(WritebackContext *context);
 extern void ScheduleBufferTagForWriteback(WritebackContext *context, BufferTag *tag);
+extern bool EvictSharedBuffer(BufferDesc *buf);
+
+/*
+ * Cumulative statistics about buffer replacement, see StrategyGetStats().
+ */
+typedef struct BufferStrategyStats
+{
+	uint64		buffer_allocs;	/* buffers allocated for new pages, other
+								 * than by reusing a strategy ring element */
+	uint64		freelist_allocs;	/* ... of which taken from the freelist */
+	uint64		ring_reuses;	/* strategy ring elements reused */
+	uint64		clock_sweep_ticks;	/* buffers passed by the clock hand */
+	uint64		clock_sweep_passes; /* complete passes of the clock hand */
+} BufferStrategyStats;
 
 /* freelist.c */
 extern BufferDesc *StrategyGetBuffer(BufferAccessStrategy strategy,
 				  uint32 *buf_state);
 extern void StrategyFreeBuffer(BufferDesc *buf);
+extern void StrategySetUsableBuffers(int nbuffers);
 extern bool StrategyRejectBuffer(BufferAccessStrategy strategy,
 					 BufferDesc *buf);
 
 extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc);
 extern void StrategyNotifyBgWriter(int bgwprocno);
+extern void StrategyGetStats(BufferStrategyStats *stats);
 
 extern Size StrategyShmemSize(void);
 extern void StrategyInitialize(bool init);
@@ -324,8 +349,9 @@ extern Size BufTableShmemSize(int size);
 extern void InitBufTable(int size);
 extern uint32 BufTableHashCode(BufferTag *tagPtr);
 extern int	BufTableLookup(BufferTag *tagPtr, uint32 hashcode);
+extern int	BufTableLookupHint(uint32 hashcode);
 extern int	BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id);
-extern void BufTableDelete(BufferTag *tagPtr, uint32 hashcode);
+extern void BufTableDelete(BufferTag *tagPtr, uint32 hashcode, int buf_id);
 
 /* localbuf.c */
 extern void LocalPrefetchBuffer(SMgrRelation smgr, ForkNumber forkNum,
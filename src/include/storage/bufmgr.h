@@ -14,6 +14,7 @@
 #ifndef BUFMGR_H
 #define BUFMGR_H
 
+#include "port/pg_iovec.h"
 #include "storage/block.h"
 #include "storage/buf.h"
 #include "storage/bufpage.h"
@@ -46,11 +47,23 @@ typedef enum
 								 * replay; otherwise same as RBM_NORMAL */
 } ReadBufferMode;
 
+/* Possible values for buffer_replacement_policy */
+typedef enum BufferReplacementPolicy
+{
+	BUFFER_REPLACEMENT_CLOCK,	/* Plain clock sweep */
+	BUFFER_REPLACEMENT_PROBATION	/* Clock sweep, new pages start at usage
+									 * count 0 */
+} BufferReplacementPolicy;
+
 /* forward declared, to avoid having to expose buf_internals.h here */
 struct WritebackContext;
 
+/* forward declared, to avoid including smgr.h here */
+struct SMgrRelationData;
+
 /* in globals.c ... this duplicates miscadmin.h */
 extern PGDLLIMPORT int NBuffers;
+extern PGDLLIMPORT int MaxNBuffers;
 
 /* in bufmgr.c */
 extern bool zero_damaged_pages;
@@ -63,8 +76,14 @@ extern int	checkpoint_flush_after;
 extern int	backend_flush_after;
 extern int	bgwriter_flush_after;
 
+extern int	io_combine_limit;
+
+/* in freelist.c */
+extern int	buffer_replacement_policy;
+
 /* in buf_init.c */
 extern PGDLLIMPORT char *BufferBlocks;
+extern int	max_shared_buffers;
 
 /* in guc.c */
 extern int	effective_io_concurrency;
@@ -77,6 +96,9 @@ extern PGDLLIMPORT int32 *LocalRefCount;
 /* upper limit for effective_io_concurrency */
 #define MAX_IO_CONCURRENCY 1000
 
+/* upper limit for io_combine_limit */
+#define MAX_IO_COMBINE_LIMIT PG_IOV_MAX
+
 /* special block number for ReadBuffer() */
 #define P_NEW	InvalidBlockNumber	/* grow the file to get a new page */
 
@@ -168,6 +190,11 @@ extern Buffer ReadBuffer(Relation reln, BlockNumber blockNum);
 extern Buffer ReadBufferExtended(Relation reln, ForkNumber forkNum,
 				   BlockNumber blockNum, ReadBufferMode mode,
 				   BufferAccessStrategy strategy);
+extern int	ReadBuffers(Relation reln, ForkNumber forkNum, BlockNumber blockNum,
+			int nblocks, Buffer *buffers, BufferAccessStrategy strategy);
+extern BlockNumber ExtendBufferedRelBy(Relation reln, ForkNumber forkNum,
+					int extend_by, Buffer *buffers,
+					BufferAccessStrategy strategy);
 extern Buffer ReadBufferWithoutRelcache(RelFileNode rnode,
 						  ForkNumber forkNum, BlockNumber blockNum,
 						  ReadBufferMode mode, BufferAccessStrategy strategy);
@@ -190,9 +217,10 @@ extern BlockNumber RelationGetNumberOfBlocksInFork(Relation relation,
 extern void FlushOneBuffer(Buffer buffer);
 extern void FlushRelationBuffers(Relation rel);
 extern void FlushDatabaseBuffers(Oid dbid);
-extern void DropRelFileNodeBuffers(RelFileNodeBackend rnode,
+extern void DropRelFileNodeBuffers(struct SMgrRelationData *smgr_reln,
 					   ForkNumber forkNum, BlockNumber firstDelBlock);
-extern void DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes);
+extern void DropRelFileNodesAllBuffers(struct SMgrRelationData **smgr_reln,
+						   int nnodes);
 extern void DropDatabaseBuffers(Oid dbid);
 
 #define RelationGetNumberOfBlocks(reln) \
@@ -205,6 +233,9 @@ extern XLogRecPtr BufferGetLSNAtomic(Buffer buffer);
 extern void PrintPinnedBufs(void);
 #endif
 extern Size BufferShmemSize(void);
+extern bool BufferPoolResizePending(void);
+extern void ResizeBufferPool(void);
+extern void RefreshBufferPoolSize(void);
 extern void BufferGetTag(Buffer buffer, RelFileNode *rnode,
 			 ForkNumber *forknum, BlockNumber *blknum);
 
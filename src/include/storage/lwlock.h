@@ -116,18 +116,36 @@ extern PGDLLIMPORT int NamedLWLockTrancheRequests;
 #define LOG2_NUM_LOCK_PARTITIONS  4
 #define NUM_LOCK_PARTITIONS  (1 << LOG2_NUM_LOCK_PARTITIONS)
 
-/* Number of partitions the shared predicate lock tables are divided into */
-#define LOG2_NUM_PREDICATELOCK_PARTITIONS  4
+/*
+ * Number of partitions the shared predicate lock tables are divided into.
+ * SIREAD locks are taken for every tuple and page a serializable transaction
+ * reads, so these see more traffic than the regular lock tables.
+ */
+#define LOG2_NUM_PREDICATELOCK_PARTITIONS  6
 #define NUM_PREDICATELOCK_PARTITIONS  (1 << LOG2_NUM_PREDICATELOCK_PARTITIONS)
 
+/* Number of partitions of the shared relation size cache */
+#define LOG2_NUM_SMGR_SHARED_RELATION_PARTITIONS  4
+#define NUM_SMGR_SHARED_RELATION_PARTITIONS  \
+	(1 << LOG2_NUM_SMGR_SHARED_RELATION_PARTITIONS)
+
+/* Number of partitions of the shared catalog cache */
+#define LOG2_NUM_SHARED_CATCACHE_PARTITIONS  4
+#define NUM_SHARED_CATCACHE_PARTITIONS  \
+	(1 << LOG2_NUM_SHARED_CATCACHE_PARTITIONS)
+
 /* Offsets for various chunks of preallocated lwlocks. */
 #define BUFFER_MAPPING_LWLOCK_OFFSET	NUM_INDIVIDUAL_LWLOCKS
 #define LOCK_MANAGER_LWLOCK_OFFSET		\
 	(BUFFER_MAPPING_LWLOCK_OFFSET + NUM_BUFFER_PARTITIONS)
 #define PREDICATELOCK_MANAGER_LWLOCK_OFFSET \
 	(LOCK_MANAGER_LWLOCK_OFFSET + NUM_LOCK_PARTITIONS)
-#define NUM_FIXED_LWLOCKS \
+#define SMGR_SHARED_RELATION_LWLOCK_OFFSET \
 	(PREDICATELOCK_MANAGER_LWLOCK_OFFSET + NUM_PREDICATELOCK_PARTITIONS)
+#define SHARED_CATCACHE_LWLOCK_OFFSET \
+	(SMGR_SHARED_RELATION_LWLOCK_OFFSET + NUM_SMGR_SHARED_RELATION_PARTITIONS)
+#define NUM_FIXED_LWLOCKS \
+	(SHARED_CATCACHE_LWLOCK_OFFSET + NUM_SHARED_CATCACHE_PARTITIONS)
 
 typedef enum LWLockMode
 {
@@ -220,6 +238,16 @@ typedef enum BuiltinTrancheIds
 	LWTRANCHE_TBM,
 	LWTRANCHE_PARALLEL_APPEND,
 	LWTRANCHE_SXACT,
+	LWTRANCHE_SMGR_SHARED_RELATION,
+	LWTRANCHE_SHARED_CATCACHE,
+	LWTRANCHE_SHARED_PLAN_CACHE,
+	LWTRANCHE_CLOG_SLRU,
+	LWTRANCHE_COMMITTS_SLRU,
+	LWTRANCHE_SUBTRANS_SLRU,
+	LWTRANCHE_MXACTOFFSET_SLRU,
+	LWTRANCHE_MXACTMEMBER_SLRU,
+	LWTRANCHE_ASYNC_SLRU,
+	LWTRANCHE_OLDSERXID_SLRU,
 	LWTRANCHE_FIRST_USER_DEFINED
 }			BuiltinTrancheIds;
 
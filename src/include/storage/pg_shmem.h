@@ -44,6 +44,7 @@ typedef struct PGShmemHeader	/* standard header for all Postgres shmem */
 /* GUC variables */
 extern int	shared_memory_type;
 extern int	huge_pages;
+extern int	numa_placement;
 
 /* Possible values for huge_pages */
 typedef enum
@@ -53,6 +54,14 @@ typedef enum
 	HUGE_PAGES_TRY
 }			HugePagesType;
 
+/* Possible values for numa_placement */
+typedef enum
+{
+	NUMA_PLACEMENT_OFF,
+	NUMA_PLACEMENT_INTERLEAVE,
+	NUMA_PLACEMENT_PARTITION
+}			NumaPlacementType;
+
 /* Possible values for shared_memory_type */
 typedef enum
 {
@@ -67,6 +76,8 @@ extern unsigned long UsedShmemSegID;
 extern HANDLE UsedShmemSegID;
 #endif
 extern void *UsedShmemSegAddr;
+extern Size UsedShmemPageSize;	/* page size backing the segment, or 0 if
+								 * not known */
 
 #if !defined(WIN32) && !defined(EXEC_BACKEND)
 #define DEFAULT_SHARED_MEMORY_TYPE SHMEM_TYPE_MMAP
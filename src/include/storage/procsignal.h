@@ -33,6 +33,7 @@ typedef enum
 	PROCSIG_NOTIFY_INTERRUPT,	/* listen/notify interrupt */
 	PROCSIG_PARALLEL_MESSAGE,	/* message from cooperating parallel backend */
 	PROCSIG_WALSND_INIT_STOPPING,	/* ask walsenders to prepare for shutdown  */
+	PROCSIG_BARRIER,			/* global barrier interrupt  */
 
 	/* Recovery conflict reasons */
 	PROCSIG_RECOVERY_CONFLICT_DATABASE,
@@ -45,6 +46,16 @@ typedef enum
 	NUM_PROCSIGNALS				/* Must be last! */
 } ProcSignalReason;
 
+/*
+ * Kinds of global barriers.  Each is a change to some piece of process-local
+ * state that all processes must have adopted before the process requesting
+ * the change can proceed; see EmitProcSignalBarrier().
+ */
+typedef enum
+{
+	PROCSIGNAL_BARRIER_SHARED_BUFFERS	/* shared buffer pool was resized */
+} ProcSignalBarrierType;
+
 /*
  * prototypes for functions in procsignal.c
  */
@@ -55,6 +66,10 @@ extern void ProcSignalInit(int pss_idx);
 extern int SendProcSignal(pid_t pid, ProcSignalReason reason,
 			   BackendId backendId);
 
+extern uint64 EmitProcSignalBarrier(ProcSignalBarrierType type);
+extern bool WaitForProcSignalBarrier(uint64 generation, long timeout);
+extern void ProcessProcSignalBarrier(void);
+
 extern void procsignal_sigusr1_handler(SIGNAL_ARGS);
 
 #endif							/* PROCSIGNAL_H */
@@ -38,6 +38,9 @@ extern void *ShmemAlloc(Size size);
 extern void *ShmemAllocNoError(Size size);
 extern void *ShmemAllocUnlocked(Size size);
 extern bool ShmemAddrIsValid(const void *addr);
+extern int	ShmemNumaNodes(void);
+extern void ShmemNumaInterleave(void *ptr, Size size);
+extern void ShmemNumaBind(void *ptr, Size size, int node);
 extern void InitShmemIndex(void);
 extern HTAB *ShmemInitHash(const char *name, long init_size, long max_size,
 			  HASHCTL *infoP, int hash_flags);
@@ -25,6 +25,13 @@
 #include "storage/lock.h"
 #include "storage/sinval.h"
 
+/* Limits of the sinval_queue_size parameter; both must be powers of 2 */
+#define SINVAL_QUEUE_SIZE_MIN	4096
+#define SINVAL_QUEUE_SIZE_MAX	(1024 * 1024)
+
+/* GUC variable */
+extern int	sinval_queue_size;
+
 /*
  * prototypes for functions in sinvaladt.c
  */
@@ -189,6 +189,14 @@ typedef struct catcacheheader
 /* this extern duplicates utils/memutils.h... */
 extern PGDLLIMPORT MemoryContext CacheMemoryContext;
 
+/* GUC variable */
+extern int	shared_catalog_cache_entries;
+
+extern Size SharedCatCacheShmemSize(void);
+extern void SharedCatCacheShmemInit(void);
+extern void SharedCatCacheInvalidate(int cacheId, Oid dbId, uint32 hashValue);
+extern void SharedCatCacheFlushDatabase(Oid dbId);
+
 extern void CreateCacheMemoryContext(void);
 
 extern CatCache *InitCatCache(int id, Oid reloid, Oid indexoid,
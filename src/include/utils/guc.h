@@ -350,6 +350,8 @@ extern const char *GetConfigOption(const char *name, bool missing_ok,
 				bool restrict_privileged);
 extern const char *GetConfigOptionResetString(const char *name);
 extern int	GetConfigOptionFlags(const char *name, bool missing_ok);
+extern uint32 GetPlannerSettingsHash(void);
+extern bool HaveSessionGUCSettings(void);
 extern void ProcessConfigFile(GucContext context);
 extern void InitializeGUCOptions(void);
 extern bool SelectConfigFiles(const char *userDoption, const char *progname);
@@ -18,6 +18,7 @@
 #include "access/tupdesc.h"
 #include "lib/ilist.h"
 #include "nodes/params.h"
+#include "storage/sinval.h"
 #include "utils/queryenvironment.h"
 
 /* Forward declaration, to avoid including parsenodes.h here */
@@ -31,8 +32,9 @@ typedef enum
 	PLAN_CACHE_MODE_FORCE_CUSTOM_PLAN
 }			PlanCacheMode;
 
-/* GUC parameter */
+/* GUC parameters */
 extern int	plan_cache_mode;
+extern int	shared_plan_cache_size;
 
 #define CACHEDPLANSOURCE_MAGIC		195726186
 #define CACHEDPLAN_MAGIC			953717834
@@ -222,4 +224,11 @@ extern void ReleaseCachedPlan(CachedPlan *plan, bool useResOwner);
 extern CachedExpression *GetCachedExpression(Node *expr);
 extern void FreeCachedExpression(CachedExpression *cexpr);
 
+extern Size SharedPlanCacheShmemSize(void);
+extern void SharedPlanCacheShmemInit(void);
+extern bool SharedPlanCacheInvalidate(const SharedInvalidationMessage *msgs,
+						  int n);
+extern void SharedPlanCacheAdvanceGeneration(void);
+extern void SharedPlanCacheFlushDatabase(Oid dbId);
+
 #endif							/* PLANCACHE_H */
@@ -162,6 +162,14 @@ typedef struct SnapshotData
 	int32		subxcnt;		/* # of xact ids in subxip[] */
 	bool		suboverflowed;	/* has the subxip array overflowed? */
 
+	/*
+	 * If suboverflowed, subxip[] is still complete for XIDs preceding
+	 * suboverflowxmin, the oldest top-level XID whose subxact cache had
+	 * overflowed.  Only XIDs from there up need to be looked up in
+	 * pg_subtrans.  Snapshots that don't know better set it to xmin.
+	 */
+	TransactionId suboverflowxmin;
+
 	bool		takenDuringRecovery;	/* recovery-shaped snapshot? */
 	bool		copied;			/* false if it's a static snapshot */
 
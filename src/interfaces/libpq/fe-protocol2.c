@@ -517,6 +517,8 @@ pqParseInput2(PGconn *conn)
 					conn->asyncStatus = PGASYNC_READY;
 					break;
 				case 'Z':		/* backend is ready for new query */
+					/* the query is complete; forget it */
+					pqCommandQueueAdvance(conn);
 					conn->asyncStatus = PGASYNC_IDLE;
 					break;
 				case 'I':		/* empty query */
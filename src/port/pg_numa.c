@@ -0,0 +1,171 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_numa.c
+ *	  Miscellaneous functions for NUMA-aware memory placement.
+ *
+ * Memory placement policies are applied with mbind(2), so they must be set
+ * before the memory is first touched; the kernel allocates each page on
+ * the node chosen by the policy when the page is first faulted in.  The
+ * range passed in is shrunk to whole pages of the given size, since a
+ * policy can only be attached to complete pages.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ * src/port/pg_numa.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "c.h"
+
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include "port/pg_numa.h"
+
+#ifdef HAVE_LIBNUMA
+
+static int	pg_numa_nodes = 0;
+
+static bool pg_numa_align_range(void *ptr, Size size, Size pagesize,
+					char **start, Size *len);
+
+#endif
+
+/*
+ * pg_numa_init --- return the number of NUMA nodes we can place memory on
+ *
+ * Returns 1 if NUMA isn't supported, either by this build or by the
+ * kernel, so that callers can treat that like a single-node machine.
+ */
+int
+pg_numa_init(void)
+{
+#ifdef HAVE_LIBNUMA
+	if (pg_numa_nodes == 0)
+	{
+		if (numa_available() < 0)
+			pg_numa_nodes = 1;
+		else
+			pg_numa_nodes = Min(Max(numa_max_node() + 1, 1),
+								PG_NUMA_MAX_NODES);
+	}
+	return pg_numa_nodes;
+#else
+	return 1;
+#endif
+}
+
+/*
+ * pg_numa_get_node --- return the NUMA node the calling process runs on
+ *
+ * The answer is only a snapshot, as the scheduler is free to move us to
+ * another CPU at any time.  Returns 0 if it cannot be determined.
+ */
+int
+pg_numa_get_node(void)
+{
+#ifdef HAVE_LIBNUMA
+	int			cpu;
+	int			node;
+
+	if (pg_numa_init() <= 1)
+		return 0;
+
+	cpu = sched_getcpu();
+	if (cpu < 0)
+		return 0;
+	node = numa_node_of_cpu(cpu);
+	if (node < 0 || node >= pg_numa_nodes)
+		return 0;
+	return node;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * pg_numa_interleave_memory --- spread a memory range across all nodes
+ *
+ * Returns 0 on success, or -1 with errno set on failure.
+ */
+int
+pg_numa_interleave_memory(void *ptr, Size size, Size pagesize)
+{
+#ifdef HAVE_LIBNUMA
+	char	   *start;
+	Size		len;
+
+	if (pg_numa_init() <= 1 ||
+		!pg_numa_align_range(ptr, size, pagesize, &start, &len))
+		return 0;
+
+	return mbind(start, len, MPOL_INTERLEAVE, numa_all_nodes_ptr->maskp,
+				 numa_all_nodes_ptr->size + 1, 0);
+#else
+	return 0;
+#endif
+}
+
+/*
+ * pg_numa_bind_memory --- place a memory range on the given node
+ *
+ * The node is only a preference: if it runs out of memory, the kernel
+ * allocates from other nodes rather than failing.
+ *
+ * Returns 0 on success, or -1 with errno set on failure.
+ */
+int
+pg_numa_bind_memory(void *ptr, Size size, Size pagesize, int node)
+{
+#ifdef HAVE_LIBNUMA
+	struct bitmask *mask;
+	char	   *start;
+	Size		len;
+	int			result;
+
+	if (pg_numa_init() <= 1 ||
+		!pg_numa_align_range(ptr, size, pagesize, &start, &len))
+		return 0;
+
+	mask = numa_allocate_nodemask();
+	numa_bitmask_setbit(mask, node);
+	result = mbind(start, len, MPOL_PREFERRED, mask->maskp, mask->size + 1, 0);
+	numa_bitmask_free(mask);
+
+	return result;
+#else
+	return 0;
+#endif
+}
+
+#ifdef HAVE_LIBNUMA
+
+/*
+ * Shrink [ptr, ptr + size) to the whole pages it contains.  Returns false if
+ * there aren't any.
+ */
+static bool
+pg_numa_align_range(void *ptr, Size size, Size pagesize,
+					char **start, Size *len)
+{
+	uintptr_t	first;
+	uintptr_t	last;
+
+	if (pagesize == 0)
+		pagesize = sysconf(_SC_PAGESIZE);
+
+	first = TYPEALIGN(pagesize, (uintptr_t) ptr);
+	last = TYPEALIGN_DOWN(pagesize, (uintptr_t) ptr + size);
+	if (last <= first)
+		return false;
+
+	*start = (char *) first;
+	*len = last - first;
+	return true;
+}
+
+#endif							/* HAVE_LIBNUMA */
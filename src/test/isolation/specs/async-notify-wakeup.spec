@@ -0,0 +1,38 @@
+# Verify which listening backends a notifying backend signals.
+#
+# Only listeners on a notified channel are signaled.  A listener on another
+# channel that is idle where our notifications start is moved past them
+# instead, unless it lags so far behind that it holds back the queue tail,
+# in which case it is signaled too.  The notifier reports what it did with
+# trace_notify.
+#
+# Each notification with a 7000 byte payload takes a queue page of its own.
+
+session "listener_a"
+step "la_listen"	{ LISTEN a; }
+step "la_begin"		{ BEGIN; }
+step "la_commit"	{ COMMIT; }
+teardown			{ UNLISTEN *; }
+
+session "listener_b"
+step "lb_listen"	{ LISTEN b; }
+step "lb_begin"		{ BEGIN; }
+step "lb_commit"	{ COMMIT; }
+teardown			{ UNLISTEN *; }
+
+session "notifier"
+setup				{ SET trace_notify = on; SET client_min_messages = debug1; }
+step "notify_a"		{ NOTIFY a; }
+step "notify_b"		{ NOTIFY b; }
+step "notify_a_page"	{ SELECT count(pg_notify('a', s || repeat('x', 7000))) FROM generate_series(1, 1) s; }
+step "notify_a_pages"	{ SELECT count(pg_notify('a', s || repeat('x', 7000))) FROM generate_series(2, 5) s; }
+
+# listener_b is moved past the notification on a, and only listener_a is
+# signaled.  listener_a can't read the queue in its transaction, so it is
+# not moved past the following notification on b.
+permutation "lb_listen" "la_listen" "la_begin" "notify_a" "notify_b" "la_commit"
+
+# listener_b doesn't read the notification on b in its transaction, and so
+# isn't moved past the following ones.  It is signaled again only once it
+# is at least four pages behind.
+permutation "lb_listen" "lb_begin" "notify_b" "notify_a_page" "notify_a_pages" "lb_commit"
@@ -0,0 +1,84 @@
+# Summarized predicate locks
+#
+# When there are no more SERIALIZABLEXACT slots, the oldest committed
+# serializable transaction is summarized: its SIREAD locks are moved to a
+# dummy transaction, and show in pg_locks without a pid.  s2 commits more
+# serializable transactions than there are slots, while s1 keeps them
+# interesting.  The summarized locks must still count: a write by s1 to a
+# row read by a summarized transaction that s1 has a conflict out to fails.
+# And they must be released once no read-write transaction overlaps the
+# transactions they came from, which the cleanup run when a transaction
+# ends tells by the value of CanPartialClearThrough it saw at its start.
+# When s1 ends, far more of s2's transactions than that cleanup releases in
+# one batch stop being interesting, and all of their locks must go.
+
+setup
+{
+  CREATE TABLE ssi_sum (id int PRIMARY KEY, val int);
+  INSERT INTO ssi_sum SELECT i, 0 FROM generate_series(1, 10) i;
+  CREATE TABLE ssi_churn (n int);
+  CREATE PROCEDURE ssi_churn()
+  LANGUAGE plpgsql AS $$
+  DECLARE
+    -- more transactions than there are SERIALIZABLEXACT slots
+    n int := (current_setting('max_connections')::int +
+              current_setting('autovacuum_max_workers')::int + 1 +
+              current_setting('max_worker_processes')::int +
+              current_setting('max_wal_senders')::int +
+              current_setting('max_prepared_transactions')::int) * 10 + 100;
+  BEGIN
+    FOR i IN 1..n LOOP
+      PERFORM val FROM ssi_sum WHERE id = 3;
+      INSERT INTO ssi_churn VALUES (i);
+      COMMIT;
+    END LOOP;
+  END
+  $$;
+}
+
+teardown
+{
+  DROP TABLE ssi_sum, ssi_churn;
+  DROP PROCEDURE ssi_churn();
+}
+
+session "s1"
+step "s1_b"	{ BEGIN ISOLATION LEVEL SERIALIZABLE; }
+step "s1_r"	{ SELECT val FROM ssi_sum WHERE id = 1; }
+step "s1_wy"	{ UPDATE ssi_sum SET val = val + 1 WHERE id = 2; }
+step "s1_c"	{ COMMIT; }
+
+session "s2"
+setup
+{
+  SET default_transaction_isolation = serializable;
+  SET synchronous_commit = off;
+}
+step "s2_b"	{ BEGIN ISOLATION LEVEL SERIALIZABLE; }
+step "s2_wx"	{ UPDATE ssi_sum SET val = val + 1 WHERE id = 1; }
+step "s2_ry"	{ SELECT val FROM ssi_sum WHERE id = 2; }
+step "s2_c"	{ COMMIT; }
+step "s2_churn"	{ CALL ssi_churn(); }
+
+session "s3"
+step "s3_b"	{ BEGIN ISOLATION LEVEL SERIALIZABLE; }
+step "s3_r"	{ SELECT val FROM ssi_sum WHERE id = 4; }
+step "s3_c"	{ COMMIT; }
+
+session "o"
+step "o_sum"	{ SELECT count(*) > 0 AS summarized FROM pg_locks WHERE mode = 'SIReadLock' AND pid IS NULL; }
+step "o_all"	{ SELECT count(*) AS sireadlocks FROM pg_locks WHERE mode = 'SIReadLock'; }
+
+# Summarized locks are released when s1 ends, and so are all the others
+permutation "s1_b" "s1_r" "s2_churn" "o_sum" "s1_c" "o_sum" "o_all"
+
+# s3 started after the summarized transactions committed, but it is a
+# read-write transaction, so the locks are only released when s3 ends
+permutation "s1_b" "s1_r" "s2_churn" "s3_b" "s3_r" "s1_c" "o_sum" "s3_c" "o_sum"
+
+# s1 read a row that s2 then wrote, and s2 read a row that s1 writes after
+# s2 has been summarized: write skew
+permutation "s1_b" "s1_r" "s2_b" "s2_wx" "s2_ry" "s2_c" "s2_churn" "s1_wy" "s1_c" "o_sum"
+
+# Without s2's transaction, the summarized locks alone don't make s1 fail
+permutation "s1_b" "s1_r" "s2_churn" "s1_wy" "s1_c" "o_sum"
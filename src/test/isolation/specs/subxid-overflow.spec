@@ -0,0 +1,67 @@
+# Subtransaction cache overflow
+#
+# s2 runs more subtransactions than fit in its PGPROC subxid cache, so that
+# snapshots taken meanwhile only know its subxids from pg_subtrans.  s1
+# started before it and s3 after it, and neither of those overflows, so
+# their subxids are older and newer than s2's top-level XID respectively.
+# Some subtransactions of each are rolled back.  Check that the reader sees
+# exactly the committed rows, both in a snapshot taken while all of them
+# were running and in later ones.
+
+setup
+{
+  CREATE TABLE subxids (sess text, n int);
+  CREATE PROCEDURE insert_subxacts(p_sess text, p_n int, p_abort_every int)
+  LANGUAGE plpgsql AS $$
+  BEGIN
+    FOR i IN 1..p_n LOOP
+      BEGIN
+        INSERT INTO subxids VALUES (p_sess, i);
+        IF p_abort_every > 0 AND i % p_abort_every = 0 THEN
+          RAISE EXCEPTION 'rolled back';
+        END IF;
+      EXCEPTION WHEN raise_exception THEN
+        NULL;
+      END;
+    END LOOP;
+  END
+  $$;
+}
+
+teardown
+{
+  DROP TABLE subxids;
+  DROP PROCEDURE insert_subxacts(text, int, int);
+}
+
+session "s1"
+setup		{ BEGIN; }
+step "s1_sub"	{ CALL insert_subxacts('s1', 10, 0); }
+step "s1_c"	{ COMMIT; }
+
+session "s2"
+setup		{ BEGIN; }
+step "s2_sub"	{ CALL insert_subxacts('s2', 100, 7); }
+step "s2_c"	{ COMMIT; }
+step "s2_a"	{ ROLLBACK; }
+
+session "s3"
+setup		{ BEGIN; }
+step "s3_sub"	{ CALL insert_subxacts('s3', 20, 5); }
+step "s3_c"	{ COMMIT; }
+step "s3_a"	{ ROLLBACK; }
+
+session "r"
+step "r_begin"	{ BEGIN ISOLATION LEVEL REPEATABLE READ; }
+step "r_check"	{ SELECT count(*) FILTER (WHERE sess = 's1') AS s1, count(*) FILTER (WHERE sess = 's2') AS s2, count(*) FILTER (WHERE sess = 's3') AS s3 FROM subxids; }
+step "r_c"	{ COMMIT; }
+
+# A snapshot taken while all three are running sees none of their rows,
+# until the end of the transaction
+permutation "s1_sub" "s2_sub" "s3_sub" "r_begin" "r_check" "s1_c" "s2_c" "r_check" "s3_c" "r_check" "r_c" "r_check"
+
+# Each new snapshot sees the transactions committed by then
+permutation "s1_sub" "s2_sub" "s3_sub" "r_check" "s2_c" "r_check" "s3_a" "r_check" "s1_c" "r_check"
+
+# The overflowed transaction rolls back, and one starts after the snapshot
+permutation "s1_sub" "s2_sub" "r_begin" "r_check" "s3_sub" "s2_a" "s1_c" "s3_c" "r_check" "r_c" "r_check"
@@ -0,0 +1,640 @@
+/*-------------------------------------------------------------------------
+ *
+ * libpq_pipeline.c
+ *		Verify libpq pipeline execution functionality
+ *
+ * Each test is run by giving its name and a connection string, and either
+ * exits with status 0 or reports what went wrong, with the line number of
+ * the check that failed, and exits with status 1.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *		src/test/modules/libpq_pipeline/libpq_pipeline.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres_fe.h"
+
+#include <sys/time.h>
+#ifdef HAVE_SYS_SELECT_H
+#include <sys/select.h>
+#endif
+
+#include "libpq-fe.h"
+
+
+static const char *const progname = "libpq_pipeline";
+
+/* Number of rows the pipelined_insert test inserts */
+#define NUM_PIPELINED_ROWS 10000
+
+#define pg_fatal(...) pg_fatal_impl(__LINE__, __VA_ARGS__)
+#define get_result(conn, status) get_result_impl(conn, status, __LINE__)
+#define get_null(conn) get_null_impl(conn, __LINE__)
+#define expect_pipeline_status(conn, status) \
+	expect_pipeline_status_impl(conn, status, __LINE__)
+
+static void pg_fatal_impl(int line, const char *fmt,...)
+			pg_attribute_printf(2, 3) pg_attribute_noreturn();
+static PGresult *get_result_impl(PGconn *conn, ExecStatusType status, int line);
+static void get_null_impl(PGconn *conn, int line);
+static void expect_pipeline_status_impl(PGconn *conn, PGpipelineStatus status,
+							int line);
+static void send_select(PGconn *conn, const char *value);
+static void check_value(PGresult *res, const char *value, int line);
+
+static const char *const drop_table_sql =
+"DROP TABLE IF EXISTS pq_pipeline_demo";
+static const char *const create_table_sql =
+"CREATE UNLOGGED TABLE pq_pipeline_demo(id serial primary key, itemno integer)";
+static const char *const insert_sql =
+"INSERT INTO pq_pipeline_demo(itemno) VALUES ($1)";
+
+
+/*
+ * Report a failed check and exit
+ */
+static void
+pg_fatal_impl(int line, const char *fmt,...)
+{
+	va_list		args;
+
+	fflush(stdout);
+
+	fprintf(stderr, "\n%s:%d: ", progname, line);
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+	exit(1);
+}
+
+/*
+ * Get the next result, and check that it has the given status
+ */
+static PGresult *
+get_result_impl(PGconn *conn, ExecStatusType status, int line)
+{
+	PGresult   *res = PQgetResult(conn);
+
+	if (res == NULL)
+		pg_fatal_impl(line, "PQgetResult returned null, expected %s: %s",
+					  PQresStatus(status), PQerrorMessage(conn));
+	if (PQresultStatus(res) != status)
+		pg_fatal_impl(line, "PQgetResult returned %s, expected %s: %s",
+					  PQresStatus(PQresultStatus(res)), PQresStatus(status),
+					  PQresultErrorMessage(res));
+	return res;
+}
+
+/*
+ * Check that the next result is the null pointer that ends a query's results
+ */
+static void
+get_null_impl(PGconn *conn, int line)
+{
+	PGresult   *res = PQgetResult(conn);
+
+	if (res != NULL)
+		pg_fatal_impl(line, "PQgetResult returned %s, expected null",
+					  PQresStatus(PQresultStatus(res)));
+}
+
+static void
+expect_pipeline_status_impl(PGconn *conn, PGpipelineStatus status, int line)
+{
+	if (PQpipelineStatus(conn) != status)
+		pg_fatal_impl(line, "pipeline status is %d, expected %d",
+					  (int) PQpipelineStatus(conn), (int) status);
+}
+
+/*
+ * Queue "SELECT $1" with the given value
+ */
+static void
+send_select(PGconn *conn, const char *value)
+{
+	const char *paramValues[1];
+	Oid			paramTypes[1];
+
+	paramValues[0] = value;
+	paramTypes[0] = 23;			/* INT4OID */
+	if (PQsendQueryParams(conn, "SELECT $1", 1, paramTypes, paramValues,
+						  NULL, NULL, 0) != 1)
+		pg_fatal("dispatching SELECT failed: %s", PQerrorMessage(conn));
+}
+
+/*
+ * Check that a result has a single row with the given single value
+ */
+static void
+check_value(PGresult *res, const char *value, int line)
+{
+	if (PQntuples(res) != 1 || PQnfields(res) != 1)
+		pg_fatal_impl(line, "expected 1 row of 1 column, got %d rows of %d",
+					  PQntuples(res), PQnfields(res));
+	if (strcmp(PQgetvalue(res, 0, 0), value) != 0)
+		pg_fatal_impl(line, "expected value \"%s\", got \"%s\"",
+					  value, PQgetvalue(res, 0, 0));
+}
+
+/*
+ * Functions that can't work in pipeline mode must refuse to, and leave the
+ * connection usable.
+ */
+static void
+test_disallowed_in_pipeline(PGconn *conn)
+{
+	PGresult   *res;
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("unable to enter pipeline mode: %s", PQerrorMessage(conn));
+	expect_pipeline_status(conn, PQ_PIPELINE_ON);
+
+	res = PQexec(conn, "SELECT 1");
+	if (res != NULL)
+		pg_fatal("PQexec should fail in pipeline mode but succeeded");
+	if (strstr(PQerrorMessage(conn), "not allowed in pipeline mode") == NULL)
+		pg_fatal("unexpected error from PQexec: %s", PQerrorMessage(conn));
+
+	if (PQsendQuery(conn, "SELECT 1") != 0)
+		pg_fatal("PQsendQuery should fail in pipeline mode but succeeded");
+
+	/* Nothing was sent, so there's nothing to wait for */
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+	expect_pipeline_status(conn, PQ_PIPELINE_OFF);
+
+	res = PQexec(conn, "SELECT 1");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		pg_fatal("PQexec failed after exiting pipeline mode: %s",
+				 PQerrorMessage(conn));
+	check_value(res, "1", __LINE__);
+	PQclear(res);
+}
+
+/*
+ * One query followed by a sync point.  The query's result is followed by a
+ * null pointer, the sync point's isn't, and pipeline mode can't be left
+ * until all of them have been collected.
+ */
+static void
+test_simple_pipeline(PGconn *conn)
+{
+	PGresult   *res;
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("unable to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	send_select(conn, "1");
+
+	if (PQexitPipelineMode(conn) != 0)
+		pg_fatal("exiting pipeline mode with a query pending didn't fail");
+
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	res = get_result(conn, PGRES_TUPLES_OK);
+	check_value(res, "1", __LINE__);
+	PQclear(res);
+	get_null(conn);
+
+	if (PQexitPipelineMode(conn) != 0)
+		pg_fatal("exiting pipeline mode with a sync point pending didn't fail");
+
+	PQclear(get_result(conn, PGRES_PIPELINE_SYNC));
+	expect_pipeline_status(conn, PQ_PIPELINE_ON);
+
+	/* Nothing left: this returns at once */
+	get_null(conn);
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+	expect_pipeline_status(conn, PQ_PIPELINE_OFF);
+}
+
+/*
+ * Two sync-delimited pipelines sent before any result is read
+ */
+static void
+test_multi_pipelines(PGconn *conn)
+{
+	PGresult   *res;
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("unable to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	send_select(conn, "1");
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+	send_select(conn, "2");
+	send_select(conn, "3");
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	res = get_result(conn, PGRES_TUPLES_OK);
+	check_value(res, "1", __LINE__);
+	PQclear(res);
+	get_null(conn);
+	PQclear(get_result(conn, PGRES_PIPELINE_SYNC));
+
+	res = get_result(conn, PGRES_TUPLES_OK);
+	check_value(res, "2", __LINE__);
+	PQclear(res);
+	get_null(conn);
+	res = get_result(conn, PGRES_TUPLES_OK);
+	check_value(res, "3", __LINE__);
+	PQclear(res);
+	get_null(conn);
+	PQclear(get_result(conn, PGRES_PIPELINE_SYNC));
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+}
+
+/*
+ * A failing query aborts the rest of its pipeline, up to the sync point, and
+ * the implicit transaction with it.  The next pipeline is unaffected.
+ */
+static void
+test_pipeline_abort(PGconn *conn)
+{
+	PGresult   *res;
+	const char *paramValues[1];
+
+	res = PQexec(conn, drop_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("dropping table failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+	res = PQexec(conn, create_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("creating table failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("unable to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	paramValues[0] = "1";
+	if (PQsendQueryParams(conn, insert_sql, 1, NULL, paramValues,
+						  NULL, NULL, 0) != 1)
+		pg_fatal("dispatching first INSERT failed: %s", PQerrorMessage(conn));
+	if (PQsendQueryParams(conn, "SELECT no_such_function($1)", 1, NULL,
+						  paramValues, NULL, NULL, 0) != 1)
+		pg_fatal("dispatching error SELECT failed: %s", PQerrorMessage(conn));
+	paramValues[0] = "2";
+	if (PQsendQueryParams(conn, insert_sql, 1, NULL, paramValues,
+						  NULL, NULL, 0) != 1)
+		pg_fatal("dispatching second INSERT failed: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	paramValues[0] = "3";
+	if (PQsendQueryParams(conn, insert_sql, 1, NULL, paramValues,
+						  NULL, NULL, 0) != 1)
+		pg_fatal("dispatching third INSERT failed: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("second pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* The first INSERT succeeds */
+	PQclear(get_result(conn, PGRES_COMMAND_OK));
+	get_null(conn);
+	expect_pipeline_status(conn, PQ_PIPELINE_ON);
+
+	/* The SELECT fails, and aborts the pipeline */
+	res = get_result(conn, PGRES_FATAL_ERROR);
+	if (strcmp(PQresultErrorField(res, PG_DIAG_SQLSTATE), "42883") != 0)
+		pg_fatal("unexpected error: %s", PQresultErrorMessage(res));
+	PQclear(res);
+	get_null(conn);
+	expect_pipeline_status(conn, PQ_PIPELINE_ABORTED);
+
+	/* The second INSERT is skipped */
+	PQclear(get_result(conn, PGRES_PIPELINE_ABORTED));
+	get_null(conn);
+	expect_pipeline_status(conn, PQ_PIPELINE_ABORTED);
+
+	/* Mode can't be left until the end of the aborted pipeline is reached */
+	if (PQexitPipelineMode(conn) != 0)
+		pg_fatal("exiting an aborted pipeline didn't fail");
+
+	/* The sync point ends the aborted pipeline */
+	PQclear(get_result(conn, PGRES_PIPELINE_SYNC));
+	expect_pipeline_status(conn, PQ_PIPELINE_ON);
+
+	/* The next pipeline works normally */
+	PQclear(get_result(conn, PGRES_COMMAND_OK));
+	get_null(conn);
+	PQclear(get_result(conn, PGRES_PIPELINE_SYNC));
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+
+	/*
+	 * The first INSERT was rolled back along with the implicit transaction
+	 * of its pipeline; the second never ran.
+	 */
+	res = PQexec(conn, "SELECT string_agg(itemno::text, ',') FROM pq_pipeline_demo");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		pg_fatal("checking table contents failed: %s", PQerrorMessage(conn));
+	check_value(res, "3", __LINE__);
+	PQclear(res);
+}
+
+/*
+ * PQsendFlushRequest makes the server send the results it has without a
+ * sync point, so they can be read while the pipeline goes on.
+ */
+static void
+test_flush_request(PGconn *conn)
+{
+	PGresult   *res;
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("unable to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	send_select(conn, "1");
+	if (PQsendFlushRequest(conn) != 1)
+		pg_fatal("sending flush request failed: %s", PQerrorMessage(conn));
+	if (PQflush(conn) != 0)
+		pg_fatal("flushing failed: %s", PQerrorMessage(conn));
+
+	/* Without the flush request, this would wait forever */
+	res = get_result(conn, PGRES_TUPLES_OK);
+	check_value(res, "1", __LINE__);
+	PQclear(res);
+	get_null(conn);
+	expect_pipeline_status(conn, PQ_PIPELINE_ON);
+
+	/* The pipeline carries on, in the same implicit transaction */
+	send_select(conn, "2");
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	res = get_result(conn, PGRES_TUPLES_OK);
+	check_value(res, "2", __LINE__);
+	PQclear(res);
+	get_null(conn);
+	PQclear(get_result(conn, PGRES_PIPELINE_SYNC));
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+}
+
+/*
+ * Prepare, describe and execute a statement in one pipeline
+ */
+static void
+test_prepared(PGconn *conn)
+{
+	PGresult   *res;
+	Oid			paramTypes[2];
+	const char *paramValues[2];
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("unable to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	paramTypes[0] = 23;			/* INT4OID */
+	paramTypes[1] = 25;			/* TEXTOID */
+	if (PQsendPrepare(conn, "select_one", "SELECT $1 AS n, $2 AS t",
+					  2, paramTypes) != 1)
+		pg_fatal("dispatching PREPARE failed: %s", PQerrorMessage(conn));
+	if (PQsendDescribePrepared(conn, "select_one") != 1)
+		pg_fatal("dispatching DESCRIBE failed: %s", PQerrorMessage(conn));
+	paramValues[0] = "42";
+	paramValues[1] = "forty-two";
+	if (PQsendQueryPrepared(conn, "select_one", 2, paramValues,
+							NULL, NULL, 0) != 1)
+		pg_fatal("dispatching EXECUTE failed: %s", PQerrorMessage(conn));
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	PQclear(get_result(conn, PGRES_COMMAND_OK));
+	get_null(conn);
+
+	res = get_result(conn, PGRES_COMMAND_OK);
+	if (PQnfields(res) != 2 || strcmp(PQfname(res, 0), "n") != 0 ||
+		PQftype(res, 0) != 23 || PQnparams(res) != 2 ||
+		PQparamtype(res, 1) != 25)
+		pg_fatal("unexpected description of prepared statement");
+	PQclear(res);
+	get_null(conn);
+
+	res = get_result(conn, PGRES_TUPLES_OK);
+	if (PQntuples(res) != 1 ||
+		strcmp(PQgetvalue(res, 0, 0), "42") != 0 ||
+		strcmp(PQgetvalue(res, 0, 1), "forty-two") != 0)
+		pg_fatal("unexpected result of prepared statement");
+	PQclear(res);
+	get_null(conn);
+
+	PQclear(get_result(conn, PGRES_PIPELINE_SYNC));
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+}
+
+/*
+ * Send many INSERTs in non-blocking mode, reading results as they arrive.
+ * In pipeline mode libpq only flushes its output buffer once enough has
+ * accumulated; this checks that everything still gets sent, interleaved
+ * with reading, so that neither side blocks the other.
+ */
+static void
+test_pipelined_insert(PGconn *conn)
+{
+	PGresult   *res;
+	char		param[32];
+	const char *paramValues[1];
+	int			nsent = 0;
+	int			nreceived = 0;
+	bool		synced = false;
+	bool		want_null = false;
+	bool		done = false;
+
+	res = PQexec(conn, drop_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("dropping table failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+	res = PQexec(conn, create_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("creating table failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+	res = PQprepare(conn, "my_insert", insert_sql, 1, NULL);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("preparing INSERT failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	if (PQsetnonblocking(conn, 1) != 0)
+		pg_fatal("failed to set non-blocking mode: %s", PQerrorMessage(conn));
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("unable to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	paramValues[0] = param;
+
+	while (!done)
+	{
+		int			sock = PQsocket(conn);
+		int			flushResult;
+		fd_set		input_mask;
+		fd_set		output_mask;
+
+		if (sock < 0)
+			pg_fatal("connection lost: %s", PQerrorMessage(conn));
+
+		/* Send some more, as long as libpq takes it */
+		while (nsent < NUM_PIPELINED_ROWS)
+		{
+			snprintf(param, sizeof(param), "%d", nsent + 1);
+			if (PQsendQueryPrepared(conn, "my_insert", 1, paramValues,
+									NULL, NULL, 0) != 1)
+				pg_fatal("dispatching INSERT failed: %s", PQerrorMessage(conn));
+			nsent++;
+
+			/* Go read results every so often */
+			if (nsent % 100 == 0)
+				break;
+		}
+		if (nsent == NUM_PIPELINED_ROWS && !synced)
+		{
+			if (PQpipelineSync(conn) != 1)
+				pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+			synced = true;
+		}
+
+		flushResult = PQflush(conn);
+		if (flushResult < 0)
+			pg_fatal("flushing failed: %s", PQerrorMessage(conn));
+
+		FD_ZERO(&input_mask);
+		FD_SET(sock, &input_mask);
+		FD_ZERO(&output_mask);
+		if (flushResult > 0)
+			FD_SET(sock, &output_mask);
+
+		/* Wait only if there's nothing more to send */
+		if (synced || flushResult > 0)
+		{
+			if (select(sock + 1, &input_mask, &output_mask, NULL, NULL) < 0)
+				pg_fatal("select() failed: %s", strerror(errno));
+		}
+
+		if (PQconsumeInput(conn) != 1)
+			pg_fatal("PQconsumeInput failed: %s", PQerrorMessage(conn));
+
+		/* Read all the results that have arrived */
+		while (!done && !PQisBusy(conn))
+		{
+			res = PQgetResult(conn);
+
+			if (want_null)
+			{
+				if (res != NULL)
+					pg_fatal("PQgetResult returned %s after INSERT %d, expected null",
+							 PQresStatus(PQresultStatus(res)), nreceived);
+				want_null = false;
+			}
+			else if (nreceived < NUM_PIPELINED_ROWS)
+			{
+				if (res == NULL)
+				{
+					/* Nothing more until the next query's results arrive */
+					break;
+				}
+				if (PQresultStatus(res) != PGRES_COMMAND_OK)
+					pg_fatal("INSERT %d failed: %s", nreceived + 1,
+							 PQresultErrorMessage(res));
+				PQclear(res);
+				nreceived++;
+				want_null = true;
+			}
+			else
+			{
+				if (res == NULL)
+					break;
+				if (PQresultStatus(res) != PGRES_PIPELINE_SYNC)
+					pg_fatal("PQgetResult returned %s, expected PGRES_PIPELINE_SYNC",
+							 PQresStatus(PQresultStatus(res)));
+				PQclear(res);
+				done = true;
+			}
+		}
+	}
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+	if (PQsetnonblocking(conn, 0) != 0)
+		pg_fatal("failed to clear non-blocking mode: %s", PQerrorMessage(conn));
+
+	res = PQexec(conn, "SELECT count(*) FROM pq_pipeline_demo");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		pg_fatal("counting rows failed: %s", PQerrorMessage(conn));
+	snprintf(param, sizeof(param), "%d", NUM_PIPELINED_ROWS);
+	check_value(res, param, __LINE__);
+	PQclear(res);
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr, "Usage: %s TESTNAME CONNINFO\n", progname);
+	fprintf(stderr, "Tests: disallowed_in_pipeline, simple_pipeline, multi_pipelines,\n"
+			"       pipeline_abort, flush_request, prepared, pipelined_insert\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *testname;
+	PGconn	   *conn;
+	PGresult   *res;
+
+	if (argc != 3)
+	{
+		usage();
+		exit(1);
+	}
+	testname = argv[1];
+
+	conn = PQconnectdb(argv[2]);
+	if (PQstatus(conn) != CONNECTION_OK)
+	{
+		fprintf(stderr, "Connection to database failed: %s",
+				PQerrorMessage(conn));
+		exit(1);
+	}
+
+	/* Keep the server's messages out of the way */
+	res = PQexec(conn, "SET client_min_messages TO warning");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("failed to set client_min_messages: %s",
+				 PQerrorMessage(conn));
+	PQclear(res);
+
+	if (strcmp(testname, "disallowed_in_pipeline") == 0)
+		test_disallowed_in_pipeline(conn);
+	else if (strcmp(testname, "simple_pipeline") == 0)
+		test_simple_pipeline(conn);
+	else if (strcmp(testname, "multi_pipelines") == 0)
+		test_multi_pipelines(conn);
+	else if (strcmp(testname, "pipeline_abort") == 0)
+		test_pipeline_abort(conn);
+	else if (strcmp(testname, "flush_request") == 0)
+		test_flush_request(conn);
+	else if (strcmp(testname, "prepared") == 0)
+		test_prepared(conn);
+	else if (strcmp(testname, "pipelined_insert") == 0)
+		test_pipelined_insert(conn);
+	else
+	{
+		fprintf(stderr, "%s: unrecognized test name \"%s\"\n",
+				progname, testname);
+		usage();
+		exit(1);
+	}
+
+	PQfinish(conn);
+	return 0;
+}
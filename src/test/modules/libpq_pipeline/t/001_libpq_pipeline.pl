@@ -0,0 +1,34 @@
+# Test libpq's pipeline mode
+#
+# Run each test of the libpq_pipeline program against a new server; the
+# program checks the results it gets, and exits with a non-zero status if
+# anything is off.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More;
+
+my @tests = qw(
+  disallowed_in_pipeline
+  simple_pipeline
+  multi_pipelines
+  pipeline_abort
+  flush_request
+  prepared
+  pipelined_insert
+);
+plan tests => scalar @tests;
+
+my $node = get_new_node('main');
+$node->init;
+$node->start;
+
+foreach my $test (@tests)
+{
+	$node->command_ok([ 'libpq_pipeline', $test, $node->connstr('postgres') ],
+		"libpq_pipeline $test");
+}
+
+$node->stop;
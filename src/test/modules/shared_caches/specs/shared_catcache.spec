@@ -0,0 +1,52 @@
+# Coherence of the shared catalog cache
+#
+# s1 loads catalog tuples into the shared cache, s2 changes them, and s3,
+# which has never looked them up itself, must see what is committed rather
+# than what s1 left in the shared cache.  The objects are created anew for
+# each permutation, so s3's own catcache never has them.
+
+setup
+{
+  CREATE TABLE cc_tab (a int);
+  INSERT INTO cc_tab VALUES (1);
+  CREATE FUNCTION cc_func() RETURNS text LANGUAGE sql AS $$SELECT 'old'::text$$;
+}
+
+teardown
+{
+  DROP TABLE cc_tab;
+  DROP FUNCTION IF EXISTS cc_func();
+}
+
+session "s1"
+step "s1_func"		{ SELECT cc_func(); }
+step "s1_col"		{ SELECT a FROM cc_tab; }
+
+session "s2"
+step "s2_begin"		{ BEGIN; }
+step "s2_replace"	{ CREATE OR REPLACE FUNCTION cc_func() RETURNS text LANGUAGE sql AS $$SELECT 'new'::text$$; }
+step "s2_func"		{ SELECT cc_func(); }
+step "s2_drop"		{ DROP FUNCTION cc_func(); }
+step "s2_rename"	{ ALTER TABLE cc_tab RENAME COLUMN a TO b; }
+step "s2_commit"	{ COMMIT; }
+step "s2_rollback"	{ ROLLBACK; }
+
+session "s3"
+step "s3_func"		{ SELECT cc_func(); }
+step "s3_col_a"		{ SELECT a FROM cc_tab; }
+step "s3_col_b"		{ SELECT b FROM cc_tab; }
+
+# A changed function is seen by sessions that had it cached and by new ones
+permutation "s1_func" "s2_replace" "s3_func" "s1_func"
+
+# An uncommitted change is not seen, a committed one is
+permutation "s1_func" "s2_begin" "s2_replace" "s3_func" "s2_commit" "s3_func"
+
+# A rolled back change doesn't get into the shared cache
+permutation "s2_begin" "s2_replace" "s2_func" "s2_rollback" "s3_func" "s1_func"
+
+# A dropped function is gone
+permutation "s1_func" "s2_drop" "s3_func"
+
+# A renamed column is found under its new name only
+permutation "s1_col" "s2_rename" "s3_col_a" "s3_col_b"
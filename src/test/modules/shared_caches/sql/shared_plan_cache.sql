@@ -0,0 +1,161 @@
+--
+-- Tests for the shared plan cache
+--
+-- shared_caches.conf enables the cache, and sets plan_cache_mode so that
+-- every prepared statement gets a generic plan at its first execution.
+-- The plans and hits reported by pg_stat_get_shared_plans() are counted
+-- from the start of the test.  A new session is started with \c whenever a
+-- plan made by another session should be looked up.
+--
+CREATE ROLE regress_spc_role;
+CREATE TABLE spc_tab (a int, b text) WITH (autovacuum_enabled = off);
+INSERT INTO spc_tab SELECT i, i::text FROM generate_series(1, 1000) i;
+ANALYZE spc_tab;
+GRANT SELECT ON spc_tab TO regress_spc_role;
+
+SELECT current_database() AS maindb,
+       plans AS plans0, hits AS hits0 FROM pg_stat_get_shared_plans() \gset
+
+CREATE VIEW spc_stats AS
+  SELECT plans - :plans0 AS plans, hits - :hits0 AS hits
+  FROM pg_stat_get_shared_plans();
+
+-- The first session to execute the statement makes the plan and enters it
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXECUTE spc_q(42);
+EXECUTE spc_q(43);
+SELECT * FROM spc_stats;
+
+-- Other sessions find it
+\c -
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXECUTE spc_q(42);
+EXPLAIN (COSTS OFF) EXECUTE spc_q(42);
+SELECT * FROM spc_stats;
+\c -
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXECUTE spc_q(44);
+SELECT * FROM spc_stats;
+
+-- A different query isn't confused with it
+PREPARE spc_q2(int) AS SELECT b FROM spc_tab WHERE a = $1 + 1;
+EXECUTE spc_q2(42);
+SELECT * FROM spc_stats;
+DEALLOCATE spc_q2;
+
+-- Creating an index removes the plans of the table, and the next session
+-- gets the plan made afterwards, using the index
+CREATE INDEX spc_tab_a ON spc_tab (a);
+SELECT * FROM spc_stats;
+EXPLAIN (COSTS OFF) EXECUTE spc_q(42);
+SELECT * FROM spc_stats;
+\c -
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXPLAIN (COSTS OFF) EXECUTE spc_q(42);
+EXECUTE spc_q(42);
+SELECT * FROM spc_stats;
+
+-- Likewise for ALTER TABLE
+ALTER TABLE spc_tab ADD COLUMN c int;
+SELECT * FROM spc_stats;
+EXECUTE spc_q(42);
+SELECT * FROM spc_stats;
+\c -
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXECUTE spc_q(42);
+SELECT * FROM spc_stats;
+
+-- Plans are made for each role separately
+\c -
+SET ROLE regress_spc_role;
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXECUTE spc_q(42);
+RESET ROLE;
+SELECT * FROM spc_stats;
+\c -
+SET ROLE regress_spc_role;
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXECUTE spc_q(42);
+RESET ROLE;
+SELECT * FROM spc_stats;
+
+-- and for each combination of planner settings
+\c -
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXPLAIN (COSTS OFF) EXECUTE spc_q(42);
+SELECT * FROM spc_stats;
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+DEALLOCATE spc_q;
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXPLAIN (COSTS OFF) EXECUTE spc_q(42);
+SELECT * FROM spc_stats;
+
+-- Plans aren't shared between databases, and are removed when their
+-- database is dropped
+CREATE DATABASE regression_spc;
+\c regression_spc
+CREATE TABLE spc_tab (a int, b text);
+INSERT INTO spc_tab VALUES (42, 'other');
+PREPARE spc_q(int) AS SELECT b FROM spc_tab WHERE a = $1;
+EXECUTE spc_q(42);
+\c :maindb
+SELECT * FROM spc_stats;
+DROP DATABASE regression_spc;
+SELECT * FROM spc_stats;
+
+-- Dropping the table removes the rest
+DROP TABLE spc_tab;
+SELECT * FROM spc_stats;
+
+-- A plan found in the cache locks the partitions that the planner added to
+-- it, not only the table named in the query
+CREATE TABLE spc_part (a int, b text) PARTITION BY RANGE (a);
+CREATE TABLE spc_part1 PARTITION OF spc_part FOR VALUES FROM (1) TO (100);
+CREATE TABLE spc_part2 PARTITION OF spc_part FOR VALUES FROM (100) TO (200);
+INSERT INTO spc_part SELECT i, i::text FROM generate_series(1, 199) i;
+PREPARE spc_pq(int) AS SELECT b FROM spc_part WHERE a = $1;
+EXECUTE spc_pq(42);
+SELECT * FROM spc_stats;
+\c -
+PREPARE spc_pq(int) AS SELECT b FROM spc_part WHERE a = $1;
+BEGIN;
+EXECUTE spc_pq(142);
+SELECT relation::regclass AS rel, mode FROM pg_locks
+  WHERE locktype = 'relation' AND pid = pg_backend_pid()
+    AND relation::regclass::text LIKE 'spc_part%'
+  ORDER BY 1;
+COMMIT;
+SELECT * FROM spc_stats;
+
+-- Detaching a partition removes the plan
+ALTER TABLE spc_part DETACH PARTITION spc_part2;
+SELECT * FROM spc_stats;
+EXECUTE spc_pq(142);
+SELECT * FROM spc_stats;
+DROP TABLE spc_part, spc_part2;
+SELECT * FROM spc_stats;
+
+-- Once the cache is full, the least recently used plans make room for new
+-- ones
+DO $$
+BEGIN
+  FOR i IN 1..300 LOOP
+    EXECUTE format('PREPARE spc_e%s AS SELECT %s AS n;', i, i);
+    EXECUTE format('EXECUTE spc_e%s;', i);
+  END LOOP;
+END
+$$;
+SELECT plans BETWEEN 1 AND 256 AS full, hits FROM spc_stats;
+\c -
+PREPARE spc_e300 AS SELECT 300 AS n;
+EXECUTE spc_e300;
+SELECT hits FROM spc_stats;
+PREPARE spc_e1 AS SELECT 1 AS n;
+EXECUTE spc_e1;
+SELECT hits FROM spc_stats;
+
+DROP VIEW spc_stats;
+DROP ROLE regress_spc_role;
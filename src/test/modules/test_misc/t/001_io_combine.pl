@@ -0,0 +1,150 @@
+# Test reads and writes combining I/O of consecutive blocks
+#
+# Sequential scans read runs of blocks that are not in shared buffers with
+# one smgrreadv() call, and checkpoints write runs of dirty blocks with one
+# smgrwritev() call.  Check that the data survives that at the smallest,
+# largest and some odd io_combine_limit settings, that runs crossing a
+# segment boundary are split correctly, and that a read error in the middle
+# of a run leaves no buffer I/O behind.
+#
+# Runs only cross segment boundaries in builds configured with a small
+# --with-segsize-blocks, such as 6.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 13;
+
+my $node = get_new_node('main');
+$node->init;
+
+# Keep shared_buffers small so that the table has to be read back from
+# disk, rather than being found in buffers.
+$node->append_conf('postgresql.conf', <<EOF);
+shared_buffers = 1MB
+autovacuum = off
+EOF
+$node->start;
+
+my ($stdout, $stderr) =
+  run_command([ 'pg_controldata', $node->data_dir ]);
+$stdout =~ /^Blocks per segment of large relation:\s+(\d+)$/m
+  or die "could not find segment size in pg_controldata output";
+my $relseg_size = $1;
+my $blocksize = $node->safe_psql('postgres', 'SHOW block_size');
+my $max_combine = $node->safe_psql('postgres',
+	"SELECT max_val FROM pg_settings WHERE name = 'io_combine_limit'");
+
+# At least a few segments with tiny segments, else a few hundred blocks;
+# with fillfactor 10 each row gets a page of its own.
+my $nblocks = $relseg_size < 100 ? 3 * $relseg_size + 3 : 300;
+
+$node->safe_psql(
+	'postgres', qq{
+CREATE TABLE t (id int, pad text) WITH (fillfactor = 10);
+INSERT INTO t SELECT i, lpad(i::text, 500, 'x')
+  FROM generate_series(1, $nblocks) i;
+CHECKPOINT;
+});
+
+is( $node->safe_psql(
+		'postgres',
+		"SELECT pg_relation_size('t') / current_setting('block_size')::int"),
+	$nblocks,
+	'one row per block');
+
+my $relpath = $node->safe_psql('postgres', "SELECT pg_relation_filepath('t')");
+SKIP:
+{
+	skip 'relation fits in one segment', 1 if $relseg_size >= $nblocks;
+
+	ok(-f $node->data_dir . "/$relpath.2", 'relation spans three segments');
+}
+
+my $query = "SELECT count(*), sum(id), md5(string_agg(pad, ',' ORDER BY id)) FROM t";
+my $expected = $node->safe_psql('postgres', $query);
+
+# Read it back after a restart, so that all blocks come from disk, with
+# different I/O sizes.  3 doesn't divide the segment size, so runs start
+# and end at different offsets around the segment boundaries.
+$node->restart;
+foreach my $limit (1, 2, 3, $max_combine)
+{
+	is( $node->safe_psql(
+			'postgres', "SET io_combine_limit = $limit; $query"),
+		$expected,
+		"sequential scan with io_combine_limit = $limit");
+}
+
+# ANALYZE reads sampled blocks through the same path
+is( $node->safe_psql(
+		'postgres', qq{
+SET io_combine_limit = 3;
+ANALYZE t;
+SELECT reltuples FROM pg_class WHERE relname = 't';
+}),
+	$nblocks,
+	'ANALYZE with io_combine_limit = 3');
+
+# The values outside of the range are rejected
+my ($ret, $out, $err) = $node->psql('postgres',
+	"SELECT set_config('io_combine_limit', '" . ($max_combine + 1) . "', false)");
+like($err, qr/is outside the valid range for parameter "io_combine_limit"/,
+	'io_combine_limit above the maximum is rejected');
+($ret, $out, $err) =
+  $node->psql('postgres', "SET io_combine_limit = 0");
+like($err, qr/is outside the valid range for parameter "io_combine_limit"/,
+	'io_combine_limit of zero is rejected');
+
+# Dirty every block and have the checkpoint write them back in runs
+$node->safe_psql(
+	'postgres', qq{
+UPDATE t SET pad = lpad(id::text, 500, 'y');
+CHECKPOINT;
+});
+$expected = $node->safe_psql('postgres', $query);
+$node->restart;
+is($node->safe_psql('postgres', $query),
+	$expected, 'blocks written by a checkpoint read back correctly');
+
+# Finally, corrupt the header of a block in the middle of the first read,
+# so that reading the blocks before it succeeds and the I/O on the blocks
+# after it is still in progress when the error is raised.  If that I/O were
+# not cleaned up, the next read of those blocks would wait for it forever.
+my $badblock = 5;
+$node->stop;
+my $segno = int($badblock / $relseg_size);
+my $file = $node->data_dir . "/$relpath" . ($segno > 0 ? ".$segno" : '');
+open(my $fh, '+<:raw', $file) or die "could not open $file: $!";
+sysseek($fh, ($badblock % $relseg_size) * $blocksize, 0)
+  or die "could not seek in $file: $!";
+syswrite($fh, "\xFF" x 24) or die "could not write to $file: $!";
+close($fh);
+$node->start;
+
+($ret, $out, $err) = $node->psql(
+	'postgres', qq{
+SET io_combine_limit = $max_combine;
+SELECT count(*) FROM t;
+SELECT count(*) FROM t;
+},
+	on_error_stop => 0,
+	timeout       => 180);
+my @errors = ($err =~ /invalid page in block $badblock of relation/g);
+is(scalar(@errors), 2, 'read error is reported each time in one session');
+
+($ret, $out, $err) = $node->psql(
+	'postgres', qq{
+SET io_combine_limit = $max_combine;
+SET zero_damaged_pages = on;
+SELECT count(*) FROM t;
+},
+	timeout => 180);
+is($out, $nblocks - 1, 'damaged page is zeroed out in another session');
+like(
+	$err,
+	qr/invalid page in block $badblock of relation .*; zeroing out page/,
+	'damaged page is reported');
+
+$node->stop;
@@ -0,0 +1,90 @@
+# Test extending a relation by many blocks at once
+#
+# When backends queue up for the relation extension lock, the one holding it
+# adds a batch of blocks with one smgrzeroextend() call and records the
+# spare ones in the free space map.  Run concurrent inserts to get there,
+# and check that no rows or pages went missing and that the relation's
+# files have the sizes they should.
+#
+# Batches of more than 8 blocks are allocated with posix_fallocate(), and
+# smaller ones are written as zeroes, which is also the fallback where the
+# file system doesn't support fallocate.  Builds configured with a small
+# --with-segsize-blocks, such as 6, split every batch at segment boundaries
+# into pieces small enough to be written as zeroes.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 5;
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf('postgresql.conf', 'autovacuum = off');
+$node->start;
+
+my ($stdout, $stderr) =
+  run_command([ 'pg_controldata', $node->data_dir ]);
+$stdout =~ /^Blocks per segment of large relation:\s+(\d+)$/m
+  or die "could not find segment size in pg_controldata output";
+my $relseg_size = $1;
+my $blocksize = $node->safe_psql('postgres', 'SHOW block_size');
+
+$node->safe_psql(
+	'postgres', qq{
+CREATE EXTENSION pg_freespacemap;
+CREATE TABLE t (id int, pad text);
+});
+
+my $clients      = 8;
+my $transactions = 200;
+my $script       = $node->basedir . '/insert.sql';
+append_to_file($script,
+	"INSERT INTO t SELECT g, lpad(g::text, 500, 'x') FROM generate_series(1, 10) g;\n"
+);
+$node->command_ok(
+	[
+		'pgbench', '-n', '-c', $clients, '-j', $clients,
+		'-t', $transactions, '-f', $script, 'postgres'
+	],
+	'concurrent inserts');
+
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	$clients * $transactions * 10, 'all rows inserted');
+
+# Spare blocks that nobody used in the end must still be in the free space
+# map, rather than being lost until the next VACUUM.
+is( $node->safe_psql(
+		'postgres', qq{
+SELECT count(*) FROM pg_freespace('t')
+WHERE avail = 0
+  AND blkno NOT IN (SELECT (ctid::text::point)[0]::bigint FROM t);
+}),
+	'0',
+	'empty blocks are recorded in the free space map');
+
+# The size reported by the server must match the files, and every segment
+# but the last must be full.
+my $relpath = $node->safe_psql('postgres', "SELECT pg_relation_filepath('t')");
+my $relsize = $node->safe_psql('postgres', "SELECT pg_relation_size('t')");
+my @segsizes;
+for (my $segno = 0;; $segno++)
+{
+	my $file = $node->data_dir . "/$relpath" . ($segno > 0 ? ".$segno" : '');
+	last unless -f $file;
+	push @segsizes, -s $file;
+}
+my $filesize = 0;
+$filesize += $_ foreach @segsizes;
+is($relsize, $filesize, 'relation size matches its files');
+
+SKIP:
+{
+	skip 'relation fits in one segment', 1 if @segsizes < 2;
+
+	my @short = grep { $_ != $relseg_size * $blocksize }
+	  @segsizes[ 0 .. $#segsizes - 1 ];
+	is(scalar(@short), 0, 'all segments but the last are full');
+}
+
+$node->stop;
@@ -0,0 +1,108 @@
+# Test resizing shared_buffers with a reload, under concurrent load
+#
+# Grow and shrink the buffer pool a few times while pgbench moves money
+# between accounts and scans a table larger than the pool, and check that
+# no update was lost, neither in memory nor on disk.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use IPC::Run;
+use Time::HiRes qw(usleep);
+use Test::More tests => 10;
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+shared_buffers = 1MB
+max_shared_buffers = 8MB
+autovacuum = off
+});
+$node->start;
+
+my $blocksize = $node->safe_psql('postgres', 'SHOW block_size');
+
+# The accounts always add up to zero.  "big" doesn't fit in the largest pool.
+$node->safe_psql(
+	'postgres', qq{
+CREATE TABLE acct (id int PRIMARY KEY, balance int NOT NULL);
+INSERT INTO acct SELECT i, 0 FROM generate_series(1, 1000) i;
+CREATE TABLE big (id int, pad text) WITH (fillfactor = 10);
+INSERT INTO big SELECT i, lpad(i::text, 500, 'x')
+  FROM generate_series(1, 1500) i;
+});
+my $big_query = "SELECT count(*), md5(string_agg(pad, ',' ORDER BY id)) FROM big";
+my $big_expected = $node->safe_psql('postgres', $big_query);
+
+# Both accounts are updated by a single statement, in index order, so that
+# the clients can't deadlock.
+my $script = $node->basedir . '/transfer.sql';
+append_to_file(
+	$script, q{
+\set a random(1, 1000)
+\set b (:a % 1000) + 1
+UPDATE acct SET balance = balance + CASE WHEN id = :a THEN -1 ELSE 1 END
+  WHERE id IN (:a, :b);
+SELECT count(*) FROM big;
+});
+
+my ($pgbench_stdout, $pgbench_stderr) = ('', '');
+my $pgbench = IPC::Run::start(
+	[
+		'pgbench', '-n', '-c', '4', '-j', '4', '-T', '20',
+		'-f', $script, '-h', $node->host, '-p', $node->port, 'postgres'
+	],
+	'>', \$pgbench_stdout, '2>', \$pgbench_stderr);
+
+# Change shared_buffers and wait for the server to report the resize.  Only
+# look at what was logged after the reload, since the same sizes come up
+# more than once.
+sub resize
+{
+	my ($from_mb, $to_mb) = @_;
+	my $from = $from_mb * 1024 * 1024 / $blocksize;
+	my $to = $to_mb * 1024 * 1024 / $blocksize;
+	my $logstart = -s $node->logfile;
+
+	$node->append_conf('postgresql.conf', "shared_buffers = ${to_mb}MB");
+	$node->reload;
+
+	my $resized = 0;
+	foreach my $i (0 .. 1800)
+	{
+		my $log = substr(slurp_file($node->logfile), $logstart);
+		if ($log =~ /shared buffers resized from $from to $to buffers/)
+		{
+			$resized = 1;
+			last;
+		}
+		usleep(100_000);
+	}
+	ok($resized, "shared_buffers resized from ${from_mb}MB to ${to_mb}MB");
+	return;
+}
+
+resize(1, 8);
+resize(8, 2);
+resize(2, 6);
+resize(6, 1);
+resize(1, 4);
+
+$pgbench->finish;
+is($pgbench->result(0), 0, 'pgbench succeeded while resizing');
+
+is($node->safe_psql('postgres', 'SELECT sum(balance) FROM acct'),
+	'0', 'no transfer lost');
+is($node->safe_psql('postgres', $big_query),
+	$big_expected, 'scanned table intact');
+
+# Pages evicted while shrinking must have been written out
+$node->restart;
+is($node->safe_psql('postgres', 'SELECT sum(balance) FROM acct'),
+	'0', 'no transfer lost after restart');
+is($node->safe_psql('postgres', 'SELECT sum(abs(balance)) > 0 FROM acct'),
+	't', 'transfers were made');
+
+$node->stop;
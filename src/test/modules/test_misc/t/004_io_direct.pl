@@ -0,0 +1,108 @@
+# Test io_direct
+#
+# With io_direct = on, relation files are opened with O_DIRECT, which needs
+# aligned buffers.  Index builds and heap rewrites write pages that aren't
+# in shared buffers, so run those along with sequential and index scans,
+# with a small shared_buffers so that everything goes to disk and back.
+
+use strict;
+use warnings;
+use Fcntl;
+use PostgresNode;
+use TestLib;
+use Test::More;
+
+# Skip if the platform or the file system of the test directory doesn't
+# support O_DIRECT, as the server would fail to open relation files.
+my $o_direct = eval { Fcntl::O_DIRECT() };
+if (!defined $o_direct)
+{
+	plan skip_all => 'no O_DIRECT';
+}
+my $probe = TestLib::tempdir() . '/probe';
+if (!sysopen(my $fh, $probe, O_RDWR | O_CREAT | $o_direct))
+{
+	plan skip_all => "file system doesn't support O_DIRECT: $!";
+}
+else
+{
+	close($fh);
+	plan tests => 9;
+}
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+io_direct = on
+shared_buffers = 1MB
+autovacuum = off
+});
+$node->start;
+
+is($node->safe_psql('postgres', 'SHOW io_direct'), 'on', 'io_direct is on');
+
+$node->safe_psql(
+	'postgres', qq{
+CREATE EXTENSION amcheck;
+CREATE TABLE t (id int, pad text);
+INSERT INTO t SELECT i, md5(i::text) FROM generate_series(1, 20000) i;
+CREATE INDEX t_id ON t (id);
+CREATE INDEX t_pad ON t (pad);
+});
+
+my $query = "SELECT count(*), sum(id), md5(string_agg(pad, ',' ORDER BY id)) FROM t";
+my $expected = $node->safe_psql('postgres', $query);
+
+is( $node->safe_psql(
+		'postgres', "SET enable_seqscan = off; SET enable_bitmapscan = off; "
+		  . "SELECT count(*) FROM t WHERE id BETWEEN 1001 AND 2000"),
+	'1000',
+	'index scan after index build');
+is( $node->safe_psql(
+		'postgres',
+		"SELECT bt_index_check('t_id', true), bt_index_check('t_pad', true)"),
+	'|',
+	'indexes are consistent with the heap');
+
+# Rewrite the heap, which rebuilds the indexes too
+$node->safe_psql(
+	'postgres', qq{
+DELETE FROM t WHERE id % 2 = 0;
+VACUUM FULL t;
+CLUSTER t USING t_id;
+});
+$expected = $node->safe_psql('postgres', $query);
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'10000', 'rows after heap rewrite');
+is( $node->safe_psql(
+		'postgres',
+		"SELECT bt_index_check('t_id', true), bt_index_check('t_pad', true)"),
+	'|',
+	'indexes are consistent after heap rewrite');
+
+# Temporary tables go through local buffers
+is( $node->safe_psql(
+		'postgres', qq{
+CREATE TEMP TABLE tt AS SELECT * FROM t;
+CREATE INDEX ON tt (id);
+SELECT count(*) FROM tt;
+}),
+	'10000',
+	'temporary table');
+
+# Read everything back from disk, in runs of blocks and one at a time
+$node->restart;
+is($node->safe_psql('postgres', $query),
+	$expected, 'sequential scan after restart');
+is( $node->safe_psql(
+		'postgres', "SET io_combine_limit = 1; $query"),
+	$expected,
+	'sequential scan reading one block at a time');
+is( $node->safe_psql(
+		'postgres',
+		"SELECT bt_index_check('t_id', true), bt_index_check('t_pad', true)"),
+	'|',
+	'indexes are consistent after restart');
+
+$node->stop;
@@ -0,0 +1,57 @@
+# Test looking up shared buffers through the lock-free lookup hints
+#
+# Backends first try to find a page through a hint of the buffer that holds
+# it, and check the buffer's tag once they have pinned it.  With a table much
+# larger than shared_buffers, buffers are reassigned to other pages all the
+# time, so that many hints are stale by the time they're used.  Check that
+# concurrent readers and writers always get the right row anyway.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 3;
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+shared_buffers = 1MB
+autovacuum = off
+});
+$node->start;
+
+$node->safe_psql(
+	'postgres', qq{
+CREATE TABLE t (id int PRIMARY KEY, val int NOT NULL, pad text)
+  WITH (fillfactor = 50);
+INSERT INTO t SELECT i, i * 7, md5(i::text) FROM generate_series(1, 50000) i;
+});
+
+# A wrong or missing row makes the lookup divide by zero, which aborts the
+# client and makes pgbench fail.
+my $script = $node->basedir . '/lookup.sql';
+append_to_file(
+	$script, q{
+\set id random(1, 50000)
+SELECT 1 / (count(*) FILTER (WHERE val = :id * 7))::int FROM t WHERE id = :id;
+UPDATE t SET pad = md5(random()::text) WHERE id = :id;
+});
+
+$node->command_ok(
+	[ 'pgbench', '-n', '-c', '8', '-j', '8', '-T', '20', '-f', $script, 'postgres' ],
+	'concurrent lookups found the right rows');
+
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t WHERE val <> id * 7'),
+	'0', 'no row changed its value');
+
+# Everything must also be found through the index after a restart
+$node->restart;
+is( $node->safe_psql(
+		'postgres',
+		'SET enable_seqscan = off; SET enable_bitmapscan = off; '
+		  . 'SELECT count(*), sum(val) FROM t WHERE id > 0'),
+	'50000|' . (7 * 50000 * 50001 / 2),
+	'all rows found through the index after a restart');
+
+$node->stop;
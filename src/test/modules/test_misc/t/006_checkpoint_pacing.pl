@@ -0,0 +1,97 @@
+# Test checkpoints paced by checkpoint_io_latency_target
+#
+# Writes and fsyncs slower than the latency target make the checkpointer
+# pause, but only as far as the checkpoint schedule allows.  Check that
+# checkpoints requested by WAL volume and by CHECKPOINT still finish, with
+# a target that most fsyncs exceed and with one that none can, and that
+# crash recovery from them is sound.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 8;
+use Time::HiRes qw(usleep);
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+fsync = on
+log_checkpoints = on
+checkpoint_timeout = 30s
+max_wal_size = 32MB
+checkpoint_completion_target = 0.9
+checkpoint_io_latency_target = 1ms
+autovacuum = off
+});
+$node->start;
+
+# Wait for a message to appear in the server log after the given offset,
+# and return the offset just past it.
+sub wait_for_log
+{
+	my ($regexp, $offset) = @_;
+
+	foreach my $i (0 .. 1800)
+	{
+		my $log = substr(slurp_file($node->logfile), $offset);
+		if ($log =~ /$regexp/)
+		{
+			return $offset + $+[0];
+		}
+		usleep(100_000);
+	}
+	return undef;
+}
+
+# Generate enough WAL to request a checkpoint, and wait for it to finish
+sub spread_checkpoint
+{
+	my ($first_id, $test_name) = @_;
+	my $offset = -s $node->logfile;
+
+	$node->safe_psql('postgres',
+		    "INSERT INTO t SELECT i, md5(i::text) FROM generate_series($first_id, "
+		  . ($first_id + 299999)
+		  . ") i");
+
+	$offset = wait_for_log(qr/checkpoint starting:.* wal/, $offset);
+	ok(defined $offset, "$test_name: checkpoint requested");
+	$offset = wait_for_log(qr/checkpoint complete: wrote/, $offset)
+	  if defined $offset;
+	ok(defined $offset, "$test_name: checkpoint completed");
+	return;
+}
+
+$node->safe_psql('postgres', 'CREATE TABLE t (id int, pad text)');
+
+# Nearly every fsync takes longer than 1ms, so the checkpointer pauses
+# whenever it is ahead of schedule.  The checkpoint must still finish.
+spread_checkpoint(1, 'low latency target');
+
+# An immediate checkpoint doesn't pause at all
+my ($ret, $stdout, $stderr) =
+  $node->psql('postgres', 'CHECKPOINT', timeout => 60);
+is($ret, 0, 'immediate checkpoint with low latency target');
+
+# Nothing is that slow, so that the checkpointer never pauses
+$node->append_conf('postgresql.conf', 'checkpoint_io_latency_target = 10s');
+$node->reload;
+spread_checkpoint(300001, 'high latency target');
+
+$node->safe_psql('postgres',
+	"INSERT INTO t SELECT i, md5(i::text) FROM generate_series(600001, 600100) i"
+);
+
+# Crash, and recover from the last checkpoint
+$node->stop('immediate');
+$node->start;
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'600100', 'all rows after crash recovery');
+is( $node->safe_psql(
+		'postgres', "SELECT count(*) FROM t WHERE pad <> md5(id::text)"),
+	'0',
+	'rows intact after crash recovery');
+
+$node->stop;
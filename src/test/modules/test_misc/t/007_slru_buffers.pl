@@ -0,0 +1,148 @@
+# Test non-default sizes of the SLRU caches
+#
+# Start a server with every SLRU cache set to a size other than its
+# default, and use each of them, so that pages map to banks other than the
+# ones the default sizes select.  Values that aren't a whole number of
+# banks are rejected.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 11;
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+transaction_buffers = 32
+subtransaction_buffers = 48
+multixact_offset_buffers = 32
+multixact_member_buffers = 64
+commit_timestamp_buffers = 48
+notify_buffers = 32
+serializable_buffers = 64
+track_commit_timestamp = on
+autovacuum = off
+});
+$node->start;
+
+is( $node->safe_psql(
+		'postgres', qq{
+SELECT string_agg(name || '=' || setting, ',' ORDER BY name)
+  FROM pg_settings
+  WHERE name LIKE '%buffers'
+    AND name NOT IN ('shared_buffers', 'max_shared_buffers', 'temp_buffers',
+                     'wal_buffers');
+}),
+	'commit_timestamp_buffers=48,multixact_member_buffers=64,'
+	  . 'multixact_offset_buffers=32,notify_buffers=32,'
+	  . 'serializable_buffers=64,subtransaction_buffers=48,'
+	  . 'transaction_buffers=32',
+	'SLRU cache sizes are set');
+
+# Each subtransaction gets an XID of its own, so this fills a few pages of
+# pg_subtrans, and the status of all of them is looked up in pg_xact.
+$node->safe_psql(
+	'postgres', qq{
+CREATE TABLE t (id int PRIMARY KEY, val int);
+DO \$\$
+BEGIN
+  FOR i IN 1..10000 LOOP
+    BEGIN
+      INSERT INTO t VALUES (i, 0);
+    EXCEPTION WHEN others THEN
+      RAISE;
+    END;
+  END LOOP;
+END
+\$\$;
+});
+is( $node->safe_psql(
+		'postgres', 'SELECT count(*), count(DISTINCT xmin) FROM t'),
+	'10000|10000',
+	'rows inserted by subtransactions');
+is( $node->safe_psql(
+		'postgres',
+		'SELECT count(*) FROM t WHERE pg_xact_commit_timestamp(xmin) IS NULL'),
+	'0',
+	'commit timestamps of subtransactions');
+
+# Locking a row again in a subtransaction creates a MultiXact
+is( $node->safe_psql(
+		'postgres', qq{
+BEGIN;
+SELECT val FROM t WHERE id <= 100 FOR SHARE;
+SAVEPOINT s;
+UPDATE t SET val = 1 WHERE id <= 100;
+RELEASE s;
+COMMIT;
+SELECT count(*) FROM t WHERE val = 1;
+}),
+	"0\n" x 100 . '100',
+	'rows locked and updated in a subtransaction');
+is( $node->safe_psql(
+		'postgres', qq{
+BEGIN;
+SELECT count(*) FROM t WHERE id <= 100 FOR KEY SHARE;
+SAVEPOINT s;
+SELECT count(*) FROM t WHERE id <= 100 FOR NO KEY UPDATE;
+COMMIT;
+SELECT count(*) FROM t WHERE id <= 100 FOR SHARE;
+}),
+	"100\n100\n100",
+	'rows locked by MultiXacts');
+
+like(
+	$node->safe_psql(
+		'postgres', qq{
+LISTEN chan;
+NOTIFY chan, 'hello';
+}),
+	qr/Asynchronous notification "chan" with payload "hello" received/,
+	'notification delivered');
+
+is( $node->safe_psql(
+		'postgres', qq{
+BEGIN ISOLATION LEVEL SERIALIZABLE;
+SELECT count(*) FROM t WHERE id <= 1000;
+UPDATE t SET val = 2 WHERE id = 1;
+COMMIT;
+}),
+	'1000',
+	'serializable transaction');
+
+# Everything must still be there after a crash
+$node->stop('immediate');
+$node->start;
+is( $node->safe_psql(
+		'postgres', 'SELECT count(*), sum(val) FROM t'),
+	'10000|101',
+	'rows after crash recovery');
+is( $node->safe_psql(
+		'postgres',
+		'SELECT count(*) FROM t WHERE pg_xact_commit_timestamp(xmin) IS NULL'),
+	'0',
+	'commit timestamps after crash recovery');
+
+# A cache size must be a whole number of 16-page banks
+my ($stdout, $stderr) = run_command(
+	[
+		'postgres', '-D', $node->data_dir, '-C', 'transaction_buffers',
+		'-c', 'transaction_buffers=20'
+	]);
+like(
+	$stderr,
+	qr/"transaction_buffers" must be a multiple of 16/,
+	'transaction_buffers not a multiple of 16 is rejected');
+($stdout, $stderr) = run_command(
+	[
+		'postgres', '-D', $node->data_dir, '-C', 'notify_buffers',
+		'-c', 'notify_buffers=40'
+	]);
+like(
+	$stderr,
+	qr/"notify_buffers" must be a multiple of 16/,
+	'notify_buffers not a multiple of 16 is rejected');
+
+$node->stop;
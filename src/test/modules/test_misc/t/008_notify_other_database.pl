@@ -0,0 +1,117 @@
+# Test that NOTIFY doesn't wake listeners in other databases
+#
+# Notifications are database-local, so a listener in another database
+# would skip them.  If it is idle where the notifications start, the
+# notifying backend moves it past them instead of signaling it.  The
+# notifier reports what it did with trace_notify.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use IPC::Run;
+use Test::More tests => 4;
+
+my $psql_timeout = IPC::Run::timer(180);
+
+my $node = get_new_node('main');
+$node->init;
+$node->start;
+$node->safe_psql('postgres', 'CREATE DATABASE db2');
+
+# Start a psql session that stays connected, listening on channel "a"
+sub start_listener
+{
+	my ($dbname, $stdin, $stdout, $stderr) = @_;
+	my $proc = IPC::Run::start(
+		[
+			'psql', '-X', '-qAt', '-v', 'ON_ERROR_STOP=1', '-f', '-', '-d',
+			$node->connstr($dbname)
+		],
+		'<', $stdin, '>', $stdout, '2>', $stderr, $psql_timeout);
+	$$stdin .= "LISTEN a;\nSELECT 'listening';\n";
+	pump_until($proc, $stdout, qr/listening/)
+	  or die "listener in $dbname did not start";
+	return $proc;
+}
+
+# Run a query in a listener session and return what it printed since
+sub run_in_listener
+{
+	my ($proc, $stdin, $stdout) = @_;
+	$$stdout = '';
+	$$stdin .= "SELECT 'done';\n";
+	pump_until($proc, $stdout, qr/done/)
+	  or die "listener did not respond";
+	return $$stdout;
+}
+
+sub pump_until
+{
+	my ($proc, $stream, $untl) = @_;
+	$proc->pump_nb();
+	while (1)
+	{
+		last if $$stream =~ /$untl/;
+		if ($psql_timeout->is_expired)
+		{
+			diag("aborting wait: program timed out");
+			diag("stream contents: >>", $$stream, "<<");
+			diag("pattern searched for: ", $untl);
+
+			return 0;
+		}
+		if (not $proc->pumpable())
+		{
+			diag("aborting wait: program died");
+			diag("stream contents: >>", $$stream, "<<");
+			diag("pattern searched for: ", $untl);
+
+			return 0;
+		}
+		$proc->pump();
+	}
+	return 1;
+}
+
+sub notify
+{
+	my ($ret, $stdout, $stderr) = $node->psql('postgres',
+		"SET trace_notify = on; SET client_min_messages = debug1; NOTIFY a;");
+	die "NOTIFY failed: $stderr" if $ret != 0;
+	return $stderr;
+}
+
+my ($db2_stdin, $db2_stdout, $db2_stderr) = ('', '', '');
+my $db2_listener =
+  start_listener('db2', \$db2_stdin, \$db2_stdout, \$db2_stderr);
+
+like(
+	notify(),
+	qr/SignalBackends: 0 to signal, 1 advanced/,
+	'listener in other database is moved past notification');
+
+my ($pg_stdin, $pg_stdout, $pg_stderr) = ('', '', '');
+my $pg_listener =
+  start_listener('postgres', \$pg_stdin, \$pg_stdout, \$pg_stderr);
+
+like(
+	notify(),
+	qr/SignalBackends: 1 to signal, 1 advanced/,
+	'only listener in same database is signaled');
+
+like(
+	run_in_listener($pg_listener, \$pg_stdin, \$pg_stdout),
+	qr/Asynchronous notification "a" received/,
+	'listener in same database received notification');
+unlike(
+	run_in_listener($db2_listener, \$db2_stdin, \$db2_stdout),
+	qr/Asynchronous notification/,
+	'listener in other database received nothing');
+
+$pg_stdin .= "\\q\n";
+$pg_listener->finish;
+$db2_stdin .= "\\q\n";
+$db2_listener->finish;
+
+$node->stop;
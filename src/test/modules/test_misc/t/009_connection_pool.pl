@@ -0,0 +1,257 @@
+# Test built-in connection pooling
+#
+# With connection_pool_size = 1, one backend serves all the sessions of a
+# kind.  A new session is authenticated by a backend of its own, which hands
+# it back as soon as it is idle and exits, since the pool is full; the
+# session's queries are then run by the pooled backend, as pg_backend_pid()
+# tells.  A session that sets up state a fresh backend wouldn't have keeps
+# the pooled backend to itself, and the other sessions wait, until it drops
+# that state.  Cancel requests must reach the backend serving a session,
+# whichever it is, and clients that go away while their session is parked
+# in the postmaster must be forgotten.
+#
+# The sessions under test connect with an application_name of their own, so
+# that the connections made by safe_psql to look around form another pool.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use IPC::Run;
+use Test::More;
+
+if ($windows_os)
+{
+	plan skip_all => 'connection pooling is not supported on Windows';
+}
+else
+{
+	plan tests => 26;
+}
+
+my $psql_timeout = IPC::Run::timer(180);
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+connection_pool_size = 1
+max_pooled_sessions = 4
+});
+$node->start;
+$node->safe_psql('postgres', 'CREATE EXTENSION dblink');
+
+my $connstr = $node->connstr('postgres') . ' application_name=pool_test';
+
+# Start a psql session that stays connected
+sub start_session
+{
+	my %session = (stdin => '', stdout => '', stderr => '');
+	$session{proc} = IPC::Run::start(
+		[ 'psql', '-X', '-qAt', '-v', 'ON_ERROR_STOP=1', '-f', '-', '-d', $connstr ],
+		'<', \$session{stdin}, '>', \$session{stdout},
+		'2>', \$session{stderr}, $psql_timeout);
+	return \%session;
+}
+
+# Send SQL to a session, followed by a marker to wait for
+sub start_query
+{
+	my ($session, $sql) = @_;
+	$session->{stdout} = '';
+	$session->{stderr} = '';
+	$session->{stdin} .= "$sql\n\\echo __done__\n";
+	$session->{proc}->pump_nb();
+	return;
+}
+
+# Has a session finished the SQL sent with start_query?
+sub query_done
+{
+	my ($session) = @_;
+	$session->{proc}->pump_nb();
+	return $session->{stdout} =~ /__done__\n/;
+}
+
+# Wait for a session to finish the SQL sent with start_query, and return
+# what it printed
+sub finish_query
+{
+	my ($session) = @_;
+	pump_until($session->{proc}, \$session->{stdout}, qr/__done__\n/)
+	  or die "session did not finish its query: $session->{stderr}";
+	(my $out = $session->{stdout}) =~ s/__done__\n$//;
+	chomp($out);
+	return $out;
+}
+
+sub query
+{
+	my ($session, $sql) = @_;
+	start_query($session, $sql);
+	return finish_query($session);
+}
+
+# Which backend runs the next query of a session?
+sub backend_pid
+{
+	my ($session) = @_;
+	return query($session, 'SELECT pg_backend_pid();');
+}
+
+sub end_session
+{
+	my ($session) = @_;
+	$session->{stdin} .= "\\q\n";
+	$session->{proc}->finish;
+	return;
+}
+
+# Wait for a backend to be idle in the pool, which means that the session
+# it served last is parked in the postmaster, unless it has ended.
+sub wait_for_pool
+{
+	my ($pid) = @_;
+	$node->poll_query_until('postgres',
+		"SELECT wait_event = 'PooledSession' FROM pg_stat_activity WHERE pid = $pid")
+	  or die "backend $pid did not return to the pool";
+	return;
+}
+
+sub pump_until
+{
+	my ($proc, $stream, $untl) = @_;
+	$proc->pump_nb();
+	while (1)
+	{
+		last if $$stream =~ /$untl/;
+		if ($psql_timeout->is_expired)
+		{
+			diag("aborting wait: program timed out");
+			diag("stream contents: >>", $$stream, "<<");
+			diag("pattern searched for: ", $untl);
+
+			return 0;
+		}
+		if (not $proc->pumpable())
+		{
+			diag("aborting wait: program died");
+			diag("stream contents: >>", $$stream, "<<");
+			diag("pattern searched for: ", $untl);
+
+			return 0;
+		}
+		$proc->pump();
+	}
+	return 1;
+}
+
+# The first session's backend becomes the pooled backend, and keeps
+# serving that session after it has been handed back.
+my $session_a = start_session();
+my $pooled_pid = backend_pid($session_a);
+wait_for_pool($pooled_pid);
+is(backend_pid($session_a), $pooled_pid,
+	'first backend serves its session from the pool');
+
+# A second session is handed to the pooled backend, and the backend that
+# authenticated it goes away.
+my $session_b = start_session();
+is(backend_pid($session_b), $pooled_pid,
+	'second session is served by pooled backend');
+ok( $node->poll_query_until(
+		'postgres', qq{
+SELECT count(*) = 1 FROM pg_stat_activity
+WHERE application_name = 'pool_test'}),
+	'backend that authenticated second session has exited');
+
+# Session state that keeps the pooled backend with a session, and how to
+# drop it.  While the backend is taken, session A has to wait for it.
+my $dblink_connstr = $node->connstr('postgres');
+my @pinning = (
+	[ 'SET', "SET work_mem = '2MB';", 'RESET work_mem;' ],
+	[ 'prepared statement', 'PREPARE p AS SELECT 1;', 'DEALLOCATE p;' ],
+	[ 'LISTEN', 'LISTEN pool_test;', 'UNLISTEN *;' ],
+	[
+		'advisory lock', 'SELECT pg_advisory_lock(1);',
+		'SELECT pg_advisory_unlock(1);'
+	],
+	[
+		'dblink connection',
+		"SELECT dblink_connect('c', \$\$$dblink_connstr\$\$);",
+		"SELECT dblink_disconnect('c');"
+	],
+	[ 'temporary table', 'CREATE TEMP TABLE tt (a int);', undef ]);
+foreach my $case (@pinning)
+{
+	my ($name, $pin_sql, $unpin_sql) = @$case;
+	my $session = start_session();
+
+	query($session, $pin_sql);
+	start_query($session_a, 'SELECT pg_backend_pid();');
+	is(backend_pid($session), $pooled_pid,
+		"session with $name keeps pooled backend");
+	ok(!query_done($session_a), "other session waits while $name is held");
+
+	if (defined $unpin_sql)
+	{
+		query($session, $unpin_sql);
+		is(finish_query($session_a), $pooled_pid,
+			"other session is served once $name is dropped");
+		end_session($session);
+	}
+	else
+	{
+		# The backend exits with the session, and a new one takes its place
+		end_session($session);
+		my $new_pid = finish_query($session_a);
+		isnt($new_pid, $pooled_pid,
+			"other session gets new backend once session with $name ends");
+		$pooled_pid = $new_pid;
+	}
+}
+
+# A cancel request sent with the key session B got from the backend that
+# authenticated it reaches the pooled backend serving it.  psql exits after
+# that, since it is running a script.
+wait_for_pool($pooled_pid);
+$session_b->{stdin} .= "SELECT pg_sleep(180);\n";
+$session_b->{proc}->pump_nb();
+ok( $node->poll_query_until(
+		'postgres', qq{
+SELECT count(*) = 1 FROM pg_stat_activity
+WHERE pid = $pooled_pid AND state = 'active'
+  AND query = 'SELECT pg_sleep(180);'}),
+	'moved session is running a query in pooled backend');
+$session_b->{proc}->signal('INT');
+ok( pump_until(
+		$session_b->{proc}, \$session_b->{stderr},
+		qr/canceling statement due to user request/),
+	'cancel request reaches backend serving moved session');
+$session_b->{proc}->finish;
+is(backend_pid($session_a), $pooled_pid,
+	'pooled backend is still serving after cancel');
+
+# Clients that disconnect while their session is parked.  If the postmaster
+# didn't forget them, they would fill max_pooled_sessions along with session
+# A, and the next session couldn't be parked.
+foreach my $i (1 .. 3)
+{
+	my $session = start_session();
+	backend_pid($session);
+	wait_for_pool($pooled_pid);
+	$session->{proc}->kill_kill;
+}
+my $session_e = start_session();
+backend_pid($session_e);
+wait_for_pool($pooled_pid);
+is(backend_pid($session_e), $pooled_pid,
+	'session is parked and reassigned after clients disconnected');
+unlike(
+	slurp_file($node->logfile),
+	qr/could not keep pooled session/,
+	'no session was turned away for lack of room');
+
+end_session($_) foreach ($session_e, $session_a);
+
+$node->stop;
@@ -0,0 +1,311 @@
+# Test pre-forked backends
+#
+# With preforked_backends > 0, the postmaster keeps backends forked and
+# initialized ahead of time and passes new connections to them.  It logs the
+# pids of the backends it forks and of those it passes connections to at
+# DEBUG2, which tells which backend took a connection.  Check that
+# connections are served by pre-forked backends, and that this makes
+# connecting faster; that a reload replaces them with backends that have the
+# new configuration; that a pooled session needing a new backend gets a
+# pre-forked one; and that no more of them are kept than max_connections
+# allows for, that a replication connection served by one counts against
+# max_wal_senders rather than max_connections, and that they don't keep
+# parallel workers from starting.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use IPC::Run;
+use Time::HiRes qw(usleep);
+use Test::More;
+
+if ($windows_os)
+{
+	plan skip_all => 'pre-forked backends are not supported on Windows';
+}
+else
+{
+	plan tests => 13;
+}
+
+my $psql_timeout = IPC::Run::timer(180);
+
+# Return the log written since $logstart
+sub log_since
+{
+	my ($node, $logstart) = @_;
+	return substr(slurp_file($node->logfile), $logstart);
+}
+
+# Pids of the backends forked ahead of time since $logstart
+sub forked_pids
+{
+	my ($node, $logstart) = @_;
+	return (log_since($node, $logstart) =~
+		  /forked new backend ahead of time, pid=(\d+)/g);
+}
+
+# Wait until at least $count backends have been forked ahead of time since
+# $logstart
+sub wait_for_forks
+{
+	my ($node, $logstart, $count) = @_;
+	foreach my $i (0 .. 1800)
+	{
+		return if scalar(forked_pids($node, $logstart)) >= $count;
+		usleep(100_000);
+	}
+	die "$count backends were not forked ahead of time";
+}
+
+# Wait for a line matching $regexp to be logged after $logstart
+sub wait_for_log
+{
+	my ($node, $logstart, $regexp) = @_;
+	foreach my $i (0 .. 1800)
+	{
+		return if log_since($node, $logstart) =~ $regexp;
+		usleep(100_000);
+	}
+	die "timed out waiting for $regexp to be logged";
+}
+
+# Start a psql session in the background, for session_query
+sub start_session
+{
+	my ($connstr) = @_;
+	my $session = { stdin => '', stdout => '', stderr => '' };
+	$session->{proc} = IPC::Run::start(
+		[ 'psql', '-X', '-qAt', '-v', 'ON_ERROR_STOP=1', '-f', '-', '-d', $connstr ],
+		'<', \$session->{stdin}, '>', \$session->{stdout},
+		'2>', \$session->{stderr}, $psql_timeout);
+	return $session;
+}
+
+# Run $sql in a session started by start_session, and return its output
+sub session_query
+{
+	my ($session, $sql) = @_;
+	$session->{stdout} = '';
+	$session->{stdin} .= "$sql\n\\echo __done__\n";
+	pump_until($session->{proc}, \$session->{stdout}, qr/__done__\n/)
+	  or die "session did not run \"$sql\": $session->{stderr}";
+	(my $out = $session->{stdout}) =~ s/__done__\n$//;
+	chomp($out);
+	return $out;
+}
+
+sub end_session
+{
+	my ($session) = @_;
+	$session->{stdin} .= "\\q\n";
+	$session->{proc}->finish;
+}
+
+sub pump_until
+{
+	my ($proc, $stream, $untl) = @_;
+	$proc->pump_nb();
+	while (1)
+	{
+		last if $$stream =~ /$untl/;
+		if ($psql_timeout->is_expired)
+		{
+			diag("aborting wait: program timed out");
+			diag("stream contents: >>", $$stream, "<<");
+			diag("pattern searched for: ", $untl);
+
+			return 0;
+		}
+		if (not $proc->pumpable())
+		{
+			diag("aborting wait: program died");
+			diag("stream contents: >>", $$stream, "<<");
+			diag("pattern searched for: ", $untl);
+
+			return 0;
+		}
+		$proc->pump();
+	}
+	return 1;
+}
+
+sub passed_to_preforked
+{
+	my ($node, $pid) = @_;
+	return slurp_file($node->logfile) =~
+	  /passed connection to pre-forked backend, pid=$pid /;
+}
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+preforked_backends = 2
+log_min_messages = debug2
+});
+$node->start;
+wait_for_forks($node, 0, 2);
+
+my $pid = $node->safe_psql('postgres', 'SELECT pg_backend_pid()');
+ok(passed_to_preforked($node, $pid),
+	'connection is served by pre-forked backend');
+
+# A reload replaces the idle pre-forked backends, which still have the old
+# configuration.
+my $logstart = -s $node->logfile;
+$node->append_conf('postgresql.conf', "work_mem = '3MB'");
+$node->reload;
+wait_for_forks($node, $logstart, 2);
+my @new_pids = forked_pids($node, $logstart);
+my ($pid_after_reload, $work_mem) = split(
+	/\n/,
+	$node->safe_psql(
+		'postgres', 'SELECT pg_backend_pid(); SHOW work_mem;'));
+ok((grep { $_ eq $pid_after_reload } @new_pids),
+	'connection after reload is served by backend forked after it');
+is($work_mem, '3MB', 'backend forked after reload has new configuration');
+
+# Pre-forked backends cut the time it takes to connect.  Measure it with
+# pgbench making a connection for each query, taking the best of a few runs
+# to smooth out the noise.
+my $script = $node->basedir . '/select.sql';
+append_to_file($script, "SELECT 1;\n");
+
+sub connection_time
+{
+	my $best;
+	foreach my $run (1 .. 3)
+	{
+		my ($stdout, $stderr) = run_command(
+			[
+				'pgbench', '-n', '-C', '-c', '1', '-j', '1', '-t', '200',
+				'-f', $script, '-h', $node->host, '-p', $node->port, 'postgres'
+			]);
+		$stdout =~ /tps = ([\d.]+) \(including connections establishing\)/
+		  or return undef;
+		$best = 1000 / $1 if !defined $best || 1000 / $1 < $best;
+	}
+	return $best;
+}
+
+my $time_preforked = connection_time();
+ok(defined $time_preforked, 'pgbench with pre-forked backends');
+
+$logstart = -s $node->logfile;
+$node->append_conf('postgresql.conf', 'preforked_backends = 0');
+$node->reload;
+wait_for_log($node, $logstart, qr/received SIGHUP, reloading configuration files/);
+my $time_forked = connection_time();
+ok(defined $time_forked, 'pgbench without pre-forked backends');
+
+note(
+	sprintf(
+		'time to connect and run a query: %.3f ms with pre-forked backends, %.3f ms without',
+		$time_preforked // 0, $time_forked // 0));
+cmp_ok($time_preforked // 0, '<', $time_forked // 0,
+	'pre-forked backends make connecting faster');
+
+$node->stop;
+
+# With connection pooling, a pooled session whose backend has gone away
+# gets a pre-forked backend.
+my $node_pool = get_new_node('pool');
+$node_pool->init;
+$node_pool->append_conf(
+	'postgresql.conf', qq{
+connection_pool_size = 1
+preforked_backends = 2
+log_min_messages = debug2
+});
+$node_pool->start;
+wait_for_forks($node_pool, 0, 2);
+
+my $session = start_session(
+	$node_pool->connstr('postgres') . ' application_name=pool_test');
+
+my $pooled_pid = session_query($session, 'SELECT pg_backend_pid();');
+$node_pool->poll_query_until('postgres',
+	"SELECT wait_event = 'PooledSession' FROM pg_stat_activity WHERE pid = $pooled_pid"
+) or die "backend $pooled_pid did not return to the pool";
+$node_pool->safe_psql('postgres', "SELECT pg_terminate_backend($pooled_pid)");
+$node_pool->poll_query_until('postgres',
+	"SELECT count(*) = 0 FROM pg_stat_activity WHERE pid = $pooled_pid")
+  or die "backend $pooled_pid did not exit";
+
+my ($new_pid, $appname) =
+  split(/\n/,
+	session_query($session, 'SELECT pg_backend_pid(); SHOW application_name;'));
+ok( $new_pid ne $pooled_pid && passed_to_preforked($node_pool, $new_pid),
+	'pooled session gets pre-forked backend');
+is($appname, 'pool_test', 'pooled session keeps its startup options');
+
+end_session($session);
+$node_pool->stop;
+
+# Each idle pre-forked backend holds a regular backend's PGPROC, so there are
+# never more of them than max_connections leaves room for, and they are kept
+# rather than dismissed and forked again over and over while there's no room
+# for more.
+my $node_limit = get_new_node('limit');
+$node_limit->init(allows_streaming => 1);
+$node_limit->append_conf(
+	'postgresql.conf', qq{
+max_connections = 2
+superuser_reserved_connections = 0
+autovacuum = off
+max_worker_processes = 3
+max_parallel_workers_per_gather = 2
+max_wal_senders = 1
+preforked_backends = 10
+log_min_messages = debug2
+});
+$node_limit->start;
+wait_for_forks($node_limit, 0, 2);
+sleep(3);
+is(scalar(forked_pids($node_limit, 0)),
+	2, 'no more backends are pre-forked than max_connections allows for');
+
+# A replication connection takes a pre-forked backend too, which then trades
+# its PGPROC for a walsender's.  Once it's a walsender, another backend is
+# pre-forked to take its place.
+$logstart = -s $node_limit->logfile;
+my $walsender =
+  start_session($node_limit->connstr('postgres') . ' replication=database');
+my $walsender_pid = session_query($walsender, 'SELECT pg_backend_pid();');
+ok(passed_to_preforked($node_limit, $walsender_pid),
+	'replication connection is served by pre-forked backend');
+wait_for_forks($node_limit, $logstart, 1);
+
+# So both regular connections are still to be had, and a parallel query in
+# one of them gets its workers.
+my $session1 = start_session($node_limit->connstr('postgres'));
+my $session2 = start_session($node_limit->connstr('postgres'));
+my $pid1 = session_query($session1, 'SELECT pg_backend_pid();');
+my $pid2 = session_query($session2, 'SELECT pg_backend_pid();');
+ok( passed_to_preforked($node_limit, $pid1)
+	  && passed_to_preforked($node_limit, $pid2),
+	'walsender served by pre-forked backend does not take a regular connection');
+
+like(
+	session_query(
+		$session1, qq{
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF)
+  SELECT count(*) FROM pg_class;
+}),
+	qr/Workers Planned: (\d+)\n\s*Workers Launched: \1\n/,
+	'parallel workers start beside pre-forked backends');
+
+my $forks_before = scalar(forked_pids($node_limit, 0));
+sleep(3);
+is(scalar(forked_pids($node_limit, 0)),
+	$forks_before, 'nothing is pre-forked while there is no room');
+
+end_session($session1);
+end_session($session2);
+end_session($walsender);
+$node_limit->stop;
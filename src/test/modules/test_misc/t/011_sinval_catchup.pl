@@ -0,0 +1,79 @@
+# Test catchup interrupts for backends lagging in the sinval queue
+#
+# Backends running a long query don't read the shared invalidation queue,
+# so they fall behind while other sessions change the catalogs.  Until the
+# queue is three-quarters full, each cleanup of the queue signals only the
+# backend furthest behind; from then on, it signals up to
+# MAX_CATCHUP_SIGNALS of them at once, so that they get a chance to catch up
+# before they have to be reset.  pg_stat_get_sinval() counts the signals
+# and the resets, and tells how full the queue was at the last cleanup.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use IPC::Run;
+use Test::More tests => 3;
+
+my $psql_timeout = IPC::Run::timer(180);
+
+# Keep other processes out of the queue, so that only the sleepers lag
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+sinval_queue_size = 4096
+autovacuum = off
+max_logical_replication_workers = 0
+});
+$node->start;
+$node->safe_psql('postgres', 'CREATE TABLE t (a int)');
+
+my $nsleepers = 8;
+my @sleepers;
+foreach my $i (1 .. $nsleepers)
+{
+	my ($stdin, $stdout, $stderr) = ("SELECT pg_sleep(600);\n", '', '');
+	push @sleepers,
+	  IPC::Run::start(
+		[ 'psql', '-X', '-qAt', '-f', '-', '-d', $node->connstr('postgres') ],
+		'<', \$stdin, '>', \$stdout, '2>', \$stderr, $psql_timeout);
+}
+$node->poll_query_until('postgres',
+	"SELECT count(*) = $nsleepers FROM pg_stat_activity WHERE wait_event = 'PgSleep'"
+) or die "sleepers did not start";
+
+sub sinval_stats
+{
+	return split(
+		/\|/,
+		$node->safe_psql(
+			'postgres',
+			'SELECT queue_size, messages, catchup_signals, resets FROM pg_stat_get_sinval()'
+		));
+}
+
+my ($queue_size, $messages, $signals_start, $resets_start) = sinval_stats();
+
+# Each ALTER TABLE queues a few messages.  Add them in batches smaller than
+# the distance between cleanups, until a cleanup finds the queue
+# three-quarters full.
+my $batch = join('', map { "ALTER TABLE t ALTER a SET STATISTICS $_;\n" } 1 .. 10);
+my ($signals, $resets);
+my $signals_below = 0;
+foreach my $i (0 .. 1000)
+{
+	$node->safe_psql('postgres', $batch);
+	($queue_size, $messages, $signals, $resets) = sinval_stats();
+	last if $messages >= $queue_size / 4 * 3;
+	$signals_below = $signals - $signals_start;
+}
+
+cmp_ok($signals_below, '<', $nsleepers,
+	'backends are signaled one at a time until the queue is nearly full');
+is($signals - $signals_start, $nsleepers,
+	'all lagging backends are signaled once the queue is nearly full');
+is($resets - $resets_start, 0, 'no backend was reset');
+
+$node->stop;
+$_->kill_kill foreach @sleepers;
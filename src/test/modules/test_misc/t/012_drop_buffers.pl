@@ -0,0 +1,90 @@
+# Test dropping the buffers of truncated and dropped relations
+#
+# When the size of a relation is in the shared relation size cache, and
+# only a few blocks are to go, their buffers are found through the buffer
+# mapping table instead of by scanning the whole buffer pool.  Run the same
+# truncations and drops with the cache and without it, which takes the
+# scan, and check with pg_buffercache that no buffer of the removed blocks
+# is left behind, and that the relations have the right contents after.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 10;
+
+foreach my $cache_size (10000, 0)
+{
+	my $node = get_new_node("cache_$cache_size");
+	$node->init;
+	$node->append_conf(
+		'postgresql.conf', qq{
+shared_buffers = 16MB
+smgr_shared_relations = $cache_size
+autovacuum = off
+});
+	$node->start;
+
+	# Count the buffers of a relfilenode, from block $from on
+	my $buffers = sub {
+		my ($filenode, $from) = @_;
+		return $node->safe_psql(
+			'postgres', qq{
+SELECT count(*) FROM pg_buffercache
+WHERE reldatabase = (SELECT oid FROM pg_database WHERE datname = 'postgres')
+  AND relfilenode = $filenode AND relblocknumber >= $from});
+	};
+
+	# With fillfactor 10, each row gets a page of its own
+	$node->safe_psql(
+		'postgres', qq{
+CREATE EXTENSION pg_buffercache;
+CREATE TABLE t (id int, pad text) WITH (fillfactor = 10);
+INSERT INTO t SELECT i, lpad(i::text, 500, 'x') FROM generate_series(1, 100) i;
+SELECT count(*) FROM t;
+});
+	my $filenode = $node->safe_psql('postgres', "SELECT pg_relation_filenode('t')");
+
+	# VACUUM truncates the empty pages at the end
+	$node->safe_psql(
+		'postgres', qq{
+DELETE FROM t WHERE id > 10;
+VACUUM t;
+});
+	is($buffers->($filenode, 10), '0',
+		"no buffers beyond end of truncated relation, cache size $cache_size");
+
+	$node->safe_psql('postgres',
+		"INSERT INTO t SELECT i, lpad(i::text, 500, 'x') FROM generate_series(11, 30) i"
+	);
+	is($node->safe_psql('postgres', 'SELECT count(*), sum(id) FROM t'),
+		'30|465', "relation extended after truncation, cache size $cache_size");
+
+	# Dirty buffers of a relation truncated in the same transaction must be
+	# dropped, not written out by the next checkpoint.
+	$node->safe_psql(
+		'postgres', qq{
+BEGIN;
+UPDATE t SET pad = 'y';
+TRUNCATE t;
+COMMIT;
+CHECKPOINT;
+});
+	is($buffers->($filenode, 0), '0',
+		"no buffers of relation file replaced by TRUNCATE, cache size $cache_size");
+
+	# Dropping a relation drops the buffers of all its forks
+	$node->safe_psql(
+		'postgres', qq{
+INSERT INTO t SELECT i, lpad(i::text, 500, 'x') FROM generate_series(1, 20) i;
+VACUUM t;
+});
+	$filenode = $node->safe_psql('postgres', "SELECT pg_relation_filenode('t')");
+	cmp_ok($buffers->($filenode, 0), '>', 0,
+		"relation has buffers before DROP, cache size $cache_size");
+	$node->safe_psql('postgres', 'DROP TABLE t; CHECKPOINT;');
+	is($buffers->($filenode, 0), '0',
+		"no buffers of dropped relation, cache size $cache_size");
+
+	$node->stop;
+}
@@ -0,0 +1,96 @@
+# Test the buffer replacement policies and their statistics
+#
+# With buffer_replacement_policy = clock, a page read into shared buffers
+# starts with a usage count of 1; with probation, it starts at 0, and only
+# gets to 1 when it is accessed again.  Check that with pg_buffercache, and
+# check that pg_buffercache_strategy_stats() counts the allocations taken
+# from the freelist, the buffers reused by a bulk read ring, and the clock
+# sweep once the freelist is used up.
+
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 14;
+
+foreach my $policy ('clock', 'probation')
+{
+	my $node = get_new_node($policy);
+	$node->init;
+	$node->append_conf(
+		'postgresql.conf', qq{
+shared_buffers = 1MB
+buffer_replacement_policy = $policy
+autovacuum = off
+});
+	$node->start;
+
+	# With fillfactor 10, each row gets a page of its own.  "small" is read
+	# without a ring, but "big" is larger than a quarter of shared buffers,
+	# so sequential scans of it use one.
+	$node->safe_psql(
+		'postgres', qq{
+CREATE EXTENSION pg_buffercache;
+CREATE TABLE small (id int, pad text) WITH (fillfactor = 10);
+INSERT INTO small SELECT i, lpad(i::text, 500, 'x') FROM generate_series(1, 10) i;
+CREATE TABLE big (id int, pad text) WITH (fillfactor = 10);
+INSERT INTO big SELECT i, lpad(i::text, 500, 'x') FROM generate_series(1, 200) i;
+VACUUM small, big;
+});
+	my $filenode = $node->safe_psql('postgres', "SELECT pg_relation_filenode('small')");
+
+	my $usagecounts = sub {
+		return $node->safe_psql(
+			'postgres', qq{
+SELECT count(*), min(usagecount), max(usagecount) FROM pg_buffercache
+WHERE reldatabase = (SELECT oid FROM pg_database WHERE datname = 'postgres')
+  AND relfilenode = $filenode AND relforknumber = 0});
+	};
+
+	# Start from an empty buffer pool
+	$node->restart;
+
+	is($node->safe_psql('postgres', 'SELECT replacement_policy FROM pg_buffercache_strategy_stats()'),
+		$policy, "policy is reported, $policy");
+
+	my $first = $policy eq 'probation' ? 0 : 1;
+	$node->safe_psql('postgres', 'SELECT count(*) FROM small');
+	is($usagecounts->(), "10|$first|$first",
+		"usage count of pages read once, $policy");
+	$node->safe_psql('postgres', 'SELECT count(*) FROM small');
+	is($usagecounts->(), "10|" . ($first + 1) . "|" . ($first + 1),
+		"usage count of pages read twice, $policy");
+
+	$node->safe_psql('postgres', 'SELECT count(*) FROM big');
+	my ($freelist_allocs, $ring_reuses) = split(
+		/\|/,
+		$node->safe_psql(
+			'postgres',
+			'SELECT freelist_allocs, ring_reuses FROM pg_buffercache_strategy_stats()'
+		));
+	cmp_ok($freelist_allocs, '>', 0,
+		"buffers allocated from the freelist after restart, $policy");
+	cmp_ok($ring_reuses, '>', 100,
+		"sequential scan of a large table reuses its ring, $policy");
+
+	# A TID scan reads each page of "big" without a ring, which uses up the
+	# freelist and makes the clock hand move.
+	$node->safe_psql(
+		'postgres', qq{
+SELECT count(*) FROM big
+WHERE ctid = ANY (ARRAY(SELECT format('(%s,1)', i)::tid FROM generate_series(0, 199) i));
+});
+	my ($buffer_allocs, $clock_sweep_ticks);
+	($buffer_allocs, $freelist_allocs, $clock_sweep_ticks) = split(
+		/\|/,
+		$node->safe_psql(
+			'postgres',
+			'SELECT buffer_allocs, freelist_allocs, clock_sweep_ticks FROM pg_buffercache_strategy_stats()'
+		));
+	cmp_ok($buffer_allocs, '>', $freelist_allocs,
+		"allocations beyond the freelist are counted, $policy");
+	cmp_ok($clock_sweep_ticks, '>', 0,
+		"clock sweep runs once the freelist is empty, $policy");
+
+	$node->stop;
+}
@@ -0,0 +1,154 @@
+# Test that the shared cache of relation sizes stays coherent on a standby
+#
+# The startup process maintains the cache while replaying extensions and
+# truncations, and must forget the sizes of a database that is dropped or
+# moved to another tablespace.  Backends on the standby read the sizes
+# before and after each of those, so that stale entries would show up as a
+# size differing from the primary's.  There are fewer slots in the cache
+# than relations in use, so slots are recycled all the time, which must not
+# lose any change either.
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 13;
+
+my $node_primary = get_new_node('primary');
+$node_primary->init(allows_streaming => 1);
+$node_primary->append_conf(
+	'postgresql.conf', qq{
+autovacuum = off
+smgr_shared_relations = 100
+});
+$node_primary->start;
+
+# The tablespace has to exist before the standby is created, so that
+# pg_basebackup can map it to a directory of the standby's own.
+my $ts_primary = TestLib::tempdir_short();
+my $ts_standby = TestLib::tempdir_short();
+$node_primary->safe_psql('postgres',
+	"CREATE TABLESPACE ts LOCATION '$ts_primary'");
+
+my $node_standby = get_new_node('standby');
+TestLib::system_or_bail(
+	'pg_basebackup', '-D', $node_standby->data_dir,
+	'-h', $node_primary->host, '-p', $node_primary->port,
+	'--checkpoint', 'fast', '--no-sync',
+	"--tablespace-mapping=$ts_primary=$ts_standby");
+chmod(0700, $node_standby->data_dir);
+$node_standby->append_conf('postgresql.conf',
+	'port = ' . $node_standby->port . "\n");
+$node_standby->enable_streaming($node_primary);
+$node_standby->start;
+
+# Compare the size and contents of a relation on both nodes, once the
+# standby has caught up.
+sub check_relation
+{
+	my ($dbname, $relname, $test_name) = @_;
+	my $query = "SELECT pg_relation_size('$relname'), count(*) FROM $relname";
+
+	$node_primary->wait_for_catchup($node_standby, 'replay',
+		$node_primary->lsn('insert'));
+	is( $node_standby->safe_psql($dbname, $query),
+		$node_primary->safe_psql($dbname, $query),
+		$test_name);
+	return;
+}
+
+# With fillfactor 10, each row gets a page of its own
+$node_primary->safe_psql(
+	'postgres', qq{
+CREATE TABLE t (id int, pad text) WITH (fillfactor = 10);
+INSERT INTO t SELECT i, lpad(i::text, 500, 'x') FROM generate_series(1, 100) i;
+});
+check_relation('postgres', 't', 'extended relation');
+
+# VACUUM truncates the empty pages at the end
+$node_primary->safe_psql(
+	'postgres', qq{
+DELETE FROM t WHERE id > 10;
+VACUUM t;
+});
+is( $node_primary->safe_psql(
+		'postgres',
+		"SELECT pg_relation_size('t') / current_setting('block_size')::int"),
+	'10',
+	'VACUUM truncated relation on primary');
+check_relation('postgres', 't', 'truncated relation');
+
+$node_primary->safe_psql('postgres',
+	"INSERT INTO t SELECT i, lpad(i::text, 500, 'x') FROM generate_series(11, 50) i"
+);
+check_relation('postgres', 't', 'relation extended again after truncation');
+
+$node_primary->safe_psql(
+	'postgres', qq{
+TRUNCATE t;
+INSERT INTO t SELECT i, lpad(i::text, 500, 'x') FROM generate_series(1, 5) i;
+});
+check_relation('postgres', 't', 'relation refilled after TRUNCATE');
+
+# Fill the cache with other relations, so that the slot of t is taken over,
+# and then extend t again.
+$node_primary->safe_psql(
+	'postgres', q{
+DO $$
+BEGIN
+  FOR i IN 1..200 LOOP
+    EXECUTE format('CREATE TABLE many%s (id int)', i);
+    EXECUTE format('INSERT INTO many%s SELECT generate_series(1, %s)', i, i * 10);
+  END LOOP;
+END
+$$;
+INSERT INTO t SELECT i, lpad(i::text, 500, 'x') FROM generate_series(6, 20) i;
+});
+check_relation('postgres', 't', 'relation extended after its slot was recycled');
+
+my $many_query = q{
+SELECT sum(pg_relation_size(oid)) FROM pg_class
+WHERE relname ~ '^many[0-9]+$'};
+is( $node_standby->safe_psql('postgres', $many_query),
+	$node_primary->safe_psql('postgres', $many_query),
+	'sizes of more relations than the cache has slots');
+
+# Move a database to another tablespace, change its table there, and move
+# it back.  The cached sizes of its relations in the original tablespace
+# must not survive the round trip.
+$node_primary->safe_psql('postgres', 'CREATE DATABASE db1');
+$node_primary->safe_psql(
+	'db1', qq{
+CREATE TABLE t1 (id int, pad text) WITH (fillfactor = 10);
+INSERT INTO t1 SELECT i, lpad(i::text, 500, 'x') FROM generate_series(1, 20) i;
+});
+check_relation('db1', 't1', 'relation in new database');
+
+$node_primary->safe_psql('postgres', 'ALTER DATABASE db1 SET TABLESPACE ts');
+check_relation('db1', 't1', 'relation in database moved to tablespace');
+like(
+	$node_standby->safe_psql('db1', "SELECT pg_relation_filepath('t1')"),
+	qr{^pg_tblspc/},
+	'relation moved to tablespace on standby');
+
+$node_primary->safe_psql('db1',
+	"INSERT INTO t1 SELECT i, lpad(i::text, 500, 'x') FROM generate_series(21, 30) i"
+);
+check_relation('db1', 't1', 'relation extended in tablespace');
+
+$node_primary->safe_psql('postgres',
+	'ALTER DATABASE db1 SET TABLESPACE pg_default');
+check_relation('db1', 't1', 'relation in database moved back');
+
+# Dropping the database must forget its sizes too.  The standby keeps
+# working with a new database, which could reuse relfilenodes.
+$node_primary->safe_psql('postgres', 'DROP DATABASE db1');
+$node_primary->safe_psql('postgres', 'CREATE DATABASE db2');
+$node_primary->safe_psql(
+	'db2', qq{
+CREATE TABLE t2 (id int, pad text) WITH (fillfactor = 10);
+INSERT INTO t2 SELECT i, lpad(i::text, 500, 'x') FROM generate_series(1, 7) i;
+});
+check_relation('db2', 't2', 'relation in database created after DROP DATABASE');
+
+$node_standby->stop;
+$node_primary->stop;
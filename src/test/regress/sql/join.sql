@@ -2513,6 +2513,92 @@ explain (costs off)
 select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
 rollback to settings;
 
+-- A join that throws away most of its outer relation pushes a bloom
+-- filter of the inner hash values down into the outer scan.
+create or replace function find_bloom_scan(node json)
+returns json language plpgsql
+as
+$$
+declare
+  x json;
+  child json;
+begin
+  if node->>'Rows Removed by Bloom Filter' is not null then
+    return node;
+  else
+    for child in select json_array_elements(node->'Plans')
+    loop
+      x := find_bloom_scan(child);
+      if x is not null then
+        return x;
+      end if;
+    end loop;
+    return null;
+  end if;
+end;
+$$;
+create or replace function hash_join_bloom_removed(query text)
+returns table (removed int) language plpgsql
+as
+$$
+declare
+  whole_plan json;
+begin
+  for whole_plan in
+    execute 'explain (analyze, format ''json'') ' || query
+  loop
+    removed := find_bloom_scan(json_extract_path(whole_plan, '0', 'Plan'))
+      ->>'Rows Removed by Bloom Filter';
+    return next;
+  end loop;
+end;
+$$;
+
+-- non-parallel
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+explain (costs off)
+  select count(*) from simple r join simple s using (id) where s.id % 1000 = 0;
+select count(*) from simple r join simple s using (id) where s.id % 1000 = 0;
+select removed > 0 as filtered
+  from hash_join_bloom_removed(
+$$
+  select count(*) from simple r join simple s using (id) where s.id % 1000 = 0;
+$$);
+-- no filter if unmatched outer rows must be kept
+select removed is null as unfiltered
+  from hash_join_bloom_removed(
+$$
+  select count(*) from simple r
+    left join (select id from simple where id % 1000 = 0) s using (id);
+$$);
+rollback to settings;
+
+-- parallel with parallel-aware hash join
+savepoint settings;
+set local max_parallel_workers_per_gather = 2;
+set local work_mem = '4MB';
+set local enable_parallel_hash = on;
+select count(*) from simple r join simple s using (id) where s.id % 1000 = 0;
+select removed > 0 as filtered
+  from hash_join_bloom_removed(
+$$
+  select count(*) from simple r join simple s using (id) where s.id % 1000 = 0;
+$$);
+rollback to settings;
+
+-- without the filter
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local enable_hashjoin_bloom = off;
+select count(*) from simple r join simple s using (id) where s.id % 1000 = 0;
+select removed is null as unfiltered
+  from hash_join_bloom_removed(
+$$
+  select count(*) from simple r join simple s using (id) where s.id % 1000 = 0;
+$$);
+rollback to settings;
+
 -- exercise special code paths for huge tuples (note use of non-strict
 -- expression and left join required to get the detoasted tuple into
 -- the hash table)
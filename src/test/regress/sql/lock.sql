@@ -113,6 +113,37 @@ LOCK TABLE ONLY lock_tbl1;
 ROLLBACK;
 RESET ROLE;
 
+--
+-- Fast-path locks beyond the first group of 16 slots
+--
+CREATE TABLE lock_tbl_part (a int) PARTITION BY RANGE (a);
+DO $$
+BEGIN
+  FOR i IN 0..99 LOOP
+    EXECUTE format('CREATE TABLE lock_tbl_part_%s PARTITION OF lock_tbl_part '
+                   'FOR VALUES FROM (%s) TO (%s)', i, i * 10, (i + 1) * 10);
+  END LOOP;
+END
+$$;
+BEGIN;
+SELECT count(*) FROM lock_tbl_part;
+SELECT count(*) AS locked,
+       count(*) FILTER (WHERE fastpath) > 16 AS fastpath_beyond_16,
+       count(*) FILTER (WHERE fastpath) <=
+         current_setting('max_fast_path_locks')::int AS fastpath_within_limit
+  FROM pg_locks
+  WHERE pid = pg_backend_pid() AND locktype = 'relation'
+    AND relation IN (SELECT oid FROM pg_class
+                     WHERE relname LIKE 'lock\_tbl\_part\_%');
+-- A strong lock moves the fast-path locks on the relation to the main table
+LOCK TABLE lock_tbl_part_0 IN SHARE ROW EXCLUSIVE MODE;
+SELECT mode, fastpath FROM pg_locks
+  WHERE pid = pg_backend_pid() AND locktype = 'relation'
+    AND relation = 'lock_tbl_part_0'::regclass
+  ORDER BY mode;
+COMMIT;
+DROP TABLE lock_tbl_part;
+
 --
 -- Clean up
 --
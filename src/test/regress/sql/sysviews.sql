@@ -32,6 +32,12 @@ select count(*) = 0 as ok from pg_prepared_statements;
 -- See also prepared_xacts.sql
 select count(*) >= 0 as ok from pg_prepared_xacts;
 
+-- The shared invalidation queue is at least its minimum size, and can't
+-- hold more messages than fit in it
+select queue_size >= 4096 and messages between 0 and queue_size
+  and catchup_signals >= 0 and resets >= 0 as ok
+  from pg_stat_get_sinval();
+
 -- This is to record the prevailing planner enable_foo settings during
 -- a regression test run.
 select name, setting from pg_settings where name like 'enable%';